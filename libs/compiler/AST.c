@@ -195,6 +195,36 @@ double expression_literal_get_floating(const node *const nd)
 	return node_get_arg_double(nd, 2);
 }
 
+node expression_to_integer_literal(node *const nd, const item_t type, const item_t value)
+{
+	const location loc = node_get_location(nd);
+	const node result = node_insert(nd, OP_LITERAL, 5);
+
+	node_set_arg(&result, 0, type);					// Тип значения выражения
+	node_set_arg(&result, 1, RVALUE);				// Категория значения выражения
+	node_set_arg(&result, 2, value);				// Значение литерала
+	node_set_arg(&result, 3, (item_t)loc.begin);	// Начальная позиция выражения
+	node_set_arg(&result, 4, (item_t)loc.end);		// Конечная позиция выражения
+
+	node_remove(nd);
+	return result;
+}
+
+node expression_to_floating_literal(node *const nd, const item_t type, const double value)
+{
+	const location loc = node_get_location(nd);
+	const node result = node_insert(nd, OP_LITERAL, DOUBLE_SIZE + 4);
+
+	node_set_arg(&result, 0, type);									// Тип значения выражения
+	node_set_arg(&result, 1, RVALUE);								// Категория значения выражения
+	node_set_arg_double(&result, 2, value);							// Значение литерала
+	node_set_arg(&result, DOUBLE_SIZE + 2, (item_t)loc.begin);		// Начальная позиция выражения
+	node_set_arg(&result, DOUBLE_SIZE + 3, (item_t)loc.end);		// Конечная позиция выражения
+
+	node_remove(nd);
+	return result;
+}
+
 
 node expression_string_literal(node *const context, const item_t type, const size_t index, const location loc)
 {
@@ -218,13 +248,14 @@ size_t expression_literal_get_string(const node *const nd)
 
 node expression_subscript(const item_t type, node *const base, node *const index, const location loc)
 {
-	node nd = node_insert(base, OP_SLICE, 4);		// Выражение-операнд
+	node nd = node_insert(base, OP_SLICE, 5);		// Выражение-операнд
 	node_set_child(&nd, index);						// Выражение-индекс
 
 	node_set_arg(&nd, 0, type);						// Тип значения выражения
 	node_set_arg(&nd, 1, LVALUE);					// Категория значения выражения
-	node_set_arg(&nd, 2, (item_t)loc.begin);		// Начальная позиция выражения
-	node_set_arg(&nd, 3, (item_t)loc.end);			// Конечная позиция выражения
+	node_set_arg(&nd, 2, false);					// Флаг доказанной принадлежности индекса границам
+	node_set_arg(&nd, 3, (item_t)loc.begin);		// Начальная позиция выражения
+	node_set_arg(&nd, 4, (item_t)loc.end);			// Конечная позиция выражения
 
 	return nd;
 }
@@ -241,6 +272,18 @@ node expression_subscript_get_index(const node *const nd)
 	return node_get_child(nd, 1);
 }
 
+bool expression_subscript_is_unchecked(const node *const nd)
+{
+	assert(node_get_type(nd) == OP_SLICE);
+	return node_get_arg(nd, 2) != 0;
+}
+
+void expression_subscript_set_unchecked(const node *const nd)
+{
+	assert(node_get_type(nd) == OP_SLICE);
+	node_set_arg(nd, 2, true);
+}
+
 
 node expression_call(const item_t type, node *const callee, node_vector *const args, const location loc)
 {
@@ -618,6 +661,17 @@ node statement_compound(node *const context, node_vector *const stmts, const loc
 	return nd;
 }
 
+node statement_compound_enclose(const node *const nd)
+{
+	const location loc = node_get_location(nd);
+	const node result = node_insert(nd, OP_BLOCK, 2);
+
+	node_set_arg(&result, 0, (item_t)loc.begin);	// Начальная позиция оператора
+	node_set_arg(&result, 1, (item_t)loc.end);		// Конечная позиция оператора
+
+	return result;
+}
+
 size_t statement_compound_get_size(const node *const nd)
 {
 	assert(node_get_type(nd) == OP_BLOCK);
@@ -641,6 +695,18 @@ node statement_null(node *const context, const location loc)
 	return nd;
 }
 
+node statement_to_null(node *const nd)
+{
+	const location loc = node_get_location(nd);
+	const node result = node_insert(nd, OP_NOP, 2);
+
+	node_set_arg(&result, 0, (item_t)loc.begin);	// Начальная позиция оператора
+	node_set_arg(&result, 1, (item_t)loc.end);		// Конечная позиция оператора
+
+	node_remove(nd);
+	return result;
+}
+
 
 node statement_if(node *const cond, node *const then_stmt, node *const else_stmt, const location loc)
 {
@@ -257,6 +257,29 @@ node expression_floating_literal(node *const context, const item_t type, const d
  */
 double expression_literal_get_floating(const node *const nd);
 
+/**
+ *	Replace expression by integer literal with the same location
+ *	@note	Also used for boolean, character and enum literals
+ *
+ *	@param	nd				Expression
+ *	@param	type			Value type
+ *	@param	value			Literal value
+ *
+ *	@return	Integer literal expression
+ */
+node expression_to_integer_literal(node *const nd, const item_t type, const item_t value);
+
+/**
+ *	Replace expression by floating literal with the same location
+ *
+ *	@param	nd				Expression
+ *	@param	type			Value type
+ *	@param	value			Literal value
+ *
+ *	@return	Floating literal expression
+ */
+node expression_to_floating_literal(node *const nd, const item_t type, const double value);
+
 
 /**
  *	Create new string literal expression
@@ -310,6 +333,22 @@ node expression_subscript_get_base(const node *const nd);
  */
 node expression_subscript_get_index(const node *const nd);
 
+/**
+ *	Check if index of subscript expression is proven to be within array bounds
+ *
+ *	@param	nd				Subscript expression
+ *
+ *	@return	@c true if bounds check is not needed
+ */
+bool expression_subscript_is_unchecked(const node *const nd);
+
+/**
+ *	Mark index of subscript expression as proven to be within array bounds
+ *
+ *	@param	nd				Subscript expression
+ */
+void expression_subscript_set_unchecked(const node *const nd);
+
 
 /**
  *	Create new call expression
@@ -700,6 +739,15 @@ node statement_default_get_substmt(const node *const nd);
  */
 node statement_compound(node *const context, node_vector *const stmts, const location loc);
 
+/**
+ *	Replace statement by compound statement with this statement inside
+ *
+ *	@param	nd				Statement
+ *
+ *	@return	Compound statement
+ */
+node statement_compound_enclose(const node *const nd);
+
 /**
  *	Get size of compound statement
  *
@@ -730,6 +778,15 @@ node statement_compound_get_substmt(const node *const nd, const size_t index);
  */
 node statement_null(node *const context, const location loc);
 
+/**
+ *	Replace statement by null statement with the same location
+ *
+ *	@param	nd				Statement
+ *
+ *	@return	Null statement
+ */
+node statement_to_null(node *const nd);
+
 
 /**
  *	Create new if statement
@@ -15,6 +15,7 @@
  */
 
 #include "builder.h"
+#include <math.h>
 #include "AST.h"
 
 
@@ -72,171 +73,296 @@ static item_t usual_arithmetic_conversions(const syntax *const sx, node *const L
 	return TYPE_INTEGER;
 }
 
-static node fold_unary_expression(builder *const bldr, const item_t type, const category_t ctg
-	, node *const expr, const unary_t op, const location loc)
+static inline bool is_int32(const item_t value)
 {
-	if (expression_get_class(expr) != EXPR_LITERAL)
+	return value >= INT32_MIN && value <= INT32_MAX;
+}
+
+static inline item_t get_unqualified_type(const syntax *const sx, const item_t type)
+{
+	return type_is_const(sx, type) ? type_const_get_unqualified_type(sx, type) : type;
+}
+
+/**
+ *	Check if expression is a literal with a value known at compile time
+ *
+ *	@param	sx			Syntax structure
+ *	@param	nd			Expression
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_constant(const syntax *const sx, const node *const nd)
+{
+	if (expression_get_class(nd) != EXPR_LITERAL)
 	{
-		return expression_unary(type, ctg, expr, op, loc);
+		return false;
 	}
 
-	switch (type_get_class(bldr->sx, expression_get_type(expr)))
+	switch (type_get_class(sx, expression_get_type(nd)))
 	{
 		case TYPE_NULL_POINTER:
-			node_remove(expr);
-			return build_boolean_literal_expression(bldr, true, loc);
+		case TYPE_FLOATING:
+			return true;
 
 		case TYPE_BOOLEAN:
-		{
-			const bool value = expression_literal_get_boolean(expr);
-			node_remove(expr);
-			return build_boolean_literal_expression(bldr, !value, loc);
-		}
-
-		case TYPE_ENUM:
+		case TYPE_CHARACTER:
 		case TYPE_INTEGER:
-		{
-			const item_t value = expression_literal_get_integer(expr);
-			node_remove(expr);
+		case TYPE_ENUM:
+			return is_int32(expression_literal_get_integer(nd));
 
-			switch (op)
-			{
-				case UN_MINUS:
-					return build_integer_literal_expression(bldr, -value, loc);
-				case UN_NOT:
-					return build_integer_literal_expression(bldr, ~value, loc);
-				case UN_LOGNOT:
-					return build_boolean_literal_expression(bldr, value == 0, loc);
-				case UN_ABS:
-					return build_integer_literal_expression(bldr, value >= 0 ? value : -value, loc);
-				default:
-					return node_broken();
-			}
-		}
+		default:
+			return false;
+	}
+}
 
-		case TYPE_FLOATING:
-		{
-			const double value = expression_literal_get_floating(expr);
-			node_remove(expr);
+static inline bool is_integral_constant(const syntax *const sx, const node *const nd)
+{
+	return is_constant(sx, nd) && !type_is_floating(sx, expression_get_type(nd));
+}
 
-			switch (op)
-			{
-				case UN_MINUS:
-					return build_floating_literal_expression(bldr, -value, loc);
-				case UN_ABS:
-					return build_floating_literal_expression(bldr, value >= 0 ? value : -value, loc);
-				default:
-					return node_broken();
-			}
-		}
+static inline item_t get_integral_value(const node *const nd)
+{
+	return type_is_null_pointer(expression_get_type(nd)) ? 0 : expression_literal_get_integer(nd);
+}
 
-		default:
-			return expression_unary(type, ctg, expr, op, loc);
+static inline double get_floating_value(const syntax *const sx, const node *const nd)
+{
+	return type_is_floating(sx, expression_get_type(nd))
+		? expression_literal_get_floating(nd)
+		: (double)get_integral_value(nd);
+}
+
+/**
+ *	Replace expression by integer literal, if the value does not overflow
+ *
+ *	@param	nd			Expression
+ *	@param	type		Literal type
+ *	@param	value		Literal value
+ *
+ *	@return	Literal expression on success, original expression on failure
+ */
+static node fold_integer_result(node *const nd, const item_t type, const item_t value)
+{
+	return is_int32(value) ? expression_to_integer_literal(nd, type, value) : *nd;
+}
+
+/**
+ *	Replace expression by floating literal, if the value is finite
+ *
+ *	@param	nd			Expression
+ *	@param	type		Literal type
+ *	@param	value		Literal value
+ *
+ *	@return	Literal expression on success, original expression on failure
+ */
+static node fold_floating_result(node *const nd, const item_t type, const double value)
+{
+	return isfinite(value) ? expression_to_floating_literal(nd, type, value) : *nd;
+}
+
+static node evaluate_cast_expression(const syntax *const sx, node *const nd)
+{
+	const node operand = expression_cast_get_operand(nd);
+	if (!is_constant(sx, &operand))
+	{
+		return *nd;
+	}
+
+	const item_t type = get_unqualified_type(sx, expression_get_type(nd));
+	if (type_is_floating(sx, type))
+	{
+		return fold_floating_result(nd, type, get_floating_value(sx, &operand));
+	}
+
+	if ((type_is_integer(sx, type) || type_is_boolean(sx, type)) && is_integral_constant(sx, &operand))
+	{
+		return fold_integer_result(nd, type, get_integral_value(&operand));
 	}
+
+	return *nd;
 }
 
-static node fold_binary_expression(builder *const bldr, const item_t type
-	, node *const LHS, node *const RHS, const binary_t op, const location loc)
+static node evaluate_unary_expression(const syntax *const sx, node *const nd)
 {
-	if (expression_get_class(LHS) != EXPR_LITERAL || expression_get_class(RHS) != EXPR_LITERAL)
+	const node operand = expression_unary_get_operand(nd);
+	if (!is_constant(sx, &operand))
 	{
-		return expression_binary(type, LHS, RHS, op, loc);
+		return *nd;
 	}
 
-	switch (type_get_class(bldr->sx, expression_get_type(LHS)))
+	const item_t type = get_unqualified_type(sx, expression_get_type(nd));
+	const unary_t op = expression_unary_get_operator(nd);
+
+	if (type_is_floating(sx, expression_get_type(&operand)))
 	{
-		case TYPE_ENUM:
-		case TYPE_INTEGER:
-		case TYPE_BOOLEAN:
+		const double value = expression_literal_get_floating(&operand);
+		switch (op)
 		{
-			const item_t left_value = expression_literal_get_integer(LHS);
-			const item_t right_value = expression_literal_get_integer(RHS);
-			node_remove(LHS);
-			node_remove(RHS);
+			case UN_MINUS:
+				return fold_floating_result(nd, type, -value);
+			case UN_ABS:
+				return fold_floating_result(nd, type, fabs(value));
+			default:
+				return *nd;
+		}
+	}
 
-			switch (op)
-			{
-				case BIN_MUL:
-					return build_integer_literal_expression(bldr, left_value * right_value, loc);
-				case BIN_DIV:
-					return build_integer_literal_expression(bldr, left_value / right_value, loc);
-				case BIN_REM:
-					return build_integer_literal_expression(bldr, left_value % right_value, loc);
-				case BIN_ADD:
-					return build_integer_literal_expression(bldr, left_value + right_value, loc);
-				case BIN_SUB:
-					return build_integer_literal_expression(bldr, left_value - right_value, loc);
-				case BIN_SHL:
-					return build_integer_literal_expression(bldr, left_value << right_value, loc);
-				case BIN_SHR:
-					return build_integer_literal_expression(bldr, left_value >> right_value, loc);
-				case BIN_LT:
-					return build_boolean_literal_expression(bldr, left_value < right_value, loc);
-				case BIN_GT:
-					return build_boolean_literal_expression(bldr, left_value > right_value, loc);
-				case BIN_LE:
-					return build_boolean_literal_expression(bldr, left_value <= right_value, loc);
-				case BIN_GE:
-					return build_boolean_literal_expression(bldr, left_value >= right_value, loc);
-				case BIN_EQ:
-					return build_boolean_literal_expression(bldr, left_value == right_value, loc);
-				case BIN_NE:
-					return build_boolean_literal_expression(bldr, left_value != right_value, loc);
-				case BIN_AND:
-					return build_integer_literal_expression(bldr, left_value & right_value, loc);
-				case BIN_XOR:
-					return build_integer_literal_expression(bldr, left_value ^ right_value, loc);
-				case BIN_OR:
-					return build_integer_literal_expression(bldr, left_value | right_value, loc);
-				case BIN_LOG_AND:
-					return build_boolean_literal_expression(bldr, left_value && right_value, loc);
-				case BIN_LOG_OR:
-					return build_boolean_literal_expression(bldr, left_value || right_value, loc);
-				default:
-					return node_broken();
-			}
+	const item_t value = get_integral_value(&operand);
+	switch (op)
+	{
+		case UN_MINUS:
+			return fold_integer_result(nd, type, -value);
+		case UN_NOT:
+			return fold_integer_result(nd, type, ~value);
+		case UN_LOGNOT:
+			return fold_integer_result(nd, type, value == 0);
+		case UN_ABS:
+			return fold_integer_result(nd, type, value >= 0 ? value : -value);
+		default:
+			return *nd;
+	}
+}
+
+static node evaluate_binary_expression(const syntax *const sx, node *const nd)
+{
+	const node LHS = expression_binary_get_LHS(nd);
+	const node RHS = expression_binary_get_RHS(nd);
+	const item_t type = get_unqualified_type(sx, expression_get_type(nd));
+	const binary_t op = expression_binary_get_operator(nd);
+
+	if (op == BIN_LOG_AND || op == BIN_LOG_OR)
+	{
+		// Правый операнд не вычисляется, если результат определяется левым
+		if (!is_integral_constant(sx, &LHS))
+		{
+			return *nd;
 		}
 
-		case TYPE_FLOATING:
+		const bool left_value = get_integral_value(&LHS) != 0;
+		if (left_value == (op == BIN_LOG_OR))
 		{
-			const double left_value = expression_literal_get_floating(LHS);
-			const double right_value = expression_literal_get_floating(RHS);
+			return fold_integer_result(nd, type, left_value);
+		}
 
-			node_remove(LHS);
-			node_remove(RHS);
+		return is_integral_constant(sx, &RHS) ? fold_integer_result(nd, type, get_integral_value(&RHS) != 0) : *nd;
+	}
 
-			switch (op)
-			{
-				case BIN_MUL:
-					return build_floating_literal_expression(bldr, left_value * right_value, loc);
-				case BIN_DIV:
-					return build_floating_literal_expression(bldr, left_value / right_value, loc);
-				case BIN_ADD:
-					return build_floating_literal_expression(bldr, left_value + right_value, loc);
-				case BIN_SUB:
-					return build_floating_literal_expression(bldr, left_value - right_value, loc);
-				case BIN_LT:
-					return build_boolean_literal_expression(bldr, left_value < right_value, loc);
-				case BIN_GT:
-					return build_boolean_literal_expression(bldr, left_value > right_value, loc);
-				case BIN_LE:
-					return build_boolean_literal_expression(bldr, left_value <= right_value, loc);
-				case BIN_GE:
-					return build_boolean_literal_expression(bldr, left_value >= right_value, loc);
-				case BIN_EQ:
-					return build_boolean_literal_expression(bldr, left_value == right_value, loc);
-				case BIN_NE:
-					return build_boolean_literal_expression(bldr, left_value != right_value, loc);
-				default:
-					return node_broken();
-			}
+	if (!is_constant(sx, &LHS) || !is_constant(sx, &RHS))
+	{
+		return *nd;
+	}
+
+	if (type_is_floating(sx, expression_get_type(&LHS)) || type_is_floating(sx, expression_get_type(&RHS)))
+	{
+		const double left_value = get_floating_value(sx, &LHS);
+		const double right_value = get_floating_value(sx, &RHS);
+
+		switch (op)
+		{
+			case BIN_MUL:
+				return fold_floating_result(nd, type, left_value * right_value);
+			case BIN_DIV:
+				return right_value != 0 ? fold_floating_result(nd, type, left_value / right_value) : *nd;
+			case BIN_ADD:
+				return fold_floating_result(nd, type, left_value + right_value);
+			case BIN_SUB:
+				return fold_floating_result(nd, type, left_value - right_value);
+			case BIN_LT:
+				return fold_integer_result(nd, type, left_value < right_value);
+			case BIN_GT:
+				return fold_integer_result(nd, type, left_value > right_value);
+			case BIN_LE:
+				return fold_integer_result(nd, type, left_value <= right_value);
+			case BIN_GE:
+				return fold_integer_result(nd, type, left_value >= right_value);
+			case BIN_EQ:
+				return fold_integer_result(nd, type, left_value == right_value);
+			case BIN_NE:
+				return fold_integer_result(nd, type, left_value != right_value);
+			default:
+				return *nd;
 		}
+	}
 
+	// Оба операнда в диапазоне int32, поэтому результат всегда помещается в item_t
+	const item_t left_value = get_integral_value(&LHS);
+	const item_t right_value = get_integral_value(&RHS);
+
+	switch (op)
+	{
+		case BIN_MUL:
+			return fold_integer_result(nd, type, left_value * right_value);
+		case BIN_DIV:
+			return right_value != 0 ? fold_integer_result(nd, type, left_value / right_value) : *nd;
+		case BIN_REM:
+			return right_value != 0 && (left_value != INT32_MIN || right_value != -1)
+				? fold_integer_result(nd, type, left_value % right_value)
+				: *nd;
+		case BIN_ADD:
+			return fold_integer_result(nd, type, left_value + right_value);
+		case BIN_SUB:
+			return fold_integer_result(nd, type, left_value - right_value);
+		case BIN_SHL:
+			return right_value >= 0 && right_value < 32
+				? fold_integer_result(nd, type, left_value * ((item_t)1 << right_value))
+				: *nd;
+		case BIN_SHR:
+			return right_value >= 0 && right_value < 32 ? fold_integer_result(nd, type, left_value >> right_value) : *nd;
+		case BIN_LT:
+			return fold_integer_result(nd, type, left_value < right_value);
+		case BIN_GT:
+			return fold_integer_result(nd, type, left_value > right_value);
+		case BIN_LE:
+			return fold_integer_result(nd, type, left_value <= right_value);
+		case BIN_GE:
+			return fold_integer_result(nd, type, left_value >= right_value);
+		case BIN_EQ:
+			return fold_integer_result(nd, type, left_value == right_value);
+		case BIN_NE:
+			return fold_integer_result(nd, type, left_value != right_value);
+		case BIN_AND:
+			return fold_integer_result(nd, type, left_value & right_value);
+		case BIN_XOR:
+			return fold_integer_result(nd, type, left_value ^ right_value);
+		case BIN_OR:
+			return fold_integer_result(nd, type, left_value | right_value);
 		default:
-			return expression_binary(type, LHS, RHS, op, loc);
+			return *nd;
 	}
 }
 
+static node evaluate_ternary_expression(const syntax *const sx, node *const nd)
+{
+	const node cond = expression_ternary_get_condition(nd);
+	if (!is_integral_constant(sx, &cond))
+	{
+		return *nd;
+	}
+
+	node result = get_integral_value(&cond) != 0 ? expression_ternary_get_LHS(nd) : expression_ternary_get_RHS(nd);
+	if (expression_get_type(&result) != expression_get_type(nd))
+	{
+		return *nd;
+	}
+
+	// Выбранный операнд занимает место условного выражения, остальное поддерево отбрасывается
+	node_swap(nd, &result);
+	return result;
+}
+
+static node fold_unary_expression(builder *const bldr, const item_t type, const category_t ctg
+	, node *const expr, const unary_t op, const location loc)
+{
+	node nd = expression_unary(type, ctg, expr, op, loc);
+	return fold_expression(bldr->sx, &nd);
+}
+
+static node fold_binary_expression(builder *const bldr, const item_t type
+	, node *const LHS, node *const RHS, const binary_t op, const location loc)
+{
+	node nd = expression_binary(type, LHS, RHS, op, loc);
+	return fold_expression(bldr->sx, &nd);
+}
 
 static size_t evaluate_args(builder *const bldr, const node *const format_str
 	, item_t *const format_types, char32_t *const placeholders)
@@ -763,16 +889,7 @@ node build_cast_expression(const item_t target_type, node *const expr)
 		{
 			// Пока тут только int -> float
 			const item_t value = expression_literal_get_integer(expr);
-			const node result = node_insert(expr, OP_LITERAL, DOUBLE_SIZE + 4);
-
-			node_set_arg(&result, 0, TYPE_FLOATING);
-			node_set_arg(&result, 1, RVALUE);
-			node_set_arg_double(&result, 2, (double)value);
-			node_set_arg(&result, DOUBLE_SIZE + 2, (item_t)loc.begin);
-			node_set_arg(&result, DOUBLE_SIZE + 3, (item_t)loc.end);
-
-			node_remove(expr);
-			return result;
+			return expression_to_floating_literal(expr, TYPE_FLOATING, (double)value);
 		}
 
 		return expression_cast(target_type, source_type, expr, loc);
@@ -781,6 +898,23 @@ node build_cast_expression(const item_t target_type, node *const expr)
 	return *expr;
 }
 
+node fold_expression(const syntax *const sx, node *const nd)
+{
+	switch (expression_get_class(nd))
+	{
+		case EXPR_CAST:
+			return evaluate_cast_expression(sx, nd);
+		case EXPR_UNARY:
+			return evaluate_unary_expression(sx, nd);
+		case EXPR_BINARY:
+			return evaluate_binary_expression(sx, nd);
+		case EXPR_TERNARY:
+			return evaluate_ternary_expression(sx, nd);
+		default:
+			return *nd;
+	}
+}
+
 node build_unary_expression(builder *const bldr, node *const operand, const unary_t op_kind, const location op_loc)
 {
 	if (!node_is_correct(operand))
@@ -1078,18 +1212,21 @@ node build_ternary_expression(builder *const bldr, node *const cond, node *const
 	if (type_is_arithmetic(bldr->sx, LHS_type) && type_is_arithmetic(bldr->sx, RHS_type))
 	{
 		const item_t type = usual_arithmetic_conversions(bldr->sx, LHS, RHS);
-		return expression_ternary(type, cond, LHS, RHS, loc);
+		node nd = expression_ternary(type, cond, LHS, RHS, loc);
+		return fold_expression(bldr->sx, &nd);
 	}
 
 	if (type_is_pointer(bldr->sx, LHS_type) && type_is_null_pointer(RHS_type))
 	{
-		return expression_ternary(LHS_type, cond, LHS, RHS, loc);
+		node nd = expression_ternary(LHS_type, cond, LHS, RHS, loc);
+		return fold_expression(bldr->sx, &nd);
 	}
 
 	if ((type_is_null_pointer(LHS_type) && type_is_pointer(bldr->sx, RHS_type))
 		|| (LHS_type == RHS_type))
 	{
-		return expression_ternary(RHS_type, cond, LHS, RHS, loc);
+		node nd = expression_ternary(RHS_type, cond, LHS, RHS, loc);
+		return fold_expression(bldr->sx, &nd);
 	}
 
 	semantic_error(bldr, op_loc, incompatible_cond_operands);
@@ -190,6 +190,17 @@ node build_member_expression(builder *const bldr, node *const base, const size_t
  */
 node build_cast_expression(const item_t target_type, node *const expr);
 
+/**
+ *	Fold an expression with constant operands into a literal
+ *	@note	Expressions which overflow or trap at runtime are left as is
+ *
+ *	@param	sx				Syntax structure
+ *	@param	nd				Expression
+ *
+ *	@return	Literal expression on success, original expression on failure
+ */
+node fold_expression(const syntax *const sx, node *const nd);
+
 /**
  *	Build an unary expression
  *
@@ -15,10 +15,12 @@
  */
 
 #include "codegen.h"
+#include <stdlib.h>
 #include "AST.h"
 #include "errors.h"
 #include "instructions.h"
 #include "item.h"
+#include "parser.h"
 #include "string.h"
 #include "tree.h"
 #include "uniprinter.h"
@@ -28,6 +30,17 @@
 
 #define DISPL_START 3
 
+#define BINARY_VERSION 1
+#define BINARY_PAGE_SIZE 4096
+#define BINARY_SHEBANG_SIZE 32
+#define BINARY_SECTIONS 5
+#define BINARY_SECTIONS_TABLE 56
+
+#define MARK_START 1
+#define MARK_LABEL 2
+#define MARK_LITERAL 4
+#define MARK_TABLE 8
+
 #ifndef abs
 	#define abs(a) ((a) > 0 ? (a) : -(a))
 #endif
@@ -39,7 +52,13 @@
 
 
 static const char *const DEFAULT_CODES = "codes.txt";
+static const char *const DEFAULT_PROFILE = "profile.txt";
+static const char *const PROFILE_SEPARATOR = "\n--- profile ---\n";
+static const char *const PROFILE_FORMAT = "profile %i %i\n";
 static const size_t MAX_MEM_SIZE = 100000;
+static const size_t CODE_START = 4;
+static const size_t MAX_PATTERN_SIZE = 32;
+static const size_t MIN_TABLE_CASES = 4;
 
 
 /** Kinds of lvalue */
@@ -49,6 +68,13 @@ typedef enum OPERAND
 	ADDRESS,		/**< Address operand */
 } operand_t;
 
+/** Kinds of profiling counter */
+typedef enum COUNTER
+{
+	COUNTER_FUNCTION,	/**< Function entries counter */
+	COUNTER_LOOP,		/**< Loop iterations counter */
+} counter_t;
+
 
 /** Allocated value designator */
 typedef struct lvalue
@@ -65,15 +91,19 @@ typedef struct encoder
 
 	vector memory;					/**< Memory table */
 	vector iniprocs;				/**< Init procedures */
+	vector literals;				/**< Addresses of literals in memory */
 
 	vector identifiers;				/**< Local identifiers table */
 	vector representations;			/**< Local representations table */
 	vector displacements;			/**< Displacements table */
 	vector functions;				/**< Functions table */
+	vector cases;					/**< Case operators references */
+	vector counters;				/**< Profiling counters: displacement, kind, function and line */
 
 	size_t addr_cond;				/**< Condition address */
-	size_t addr_case;				/**< Case operator address */
+	size_t addr_default;			/**< Default operator references */
 	size_t addr_break;				/**< Break operator address */
+	size_t curr_case;				/**< Next case operator */
 
 	item_t displ;					/**< Current stack displacement */
 
@@ -82,8 +112,33 @@ typedef struct encoder
 
 	const node *curr_func;			/**< Currently emitted function */
 	const item_status target;		/**< Target tables item type */
+	const bool is_profiling;		/**< Set if profiling counters are emitted */
+	const bool has_extended_codes;	/**< Set if instructions of in-tree virtual machine are emitted */
 } encoder;
 
+/** Case operator of switch statement */
+typedef struct case_label
+{
+	item_t value;					/**< Case value */
+	size_t index;					/**< Case operator index in switch */
+} case_label;
+
+/** Peephole optimizer of emitted codes */
+typedef struct peephole
+{
+	encoder *const enc;				/**< Encoder */
+
+	vector marks;					/**< Marks of memory addresses */
+	vector indices;					/**< Instruction indices of memory addresses */
+	vector starts;					/**< Start addresses of instructions */
+
+	vector code;					/**< Optimized codes */
+	vector map;						/**< New addresses of instructions */
+	vector relocs;					/**< Addresses of references in optimized codes */
+
+	bool is_reachable;				/**< Set if the next instruction is reachable */
+} peephole;
+
 
 static void emit_void_expression(encoder *const enc, const node *const nd);
 static lvalue emit_lvalue(encoder *const enc, const node *const nd);
@@ -284,14 +339,54 @@ static void addr_end_condition(encoder *const enc)
 	}
 }
 
-static void addr_end_break(encoder *const enc)
+static void addr_end_chain(encoder *const enc, size_t ref)
+{
+	while (ref)
+	{
+		const size_t next = (size_t)mem_get(enc, ref);
+		mem_set(enc, ref, (item_t)mem_size(enc));
+		ref = next;
+	}
+}
+
+static inline void addr_end_break(encoder *const enc)
 {
-	while (enc->addr_break)
+	addr_end_chain(enc, enc->addr_break);
+	enc->addr_break = 0;
+}
+
+
+/**
+ *	Emit increment of new profiling counter
+ *
+ *	@param	enc			Encoder
+ *	@param	nd			Node in AST, which is counted
+ *	@param	kind		Counter kind
+ */
+static void emit_counter(encoder *const enc, const node *const nd, const counter_t kind)
+{
+	if (!enc->is_profiling || enc->curr_func == NULL)
 	{
-		const size_t ref = (size_t)mem_get(enc, enc->addr_break);
-		mem_set(enc, enc->addr_break, (item_t)mem_size(enc));
-		enc->addr_break = ref;
+		return;
 	}
+
+	// Счётчики размещаются среди глобальных переменных и обнуляются при запуске
+	const item_t displ = -enc->max_global_displ;
+	enc->max_global_displ++;
+
+	universal_io *const io = enc->sx->io;
+	const size_t position = in_get_position(io);
+	in_set_position(io, node_get_location(nd).begin);
+	const size_t line = location_get_line(io);
+	in_set_position(io, position);
+
+	vector_add(&enc->counters, displ);
+	vector_add(&enc->counters, kind);
+	vector_add(&enc->counters, (item_t)declaration_function_get_id(enc->curr_func));
+	vector_add(&enc->counters, (item_t)line);
+
+	mem_add(enc, IC_PRE_INC_V);
+	mem_add(enc, displ);
 }
 
 
@@ -305,16 +400,20 @@ static void addr_end_break(encoder *const enc)
  */
 static encoder enc_create(const workspace *const ws, syntax *const sx)
 {
-	encoder enc = { .sx = sx, .target = item_get_status(ws) };
+	encoder enc = { .sx = sx, .target = item_get_status(ws), .is_profiling = ws_has_flag(ws, "--profile")
+		, .has_extended_codes = ws_has_flag(ws, "--extended-codes") };
 
 	enc.memory = vector_create(MAX_MEM_SIZE);
 	enc.iniprocs = vector_create(0);
+	enc.literals = vector_create(0);
 
 	const size_t records = vector_size(&sx->identifiers) / 4;
 	enc.identifiers = vector_create(records * 3);
 	enc.representations = vector_create(records * 8);
 	enc.displacements = vector_create(records);
 	enc.functions = vector_create(records);
+	enc.cases = vector_create(0);
+	enc.counters = vector_create(0);
 
 	vector_increase(&enc.memory, 4);
 	vector_increase(&enc.iniprocs, vector_size(&enc.sx->types));
@@ -338,16 +437,15 @@ static encoder enc_create(const workspace *const ws, syntax *const sx)
 static int print_table(const encoder *const enc, const vector *const table)
 {
 	const size_t size = vector_size(table);
-	for (size_t i = 0; i < size; i++)
+	if (!item_check_array(enc->target, vector_get_array(table), size))
 	{
-		const item_t item = vector_get(table, i);
-		if (!item_check_var(enc->target, item))
-		{
-			system_error(tables_cannot_be_compressed);
-			return -1;
-		}
+		system_error(tables_cannot_be_compressed);
+		return -1;
+	}
 
-		uni_printf(enc->sx->io, "%" PRIitem " ", item);
+	for (size_t i = 0; i < size; i++)
+	{
+		uni_printf(enc->sx->io, "%" PRIitem " ", vector_get(table, i));
 	}
 
 	uni_printf(enc->sx->io, "\n");
@@ -380,6 +478,186 @@ static int enc_export(const encoder *const enc)
 		|| print_table(enc, &enc->sx->types);
 }
 
+/**
+ *	Export names and lines of profiling counters
+ *
+ *	@param	enc			Encoder
+ *
+ *	@return	@c 0 on success, @c -1 on error
+ */
+static int enc_export_profile(const encoder *const enc)
+{
+	universal_io io = io_create();
+	if (out_set_file(&io, DEFAULT_PROFILE))
+	{
+		return -1;
+	}
+
+	const size_t amount = vector_size(&enc->counters) / 4;
+	for (size_t i = 0; i < amount; i++)
+	{
+		const counter_t kind = (counter_t)vector_get(&enc->counters, 4 * i + 1);
+		const size_t function = (size_t)vector_get(&enc->counters, 4 * i + 2);
+		const item_t line = vector_get(&enc->counters, 4 * i + 3);
+
+		uni_printf(&io, "%zu %s %s %" PRIitem "\n", i, kind == COUNTER_FUNCTION ? "function" : "loop"
+			, ident_get_spelling(enc->sx, function), line);
+	}
+
+	io_erase(&io);
+	return 0;
+}
+
+/**
+ *	Store value in little-endian byte order
+ *
+ *	@param	buffer		Output buffer
+ *	@param	value		Stored value
+ *	@param	width		Number of bytes
+ */
+static inline void store_little_endian(uint8_t *const buffer, const uint64_t value, const size_t width)
+{
+	for (size_t i = 0; i < width; i++)
+	{
+		buffer[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+/**
+ *	Pack table into fixed-width little-endian items of target type
+ *
+ *	@param	enc			Encoder
+ *	@param	table		Table for packing
+ *	@param	buffer		Output buffer
+ *
+ *	@return	@c 0 on success, @c -1 on error
+ */
+static int pack_table(const encoder *const enc, const vector *const table, uint8_t *const buffer)
+{
+	if (item_pack_array(enc->target, vector_get_array(table), vector_size(table), buffer))
+	{
+		system_error(tables_cannot_be_compressed);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ *	Export codes of virtual machine in binary container
+ *	@note	Layout of container, all numbers are little-endian:
+ *			@c 0	shebang line, padded with zeros up to 32 bytes,
+ *			@c 32	magic "RUCB",
+ *			@c 36	uint16 format version,
+ *			@c 38	uint8 item size in bytes,
+ *			@c 39	uint8 set, if items are signed,
+ *			@c 40	uint32 page size, which aligns sections,
+ *			@c 44	uint32 number of sections,
+ *			@c 48	int64 maximal global displacement,
+ *			@c 56	sections table of uint64 offset, uint64 size in bytes and uint64 number of records per section.
+ *			Sections go in order: memory, functions, identifiers, names, types.
+ *			Tables contain fixed-width items of target type, names are NUL-terminated UTF-8 strings,
+ *			the first field of identifier record is an offset of its name in bytes.
+ *
+ *	@param	enc			Encoder
+ *
+ *	@return	@c 0 on success, @c -1 on error
+ */
+static int enc_export_binary(const encoder *const enc)
+{
+	const size_t width = item_get_width(enc->target);
+
+	// Имена переводятся в UTF-8, ссылки на них заменяются смещениями в байтах
+	const size_t representations = vector_size(&enc->representations);
+	char *const names = malloc(representations * 4 + 1);
+	vector offsets = vector_create(representations);
+	size_t names_size = 0;
+	size_t names_amount = 0;
+
+	for (size_t i = 0; i < representations && names != NULL; i++)
+	{
+		vector_add(&offsets, (item_t)names_size);
+
+		const char32_t symbol = (char32_t)vector_get(&enc->representations, i);
+		if (symbol == '\0')
+		{
+			names[names_size++] = '\0';
+			names_amount++;
+		}
+		else
+		{
+			names_size += utf8_to_string(&names[names_size], symbol);
+		}
+	}
+
+	vector identifiers = vector_create(vector_size(&enc->identifiers));
+	for (size_t i = 0; i < vector_size(&enc->identifiers); i++)
+	{
+		const item_t item = vector_get(&enc->identifiers, i);
+		vector_add(&identifiers, i % 3 == 0 ? vector_get(&offsets, (size_t)(item + 2)) : item);
+	}
+
+	const vector *const tables[BINARY_SECTIONS] =
+		{ &enc->memory, &enc->functions, &identifiers, NULL, &enc->sx->types };
+
+	uint8_t header[BINARY_PAGE_SIZE] = { 0 };
+	const char *const shebang = "#!/usr/bin/ruc-vm\n";
+	memcpy(header, shebang, strlen(shebang));
+	memcpy(&header[BINARY_SHEBANG_SIZE], "RUCB", 4);
+	store_little_endian(&header[36], BINARY_VERSION, 2);
+	store_little_endian(&header[38], width, 1);
+	store_little_endian(&header[39], enc->target >= item_int64 && enc->target <= item_int8, 1);
+	store_little_endian(&header[40], BINARY_PAGE_SIZE, 4);
+	store_little_endian(&header[44], BINARY_SECTIONS, 4);
+	store_little_endian(&header[48], (uint64_t)enc->max_global_displ, 8);
+
+	size_t sizes[BINARY_SECTIONS];
+	size_t offset = BINARY_PAGE_SIZE;
+	for (size_t i = 0; i < BINARY_SECTIONS; i++)
+	{
+		sizes[i] = tables[i] != NULL ? vector_size(tables[i]) * width : names_size;
+		const size_t records = tables[i] != NULL ? vector_size(tables[i]) : names_amount;
+
+		store_little_endian(&header[BINARY_SECTIONS_TABLE + 24 * i], offset, 8);
+		store_little_endian(&header[BINARY_SECTIONS_TABLE + 24 * i + 8], sizes[i], 8);
+		store_little_endian(&header[BINARY_SECTIONS_TABLE + 24 * i + 16], records, 8);
+		offset += (sizes[i] + BINARY_PAGE_SIZE - 1) / BINARY_PAGE_SIZE * BINARY_PAGE_SIZE;
+	}
+
+	int ret = names == NULL || uni_write(enc->sx->io, header, BINARY_PAGE_SIZE) != BINARY_PAGE_SIZE ? -1 : 0;
+	for (size_t i = 0; i < BINARY_SECTIONS && !ret; i++)
+	{
+		// Секции выравниваются на границу страницы, чтобы их можно было отобразить в память
+		const size_t aligned = (sizes[i] + BINARY_PAGE_SIZE - 1) / BINARY_PAGE_SIZE * BINARY_PAGE_SIZE;
+		uint8_t *const buffer = calloc(aligned + 1, sizeof(uint8_t));
+		if (buffer == NULL)
+		{
+			ret = -1;
+			break;
+		}
+
+		if (tables[i] != NULL)
+		{
+			ret = pack_table(enc, tables[i], buffer);
+		}
+		else
+		{
+			memcpy(buffer, names, names_size);
+		}
+
+		if (!ret && uni_write(enc->sx->io, buffer, aligned) != aligned)
+		{
+			ret = -1;
+		}
+		free(buffer);
+	}
+
+	vector_clear(&identifiers);
+	vector_clear(&offsets);
+	free(names);
+	return ret;
+}
+
 /**
  *	Free allocated memory
  *
@@ -389,10 +667,13 @@ static void enc_clear(encoder *const enc)
 {
 	vector_clear(&enc->memory);
 	vector_clear(&enc->iniprocs);
+	vector_clear(&enc->literals);
 	vector_clear(&enc->identifiers);
 	vector_clear(&enc->representations);
 	vector_clear(&enc->displacements);
 	vector_clear(&enc->functions);
+	vector_clear(&enc->cases);
+	vector_clear(&enc->counters);
 }
 
 /**
@@ -498,7 +779,7 @@ static lvalue emit_subscript_lvalue(encoder *const enc, const node *const nd)
 	const node index = expression_subscript_get_index(nd);
 	emit_expression(enc, &index);
 
-	mem_add(enc, IC_SLICE);
+	mem_add(enc, expression_subscript_is_unchecked(nd) && enc->has_extended_codes ? IC_SLICE_UNCHECKED : IC_SLICE);
 
 	const item_t type = expression_get_type(nd);
 	mem_add(enc, (item_t)type_size(enc->sx, type));
@@ -625,6 +906,33 @@ static lvalue emit_lvalue(encoder *const enc, const node *const nd)
 }
 
 
+/**
+ *	Emit string literal, which is placed in codes
+ *
+ *	@param	enc			Encoder
+ *	@param	string		String in UTF-8
+ */
+static void emit_string(encoder *const enc, const char *const string)
+{
+	vector_add(&enc->literals, (item_t)mem_size(enc));
+	mem_add(enc, IC_LI);
+	const size_t reserved = mem_size(enc) + 4;
+	mem_add(enc, (item_t)reserved);
+	mem_add(enc, IC_B);
+	mem_increase(enc, 2);
+
+
+	item_t length = 0;
+	for (size_t i = 0; string[i] != '\0'; i += utf8_symbol_size(string[i]))
+	{
+		mem_add(enc, utf8_convert(&string[i]));
+		length++;
+	}
+
+	mem_set(enc, reserved - 1, length);
+	mem_set(enc, reserved - 2, (item_t)mem_size(enc));
+}
+
 /**
  *	Emit literal expression
  *
@@ -685,24 +993,7 @@ static void emit_literal_expression(encoder *const enc, const node *const nd)
 		{
 			// Это может быть только строка
 			const size_t string_num = expression_literal_get_string(nd);
-			const char *const string = string_get(enc->sx, string_num);
-
-			mem_add(enc, IC_LI);
-			const size_t reserved = mem_size(enc) + 4;
-			mem_add(enc, (item_t)reserved);
-			mem_add(enc, IC_B);
-			mem_increase(enc, 2);
-
-
-			item_t length = 0;
-			for (size_t i = 0; string[i] != '\0'; i += utf8_symbol_size(string[i]))
-			{
-				mem_add(enc, utf8_convert(&string[i]));
-				length++;
-			}
-
-			mem_set(enc, reserved - 1, length);
-			mem_set(enc, reserved - 2, (item_t)mem_size(enc));
+			emit_string(enc, string_get(enc->sx, string_num));
 			return;
 		}
 
@@ -730,6 +1021,7 @@ static void emit_argument(encoder *const enc, const node *const nd)
 	}
 	else if (expression_get_class(nd) == EXPR_INITIALIZER)
 	{
+		vector_add(&enc->literals, (item_t)mem_size(enc));
 		mem_add(enc, IC_LI);
 		const size_t reserved = mem_size(enc) + 4;
 		mem_add(enc, (item_t)reserved);
@@ -1595,6 +1887,7 @@ static void emit_function_definition(encoder *const enc, const node *const nd)
 	const size_t jump_addr = mem_reserve(enc);
 
 	const node function_body = declaration_function_get_body(nd);
+	emit_counter(enc, &function_body, COUNTER_FUNCTION);
 	emit_statement(enc, &function_body);
 	mem_add(enc, IC_RETURN_VOID);
 
@@ -1665,19 +1958,8 @@ static void emit_declaration_statement(encoder *const enc, const node *const nd)
  */
 static void emit_case_statement(encoder *const enc, const node *const nd)
 {
-	if (enc->addr_case != 0)
-	{
-		mem_set(enc, enc->addr_case, (item_t)mem_size(enc));
-	}
-
-	mem_add(enc, IC_DUPLICATE);
-
-	const node expr = statement_case_get_expression(nd);
-	emit_expression(enc, &expr);
-
-	mem_add(enc, IC_EQ);
-	mem_add(enc, IC_BE0);
-	enc->addr_case = mem_reserve(enc);
+	addr_end_chain(enc, (size_t)vector_get(&enc->cases, enc->curr_case));
+	vector_set(&enc->cases, enc->curr_case++, 0);
 
 	const node substmt = statement_case_get_substmt(nd);
 	emit_statement(enc, &substmt);
@@ -1691,11 +1973,8 @@ static void emit_case_statement(encoder *const enc, const node *const nd)
  */
 static void emit_default_statement(encoder *const enc, const node *const nd)
 {
-	if (enc->addr_case != 0)
-	{
-		mem_set(enc, enc->addr_case, (item_t)mem_size(enc));
-	}
-	enc->addr_case = 0;
+	addr_end_chain(enc, enc->addr_default);
+	enc->addr_default = 0;
 
 	const node substmt = statement_default_get_substmt(nd);
 	emit_statement(enc, &substmt);
@@ -1752,116 +2031,432 @@ static void emit_if_statement(encoder *const enc, const node *const nd)
 }
 
 /**
- *	Emit switch statement
+ *	Collect case operators of switch statement
  *
  *	@param	enc			Encoder
- *	@param	nd			Node in AST
+ *	@param	nd			Statement
+ *	@param	values		Case values
+ *
+ *	@return	@c true if all case expressions are integer literals
  */
-static void emit_switch_statement(encoder *const enc, const node *const nd)
+static bool collect_cases(encoder *const enc, const node *const nd, vector *const values)
 {
-	const size_t old_addr_break = enc->addr_break;
-	const size_t old_addr_case = enc->addr_case;
-	enc->addr_break = 0;
-	enc->addr_case = 0;
+	switch (node_get_type(nd))
+	{
+		case OP_SWITCH:
+			return true;
 
-	const node condition = statement_switch_get_condition(nd);
-	emit_expression(enc, &condition);
+		case OP_CASE:
+		{
+			vector_add(&enc->cases, 0);
 
-	const node body = statement_switch_get_body(nd);
-	emit_statement(enc, &body);
+			const node expr = statement_case_get_expression(nd);
+			const bool is_literal = expression_get_class(&expr) == EXPR_LITERAL;
+			vector_add(values, is_literal ? expression_literal_get_integer(&expr) : 0);
 
-	if (enc->addr_case > 0)
-	{
-		mem_set(enc, enc->addr_case, (item_t)mem_size(enc));
-	}
+			const node substmt = statement_case_get_substmt(nd);
+			return collect_cases(enc, &substmt, values) && is_literal;
+		}
 
-	addr_end_break(enc);
+		default:
+		{
+			bool is_constant = true;
+			const size_t amount = node_get_amount(nd);
+			for (size_t i = 0; i < amount; i++)
+			{
+				const node child = node_get_child(nd, i);
+				is_constant = collect_cases(enc, &child, values) && is_constant;
+			}
 
-	enc->addr_case = old_addr_case;
-	enc->addr_break = old_addr_break;
+			return is_constant;
+		}
+	}
 }
 
 /**
- *	Emit while statement
+ *	Compare case labels by value and then by order in switch
  *
- *	@param	enc			Encoder
- *	@param	nd			Node in AST
+ *	@param	fst			First label
+ *	@param	snd			Second label
+ *
+ *	@return	Comparison result for @c qsort
  */
-static void emit_while_statement(encoder *const enc, const node *const nd)
+static int case_label_compare(const void *const fst, const void *const snd)
 {
-	const size_t old_addr_break = enc->addr_break;
-	const size_t old_addr_cond = enc->addr_cond;
-	const size_t addr = mem_size(enc);
-	enc->addr_cond = addr;
+	const case_label *const lhs = fst;
+	const case_label *const rhs = snd;
 
-	const node condition = statement_while_get_condition(nd);
-	emit_expression(enc, &condition);
+	if (lhs->value != rhs->value)
+	{
+		return lhs->value < rhs->value ? -1 : 1;
+	}
 
-	mem_add(enc, IC_BE0);
-	enc->addr_break = mem_size(enc);
-	mem_add(enc, 0);
+	return lhs->index < rhs->index ? -1 : lhs->index > rhs->index;
+}
 
-	const node body = statement_while_get_body(nd);
-	emit_statement(enc, &body);
+/**
+ *	Emit reference to case operator
+ *
+ *	@param	enc			Encoder
+ *	@param	index		Case operator index
+ */
+static void emit_case_reference(encoder *const enc, const size_t index)
+{
+	mem_add(enc, vector_get(&enc->cases, index));
+	vector_set(&enc->cases, index, (item_t)mem_size(enc) - 1);
+}
 
-	addr_begin_condition(enc, addr);
+/**
+ *	Emit branch to default operator
+ *
+ *	@param	enc			Encoder
+ */
+static void emit_default_branch(encoder *const enc)
+{
 	mem_add(enc, IC_B);
-	mem_add(enc, (item_t)addr);
-	addr_end_break(enc);
-
-	enc->addr_break = old_addr_break;
-	enc->addr_cond = old_addr_cond;
+	mem_add(enc, (item_t)enc->addr_default);
+	enc->addr_default = mem_size(enc) - 1;
 }
 
 /**
- *	Emit do statement
+ *	Emit sequential comparisons of switch value with case expressions
  *
  *	@param	enc			Encoder
- *	@param	nd			Node in AST
+ *	@param	nd			Statement
+ *	@param	displ		Switch value displacement
  */
-static void emit_do_statement(encoder *const enc, const node *const nd)
+static void emit_case_comparisons(encoder *const enc, const node *const nd, const item_t displ)
 {
-	const size_t old_addr_break = enc->addr_break;
-	const size_t old_addr_cond = enc->addr_cond;
-	const item_t addr = (item_t)mem_size(enc);
+	switch (node_get_type(nd))
+	{
+		case OP_SWITCH:
+			return;
 
-	enc->addr_cond = 0;
-	enc->addr_break = 0;
+		case OP_CASE:
+		{
+			mem_add(enc, IC_LOAD);
+			mem_add(enc, displ);
 
-	const node body = statement_do_get_body(nd);
-	emit_statement(enc, &body);
-	addr_end_condition(enc);
+			const node expr = statement_case_get_expression(nd);
+			emit_expression(enc, &expr);
 
-	const node condition = statement_do_get_condition(nd);
-	emit_expression(enc, &condition);
+			mem_add(enc, IC_EQ);
+			mem_add(enc, IC_BNE0);
+			emit_case_reference(enc, enc->curr_case++);
 
-	mem_add(enc, IC_BNE0);
-	mem_add(enc, addr);
-	addr_end_break(enc);
+			const node substmt = statement_case_get_substmt(nd);
+			emit_case_comparisons(enc, &substmt, displ);
+			return;
+		}
 
-	enc->addr_break = old_addr_break;
-	enc->addr_cond = old_addr_cond;
+		default:
+		{
+			const size_t amount = node_get_amount(nd);
+			for (size_t i = 0; i < amount; i++)
+			{
+				const node child = node_get_child(nd, i);
+				emit_case_comparisons(enc, &child, displ);
+			}
+			return;
+		}
+	}
 }
 
 /**
- *	Emit for statement
+ *	Emit jump table for switch value on stack
+ *	@note	Instruction @c IC_SWITCH pops value and jumps to its branch in the following table,
+ *			values out of range jump to the branch after the table
  *
  *	@param	enc			Encoder
- *	@param	nd			Node in AST
+ *	@param	labels		Sorted case labels
+ *	@param	begin		First label
+ *	@param	end			Label after the last one
  */
-static void emit_for_statement(encoder *const enc, const node *const nd)
+static void emit_case_table(encoder *const enc, const case_label *const labels, const size_t begin, const size_t end)
 {
-	const item_t scope_displacement = enc->displ;
-	if (statement_for_has_inition(nd))
-	{
-		const node inition = statement_for_get_inition(nd);
-		emit_statement(enc, &inition);
-	}
+	const item_t low = labels[begin].value;
+	const item_t high = labels[end - 1].value;
 
-	const size_t old_addr_break = enc->addr_break;
-	const size_t old_addr_cond = enc->addr_cond;
-	enc->addr_cond = 0;
-	enc->addr_break = 0;
+	mem_add(enc, IC_SWITCH);
+	mem_add(enc, low);
+	mem_add(enc, high - low + 1);
+
+	size_t i = begin;
+	for (item_t value = low; value <= high; value++)
+	{
+		if (labels[i].value == value)
+		{
+			mem_add(enc, IC_B);
+			emit_case_reference(enc, labels[i++].index);
+		}
+		else
+		{
+			emit_default_branch(enc);
+		}
+	}
+
+	emit_default_branch(enc);
+}
+
+/**
+ *	Emit comparisons of switch value with case labels
+ *
+ *	@param	enc			Encoder
+ *	@param	labels		Sorted case labels
+ *	@param	begin		First label
+ *	@param	end			Label after the last one
+ *	@param	displ		Switch value displacement
+ */
+static void emit_case_labels(encoder *const enc, const case_label *const labels
+	, const size_t begin, const size_t end, const item_t displ)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		mem_add(enc, IC_LOAD);
+		mem_add(enc, displ);
+		mem_add(enc, IC_LI);
+		mem_add(enc, labels[i].value);
+		mem_add(enc, IC_EQ);
+		mem_add(enc, IC_BNE0);
+		emit_case_reference(enc, labels[i].index);
+	}
+
+	emit_default_branch(enc);
+}
+
+/**
+ *	Emit binary search of switch value among clusters of case labels
+ *
+ *	@param	enc			Encoder
+ *	@param	labels		Sorted case labels
+ *	@param	clusters	First labels of clusters
+ *	@param	begin		First cluster
+ *	@param	end			Cluster after the last one
+ *	@param	displ		Switch value displacement
+ */
+static void emit_case_search(encoder *const enc, const case_label *const labels, const vector *const clusters
+	, const size_t begin, const size_t end, const item_t displ)
+{
+	const size_t first = (size_t)vector_get(clusters, begin);
+	const size_t last = (size_t)vector_get(clusters, end);
+
+	if (end - begin == 1 && last - first >= MIN_TABLE_CASES && enc->has_extended_codes)
+	{
+		mem_add(enc, IC_LOAD);
+		mem_add(enc, displ);
+		emit_case_table(enc, labels, first, last);
+		return;
+	}
+
+	if (end - begin == 1 || last - first < MIN_TABLE_CASES)
+	{
+		emit_case_labels(enc, labels, first, last, displ);
+		return;
+	}
+
+	const size_t middle = begin + (end - begin) / 2;
+	mem_add(enc, IC_LOAD);
+	mem_add(enc, displ);
+	mem_add(enc, IC_LI);
+	mem_add(enc, labels[vector_get(clusters, middle)].value);
+	mem_add(enc, IC_LT);
+	mem_add(enc, IC_BNE0);
+	const size_t addr = mem_reserve(enc);
+
+	emit_case_search(enc, labels, clusters, middle, end, displ);
+	mem_set(enc, addr, (item_t)mem_size(enc));
+	emit_case_search(enc, labels, clusters, begin, middle, displ);
+}
+
+/**
+ *	Emit switch statement
+ *	@note	Dense case values are dispatched by jump table, sparse ones by binary search,
+ *			non-constant case expressions are compared sequentially.
+ *			Without flag @c --extended-codes dense values are compared sequentially too
+ *
+ *	@param	enc			Encoder
+ *	@param	nd			Node in AST
+ */
+static void emit_switch_statement(encoder *const enc, const node *const nd)
+{
+	const size_t old_addr_break = enc->addr_break;
+	const size_t old_addr_default = enc->addr_default;
+	const size_t old_curr_case = enc->curr_case;
+	enc->addr_break = 0;
+	enc->addr_default = 0;
+	const size_t first = vector_size(&enc->cases);
+	enc->curr_case = first;
+
+	const node body = statement_switch_get_body(nd);
+	vector values = vector_create(0);
+	const bool is_constant = collect_cases(enc, &body, &values);
+
+	// Метки сортируются по значению, из повторяющихся остается первая
+	const size_t amount = vector_size(&values);
+	case_label *const labels = is_constant ? malloc(amount * sizeof(case_label) + 1) : NULL;
+	vector clusters = vector_create(0);
+	size_t unique = 0;
+	if (labels != NULL)
+	{
+		for (size_t i = 0; i < amount; i++)
+		{
+			labels[i] = (case_label){ .value = vector_get(&values, i), .index = first + i };
+		}
+
+		qsort(labels, amount, sizeof(case_label), &case_label_compare);
+		for (size_t i = 0; i < amount; i++)
+		{
+			if (unique == 0 || labels[unique - 1].value != labels[i].value)
+			{
+				labels[unique++] = labels[i];
+			}
+		}
+
+		// Кластер продолжается, пока таблица переходов заполнена хотя бы наполовину
+		for (size_t i = 0; i < unique;)
+		{
+			vector_add(&clusters, (item_t)i);
+
+			size_t j = i + 1;
+			while (j < unique && (size_t)(labels[j].value - labels[i].value) < 2 * (j - i + 1))
+			{
+				j++;
+			}
+			i = j;
+		}
+		vector_add(&clusters, (item_t)unique);
+	}
+
+	const node condition = statement_switch_get_condition(nd);
+	emit_expression(enc, &condition);
+
+	// Таблицу переходов исполняет только встроенная виртуальная машина
+	if (labels != NULL && vector_size(&clusters) == 2 && unique >= MIN_TABLE_CASES && enc->has_extended_codes)
+	{
+		emit_case_table(enc, labels, 0, unique);
+	}
+	else
+	{
+		// Значение сохраняется во временной переменной на время выбора ветви
+		const item_t displ = enc->displ;
+		enc->max_local_displ = max(displ + 1, enc->max_local_displ);
+		mem_add(enc, IC_ASSIGN_V);
+		mem_add(enc, displ);
+
+		if (labels == NULL)
+		{
+			emit_case_comparisons(enc, &body, displ);
+			enc->curr_case = first;
+			emit_default_branch(enc);
+		}
+		else if (unique == 0)
+		{
+			emit_default_branch(enc);
+		}
+		else
+		{
+			emit_case_search(enc, labels, &clusters, 0, vector_size(&clusters) - 1, displ);
+		}
+	}
+
+	free(labels);
+	vector_clear(&clusters);
+	vector_clear(&values);
+
+	emit_statement(enc, &body);
+
+	addr_end_chain(enc, enc->addr_default);
+	addr_end_break(enc);
+
+	vector_resize(&enc->cases, first);
+	enc->curr_case = old_curr_case;
+	enc->addr_default = old_addr_default;
+	enc->addr_break = old_addr_break;
+}
+
+/**
+ *	Emit while statement
+ *
+ *	@param	enc			Encoder
+ *	@param	nd			Node in AST
+ */
+static void emit_while_statement(encoder *const enc, const node *const nd)
+{
+	const size_t old_addr_break = enc->addr_break;
+	const size_t old_addr_cond = enc->addr_cond;
+	const size_t addr = mem_size(enc);
+	enc->addr_cond = addr;
+
+	const node condition = statement_while_get_condition(nd);
+	emit_expression(enc, &condition);
+
+	mem_add(enc, IC_BE0);
+	enc->addr_break = mem_size(enc);
+	mem_add(enc, 0);
+	emit_counter(enc, nd, COUNTER_LOOP);
+
+	const node body = statement_while_get_body(nd);
+	emit_statement(enc, &body);
+
+	addr_begin_condition(enc, addr);
+	mem_add(enc, IC_B);
+	mem_add(enc, (item_t)addr);
+	addr_end_break(enc);
+
+	enc->addr_break = old_addr_break;
+	enc->addr_cond = old_addr_cond;
+}
+
+/**
+ *	Emit do statement
+ *
+ *	@param	enc			Encoder
+ *	@param	nd			Node in AST
+ */
+static void emit_do_statement(encoder *const enc, const node *const nd)
+{
+	const size_t old_addr_break = enc->addr_break;
+	const size_t old_addr_cond = enc->addr_cond;
+	const item_t addr = (item_t)mem_size(enc);
+
+	enc->addr_cond = 0;
+	enc->addr_break = 0;
+	emit_counter(enc, nd, COUNTER_LOOP);
+
+	const node body = statement_do_get_body(nd);
+	emit_statement(enc, &body);
+	addr_end_condition(enc);
+
+	const node condition = statement_do_get_condition(nd);
+	emit_expression(enc, &condition);
+
+	mem_add(enc, IC_BNE0);
+	mem_add(enc, addr);
+	addr_end_break(enc);
+
+	enc->addr_break = old_addr_break;
+	enc->addr_cond = old_addr_cond;
+}
+
+/**
+ *	Emit for statement
+ *
+ *	@param	enc			Encoder
+ *	@param	nd			Node in AST
+ */
+static void emit_for_statement(encoder *const enc, const node *const nd)
+{
+	const item_t scope_displacement = enc->displ;
+	if (statement_for_has_inition(nd))
+	{
+		const node inition = statement_for_get_inition(nd);
+		emit_statement(enc, &inition);
+	}
+
+	const size_t old_addr_break = enc->addr_break;
+	const size_t old_addr_cond = enc->addr_cond;
+	enc->addr_cond = 0;
+	enc->addr_break = 0;
 
 	const size_t addr_init = mem_size(enc);
 	if (statement_for_has_condition(nd))
@@ -1873,6 +2468,7 @@ static void emit_for_statement(encoder *const enc, const node *const nd)
 		enc->addr_break = mem_size(enc);
 		mem_add(enc, 0);
 	}
+	emit_counter(enc, nd, COUNTER_LOOP);
 
 	const node body = statement_for_get_body(nd);
 	emit_statement(enc, &body);
@@ -2008,6 +2604,59 @@ static void emit_statement(encoder *const enc, const node *const nd)
 	}
 }
 
+/**
+ *	Emit printing of profiling counters
+ *
+ *	@param	enc			Encoder
+ */
+static void emit_profile(encoder *const enc)
+{
+	const size_t amount = vector_size(&enc->counters) / 4;
+	if (amount == 0)
+	{
+		return;
+	}
+
+	// Последняя строка программы может быть без перевода строки, отчёт начинается с новой
+	emit_string(enc, PROFILE_SEPARATOR);
+	mem_add(enc, IC_PRINTF);
+	mem_add(enc, 0);
+
+	const item_t format = -enc->max_global_displ;
+	enc->max_global_displ++;
+	emit_string(enc, PROFILE_FORMAT);
+	mem_add(enc, IC_ASSIGN_V);
+	mem_add(enc, format);
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		mem_add(enc, IC_LI);
+		mem_add(enc, (item_t)i);
+		mem_add(enc, IC_LOAD);
+		mem_add(enc, vector_get(&enc->counters, 4 * i));
+		mem_add(enc, IC_LOAD);
+		mem_add(enc, format);
+		mem_add(enc, IC_PRINTF);
+		mem_add(enc, 2);
+	}
+}
+
+/**
+ *	Emit call of main function and program end
+ *
+ *	@param	enc			Encoder
+ */
+static void emit_entry_point(encoder *const enc)
+{
+	const item_t main_displ = displacements_get(enc, enc->sx->ref_main);
+
+	mem_add(enc, IC_CALL1);
+	mem_add(enc, IC_CALL2);
+	mem_add(enc, main_displ);
+	emit_profile(enc);
+	mem_add(enc, IC_STOP);
+}
+
 /**
  *	Emit translation unit
  *
@@ -2023,44 +2672,1200 @@ static void emit_translation_unit(encoder *const enc, const node *const nd)
 		emit_declaration(enc, &decl);
 	}
 
-	const item_t main_displ = displacements_get(enc, enc->sx->ref_main);
+	emit_entry_point(enc);
+}
 
-	mem_add(enc, IC_CALL1);
-	mem_add(enc, IC_CALL2);
-	mem_add(enc, main_displ);
-	mem_add(enc, IC_STOP);
+/**
+ *	Emit external declaration just after its parsing
+ *
+ *	@param	context		Encoder
+ *	@param	nd			Node in AST
+ *
+ *	@return	@c 0 on success
+ */
+static int emit_external_declaration(void *const context, const node *const nd)
+{
+	encoder *const enc = context;
+
+	// Таблицы растут вместе с разбором, поэтому соответствия расширяются перед каждым объявлением
+	vector_increase(&enc->displacements, vector_size(&enc->sx->identifiers) - vector_size(&enc->displacements));
+	vector_increase(&enc->iniprocs, vector_size(&enc->sx->types) - vector_size(&enc->iniprocs));
+
+	emit_declaration(enc, nd);
+	return 0;
 }
 
 
-/*
- *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
- *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
- *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
- *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
- *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
- */
 
 
-int encode_to_vm(const workspace *const ws, syntax *const sx)
+
+static inline size_t unit_get_start(const peephole *const ph, const size_t unit)
 {
-	if (!ws_is_correct(ws) || sx == NULL)
-	{
-		return -1;
-	}
+	return (size_t)vector_get(&ph->starts, unit);
+}
 
-	encoder enc = enc_create(ws, sx);
+static inline size_t unit_get_size(const peephole *const ph, const size_t unit)
+{
+	return unit_get_start(ph, unit + 1) - unit_get_start(ph, unit);
+}
 
-	const node root = node_get_root(&sx->tree);
-	emit_translation_unit(&enc, &root);
+static inline instruction_t unit_get_instruction(const peephole *const ph, const size_t unit)
+{
+	return (instruction_t)mem_get(ph->enc, unit_get_start(ph, unit));
+}
 
-#ifndef NDEBUG
-	write_codes(DEFAULT_CODES, &enc.memory);
-#endif
+static inline item_t unit_get_operand(const peephole *const ph, const size_t unit, const size_t index)
+{
+	return mem_get(ph->enc, unit_get_start(ph, unit) + 1 + index);
+}
+
+static inline bool unit_has_mark(const peephole *const ph, const size_t unit, const item_t mark)
+{
+	return (vector_get(&ph->marks, unit_get_start(ph, unit)) & mark) != 0;
+}
+
+static inline size_t unit_get_amount(const peephole *const ph)
+{
+	return vector_size(&ph->starts) - 1;
+}
+
+static inline size_t address_get_unit(const peephole *const ph, const size_t address)
+{
+	return (size_t)vector_get(&ph->indices, address);
+}
+
+static inline bool address_has_mark(const peephole *const ph, const size_t address, const item_t mark)
+{
+	return address < vector_size(&ph->marks) && (vector_get(&ph->marks, address) & mark) != 0;
+}
+
+static inline void code_add(peephole *const ph, const item_t value)
+{
+	vector_add(&ph->code, value);
+}
+
+static inline void code_add_reference(peephole *const ph, const item_t address)
+{
+	vector_add(&ph->relocs, (item_t)vector_size(&ph->code));
+	vector_add(&ph->code, address);
+}
+
+
+/**
+ *	Get index of operand which refers to code address
+ *
+ *	@param	instruction	Instruction
+ *
+ *	@return	Operand index, @c SIZE_MAX if instruction has no such operand
+ */
+static size_t instruction_get_reference(const instruction_t instruction)
+{
+	switch (instruction)
+	{
+		case IC_B:
+		case IC_BE0:
+		case IC_BNE0:
+			return 0;
+
+		case IC_FUNC_BEG:
+		case IC_STRUCT_WITH_ARR:
+			return 1;
+
+		case IC_DEFARR:
+			return 3;
+
+		default:
+			return SIZE_MAX;
+	}
+}
+
+/**
+ *	Get amount of values popped by instruction without side effects
+ *	@note	Such instruction always pushes one value
+ *
+ *	@param	instruction	Instruction
+ *
+ *	@return	Amount of popped values, @c -1 if instruction has side effects
+ */
+static int instruction_get_pops(const instruction_t instruction)
+{
+	switch (instruction)
+	{
+		case IC_LI:
+		case IC_LID:
+		case IC_LOAD:
+		case IC_LOADD:
+		case IC_LA:
+			return 0;
+
+		case IC_LAT:
+		case IC_LATD:
+		case IC_SELECT:
+		case IC_WIDEN:
+		case IC_UNMINUS:
+		case IC_UNMINUS_R:
+		case IC_NOT:
+		case IC_LOG_NOT:
+			return 1;
+
+		case IC_SLICE:
+		case IC_SLICE_UNCHECKED:
+		case IC_ADD:
+		case IC_SUB:
+		case IC_MUL:
+		case IC_SHL:
+		case IC_SHR:
+		case IC_AND:
+		case IC_XOR:
+		case IC_OR:
+		case IC_EQ:
+		case IC_NE:
+		case IC_LT:
+		case IC_GT:
+		case IC_LE:
+		case IC_GE:
+		case IC_ADD_R:
+		case IC_SUB_R:
+		case IC_MUL_R:
+		case IC_EQ_R:
+		case IC_NE_R:
+		case IC_LT_R:
+		case IC_GT_R:
+		case IC_LE_R:
+		case IC_GE_R:
+			return 2;
+
+		default:
+			return -1;
+	}
+}
+
+/**
+ *	Convert binary operation to corresponding compound assignment to variable
+ *
+ *	@param	instruction	Binary operation
+ *
+ *	@return	Compound assignment, @c IC_NOP if there is no such one
+ */
+static instruction_t instruction_to_assignment(const instruction_t instruction)
+{
+	switch (instruction)
+	{
+		case IC_REM:				return IC_REM_ASSIGN;
+		case IC_SHL:				return IC_SHL_ASSIGN;
+		case IC_SHR:				return IC_SHR_ASSIGN;
+		case IC_AND:				return IC_AND_ASSIGN;
+		case IC_XOR:				return IC_XOR_ASSIGN;
+		case IC_OR:					return IC_OR_ASSIGN;
+		case IC_ADD:				return IC_ADD_ASSIGN;
+		case IC_SUB:				return IC_SUB_ASSIGN;
+		case IC_MUL:				return IC_MUL_ASSIGN;
+		case IC_DIV:				return IC_DIV_ASSIGN;
+		case IC_ADD_R:				return IC_ADD_ASSIGN_R;
+		case IC_SUB_R:				return IC_SUB_ASSIGN_R;
+		case IC_MUL_R:				return IC_MUL_ASSIGN_R;
+		case IC_DIV_R:				return IC_DIV_ASSIGN_R;
+
+		default:
+			return IC_NOP;
+	}
+}
+
+static inline bool instruction_is_commutative(const instruction_t instruction)
+{
+	return instruction == IC_ADD || instruction == IC_MUL || instruction == IC_AND
+		|| instruction == IC_XOR || instruction == IC_OR
+		|| instruction == IC_ADD_R || instruction == IC_MUL_R;
+}
+
+static inline bool instruction_is_floating(const instruction_t instruction)
+{
+	return (instruction >= IC_ASSIGN_R && instruction <= IC_UNMINUS_R)
+		|| (instruction >= IC_ASSIGN_R_V && instruction <= IC_PRE_DEC_AT_R_V);
+}
+
+/**
+ *	Get simple assignment, which corresponds to the store instruction
+ *
+ *	@param	instruction	Instruction
+ *	@param	is_address	Set if assignment is by address
+ *	@param	is_void		Set if assignment does not leave value on stack
+ *
+ *	@return	@c true if instruction is simple assignment
+ */
+static bool instruction_is_assignment(const instruction_t instruction, bool *const is_address, bool *const is_void)
+{
+	switch (instruction)
+	{
+		case IC_ASSIGN:
+		case IC_ASSIGN_R:
+			*is_address = false;
+			*is_void = false;
+			return true;
+
+		case IC_ASSIGN_V:
+		case IC_ASSIGN_R_V:
+			*is_address = false;
+			*is_void = true;
+			return true;
+
+		case IC_ASSIGN_AT:
+		case IC_ASSIGN_AT_R:
+			*is_address = true;
+			*is_void = false;
+			return true;
+
+		case IC_ASSIGN_AT_V:
+		case IC_ASSIGN_AT_R_V:
+			*is_address = true;
+			*is_void = true;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+
+/**
+ *	Split memory into instructions
+ *
+ *	@param	ph			Peephole optimizer
+ *
+ *	@return	@c true on success, @c false if memory contains unknown codes
+ */
+static bool peephole_decode(peephole *const ph)
+{
+	const encoder *const enc = ph->enc;
+	const size_t size = mem_size(enc);
+
+	item_t buffer[8];
+	const size_t double_size = item_store_double_for_target(enc->target, 0, buffer);
+
+	vector_resize(&ph->marks, 0);
+	vector_resize(&ph->marks, size + 1);
+	vector_resize(&ph->indices, 0);
+	vector_resize(&ph->indices, size + 1);
+	vector_resize(&ph->starts, 0);
+
+	size_t literal = 0;
+	size_t pc = CODE_START;
+	while (pc < size)
+	{
+		vector_set(&ph->indices, pc, (item_t)vector_add(&ph->starts, (item_t)pc));
+
+		const instruction_t instruction = (instruction_t)mem_get(enc, pc);
+		if (literal < vector_size(&enc->literals) && (size_t)vector_get(&enc->literals, literal) == pc)
+		{
+			// Литерал размещается в коде: LI адрес, B конец, длина, данные
+			vector_set(&ph->marks, pc, MARK_START | MARK_LITERAL);
+			const size_t end = (size_t)mem_get(enc, pc + 3);
+			if (end <= pc + 4)
+			{
+				return false;
+			}
+
+			pc = end;
+			literal++;
+		}
+		else if ((instruction >= IC_GETID && instruction <= IC_PRINTID)
+			|| (instruction > MIN_INSTRUCTION_CODE && instruction < MAX_INSTRUCTION_CODE))
+		{
+			vector_set(&ph->marks, pc, MARK_START);
+			pc += 1 + (instruction == IC_LID ? double_size : instruction_get_operands_amount(instruction));
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	vector_add(&ph->starts, (item_t)size);
+	vector_set(&ph->indices, size, (item_t)unit_get_amount(ph));
+	vector_set(&ph->marks, size, MARK_START);
+	return pc == size && literal == vector_size(&enc->literals);
+}
+
+/**
+ *	Get final target of branch chain
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	target		Branch target
+ *
+ *	@return	Final target
+ */
+static item_t peephole_follow(const peephole *const ph, item_t target)
+{
+	for (size_t i = 0; i < MAX_PATTERN_SIZE; i++)
+	{
+		if (address_has_mark(ph, (size_t)target, MARK_LITERAL) || mem_get(ph->enc, (size_t)target) != IC_B)
+		{
+			break;
+		}
+
+		const item_t next = mem_get(ph->enc, (size_t)target + 1);
+		if (next == target)
+		{
+			break;
+		}
+
+		target = next;
+	}
+
+	return target;
+}
+
+/**
+ *	Thread branches and mark all addresses referred from code and tables
+ *
+ *	@param	ph			Peephole optimizer
+ *
+ *	@return	@c true on success, @c false if some reference is incorrect
+ */
+static bool peephole_mark_labels(peephole *const ph)
+{
+	encoder *const enc = ph->enc;
+	const size_t amount = unit_get_amount(ph);
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const size_t index = instruction_get_reference(unit_get_instruction(ph, i));
+		if (unit_has_mark(ph, i, MARK_LITERAL) || index == SIZE_MAX)
+		{
+			continue;
+		}
+
+		const item_t target = unit_get_operand(ph, i, index);
+		if (target != 0 && (target < 0 || !address_has_mark(ph, (size_t)target, MARK_START)))
+		{
+			return false;
+		}
+	}
+
+	const size_t functions = vector_size(&enc->functions);
+	for (size_t i = 0; i < functions; i++)
+	{
+		const item_t address = vector_get(&enc->functions, i);
+		if (address != 0 && (address < 0 || !address_has_mark(ph, (size_t)address, MARK_START)))
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const instruction_t instruction = unit_get_instruction(ph, i);
+		const size_t index = instruction_get_reference(instruction);
+		if (unit_has_mark(ph, i, MARK_LITERAL) || index == SIZE_MAX || unit_get_operand(ph, i, index) == 0)
+		{
+			continue;
+		}
+
+		const size_t address = unit_get_start(ph, i) + 1 + index;
+		item_t target = mem_get(enc, address);
+		if (instruction == IC_B || instruction == IC_BE0 || instruction == IC_BNE0)
+		{
+			target = peephole_follow(ph, target);
+			mem_set(enc, address, target);
+		}
+
+		vector_set(&ph->marks, (size_t)target, vector_get(&ph->marks, (size_t)target) | MARK_LABEL);
+	}
+
+	for (size_t i = 0; i < functions; i++)
+	{
+		const item_t address = vector_get(&enc->functions, i);
+		if (address != 0)
+		{
+			vector_set(&ph->marks, (size_t)address, vector_get(&ph->marks, (size_t)address) | MARK_LABEL);
+		}
+	}
+
+	// Ветви таблицы переходов адресуются по смещению и не изменяются
+	for (size_t i = 0; i < amount; i++)
+	{
+		if (unit_has_mark(ph, i, MARK_LITERAL) || unit_get_instruction(ph, i) != IC_SWITCH)
+		{
+			continue;
+		}
+
+		const item_t size = unit_get_operand(ph, i, 1);
+		if (size < 0 || i + (size_t)size >= amount)
+		{
+			return false;
+		}
+
+		for (size_t j = i + 1; j <= i + (size_t)size; j++)
+		{
+			if (unit_has_mark(ph, j, MARK_LITERAL) || unit_get_instruction(ph, j) != IC_B)
+			{
+				return false;
+			}
+
+			vector_set(&ph->marks, unit_get_start(ph, j), vector_get(&ph->marks, unit_get_start(ph, j)) | MARK_LABEL | MARK_TABLE);
+		}
+
+		const size_t next = unit_get_start(ph, i + (size_t)size + 1);
+		vector_set(&ph->marks, next, vector_get(&ph->marks, next) | MARK_LABEL);
+	}
+
+	vector_set(&ph->marks, CODE_START, vector_get(&ph->marks, CODE_START) | MARK_LABEL);
+	return true;
+}
+
+/**
+ *	Check that some of instructions are branch targets
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	begin		First instruction
+ *	@param	end			Instruction after the last one
+ *
+ *	@return	@c true if some instruction is a branch target
+ */
+static bool peephole_has_labels(const peephole *const ph, const size_t begin, const size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		if (unit_has_mark(ph, i, MARK_LABEL))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Check that instructions compute the same values
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	fst			First instruction of the first sequence
+ *	@param	snd			First instruction of the second sequence
+ *	@param	amount		Amount of instructions
+ *
+ *	@return	@c true on equal sequences
+ */
+static bool peephole_is_equal(const peephole *const ph, const size_t fst, const size_t snd, const size_t amount)
+{
+	if (snd + amount > unit_get_amount(ph))
+	{
+		return false;
+	}
+
+	const size_t size = unit_get_start(ph, fst + amount) - unit_get_start(ph, fst);
+	if (unit_get_start(ph, snd + amount) - unit_get_start(ph, snd) != size)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		if (mem_get(ph->enc, unit_get_start(ph, fst) + i) != mem_get(ph->enc, unit_get_start(ph, snd) + i))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *	Find the end of expression without side effects
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	begin		First instruction of expression
+ *	@param	end			Previous end of expression, @c begin for the first one
+ *
+ *	@return	Instruction after the next possible end of expression, @c SIZE_MAX if there is no such one
+ */
+static size_t peephole_skip_expression(const peephole *const ph, const size_t begin, size_t end)
+{
+	size_t depth = end == begin ? 0 : 1;
+	const size_t amount = unit_get_amount(ph);
+
+	while (end < amount && end - begin < MAX_PATTERN_SIZE && !unit_has_mark(ph, end, MARK_LITERAL)
+		&& (end == begin || !unit_has_mark(ph, end, MARK_LABEL)))
+	{
+		const int pops = instruction_get_pops(unit_get_instruction(ph, end));
+		if (pops < 0 || (size_t)pops > depth)
+		{
+			return SIZE_MAX;
+		}
+
+		depth = depth - (size_t)pops + 1;
+		end++;
+
+		if (depth == 1)
+		{
+			return end;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/**
+ *	Check that expression may be safely deleted and does not read the variable
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	begin		First instruction of expression
+ *	@param	end			Instruction after expression
+ *	@param	displ		Variable displacement
+ *
+ *	@return	@c true if expression does not depend on the variable
+ */
+static bool peephole_is_independent(const peephole *const ph, const size_t begin, const size_t end, const item_t displ)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		const instruction_t instruction = unit_get_instruction(ph, i);
+		if (instruction == IC_LAT || instruction == IC_LATD
+			|| instruction == IC_SLICE || instruction == IC_SLICE_UNCHECKED
+			|| ((instruction == IC_LOAD || instruction == IC_LOADD) && unit_get_operand(ph, i, 0) == displ))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ *	Copy instruction to optimized codes
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Instruction
+ */
+static void peephole_copy(peephole *const ph, const size_t unit)
+{
+	const size_t start = unit_get_start(ph, unit);
+	const size_t size = unit_get_size(ph, unit);
+	const item_t address = (item_t)vector_size(&ph->code);
+
+	if (unit_has_mark(ph, unit, MARK_LITERAL))
+	{
+		code_add(ph, IC_LI);
+		code_add(ph, address + mem_get(ph->enc, start + 1) - (item_t)start);
+		code_add(ph, IC_B);
+		code_add(ph, address + (item_t)size);
+
+		for (size_t i = 4; i < size; i++)
+		{
+			code_add(ph, mem_get(ph->enc, start + i));
+		}
+		return;
+	}
+
+	const size_t index = instruction_get_reference(unit_get_instruction(ph, unit));
+	for (size_t i = 0; i < size; i++)
+	{
+		const item_t value = mem_get(ph->enc, start + i);
+		if (index != SIZE_MAX && i == index + 1 && value != 0)
+		{
+			code_add_reference(ph, value);
+		}
+		else
+		{
+			code_add(ph, value);
+		}
+	}
+}
+
+/**
+ *	Copy sequence of instructions to optimized codes
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	begin		First instruction
+ *	@param	end			Instruction after the last one
+ */
+static void peephole_copy_sequence(peephole *const ph, const size_t begin, const size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		vector_set(&ph->map, unit_get_start(ph, i), (item_t)vector_size(&ph->code));
+		peephole_copy(ph, i);
+	}
+}
+
+/**
+ *	Optimize unconditional branch
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Branch instruction
+ */
+static void peephole_branch(peephole *const ph, const size_t unit)
+{
+	const size_t target = (size_t)unit_get_operand(ph, unit, 0);
+	const size_t target_unit = address_get_unit(ph, target);
+	ph->is_reachable = false;
+
+	// Переход вперед через недостижимый код не нужен
+	if (target > unit_get_start(ph, unit) && !peephole_has_labels(ph, unit + 1, target_unit))
+	{
+		return;
+	}
+
+	if (target_unit < unit_get_amount(ph) && !unit_has_mark(ph, target_unit, MARK_LITERAL))
+	{
+		const instruction_t instruction = unit_get_instruction(ph, target_unit);
+		if (instruction == IC_RETURN_VOID || instruction == IC_RETURN_VAL || instruction == IC_STOP)
+		{
+			peephole_copy(ph, target_unit);
+			return;
+		}
+	}
+
+	peephole_copy(ph, unit);
+}
+
+/**
+ *	Optimize conditional branch over unconditional one
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Conditional branch instruction
+ *
+ *	@return	Amount of replaced instructions
+ */
+static size_t peephole_conditional_branch(peephole *const ph, const size_t unit)
+{
+	const size_t next = unit + 1;
+	if (next >= unit_get_amount(ph) || unit_has_mark(ph, next, MARK_LABEL | MARK_LITERAL)
+		|| unit_get_instruction(ph, next) != IC_B
+		|| (size_t)unit_get_operand(ph, unit, 0) != unit_get_start(ph, next + 1))
+	{
+		return 0;
+	}
+
+	code_add(ph, unit_get_instruction(ph, unit) == IC_BE0 ? IC_BNE0 : IC_BE0);
+	code_add_reference(ph, unit_get_operand(ph, next, 0));
+	return 2;
+}
+
+/**
+ *	Replace store to variable with subsequent load of the same variable by assignment
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Store instruction
+ *
+ *	@return	Amount of replaced instructions
+ */
+static size_t peephole_store(peephole *const ph, const size_t unit)
+{
+	const size_t next = unit + 1;
+	if (next >= unit_get_amount(ph) || unit_has_mark(ph, next, MARK_LABEL | MARK_LITERAL))
+	{
+		return 0;
+	}
+
+	const instruction_t instruction = unit_get_instruction(ph, unit);
+	const instruction_t load = instruction_is_floating(instruction) ? IC_LOADD : IC_LOAD;
+	if (unit_get_instruction(ph, next) != load || unit_get_operand(ph, next, 0) != unit_get_operand(ph, unit, 0))
+	{
+		return 0;
+	}
+
+	instruction_t result = (instruction_t)(instruction - (IC_ASSIGN_V - IC_ASSIGN));
+	if (result == IC_POST_INC || result == IC_POST_DEC || result == IC_POST_INC_R || result == IC_POST_DEC_R)
+	{
+		result = (instruction_t)(result + (IC_PRE_INC - IC_POST_INC));
+	}
+
+	code_add(ph, result);
+	code_add(ph, unit_get_operand(ph, unit, 0));
+	return 2;
+}
+
+/**
+ *	Replace addition or subtraction of one by increment
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Load of constant
+ *
+ *	@return	Amount of replaced instructions
+ */
+static size_t peephole_increment(peephole *const ph, const size_t unit)
+{
+	const size_t next = unit + 1;
+	if (unit_get_operand(ph, unit, 0) != 1 || next >= unit_get_amount(ph)
+		|| unit_has_mark(ph, next, MARK_LABEL | MARK_LITERAL))
+	{
+		return 0;
+	}
+
+	const instruction_t instruction = unit_get_instruction(ph, next);
+	instruction_t result = IC_NOP;
+	switch (instruction)
+	{
+		case IC_ADD_ASSIGN:			result = IC_PRE_INC;		break;
+		case IC_SUB_ASSIGN:			result = IC_PRE_DEC;		break;
+		case IC_ADD_ASSIGN_V:		result = IC_PRE_INC_V;		break;
+		case IC_SUB_ASSIGN_V:		result = IC_PRE_DEC_V;		break;
+		case IC_ADD_ASSIGN_AT:		result = IC_PRE_INC_AT;		break;
+		case IC_SUB_ASSIGN_AT:		result = IC_PRE_DEC_AT;		break;
+		case IC_ADD_ASSIGN_AT_V:	result = IC_PRE_INC_AT_V;	break;
+		case IC_SUB_ASSIGN_AT_V:	result = IC_PRE_DEC_AT_V;	break;
+		default:
+			return 0;
+	}
+
+	code_add(ph, result);
+	if (instruction_get_operands_amount(result) != 0)
+	{
+		code_add(ph, unit_get_operand(ph, next, 0));
+	}
+
+	return 2;
+}
+
+/**
+ *	Emit compound assignment instead of binary operation and simple assignment
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	operation	Binary operation
+ *	@param	store		Simple assignment
+ *	@param	displ		Variable displacement
+ */
+static void peephole_emit_assignment(peephole *const ph, const size_t operation, const size_t store, const item_t displ)
+{
+	bool is_address;
+	bool is_void;
+	const instruction_t assignment = unit_get_instruction(ph, store);
+	instruction_is_assignment(assignment, &is_address, &is_void);
+
+	instruction_t result = instruction_to_assignment(unit_get_instruction(ph, operation));
+	if (is_address)
+	{
+		result = instruction_is_floating(result)
+			? (instruction_t)(result + (IC_ASSIGN_AT_R - IC_ASSIGN_R))
+			: instruction_to_address_ver(result);
+	}
+
+	code_add(ph, is_void ? (instruction_t)(result + (IC_ASSIGN_V - IC_ASSIGN)) : result);
+	if (!is_address)
+	{
+		code_add(ph, displ);
+	}
+}
+
+/**
+ *	Check that instructions are binary operation and assignment, which may be fused
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Binary operation
+ *	@param	is_address	Set if assignment should be by address
+ *	@param	displ		Variable displacement
+ *	@param	is_swapped	Set if variable is the right operand
+ *
+ *	@return	@c true if instructions may be fused
+ */
+static bool peephole_is_fusible(const peephole *const ph, const size_t unit, const bool is_address
+	, const item_t displ, const bool is_swapped)
+{
+	if (unit + 1 >= unit_get_amount(ph) || peephole_has_labels(ph, unit, unit + 2)
+		|| unit_has_mark(ph, unit, MARK_LITERAL) || unit_has_mark(ph, unit + 1, MARK_LITERAL))
+	{
+		return false;
+	}
+
+	const instruction_t operation = unit_get_instruction(ph, unit);
+	const instruction_t store = unit_get_instruction(ph, unit + 1);
+	bool is_store_address;
+	bool is_void;
+	if (instruction_to_assignment(operation) == IC_NOP || (is_swapped && !instruction_is_commutative(operation))
+		|| !instruction_is_assignment(store, &is_store_address, &is_void) || is_store_address != is_address
+		|| instruction_is_floating(operation) != instruction_is_floating(store))
+	{
+		return false;
+	}
+
+	return is_address || unit_get_operand(ph, unit + 1, 0) == displ;
+}
+
+/**
+ *	Fuse load of variable, binary operation and store to the same variable
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Load instruction
+ *
+ *	@return	Amount of replaced instructions
+ */
+static size_t peephole_variable_assignment(peephole *const ph, const size_t unit)
+{
+	const item_t displ = unit_get_operand(ph, unit, 0);
+	const bool is_floating = unit_get_instruction(ph, unit) == IC_LOADD;
+
+	// Значение переменной - правый операнд: 'x = y + x'
+	if (peephole_is_fusible(ph, unit + 1, false, displ, true)
+		&& instruction_is_floating(unit_get_instruction(ph, unit + 1)) == is_floating)
+	{
+		peephole_emit_assignment(ph, unit + 1, unit + 2, displ);
+		return 3;
+	}
+
+	// Значение переменной - левый операнд: 'x = x - y'
+	for (size_t end = unit + 1; !unit_has_mark(ph, unit + 1, MARK_LABEL)
+		&& (end = peephole_skip_expression(ph, unit + 1, end)) != SIZE_MAX;)
+	{
+		if (peephole_is_fusible(ph, end, false, displ, false)
+			&& instruction_is_floating(unit_get_instruction(ph, end)) == is_floating)
+		{
+			peephole_copy_sequence(ph, unit + 1, end);
+			peephole_emit_assignment(ph, end, end + 1, displ);
+			return end + 2 - unit;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ *	Fuse calculation of address, load by the same address, binary operation and store
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		First instruction of address calculation
+ *
+ *	@return	Amount of replaced instructions
+ */
+static size_t peephole_address_assignment(peephole *const ph, const size_t unit)
+{
+	for (size_t address = unit; (address = peephole_skip_expression(ph, unit, address)) != SIZE_MAX;)
+	{
+		const size_t amount = address - unit;
+
+		// Адрес вычисляется повторно для левого операнда: 'a[i] = a[i] - y'
+		const size_t load = address + amount;
+		if (load + 1 < unit_get_amount(ph) && peephole_is_equal(ph, unit, address, amount)
+			&& !peephole_has_labels(ph, address, load + 2) && !unit_has_mark(ph, load, MARK_LITERAL))
+		{
+			const instruction_t instruction = unit_get_instruction(ph, load);
+			for (size_t end = load + 1; (instruction == IC_LAT || instruction == IC_LATD)
+				&& (end = peephole_skip_expression(ph, load + 1, end)) != SIZE_MAX;)
+			{
+				if (peephole_is_fusible(ph, end, true, 0, false)
+					&& (instruction == IC_LATD) == instruction_is_floating(unit_get_instruction(ph, end)))
+				{
+					peephole_copy_sequence(ph, unit, address);
+					peephole_copy_sequence(ph, load + 1, end);
+					peephole_emit_assignment(ph, end, end + 1, 0);
+					return end + 2 - unit;
+				}
+			}
+		}
+
+		// Адрес вычисляется повторно для правого операнда: 'a[i] = y + a[i]'
+		for (size_t end = address; !unit_has_mark(ph, address, MARK_LABEL)
+			&& (end = peephole_skip_expression(ph, address, end)) != SIZE_MAX;)
+		{
+			const size_t operation = end + amount + 1;
+			if (peephole_is_equal(ph, unit, end, amount) && !peephole_has_labels(ph, end, operation)
+				&& peephole_is_fusible(ph, operation, true, 0, true)
+				&& unit_get_instruction(ph, operation - 1)
+					== (instruction_is_floating(unit_get_instruction(ph, operation)) ? IC_LATD : IC_LAT))
+			{
+				peephole_copy_sequence(ph, unit, end);
+				peephole_emit_assignment(ph, operation, operation + 1, 0);
+				return operation + 2 - unit;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ *	Delete assignment of variable, which is overwritten by the next one
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		First instruction of assigned expression
+ *
+ *	@return	Amount of deleted instructions
+ */
+static size_t peephole_dead_store(peephole *const ph, const size_t unit)
+{
+	const size_t amount = unit_get_amount(ph);
+	const size_t store = peephole_skip_expression(ph, unit, unit);
+	if (store == SIZE_MAX || store >= amount || unit_has_mark(ph, store, MARK_LABEL | MARK_LITERAL))
+	{
+		return 0;
+	}
+
+	const instruction_t instruction = unit_get_instruction(ph, store);
+	if (instruction != IC_ASSIGN_V && instruction != IC_ASSIGN_R_V)
+	{
+		return 0;
+	}
+
+	// Присваивание переменной самой себе: 'x = x'
+	const item_t displ = unit_get_operand(ph, store, 0);
+	const instruction_t load = instruction == IC_ASSIGN_V ? IC_LOAD : IC_LOADD;
+	if (store == unit + 1 && unit_get_instruction(ph, unit) == load && unit_get_operand(ph, unit, 0) == displ)
+	{
+		return 2;
+	}
+
+	// Выражение не должно содержать обращений к памяти, которые могут прервать выполнение
+	if (!peephole_is_independent(ph, unit, store, ITEM_MAX))
+	{
+		return 0;
+	}
+
+	for (size_t end = store + 1; (end = peephole_skip_expression(ph, store + 1, end)) != SIZE_MAX;)
+	{
+		if (end < amount && !unit_has_mark(ph, end, MARK_LABEL | MARK_LITERAL)
+			&& (unit_get_instruction(ph, end) == instruction
+				|| unit_get_instruction(ph, end) == instruction - (IC_ASSIGN_V - IC_ASSIGN))
+			&& unit_get_operand(ph, end, 0) == displ)
+		{
+			return peephole_is_independent(ph, store + 1, end, displ) ? store + 1 - unit : 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ *	Optimize instruction and copy it to optimized codes
+ *
+ *	@param	ph			Peephole optimizer
+ *	@param	unit		Instruction
+ *
+ *	@return	Amount of processed instructions
+ */
+static size_t peephole_instruction(peephole *const ph, const size_t unit)
+{
+	if (unit_has_mark(ph, unit, MARK_LITERAL | MARK_TABLE))
+	{
+		peephole_copy(ph, unit);
+		return 1;
+	}
+
+	size_t amount = 0;
+	const instruction_t instruction = unit_get_instruction(ph, unit);
+	switch (instruction)
+	{
+		case IC_B:
+		case IC_RETURN_VOID:
+		case IC_RETURN_VAL:
+		case IC_STOP:
+			if (instruction == IC_B)
+			{
+				peephole_branch(ph, unit);
+			}
+			else
+			{
+				peephole_copy(ph, unit);
+			}
+
+			ph->is_reachable = false;
+			return 1;
+
+		case IC_BE0:
+		case IC_BNE0:
+			amount = peephole_conditional_branch(ph, unit);
+			break;
+
+		case IC_LI:
+			amount = peephole_increment(ph, unit);
+			break;
+
+		case IC_LOAD:
+		case IC_LOADD:
+			amount = peephole_variable_assignment(ph, unit);
+			break;
+
+		default:
+			if ((instruction >= IC_REM_ASSIGN_V && instruction <= IC_DIV_ASSIGN_V)
+				|| (instruction >= IC_POST_INC_V && instruction <= IC_PRE_DEC_V)
+				|| (instruction >= IC_ASSIGN_R_V && instruction <= IC_DIV_ASSIGN_R_V)
+				|| (instruction >= IC_POST_INC_R_V && instruction <= IC_PRE_DEC_R_V))
+			{
+				amount = peephole_store(ph, unit);
+			}
+			break;
+	}
+
+	if (amount == 0)
+	{
+		amount = peephole_address_assignment(ph, unit);
+	}
+
+	if (amount == 0)
+	{
+		amount = peephole_dead_store(ph, unit);
+	}
+
+	if (amount == 0)
+	{
+		peephole_copy(ph, unit);
+		return 1;
+	}
+
+	return amount;
+}
+
+/**
+ *	Optimize codes and replace memory by them
+ *
+ *	@param	ph			Peephole optimizer
+ */
+static void peephole_rewrite(peephole *const ph)
+{
+	encoder *const enc = ph->enc;
+	const size_t size = mem_size(enc);
+
+	vector_resize(&ph->code, 0);
+	vector_resize(&ph->map, 0);
+	vector_resize(&ph->map, size + 1);
+	vector_resize(&ph->relocs, 0);
+
+	for (size_t i = 0; i < CODE_START; i++)
+	{
+		code_add(ph, mem_get(enc, i));
+	}
+
+	ph->is_reachable = true;
+	const size_t amount = unit_get_amount(ph);
+	for (size_t i = 0; i < amount;)
+	{
+		const size_t start = unit_get_start(ph, i);
+		vector_set(&ph->map, start, (item_t)vector_size(&ph->code));
+		ph->is_reachable = ph->is_reachable || unit_has_mark(ph, i, MARK_LABEL);
+
+		if (!ph->is_reachable)
+		{
+			i++;
+			continue;
+		}
+
+		const size_t processed = peephole_instruction(ph, i);
+		for (size_t j = i + 1; j < i + processed; j++)
+		{
+			vector_set(&ph->map, unit_get_start(ph, j), (item_t)vector_size(&ph->code));
+		}
+
+		i += processed;
+	}
+
+	vector_set(&ph->map, size, (item_t)vector_size(&ph->code));
+
+	const size_t relocs = vector_size(&ph->relocs);
+	for (size_t i = 0; i < relocs; i++)
+	{
+		const size_t address = (size_t)vector_get(&ph->relocs, i);
+		vector_set(&ph->code, address, vector_get(&ph->map, (size_t)vector_get(&ph->code, address)));
+	}
+
+	vector *const tables[] = { &enc->functions, &enc->literals, &enc->iniprocs };
+	for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++)
+	{
+		const size_t table_size = vector_size(tables[i]);
+		for (size_t j = 0; j < table_size; j++)
+		{
+			const item_t address = vector_get(tables[i], j);
+			if (address > 0 && (size_t)address <= size)
+			{
+				vector_set(tables[i], j, vector_get(&ph->map, (size_t)address));
+			}
+		}
+	}
+
+	const vector memory = enc->memory;
+	enc->memory = ph->code;
+	ph->code = memory;
+}
+
+/**
+ *	Optimize emitted codes by peephole optimizer
+ *	@note	Optimizer threads branches, deletes unreachable codes, dead stores and loads,
+ *			fuses loads, operations and stores into compound assignments
+ *
+ *	@param	enc			Encoder
+ */
+static void emit_peephole(encoder *const enc)
+{
+	peephole ph = { .enc = enc };
+	ph.marks = vector_create(mem_size(enc) + 1);
+	ph.indices = vector_create(mem_size(enc) + 1);
+	ph.starts = vector_create(mem_size(enc) / 2);
+	ph.code = vector_create(mem_size(enc));
+	ph.map = vector_create(mem_size(enc) + 1);
+	ph.relocs = vector_create(0);
+
+	// Каждый проход уменьшает размер кода, поэтому оптимизация конечна
+	for (size_t size = SIZE_MAX; mem_size(enc) < size;)
+	{
+		size = mem_size(enc);
+		if (!peephole_decode(&ph) || !peephole_mark_labels(&ph))
+		{
+			break;
+		}
+
+		peephole_rewrite(&ph);
+	}
+
+	vector_clear(&ph.marks);
+	vector_clear(&ph.indices);
+	vector_clear(&ph.starts);
+	vector_clear(&ph.code);
+	vector_clear(&ph.map);
+	vector_clear(&ph.relocs);
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+int encode_to_vm(const workspace *const ws, syntax *const sx)
+{
+	if (!ws_is_correct(ws) || sx == NULL)
+	{
+		return -1;
+	}
+
+	encoder enc = enc_create(ws, sx);
+	int ret = 0;
+
+	if (ws_has_flag(ws, "--stream"))
+	{
+		// Объявления кодируются во время разбора, после чего дерево не хранится
+		ret = parse_streaming(sx, &emit_external_declaration, &enc) != 0
+			|| (!ws_has_flag(ws, "-c") && !sx_is_correct(sx)) ? 1 : 0;
+		if (!ret)
+		{
+			emit_entry_point(&enc);
+		}
+	}
+	else
+	{
+		const node root = node_get_root(&sx->tree);
+		emit_translation_unit(&enc, &root);
+	}
+
+	ret = ret || reporter_get_errors_number(&enc.sx->rprt) != 0 ? 1 : 0;
+	if (!ret && !ws_has_flag(ws, "-O0"))
+	{
+		emit_peephole(&enc);
+	}
+
+#ifndef NDEBUG
+	write_codes(DEFAULT_CODES, &enc.memory);
+#endif
 
-	int ret = reporter_get_errors_number(&enc.sx->rprt) != 0 ? 1 : 0;
 	if (!ret)
 	{
-		ret = enc_export(&enc);
+		ret = ws_has_flag(ws, "--binary") ? enc_export_binary(&enc) : enc_export(&enc);
+	}
+
+	if (!ret && enc.is_profiling)
+	{
+		ret = enc_export_profile(&enc);
 	}
 
 	enc_clear(&enc);
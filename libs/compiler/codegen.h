@@ -26,6 +26,10 @@ extern "C" {
 
 /**
  *	Encode to virtual machine codes
+ *	@note	Flag @c --binary selects binary container instead of text tables,
+ *			flag @c --stream parses and encodes declarations one by one without keeping syntax tree,
+ *			flag @c --extended-codes emits instructions SWITCH and SLICE_UNCHECKED,
+ *			which only in-tree virtual machine executes
  *
  *	@param	ws				Compiler workspace
  *	@param	sx				Syntax structure
@@ -15,12 +15,14 @@
  */
 
 #include "compiler.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "codegen.h"
 #include "errors.h"
 #include "mipsgen.h"
 #include "llvmgen.h"
+#include "optimizer.h"
 #include "parser.h"
 #include "macro.h"
 #include "syntax.h"
@@ -37,6 +39,7 @@ static const char *const DEFAULT_MACRO = "macro.txt";
 static const char *const DEFAULT_VM = "out.ruc";
 static const char *const DEFAULT_LLVM = "out.ll";
 static const char *const DEFAULT_MIPS = "out.s";
+static const char *const DEFAULT_MIPS_OBJECT = "out.o";
 
 
 typedef int (*encoder)(const workspace *const ws, syntax *const sx);
@@ -70,19 +73,29 @@ static status_t compile_from_io(const workspace *const ws, universal_io *const i
 	}
 
 	syntax sx = sx_create(ws, io);
-	int ret = parse(&sx);
+
+	// Потоковый кодогенератор сам разбирает программу по объявлениям, оптимизации дерева пропускаются
+	const bool is_streaming = enc == &encode_to_vm && ws_has_flag(ws, "--stream");
+	int ret = is_streaming ? 0 : parse(&sx);
 	status_t sts = sts_parse_error;
 
-	if (!ret && !ws_has_flag(ws, "-c")) // Skip linker stage
+	if (!ret && !is_streaming && !ws_has_flag(ws, "-c")) // Skip linker stage
 	{
 		ret = !sx_is_correct(&sx);
 		sts = sts_link_error;
 	}
 
+	if (!ret && !is_streaming)
+	{
+		ret = optimize(ws, &sx);
+		sts = sts_optimize_error;
+	}
+
 	if (!ret)
 	{
 		ret = enc(ws, &sx);
-		sts = sts_codegen_error;
+		sts = !is_streaming ? sts_codegen_error
+			: reporter_get_errors_number(&sx.rprt) != 0 ? sts_parse_error : sts_link_error;
 	}
 
 	sx_clear(&sx);
@@ -190,10 +203,17 @@ int compile_to_mips(workspace *const ws)
 {
 	if (ws_get_output(ws) == NULL)
 	{
-		ws_set_output(ws, DEFAULT_MIPS);
+		ws_set_output(ws, ws_has_flag(ws, "--binary") ? DEFAULT_MIPS_OBJECT : DEFAULT_MIPS);
 	}
 
-	return compile_from_ws(ws, &encode_to_mips);
+	const status_t sts = compile_from_ws(ws, &encode_to_mips);
+	if (sts >= sts_parse_error && ws_has_flag(ws, "--binary"))
+	{
+		// Недописанный объектный файл не должен попасть к компоновщику
+		remove(ws_get_output(ws));
+	}
+
+	return sts;
 }
 
 
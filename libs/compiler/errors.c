@@ -451,6 +451,14 @@ static void get_error(const err_t num, char *const msg, va_list args)
 		case too_many_arguments:
 			sprintf(msg, "слишком много аргументов у функции, допустимое количество до 128");
 			break;
+		case instruction_cannot_be_encoded:
+		{
+			const char *const instruction = va_arg(args, char *);
+			const char *const label = va_arg(args, char *);
+			sprintf(msg, "инструкция '%s' после метки %s не может быть закодирована в объектном файле"
+				, instruction, label);
+		}
+		break;
 
 		default:
 			sprintf(msg, "неизвестный код ошибки (%i)", num);
@@ -563,6 +571,13 @@ void system_warning(warning_t num, ...)
 }
 
 
+size_t location_get_line(universal_io *const io)
+{
+	const location loc = loc_search(io);
+	return loc_get_line(&loc);
+}
+
+
 void error_msg(const char *const msg)
 {
 	log_system_error(TAG_RUC, msg);
@@ -164,7 +164,8 @@ typedef enum ERROR
 	wrong_init_in_actparam,
 	array_borders_cannot_be_static_dynamic,
 	such_array_is_not_supported,
-	too_many_arguments
+	too_many_arguments,
+	instruction_cannot_be_encoded
 } err_t;
 
 /** Warnings codes */
@@ -227,6 +228,16 @@ void system_error(err_t num, ...);
 void system_warning(warning_t num, ...);
 
 
+/**
+ *	Get source line of current input position
+ *
+ *	@param	io			Universal io
+ *
+ *	@return	Line number
+ */
+size_t location_get_line(universal_io *const io);
+
+
 /**
  *	Emit an error message
  *
@@ -176,3 +176,63 @@ instruction_t instruction_to_void_ver(const instruction_t instruction)
 			? (instruction_t)((size_t)instruction + DISPL_TO_VOID)
 			: instruction;
 }
+
+size_t instruction_get_operands_amount(const instruction_t instruction)
+{
+	switch (instruction)
+	{
+		case IC_DEFARR:
+			return 7;
+
+		case IC_ARR_INIT:
+			return 4;
+
+		case IC_COPY00:
+		case IC_COPYST:
+			return 3;
+
+		case IC_COPY01:
+		case IC_COPY10:
+		case IC_COPY0ST:
+		case IC_COPY0ST_ASSIGN:
+		case IC_STRUCT_WITH_ARR:
+		case IC_FUNC_BEG:
+		case IC_SWITCH:
+			return 2;
+
+		case IC_COPY11:
+		case IC_COPY1ST:
+		case IC_COPY1ST_ASSIGN:
+		case IC_CALL2:
+		case IC_PRINT:
+		case IC_PRINTID:
+		case IC_PRINTF:
+		case IC_GETID:
+		case IC_BEG_INIT:
+		case IC_LI:
+		case IC_LOAD:
+		case IC_LOADD:
+		case IC_LA:
+		case IC_RETURN_VAL:
+		case IC_B:
+		case IC_BE0:
+		case IC_BNE0:
+		case IC_SLICE:
+		case IC_SLICE_UNCHECKED:
+		case IC_SELECT:
+			return 1;
+
+		default:
+			// Присваивания переменным и их инкременты содержат смещение переменной
+			return (instruction >= IC_REM_ASSIGN && instruction <= IC_DIV_ASSIGN)
+				|| (instruction >= IC_POST_INC && instruction <= IC_PRE_DEC)
+				|| (instruction >= IC_ASSIGN_R && instruction <= IC_DIV_ASSIGN_R)
+				|| (instruction >= IC_POST_INC_R && instruction <= IC_PRE_DEC_R)
+				|| (instruction >= IC_REM_ASSIGN_V && instruction <= IC_DIV_ASSIGN_V)
+				|| (instruction >= IC_POST_INC_V && instruction <= IC_PRE_DEC_V)
+				|| (instruction >= IC_ASSIGN_R_V && instruction <= IC_DIV_ASSIGN_R_V)
+				|| (instruction >= IC_POST_INC_R_V && instruction <= IC_PRE_DEC_R_V)
+					? 1
+					: 0;
+	}
+}
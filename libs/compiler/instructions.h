@@ -257,6 +257,9 @@ typedef enum INSTURCTION
 	IC_FGETC,					/**< 'FGETC' instruction code */
 	IC_FPUTC,					/**< 'FPUTC' instruction code */
 
+	IC_SWITCH,					/**< 'SWITCH' instruction code */
+	IC_SLICE_UNCHECKED,			/**< 'SLICE_UNCHECKED' instruction code */
+
 	MAX_INSTRUCTION_CODE,
 } instruction_t;
 
@@ -316,6 +319,16 @@ instruction_t instruction_to_floating_ver(const instruction_t instruction);
  */
 instruction_t instruction_to_void_ver(const instruction_t instruction);
 
+/**
+ *	Get amount of instruction operands in memory
+ *	@note	Floating literal of @c IC_LID occupies target dependent amount of items and is not counted
+ *
+ *	@param	instruction		Instruction
+ *
+ *	@return	Operands amount
+ */
+size_t instruction_get_operands_amount(const instruction_t instruction);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
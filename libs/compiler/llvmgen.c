@@ -19,6 +19,7 @@
 #include "AST.h"
 #include "errors.h"
 #include "hash.h"
+#include "pool.h"
 #include "uniprinter.h"
 
 
@@ -29,6 +30,7 @@
 
 
 static const size_t HASH_TABLE_SIZE = 1024;
+static const size_t BUFFER_SIZE = 65536;				// Размер буфера для объявления верхнего уровня
 static const size_t IS_STATIC = 0;
 static const size_t MAX_DIMENSIONS = SIZE_MAX - 2;		// Из-за OP_SLICE
 
@@ -51,9 +53,38 @@ typedef enum LOCATION
 	LFREE,								/**< Свободный запрос значения */
 } location_t;
 
+typedef enum ATTRIBUTE
+{
+	ATTR_READNONE = 1 << 0,				/**< Функция не обращается к памяти вне своего кадра */
+	ATTR_NORECURSE = 1 << 1,			/**< Функция не вызывает себя ни прямо, ни косвенно */
+	ATTR_ADDRESS_TAKEN = 1 << 2,		/**< Адрес функции используется как значение */
+	ATTR_INDIRECT_CALLS = 1 << 3,		/**< Функция вызывает функции по указателю */
+	ATTR_HAS_CALLER = 1 << 4,			/**< При анализе рекурсии: функцию вызывает непроверенная функция */
+	ATTR_HAS_CALLEE = 1 << 5,			/**< При анализе рекурсии: функция вызывает непроверенную функцию */
+	ATTR_UNKNOWN_CALLS = 1 << 6,		/**< Функция вызывает функции, определённые вне единицы трансляции */
+} attribute_t;
+
+typedef enum METADATA
+{
+	MD_TBAA_ROOT = 1,					/**< Корень дерева типов TBAA */
+	MD_TBAA_CHAR,						/**< Тип char, совпадающий по памяти с любым типом */
+	MD_TBAA_BOOL,						/**< Тип bool */
+	MD_TBAA_INT,						/**< Тип int */
+	MD_TBAA_DOUBLE,						/**< Тип double */
+	MD_TBAA_POINTER,					/**< Любой указатель */
+	MD_TBAA_CHAR_ACCESS,				/**< Теги обращений к памяти соответствующих типов */
+	MD_TBAA_BOOL_ACCESS,
+	MD_TBAA_INT_ACCESS,
+	MD_TBAA_DOUBLE_ACCESS,
+	MD_TBAA_POINTER_ACCESS,
+	MD_LOOP_MUSTPROGRESS,				/**< Свойство завершаемости цикла */
+	MD_LOOP_BEGIN,						/**< Номер метаданных первого цикла */
+} metadata_t;
+
 typedef struct information
 {
 	syntax *sx;								/**< Структура syntax с таблицами */
+	universal_io *io;						/**< Вывод кода */
 
 	size_t register_num;					/**< Номер регистра */
 	size_t label_num;						/**< Номер метки */
@@ -83,6 +114,12 @@ typedef struct information
 												@c value[0]	 - флаг статичности
 												@c value[1..MAX] - границы массива */
 
+	hash functions;							/**< Хеш таблица с атрибутами функций:
+												@c key		 - id функции
+												@c value[0]	 - флаги атрибутов
+												@c value[1..MAX] - флаги nocapture параметров */
+	size_t loop_num;						/**< Количество циклов с метаданными */
+
 	bool was_stack_functions;				/**< Истина, если использовались стековые функции */
 	bool was_dynamic;						/**< Истина, если в функции были динамические массивы */
 	bool was_file;							/**< Истина, если была работа с файлами */
@@ -93,8 +130,17 @@ typedef struct information
 	bool is_call;							/**< Истина, если обрабатывается вызов функции */
 
 	size_t func_ref;						/**< id функции */
+	item_t ret_type;						/**< Тип возвращаемого значения обрабатываемой функции */
 } information;
 
+/** Объявление верхнего уровня, код которого выводится в отдельный буфер */
+typedef struct definition
+{
+	node nd;								/**< Объявление */
+	information info;						/**< Состояние генерации функции */
+	universal_io io;						/**< Буфер с кодом объявления */
+} definition;
+
 
 static void emit_statement(information *const info, const node *const nd);
 static void emit_compound_statement(information *const info, const node *const nd, const bool is_function_body);
@@ -134,13 +180,13 @@ static void func_name_to_io(information *const info, const size_t func_ref)
 	const char *name = ident_get_spelling(info->sx, func_ref);
 	if (func_ref < BEGIN_USER_FUNC)
 	{
-		uni_printf(info->sx->io, "%s", name);
+		uni_printf(info->io, "%s", name);
 		return;
 	}
 
 	char modified_name[MAX_NAME];
 	utf8_transliteration(name, modified_name);
-	uni_printf(info->sx->io, "%s", modified_name);
+	uni_printf(info->io, "%s", modified_name);
 }
 
 static void type_to_io(information *const info, const item_t type)
@@ -149,51 +195,53 @@ static void type_to_io(information *const info, const item_t type)
 	switch (type_class)
 	{
 		case TYPE_VARARG:
-			uni_printf(info->sx->io, "...");
+			uni_printf(info->io, "...");
 			break;
 
 		case TYPE_BOOLEAN:
-			uni_printf(info->sx->io, "i1");
+			uni_printf(info->io, "i1");
 			break;
 
 		case TYPE_CHARACTER:
-			uni_printf(info->sx->io, "i8");
+			uni_printf(info->io, "i8");
 			break;
 
 		case TYPE_INTEGER:
 		case TYPE_ENUM:
-			uni_printf(info->sx->io, "i32");
+			uni_printf(info->io, "i32");
 			break;
 
 		case TYPE_FLOATING:
-			uni_printf(info->sx->io, "double");
+			uni_printf(info->io, "double");
 			break;
 
 		case TYPE_VOID:
-			uni_printf(info->sx->io, "void");
+			uni_printf(info->io, "void");
 			break;
 
 		case TYPE_STRUCTURE:
-			uni_printf(info->sx->io, "%%struct_opt.%" PRIitem, type);
+			uni_printf(info->io, "%%struct_opt.%" PRIitem, type);
 			break;
 
 		case TYPE_POINTER:
 		{
-			type_to_io(info, type_pointer_get_element_type(info->sx, type));
-			uni_printf(info->sx->io, "*");
+			// В LLVM нет указателей на void, вместо них используется i8*
+			const item_t element_type = type_pointer_get_element_type(info->sx, type);
+			type_to_io(info, type_is_void(element_type) ? TYPE_CHARACTER : element_type);
+			uni_printf(info->io, "*");
 		}
 		break;
 
 		case TYPE_ARRAY:
 		{
 			type_to_io(info, type_array_get_element_type(info->sx, type));
-			uni_printf(info->sx->io, "*");
+			uni_printf(info->io, "*");
 		}
 		break;
 
 		case TYPE_FILE:
 		{
-			uni_printf(info->sx->io, "%%struct._IO_FILE");
+			uni_printf(info->io, "%%struct._IO_FILE");
 			info->was_file = true;
 		}
 		break;
@@ -201,7 +249,7 @@ static void type_to_io(information *const info, const item_t type)
 		case TYPE_FUNCTION:
 		{
 			type_to_io(info, type_function_get_return_type(info->sx, type));
-			uni_printf(info->sx->io, " (");
+			uni_printf(info->io, " (");
 
 			const size_t parameter_amount = type_function_get_parameter_amount(info->sx, type);
 			for (size_t i = 0; i < parameter_amount; i++)
@@ -219,19 +267,19 @@ static void type_to_io(information *const info, const item_t type)
 
 				if (type_is_function(info->sx, type_parameter))
 				{
-					uni_printf(info->sx->io, "*");
+					uni_printf(info->io, "*");
 				}
 
 				if (i != parameter_amount - 1)
 				{
-					uni_printf(info->sx->io, ", ");
+					uni_printf(info->io, ", ");
 				}
 			}
-			uni_printf(info->sx->io, ")");
+			uni_printf(info->io, ")");
 
 			if (!info->is_call)
 			{
-				uni_printf(info->sx->io, "*");
+				uni_printf(info->io, "*");
 			}
 		}
 		break;
@@ -247,71 +295,71 @@ static void operation_to_io(information *const info, const binary_t operation_ty
 	{
 		case BIN_ADD_ASSIGN:
 		case BIN_ADD:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "add nsw" : "fadd");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "add nsw" : "fadd");
 			break;
 
 		case BIN_SUB_ASSIGN:
 		case BIN_SUB:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "sub nsw" : "fsub");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "sub nsw" : "fsub");
 			break;
 
 		case BIN_MUL_ASSIGN:
 		case BIN_MUL:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "mul nsw" : "fmul");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "mul nsw" : "fmul");
 			break;
 
 		case BIN_DIV_ASSIGN:
 		case BIN_DIV:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "sdiv" : "fdiv");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "sdiv" : "fdiv");
 			break;
 
 		case BIN_REM_ASSIGN:
 		case BIN_REM:
-			uni_printf(info->sx->io, "srem");
+			uni_printf(info->io, "srem");
 			break;
 
 		case BIN_SHL_ASSIGN:
 		case BIN_SHL:
-			uni_printf(info->sx->io, "shl");
+			uni_printf(info->io, "shl");
 			break;
 
 		case BIN_SHR_ASSIGN:
 		case BIN_SHR:
-			uni_printf(info->sx->io, "ashr");
+			uni_printf(info->io, "ashr");
 			break;
 
 		case BIN_AND_ASSIGN:
 		case BIN_AND:
-			uni_printf(info->sx->io, "and");
+			uni_printf(info->io, "and");
 			break;
 
 		case BIN_XOR_ASSIGN:
 		case BIN_XOR:
-			uni_printf(info->sx->io, "xor");
+			uni_printf(info->io, "xor");
 			break;
 
 		case BIN_OR_ASSIGN:
 		case BIN_OR:
-			uni_printf(info->sx->io, "or");
+			uni_printf(info->io, "or");
 			break;
 
 		case BIN_EQ:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp eq" : "fcmp oeq");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp eq" : "fcmp oeq");
 			break;
 		case BIN_NE:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp ne" : "fcmp one");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp ne" : "fcmp one");
 			break;
 		case BIN_LT:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp slt" : "fcmp olt");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp slt" : "fcmp olt");
 			break;
 		case BIN_GT:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp sgt" : "fcmp ogt");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp sgt" : "fcmp ogt");
 			break;
 		case BIN_LE:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp sle" : "fcmp ole");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp sle" : "fcmp ole");
 			break;
 		case BIN_GE:
-			uni_printf(info->sx->io, type_is_integer(info->sx, type) ? "icmp sge" : "fcmp oge");
+			uni_printf(info->io, type_is_integer(info->sx, type) ? "icmp sge" : "fcmp oge");
 			break;
 		default:
 			break;
@@ -321,161 +369,235 @@ static void operation_to_io(information *const info, const binary_t operation_ty
 static void to_code_operation_reg_reg(information *const info, const binary_t operation
 	, const size_t fst, const size_t snd, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, type);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %%.%zu, %%.%zu\n", fst, snd);
+	uni_printf(info->io, " %%.%zu, %%.%zu\n", fst, snd);
 }
 
 static void to_code_operation_reg_const_integer(information *const info, const binary_t operation
 	, const size_t fst, const item_t snd, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_INTEGER);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %%.%zu, %" PRIitem "\n", fst, snd);
+	uni_printf(info->io, " %%.%zu, %" PRIitem "\n", fst, snd);
 }
 
 static void to_code_operation_reg_const_bool(information *const info, const binary_t operation
 	, const size_t fst, const bool snd, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_INTEGER);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %%.%zu, %s\n", fst, snd ? "true" : "false");
+	uni_printf(info->io, " %%.%zu, %s\n", fst, snd ? "true" : "false");
 }
 
 static void to_code_operation_reg_const_double(information *const info, const binary_t operation
 	, const size_t fst, const double snd)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_FLOATING);
-	uni_printf(info->sx->io, " double %%.%zu, %f\n", fst, snd);
+	uni_printf(info->io, " double %%.%zu, %f\n", fst, snd);
 }
 
 static void to_code_operation_const_reg_integer(information *const info, const binary_t operation
 	, const item_t fst, const size_t snd, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_INTEGER);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %" PRIitem ", %%.%zu\n", fst, snd);
+	uni_printf(info->io, " %" PRIitem ", %%.%zu\n", fst, snd);
 }
 
 static void to_code_operation_const_reg_double(information *const info, const binary_t operation
 	, const double fst, const size_t snd)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
+	operation_to_io(info, operation, TYPE_FLOATING);
+	uni_printf(info->io, " double %f, %%.%zu\n", fst, snd);
+}
+
+static void to_code_operation_const_const_integer(information *const info, const binary_t operation
+	, const item_t fst, const item_t snd, const item_t type)
+{
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
+	operation_to_io(info, operation, TYPE_INTEGER);
+	uni_printf(info->io, " ");
+	type_to_io(info, type);
+	uni_printf(info->io, " %" PRIitem ", %" PRIitem "\n", fst, snd);
+}
+
+static void to_code_operation_const_const_double(information *const info, const binary_t operation
+	, const double fst, const double snd)
+{
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_FLOATING);
-	uni_printf(info->sx->io, " double %f, %%.%zu\n", fst, snd);
+	uni_printf(info->io, " double %f, %f\n", fst, snd);
 }
 
 static void to_code_operation_reg_null(information *const info, const binary_t operation
 	, const size_t fst, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_INTEGER);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %%.%zu, null\n", fst);
+	uni_printf(info->io, " %%.%zu, null\n", fst);
 }
 
 static void to_code_operation_null_reg(information *const info, const binary_t operation
 	, const size_t snd, const item_t type)
 {
-	uni_printf(info->sx->io, " %%.%zu = ", info->register_num);
+	uni_printf(info->io, " %%.%zu = ", info->register_num);
 	operation_to_io(info, operation, TYPE_INTEGER);
-	uni_printf(info->sx->io, " ");
+	uni_printf(info->io, " ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " null, %%.%zu\n", snd);
+	uni_printf(info->io, " null, %%.%zu\n", snd);
+}
+
+static void to_code_tbaa(information *const info, const item_t type)
+{
+	switch (type_get_class(info->sx, type))
+	{
+		case TYPE_BOOLEAN:
+			uni_printf(info->io, ", !tbaa !%i", MD_TBAA_BOOL_ACCESS);
+			return;
+
+		case TYPE_CHARACTER:
+			uni_printf(info->io, ", !tbaa !%i", MD_TBAA_CHAR_ACCESS);
+			return;
+
+		case TYPE_INTEGER:
+		case TYPE_ENUM:
+			uni_printf(info->io, ", !tbaa !%i", MD_TBAA_INT_ACCESS);
+			return;
+
+		case TYPE_FLOATING:
+			uni_printf(info->io, ", !tbaa !%i", MD_TBAA_DOUBLE_ACCESS);
+			return;
+
+		case TYPE_POINTER:
+		case TYPE_ARRAY:
+			uni_printf(info->io, ", !tbaa !%i", MD_TBAA_POINTER_ACCESS);
+			return;
+
+		default:
+			return;
+	}
 }
 
 static void to_code_load(information *const info, const size_t result, const size_t id, const item_t type
 	, const bool is_array, const bool is_local)
 {
-	uni_printf(info->sx->io, " %%.%zu = load ", result);
+	uni_printf(info->io, " %%.%zu = load ", result);
 	type_to_io(info, type);
-	uni_printf(info->sx->io, ", ");
+	uni_printf(info->io, ", ");
 	type_to_io(info, type);
 	if (type_get_class(info->sx, type) == TYPE_FUNCTION && !is_local)
 	{
-		uni_printf(info->sx->io, "* @");
+		uni_printf(info->io, "* @");
 		func_name_to_io(info, info->func_ref);
-		uni_printf(info->sx->io, ", align 4\n");
+		uni_printf(info->io, ", align 4\n");
 		return;
 	}
-	uni_printf(info->sx->io, "* %s%s.%zu, align 4\n", is_local ? "%" : "@", is_array ? "" : "var", id);
+	uni_printf(info->io, "* %s%s.%zu, align 4", is_local ? "%" : "@", is_array ? "" : "var", id);
+	to_code_tbaa(info, type);
+	uni_printf(info->io, "\n");
 }
 
 static void to_code_store_reg(information *const info, const size_t reg, const size_t id, const item_t type
 	, const bool is_array, const bool is_pointer, const bool is_local)
 {
-	uni_printf(info->sx->io, " store ");
+	uni_printf(info->io, " store ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %s%s.%zu, ", /*ident_is_local(info->sx, reg)*/true ? "%" : "@", is_pointer ? "var" : "", reg);
+	uni_printf(info->io, " %s%s.%zu, ", is_pointer && !ident_is_local(info->sx, reg) ? "@" : "%"
+		, is_pointer ? "var" : "", reg);
 	type_to_io(info, type);
-	uni_printf(info->sx->io, "* %s%s.%zu, align 4\n", is_local ? "%" : "@", is_array ? "" : "var", id);
+	uni_printf(info->io, "* %s%s.%zu, align 4", is_local ? "%" : "@", is_array ? "" : "var", id);
+	to_code_tbaa(info, type);
+	uni_printf(info->io, "\n");
 }
 
 static inline void to_code_store_const_integer(information *const info, const item_t arg, const size_t id
 	, const bool is_array, const bool is_local, const item_t type)
 {
-	uni_printf(info->sx->io, " store ");
+	uni_printf(info->io, " store ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " %" PRIitem ", ", arg);
+	uni_printf(info->io, " %" PRIitem ", ", arg);
 	type_to_io(info, type);
-	uni_printf(info->sx->io, "* %s%s.%zu, align 4\n", is_local ? "%" : "@", is_array ? "" : "var", id);
+	uni_printf(info->io, "* %s%s.%zu, align 4", is_local ? "%" : "@", is_array ? "" : "var", id);
+	to_code_tbaa(info, type);
+	uni_printf(info->io, "\n");
 }
 
 static inline void to_code_store_const_bool(information *const info, const bool arg, const size_t id
 	, const bool is_array, const bool is_local)
 {
-	uni_printf(info->sx->io, " store i1 %s, i1* %s%s.%zu, align 4\n"
+	uni_printf(info->io, " store i1 %s, i1* %s%s.%zu, align 4"
 		, arg ? "true" : "false", is_local ? "%" : "@", is_array ? "" : "var", id);
+	to_code_tbaa(info, TYPE_BOOLEAN);
+	uni_printf(info->io, "\n");
 }
 
 static inline void to_code_store_const_double(information *const info, const double arg, const size_t id
 	, const bool is_array, const bool is_local)
 {
-	uni_printf(info->sx->io, " store double %f, double* %s%s.%zu, align 4\n"
+	uni_printf(info->io, " store double %f, double* %s%s.%zu, align 4"
 		, arg, is_local ? "%" : "@", is_array ? "" : "var", id);
+	to_code_tbaa(info, TYPE_FLOATING);
+	uni_printf(info->io, "\n");
 }
 
 static void to_code_store_null(information *const info, const size_t id, const item_t type)
 {
-	uni_printf(info->sx->io, " store ");
+	uni_printf(info->io, " store ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, " null, ");
+	uni_printf(info->io, " null, ");
 	type_to_io(info, type);
-	uni_printf(info->sx->io, "* %%var.%zu, align 4\n", id);
+	uni_printf(info->io, "* %%var.%zu, align 4", id);
+	to_code_tbaa(info, type);
+	uni_printf(info->io, "\n");
 }
 
 static inline void to_code_label(information *const info, const size_t label_num)
 {
-	uni_printf(info->sx->io, " label%zu:\n", label_num);
+	uni_printf(info->io, " label%zu:\n", label_num);
 }
 
 static inline void to_code_unconditional_branch(information *const info, const size_t label_num)
 {
-	uni_printf(info->sx->io, " br label %%label%zu\n", label_num);
+	uni_printf(info->io, " br label %%label%zu\n", label_num);
+}
+
+static void to_code_loop_branch(information *const info, const size_t label_num, const bool is_constant)
+{
+	// Цикл с неконстантным условием может считаться завершающимся (C11 6.8.5)
+	if (is_constant)
+	{
+		to_code_unconditional_branch(info, label_num);
+		return;
+	}
+
+	uni_printf(info->io, " br label %%label%zu, !llvm.loop !%zu\n", label_num, MD_LOOP_BEGIN + info->loop_num++);
 }
 
 static inline void to_code_conditional_branch(information *const info)
 {
-	uni_printf(info->sx->io, " br i1 %%.%zu, label %%label%zu, label %%label%zu\n"
+	uni_printf(info->io, " br i1 %%.%zu, label %%label%zu, label %%label%zu\n"
 		, info->answer_reg, info->label_true, info->label_false);
 }
 
 static void to_code_stack_save(information *const info, const item_t index)
 {
 	// команды сохранения состояния стека
-	uni_printf(info->sx->io, " %%dyn.%" PRIitem " = alloca i8*, align 4\n", index);
-	uni_printf(info->sx->io, " %%.%zu = call i8* @llvm.stacksave()\n", info->register_num);
-	uni_printf(info->sx->io, " store i8* %%.%zu, i8** %%dyn.%" PRIitem ", align 4\n"
+	uni_printf(info->io, " %%dyn.%" PRIitem " = alloca i8*, align 4\n", index);
+	uni_printf(info->io, " %%.%zu = call i8* @llvm.stacksave()\n", info->register_num);
+	uni_printf(info->io, " store i8* %%.%zu, i8** %%dyn.%" PRIitem ", align 4\n"
 		, info->register_num, index);
 	info->register_num++;
 
@@ -485,23 +607,39 @@ static void to_code_stack_save(information *const info, const item_t index)
 static void to_code_stack_load(information *const info, const item_t index)
 {
 	// команды восстановления состояния стека
-	uni_printf(info->sx->io, " %%.%zu = load i8*, i8** %%dyn.%" PRIitem ", align 4\n"
+	uni_printf(info->io, " %%.%zu = load i8*, i8** %%dyn.%" PRIitem ", align 4\n"
 		, info->register_num, index);
-	uni_printf(info->sx->io, " call void @llvm.stackrestore(i8* %%.%zu)\n", info->register_num);
+	uni_printf(info->io, " call void @llvm.stackrestore(i8* %%.%zu)\n", info->register_num);
 	info->register_num++;
 
 	info->was_stack_functions = true;
 }
 
+static void to_code_array_type(information *const info, const size_t index, const size_t dimension
+	, const item_t type)
+{
+	const size_t dim = hash_get_amount_by_index(&info->arrays, index) - 1;
+	for (size_t i = dimension; i <= dim; i++)
+	{
+		uni_printf(info->io, "[%" PRIitem " x ", hash_get_by_index(&info->arrays, index, i));
+	}
+	type_to_io(info, type);
+
+	for (size_t i = dimension; i <= dim; i++)
+	{
+		uni_printf(info->io, "]");
+	}
+}
+
 static void to_code_alloc_array_static(information *const info, const size_t index, const item_t type, const bool is_local)
 {
 	if (is_local)
 	{
-		uni_printf(info->sx->io, " %%arr.%" PRIitem " = alloca ", hash_get_key(&info->arrays, index));
+		uni_printf(info->io, " %%arr.%" PRIitem " = alloca ", hash_get_key(&info->arrays, index));
 	}
 	else
 	{
-		uni_printf(info->sx->io, "@arr.%" PRIitem " = common global ", hash_get_key(&info->arrays, index));
+		uni_printf(info->io, "@arr.%" PRIitem " = common global ", hash_get_key(&info->arrays, index));
 	}
 
 	const size_t dim = hash_get_amount_by_index(&info->arrays, index) - 1;
@@ -511,17 +649,102 @@ static void to_code_alloc_array_static(information *const info, const size_t ind
 		return;
 	}
 
-	for (size_t i = 1; i <= dim; i++)
+	to_code_array_type(info, index, 1, type);
+	uni_printf(info->io, "%s, align 4\n", is_local ? "" : " zeroinitializer");
+}
+
+/**
+ *	Check if initializer of array consists of literals only and fits into array bounds
+ *
+ *	@param	info		Encoder
+ *	@param	nd			Initializer of current dimension
+ *	@param	index		Index of array in arrays table
+ *	@param	dimension	Current dimension, starting from @c 1
+ *
+ *	@return	@c true, if initializer may be emitted as constant aggregate
+ */
+static bool array_initializer_is_constant(information *const info, const node *const nd, const size_t index
+	, const size_t dimension)
+{
+	if (node_get_type(nd) != OP_INITIALIZER
+		|| (item_t)expression_initializer_get_size(nd) > hash_get_by_index(&info->arrays, index, dimension))
+	{
+		return false;
+	}
+
+	const size_t dim = hash_get_amount_by_index(&info->arrays, index) - 1;
+	const size_t size = expression_initializer_get_size(nd);
+	for (size_t i = 0; i < size; i++)
 	{
-		uni_printf(info->sx->io, "[%" PRIitem " x ", hash_get_by_index(&info->arrays, index, i));
+		const node initializer = expression_initializer_get_subexpr(nd, i);
+		if (dimension != dim)
+		{
+			if (!array_initializer_is_constant(info, &initializer, index, dimension + 1))
+			{
+				return false;
+			}
+
+			continue;
+		}
+
+		const item_t type = expression_get_type(&initializer);
+		if (expression_get_class(&initializer) != EXPR_LITERAL
+			|| !(type_is_integer(info->sx, type) || type_is_floating(info->sx, type)))
+		{
+			return false;
+		}
 	}
-	type_to_io(info, type);
 
-	for (size_t i = 1; i <= dim; i++)
+	return true;
+}
+
+/**
+ *	Emit constant aggregate of array initializer, missing elements are filled with zeroes
+ *
+ *	@param	info		Encoder
+ *	@param	nd			Initializer of current dimension
+ *	@param	index		Index of array in arrays table
+ *	@param	dimension	Current dimension, starting from @c 1
+ *	@param	type		Type of array elements
+ */
+static void to_code_array_constant(information *const info, const node *const nd, const size_t index
+	, const size_t dimension, const item_t type)
+{
+	const size_t dim = hash_get_amount_by_index(&info->arrays, index) - 1;
+	const size_t bound = (size_t)hash_get_by_index(&info->arrays, index, dimension);
+	const size_t size = expression_initializer_get_size(nd);
+
+	uni_printf(info->io, "[");
+	for (size_t i = 0; i < bound; i++)
 	{
-		uni_printf(info->sx->io, "]");
+		uni_printf(info->io, i == 0 ? "" : ", ");
+		to_code_array_type(info, index, dimension + 1, type);
+		uni_printf(info->io, " ");
+
+		if (i >= size)
+		{
+			uni_printf(info->io, "zeroinitializer");
+			continue;
+		}
+
+		const node initializer = expression_initializer_get_subexpr(nd, i);
+		if (dimension != dim)
+		{
+			to_code_array_constant(info, &initializer, index, dimension + 1, type);
+		}
+		else if (type_is_floating(info->sx, type))
+		{
+			const bool is_floating = type_is_floating(info->sx, expression_get_type(&initializer));
+			uni_printf(info->io, "%f", is_floating
+				? expression_literal_get_floating(&initializer)
+				: (double)expression_literal_get_integer(&initializer));
+		}
+		else
+		{
+			uni_printf(info->io, "%" PRIitem, expression_literal_get_integer(&initializer));
+		}
 	}
-	uni_printf(info->sx->io, "%s, align 4\n", is_local ? "" : " zeroinitializer");
+	uni_printf(info->io, "]");
 }
 
 static void to_code_alloc_array_dynamic(information *const info, const size_t index, const item_t type)
@@ -538,19 +761,19 @@ static void to_code_alloc_array_dynamic(information *const info, const size_t in
 
 	for (size_t i = 2; i <= dim; i++)
 	{
-		uni_printf(info->sx->io, " %%.%zu = mul nuw i32 %%.%" PRIitem ", %%.%" PRIitem "\n"
+		uni_printf(info->io, " %%.%zu = mul nuw i32 %%.%" PRIitem ", %%.%" PRIitem "\n"
 			, info->register_num, to_alloc, hash_get_by_index(&info->arrays, index, i));
 		to_alloc = info->register_num++;
 	}
-	uni_printf(info->sx->io, " %%dynarr.%" PRIitem " = alloca ", hash_get_key(&info->arrays, index));
+	uni_printf(info->io, " %%dynarr.%" PRIitem " = alloca ", hash_get_key(&info->arrays, index));
 	type_to_io(info, type);
-	uni_printf(info->sx->io, ", i32 %%.%" PRIitem ", align 4\n", to_alloc);
+	uni_printf(info->io, ", i32 %%.%" PRIitem ", align 4\n", to_alloc);
 }
 
 static void to_code_slice(information *const info, const item_t id, const size_t cur_dimension
 	, const item_t prev_slice, const item_t type, const bool is_local)
 {
-	uni_printf(info->sx->io, " %%.%zu = getelementptr inbounds ", info->register_num);
+	uni_printf(info->io, " %%.%zu = getelementptr inbounds ", info->register_num);
 	const size_t dimensions = hash_get_amount(&info->arrays, id) - 1;
 
 	if (dimensions == SIZE_MAX)
@@ -562,58 +785,58 @@ static void to_code_slice(information *const info, const item_t id, const size_t
 	{
 		for (size_t i = dimensions - cur_dimension; i <= dimensions; i++)
 		{
-			uni_printf(info->sx->io, "[%" PRIitem " x ", hash_get(&info->arrays, id, i));
+			uni_printf(info->io, "[%" PRIitem " x ", hash_get(&info->arrays, id, i));
 		}
 		type_to_io(info, type);
 
 		for (size_t i = dimensions - cur_dimension; i <= dimensions; i++)
 		{
-			uni_printf(info->sx->io, "]");
+			uni_printf(info->io, "]");
 		}
-		uni_printf(info->sx->io, ", ");
+		uni_printf(info->io, ", ");
 
 		for (size_t i = dimensions - cur_dimension; i <= dimensions; i++)
 		{
-			uni_printf(info->sx->io, "[%" PRIitem " x ", hash_get(&info->arrays, id, i));
+			uni_printf(info->io, "[%" PRIitem " x ", hash_get(&info->arrays, id, i));
 		}
 		type_to_io(info, type);
 
 		for (size_t i = dimensions - cur_dimension; i <= dimensions; i++)
 		{
-			uni_printf(info->sx->io, "]");
+			uni_printf(info->io, "]");
 		}
 
 		if (cur_dimension == dimensions - 1)
 		{
-			uni_printf(info->sx->io, "* %sarr.%" PRIitem ", i32 0", is_local ? "%" : "@", id);
+			uni_printf(info->io, "* %sarr.%" PRIitem ", i32 0", is_local ? "%" : "@", id);
 		}
 		else
 		{
-			uni_printf(info->sx->io, "* %%.%" PRIitem ", i32 0", prev_slice);
+			uni_printf(info->io, "* %%.%" PRIitem ", i32 0", prev_slice);
 		}
 	}
 	else if (cur_dimension == dimensions - 1)
 	{
 		type_to_io(info, type);
-		uni_printf(info->sx->io, ", ");
+		uni_printf(info->io, ", ");
 		type_to_io(info, type);
-		uni_printf(info->sx->io, "* %%dynarr.%" PRIitem, id);
+		uni_printf(info->io, "* %%dynarr.%" PRIitem, id);
 	}
 	else
 	{
 		type_to_io(info, type);
-		uni_printf(info->sx->io, ", ");
+		uni_printf(info->io, ", ");
 		type_to_io(info, type);
-		uni_printf(info->sx->io, "* %%.%" PRIitem, prev_slice);
+		uni_printf(info->io, "* %%.%" PRIitem, prev_slice);
 	}
 
 	if (info->answer_kind == AREG)
 	{
-		uni_printf(info->sx->io, ", i32 %%.%zu\n", info->answer_reg);
+		uni_printf(info->io, ", i32 %%.%zu\n", info->answer_reg);
 	}
 	else // if (info->answer_kind == ACONST)
 	{
-		uni_printf(info->sx->io, ", i32 %" PRIitem "\n", info->answer_const);
+		uni_printf(info->io, ", i32 %" PRIitem "\n", info->answer_const);
 	}
 
 	info->register_num++;
@@ -621,13 +844,13 @@ static void to_code_slice(information *const info, const item_t id, const size_t
 
 static void to_code_int_to_char(information *const info, const size_t reg)
 {
-	uni_printf(info->sx->io, " %%.%zu = trunc i32 %%.%zu to i8\n", info->register_num, reg);
+	uni_printf(info->io, " %%.%zu = trunc i32 %%.%zu to i8\n", info->register_num, reg);
 	info->register_num++;
 }
 
 static void to_code_char_to_int(information *const info, const size_t reg)
 {
-	uni_printf(info->sx->io, " %%.%zu = zext i8 %%.%zu to i32\n", info->register_num, reg);
+	uni_printf(info->io, " %%.%zu = zext i8 %%.%zu to i32\n", info->register_num, reg);
 	info->register_num++;
 }
 
@@ -705,9 +928,15 @@ static void global_initialization(information *const info)
 
 			if (type_is_array(info->sx, type) && has_init)
 			{
-				const size_t dimensions = array_get_dim(info, type);
 				const node initializer = declaration_variable_get_initializer(&decl);
-				emit_one_dimension_initialization(info, &initializer, id, type, dimensions - 1, 0, false);
+				const size_t index = hash_get_index(&info->arrays, (item_t)id);
+
+				// Массивы с константными инициализаторами уже заданы в объявлении
+				if (!array_initializer_is_constant(info, &initializer, index, 1))
+				{
+					const size_t dimensions = array_get_dim(info, type);
+					emit_one_dimension_initialization(info, &initializer, id, type, dimensions - 1, 0, false);
+				}
 			}
 		}
 	}
@@ -737,11 +966,11 @@ static void emit_cast_expression(information *const info, const node *const nd)
 	const node expression_to_cast = expression_cast_get_operand(nd);
 	emit_expression(info, &expression_to_cast);
 
-	uni_printf(info->sx->io, " %%.%zu = sitofp ", info->register_num);
+	uni_printf(info->io, " %%.%zu = sitofp ", info->register_num);
 	type_to_io(info, source_type);
-	uni_printf(info->sx->io, " %%.%zu to ", info->answer_reg);
+	uni_printf(info->io, " %%.%zu to ", info->answer_reg);
 	type_to_io(info, target_type);
-	uni_printf(info->sx->io, "\n");
+	uni_printf(info->io, "\n");
 
 	info->answer_reg = info->register_num++;
 }
@@ -931,7 +1160,7 @@ static void emit_subscript_expression(information *const info, const node *const
 			}
 			else
 			{
-				uni_printf(info->sx->io, " call void @exit(i32 1)");
+				uni_printf(info->io, " call void @exit(i32 1)");
 				info->answer_const = ITEM_MAX;
 			}
 		}
@@ -981,6 +1210,54 @@ static void emit_subscript_expression(information *const info, const node *const
 	info->answer_kind = AREG;
 }
 
+/**
+ *	Emit call of message builtin, runtime passes structure msg_info by fields
+ *
+ *	@param	info		Encoder
+ *	@param	nd			Node in AST
+ *	@param	func_ref	Builtin function
+ */
+static void emit_message_call(information *const info, const node *const nd, const size_t func_ref)
+{
+	if (func_ref == BI_MSG_SEND)
+	{
+		info->variable_location = LFREE;
+		const node argument = expression_call_get_argument(nd, 0);
+		emit_expression(info, &argument);
+
+		for (size_t i = 0; i < 2; i++)
+		{
+			uni_printf(info->io, " %%.%zu = extractvalue ", info->register_num + i);
+			type_to_io(info, TYPE_MSG_INFO);
+			uni_printf(info->io, " %%.%zu, %zu\n", info->answer_reg, i);
+		}
+
+		uni_printf(info->io, " call void @t_msg_send(i32 %%.%zu, i32 %%.%zu)\n"
+			, info->register_num, info->register_num + 1);
+		info->register_num += 2;
+		return;
+	}
+
+	// Номер отправителя в младшей половине, данные в старшей
+	const size_t result = info->register_num;
+	uni_printf(info->io, " %%.%zu = call i64 @t_msg_receive()\n", result);
+	uni_printf(info->io, " %%.%zu = trunc i64 %%.%zu to i32\n", result + 1, result);
+	uni_printf(info->io, " %%.%zu = lshr i64 %%.%zu, 32\n", result + 2, result);
+	uni_printf(info->io, " %%.%zu = trunc i64 %%.%zu to i32\n", result + 3, result + 2);
+
+	uni_printf(info->io, " %%.%zu = insertvalue ", result + 4);
+	type_to_io(info, TYPE_MSG_INFO);
+	uni_printf(info->io, " undef, i32 %%.%zu, 0\n", result + 1);
+
+	uni_printf(info->io, " %%.%zu = insertvalue ", result + 5);
+	type_to_io(info, TYPE_MSG_INFO);
+	uni_printf(info->io, " %%.%zu, i32 %%.%zu, 1\n", result + 4, result + 3);
+
+	info->register_num += 6;
+	info->answer_kind = AREG;
+	info->answer_reg = result + 5;
+}
+
 /**
  *	Emit call expression
  *
@@ -1012,6 +1289,12 @@ static void emit_call_expression(information *const info, const node *const nd)
 		info->was_function[func_ref] = true;
 	}
 
+	if (func_ref == BI_MSG_SEND || func_ref == BI_MSG_RECEIVE)
+	{
+		emit_message_call(info, nd, func_ref);
+		return;
+	}
+
 	size_t func_reg = 0;
 	if (!ident_is_local(info->sx, func_ref))
 	{
@@ -1031,7 +1314,7 @@ static void emit_call_expression(information *const info, const node *const nd)
 		// TODO: сделать параметры других типов (логическое)
 		arguments_type[i] = info->answer_kind;
 
-		if (info->answer_kind == AREG || info->answer_kind == ALOGIC)
+		if (info->answer_kind == AREG || info->answer_kind == ALOGIC || info->answer_kind == AMEM)
 		{
 			arguments[i] = info->answer_reg;
 		}
@@ -1055,16 +1338,16 @@ static void emit_call_expression(information *const info, const node *const nd)
 
 	if (!type_is_void(func_type))
 	{
-		uni_printf(info->sx->io, " %%.%zu =", info->register_num);
+		uni_printf(info->io, " %%.%zu =", info->register_num);
 		info->answer_kind = AREG;
 		info->answer_reg = info->register_num++;
 	}
-	uni_printf(info->sx->io, " call ");
+	uni_printf(info->io, " call ");
 
 	if (func_ref == BI_ROUND)
 	{
 		type_to_io(info, TYPE_FLOATING);
-		uni_printf(info->sx->io, " @llvm.round.f64(");
+		uni_printf(info->io, " @llvm.round.f64(");
 	}
 	else
 	{
@@ -1073,21 +1356,21 @@ static void emit_call_expression(information *const info, const node *const nd)
 		info->is_call = false;
 		if (ident_is_local(info->sx, func_ref))
 		{
-			uni_printf(info->sx->io, " @");
+			uni_printf(info->io, " @");
 			func_name_to_io(info, func_ref);
 		}
 		else
 		{
-			uni_printf(info->sx->io, " %%.%zu", func_reg);
+			uni_printf(info->io, " %%.%zu", func_reg);
 		}
-		uni_printf(info->sx->io, "(");
+		uni_printf(info->io, "(");
 	}
 
 	for (size_t i = 0; i < args; i++)
 	{
 		if (i != 0)
 		{
-			uni_printf(info->sx->io, ", ");
+			uni_printf(info->io, ", ");
 		}
 
 		if (arguments_type[i] == ASTR)
@@ -1095,7 +1378,7 @@ static void emit_call_expression(information *const info, const node *const nd)
 			const size_t index = (size_t)arguments[i];
 			const size_t string_length = strings_length(info->sx, index);
 
-			uni_printf(info->sx->io, "i8* getelementptr inbounds "
+			uni_printf(info->io, "i8* getelementptr inbounds "
 				"([%zu x i8], [%zu x i8]* @.str%zu, i32 0, i32 0)"
 				, string_length + 1
 				, string_length + 1
@@ -1129,19 +1412,25 @@ static void emit_call_expression(information *const info, const node *const nd)
 			const node argument = expression_call_get_argument(nd, i);
 			const size_t id = expression_identifier_get_id(&argument);
 
-			uni_printf(info->sx->io, " @");
+			uni_printf(info->io, " @");
 			func_name_to_io(info, id);
 		}
 		else if (arguments_type[i] == AREG || arguments_type[i] == ALOGIC)
 		{
-			uni_printf(info->sx->io, " %%.%" PRIitem, arguments[i]);
+			uni_printf(info->io, " %%.%" PRIitem, arguments[i]);
+		}
+		else if (arguments_type[i] == AMEM)
+		{
+			// Адрес переменной -- это сама переменная в памяти
+			uni_printf(info->io, " %svar.%" PRIitem, ident_is_local(info->sx, (size_t)arguments[i]) ? "%" : "@"
+				, arguments[i]);
 		}
 		else if (arguments_type[i] == ASTR)
 		{
 			const size_t index = (size_t)arguments[i];
 			const size_t string_length = strings_length(info->sx, index);
 
-			uni_printf(info->sx->io, "i8* getelementptr inbounds "
+			uni_printf(info->io, "i8* getelementptr inbounds "
 				"([%zu x i8], [%zu x i8]* @.str%zu, i32 0, i32 0)"
 				, string_length + 1
 				, string_length + 1
@@ -1149,22 +1438,22 @@ static void emit_call_expression(information *const info, const node *const nd)
 		}
 		else if (type_is_integer(info->sx, arguments_value_type[i])) // ACONST
 		{
-			uni_printf(info->sx->io, " %" PRIitem, arguments[i]);
+			uni_printf(info->io, " %" PRIitem, arguments[i]);
 		}
 		else if (type_is_boolean(info->sx, arguments_value_type[i]))
 		{
-			uni_printf(info->sx->io, " %s", arguments_bool[i] ? "true" : "false");
+			uni_printf(info->io, " %s", arguments_bool[i] ? "true" : "false");
 		}
 		else // double
 		{
-			uni_printf(info->sx->io, " %f", arguments_double[i]);
+			uni_printf(info->io, " %f", arguments_double[i]);
 		}
 	}
-	uni_printf(info->sx->io, ")\n");
+	uni_printf(info->io, ")\n");
 
 	if (func_ref == BI_ROUND)
 	{
-		uni_printf(info->sx->io, " %%.%zu = fptosi double %%.%zu to i32\n", info->register_num, info->answer_reg);
+		uni_printf(info->io, " %%.%zu = fptosi double %%.%zu to i32\n", info->register_num, info->answer_reg);
 		info->answer_reg = info->register_num++;
 	}
 }
@@ -1219,14 +1508,14 @@ static void emit_member_expression(information *const info, const node *const nd
 		is_complex = true;
 		info->variable_location = loc;
 
-		uni_printf(info->sx->io, " %%.%zu = extractvalue %%struct_opt.%" PRIitem " %%.%zu, %" PRIitem "\n"
+		uni_printf(info->io, " %%.%zu = extractvalue %%struct_opt.%" PRIitem " %%.%zu, %" PRIitem "\n"
 			, info->register_num, type, info->register_num - 1, place);
 
 		info->answer_reg = info->register_num++;
 		return;
 	}
 
-	uni_printf(info->sx->io, " %%.%zu = getelementptr inbounds %%struct_opt.%" PRIitem ", " 
+	uni_printf(info->io, " %%.%zu = getelementptr inbounds %%struct_opt.%" PRIitem ", " 
 		"%%struct_opt.%" PRIitem "* %s.%zu, i32 0, i32 %" PRIitem "\n", info->register_num, type, type
 		, is_complex ? "%" : (ident_is_local(info->sx, id) ? "%var" : "@var"), is_complex ? info->register_num - 1 : id, place);
 
@@ -1326,7 +1615,20 @@ static void emit_unary_expression(information *const info, const node *const nd)
 			info->variable_location = LREG;
 			emit_expression(info, &operand);
 
-			if (operator == UN_MINUS && type_is_integer(info->sx, operation_type))
+			// Константный операнд остаётся только там, где свёртка невозможна из-за переполнения
+			if (info->answer_kind == ACONST && operator == UN_MINUS && type_is_integer(info->sx, operation_type))
+			{
+				to_code_operation_const_const_integer(info, BIN_SUB, 0, info->answer_const, operation_type);
+			}
+			else if (info->answer_kind == ACONST && operator == UN_NOT)
+			{
+				to_code_operation_const_const_integer(info, BIN_XOR, info->answer_const, -1, operation_type);
+			}
+			else if (info->answer_kind == ACONST && operator == UN_MINUS)
+			{
+				to_code_operation_const_const_double(info, BIN_SUB, 0, info->answer_const_double);
+			}
+			else if (operator == UN_MINUS && type_is_integer(info->sx, operation_type))
 			{
 				to_code_operation_const_reg_integer(info, BIN_SUB, 0, info->answer_reg, operation_type);
 			}
@@ -1408,22 +1710,33 @@ static void emit_unary_expression(information *const info, const node *const nd)
 			info->variable_location = LFREE;
 			emit_expression(info, &operand);
 
-			uni_printf(info->sx->io, " %%.%zu = call ", info->register_num);
+			uni_printf(info->io, " %%.%zu = call ", info->register_num);
 			type_to_io(info, type);
 
 			if (type_is_integer(info->sx, type))
 			{
-				uni_printf(info->sx->io, " @abs(");
+				uni_printf(info->io, " @abs(");
 				info->was_abs = true;
 			}
 			else
 			{
-				uni_printf(info->sx->io, " @llvm.fabs.f64(");
+				uni_printf(info->io, " @llvm.fabs.f64(");
 				info->was_fabs = true;
 			}
 
 			type_to_io(info, type);
-			uni_printf(info->sx->io, " %%.%zu)\n", info->answer_reg);
+			if (info->answer_kind == ACONST && type_is_integer(info->sx, type))
+			{
+				uni_printf(info->io, " %" PRIitem ")\n", info->answer_const);
+			}
+			else if (info->answer_kind == ACONST)
+			{
+				uni_printf(info->io, " %f)\n", info->answer_const_double);
+			}
+			else
+			{
+				uni_printf(info->io, " %%.%zu)\n", info->answer_reg);
+			}
 
 			info->answer_kind = AREG;
 			info->answer_reg = info->register_num++;
@@ -1447,7 +1760,7 @@ static void emit_unary_expression(information *const info, const node *const nd)
 						upb *= (size_t)hash_get(&info->arrays, id, i);
 					}
 
-					uni_printf(info->sx->io, " %%.%zu = add nsw i32 0, %zu\n", info->register_num, upb);
+					uni_printf(info->io, " %%.%zu = add nsw i32 0, %zu\n", info->register_num, upb);
 					info->answer_kind = AREG;
 					info->answer_reg = info->register_num++;
 				}
@@ -1457,7 +1770,7 @@ static void emit_unary_expression(information *const info, const node *const nd)
 
 					for (size_t i = 2; i <= dimensions; i++)
 					{
-						uni_printf(info->sx->io, " %%.%zu = mul nsw i32 %%.%zu, %%.%zu\n"
+						uni_printf(info->io, " %%.%zu = mul nsw i32 %%.%zu, %%.%zu\n"
 							, info->register_num, upb_reg, (size_t)hash_get(&info->arrays, id, i));
 						upb_reg = info->register_num++;
 					}
@@ -1540,6 +1853,14 @@ static void emit_integral_expression(information *const info, const node *const
 	{
 		to_code_operation_const_reg_double(info, operation, left_const_double, right_reg);
 	}
+	else if (left_kind == ACONST && right_kind == ACONST && type_is_integer(info->sx, operation_type))
+	{
+		to_code_operation_const_const_integer(info, operation, left_const, right_const, operation_type);
+	}
+	else if (left_kind == ACONST && right_kind == ACONST) // double
+	{
+		to_code_operation_const_const_double(info, operation, left_const_double, right_const_double);
+	}
 	else if (left_kind == AREG && right_kind == ANULL)
 	{
 		to_code_operation_reg_null(info, operation, left_reg, operation_type);
@@ -1774,7 +2095,7 @@ static void emit_binary_expression(information *const info, const node *const nd
 			if (!is_logic)
 			{
 				to_code_label(info, info->label_false);
-				uni_printf(info->sx->io, " %%.%zu = phi i1 [ %s, %%%s%zu ], [ %%.%zu, %%label%zu ]\n", info->register_num
+				uni_printf(info->io, " %%.%zu = phi i1 [ %s, %%%s%zu ], [ %%.%zu, %%label%zu ]\n", info->register_num
 					, operator == BIN_LOG_OR ? "true" : "false", info->label_phi_previous == 0 ? "" : "label"
 					, info->label_phi_previous, info->register_num - 1, label_next);
 
@@ -1865,11 +2186,11 @@ static void emit_ternary_expression(information *const info, const node *const n
 	to_code_unconditional_branch(info, label_end);
 	to_code_label(info, label_end);
 
-	uni_printf(info->sx->io, " %%.%zu = phi ", info->register_num);
+	uni_printf(info->io, " %%.%zu = phi ", info->register_num);
 	type_to_io(info, expression_get_type(nd));
-	uni_printf(info->sx->io, " [ %s%" PRIitem ", %%label%zu ]", then_answer == AREG ? "%." : ""
+	uni_printf(info->io, " [ %s%" PRIitem ", %%label%zu ]", then_answer == AREG ? "%." : ""
 		, then_answer == AREG ? then_reg : then_const, label_then);
-	uni_printf(info->sx->io, ", [ %s%" PRIitem ", %%label%zu ]\n", else_answer == AREG ? "%." : ""
+	uni_printf(info->io, ", [ %s%" PRIitem ", %%label%zu ]\n", else_answer == AREG ? "%." : ""
 		, else_answer == AREG ? else_reg : else_const, label_else);
 
 	info->answer_kind = AREG;
@@ -1900,7 +2221,7 @@ static void emit_initializer_expression(information *const info, const node *con
 			const node initializer = expression_initializer_get_subexpr(nd, i);
 			emit_expression(info, &initializer);
 
-			uni_printf(info->sx->io, " %%.%zu = getelementptr inbounds %%struct_opt.%zu, " 
+			uni_printf(info->io, " %%.%zu = getelementptr inbounds %%struct_opt.%zu, " 
 			"%%struct_opt.%zu* %%.%zu, i32 0, i32 %zu\n", info->register_num
 				, structure_type, structure_type, slice_reg, i);
 
@@ -2077,6 +2398,14 @@ static void emit_initialization(information *const info, const node *const nd, c
 			to_code_alloc_array_static(info, index, type, true);
 			emit_one_dimension_initialization(info, nd, id, arr_type, dimensions - 1, 0, is_local);
 		}
+		else if (array_initializer_is_constant(info, nd, index, 1))
+		{
+			uni_printf(info->io, "@arr.%" PRIitem " = global ", id);
+			to_code_array_type(info, index, 1, type);
+			uni_printf(info->io, " ");
+			to_code_array_constant(info, nd, index, 1, type);
+			uni_printf(info->io, ", align 4\n");
+		}
 		else
 		{
 			to_code_alloc_array_static(info, index, type, false);
@@ -2122,7 +2451,7 @@ static void emit_initialization(information *const info, const node *const nd, c
 				const item_t type = expression_get_type(&initializer);
 
 				const size_t member_reg = (size_t)info->register_num;
-				uni_printf(info->sx->io, " %%.%zu = getelementptr inbounds %%struct_opt.%" PRIitem
+				uni_printf(info->io, " %%.%zu = getelementptr inbounds %%struct_opt.%" PRIitem
 					", %%struct_opt.%" PRIitem "* %%var.%" PRIitem ", i32 0, i32 %zu\n"
 					, info->register_num, arr_type, arr_type, id, i);
 				info->register_num++;
@@ -2147,7 +2476,7 @@ static void emit_initialization(information *const info, const node *const nd, c
 		}
 		else
 		{
-			uni_printf(info->sx->io, "global %%struct_opt.%" PRIitem " { ", arr_type);
+			uni_printf(info->io, "global %%struct_opt.%" PRIitem " { ", arr_type);
 
 			for (size_t i = 0; i < N && N != SIZE_MAX; i++)
 			{
@@ -2158,22 +2487,22 @@ static void emit_initialization(information *const info, const node *const nd, c
 
 				if (i != 0)
 				{
-					uni_printf(info->sx->io, ", ");
+					uni_printf(info->io, ", ");
 				}
 
 				// константа типа int
 				if (type_is_integer(info->sx, type))
 				{
-					uni_printf(info->sx->io, "i32 %" PRIitem, info->answer_const);
+					uni_printf(info->io, "i32 %" PRIitem, info->answer_const);
 				}
 				// константа типа double
 				else
 				{
-					uni_printf(info->sx->io, "double %f", info->answer_const_double);
+					uni_printf(info->io, "double %f", info->answer_const_double);
 				}
 			}
 
-			uni_printf(info->sx->io, " }, align 4\n");
+			uni_printf(info->io, " }, align 4\n");
 		}
 	}
 	else if (expression_get_class(nd) == EXPR_CALL && type_is_structure(info->sx, expression_get_type(nd)))
@@ -2209,10 +2538,7 @@ static void emit_variable_declaration(information *const info, const node *const
 
 	if (!type_is_array(info->sx, type) && is_local) // обычная переменная int a; или struct point p;
 	{
-		uni_printf(info->sx->io, " %%var.%zu = alloca ", id);
-		type_to_io(info, type);
-		uni_printf(info->sx->io, ", align 4\n");
-
+		// Память под переменную выделена в начале функции
 		if (declaration_variable_has_initializer(nd))
 		{
 			info->variable_location = LFREE;
@@ -2290,7 +2616,7 @@ static void emit_variable_declaration(information *const info, const node *const
 	}
 	else if (!type_is_array(info->sx, type) && !is_local) // глобальные переменные
 	{
-		uni_printf(info->sx->io, "@var.%zu = ", id);
+		uni_printf(info->io, "@var.%zu = ", id);
 
 		if (declaration_variable_has_initializer(nd))
 		{
@@ -2309,46 +2635,51 @@ static void emit_variable_declaration(information *const info, const node *const
 
 			if (info->answer_kind == ACONST)
 			{
-				uni_printf(info->sx->io, "global ");
+				uni_printf(info->io, "global ");
 				type_to_io(info, type);
 				if (type_is_integer(info->sx, type))
 				{
-					uni_printf(info->sx->io, " %" PRIitem ", align 4\n", info->answer_const);
+					uni_printf(info->io, " %" PRIitem ", align 4\n", info->answer_const);
 				}
 				else
 				{
-					uni_printf(info->sx->io, " %f, align 4\n", info->answer_const_double);
+					uni_printf(info->io, " %f, align 4\n", info->answer_const_double);
 				}
 			}
 		}
 		else
 		{
-			uni_printf(info->sx->io, "common global ");
+			uni_printf(info->io, "common global ");
 			type_to_io(info, type);
 
 			if (type_is_integer(info->sx, type))
 			{
-				uni_printf(info->sx->io, " 0");
+				uni_printf(info->io, " 0");
 			}
 			else if (type_is_floating(info->sx, type))
 			{
-				uni_printf(info->sx->io, " 0.0");
+				uni_printf(info->io, " 0.0");
 			}
 			else if (type_is_boolean(info->sx, type))  
 			{
-				uni_printf(info->sx->io, " false");
+				uni_printf(info->io, " false");
 			}
 			else if (type_is_structure(info->sx, type))
 			{
-				uni_printf(info->sx->io, " zeroinitializer");
+				uni_printf(info->io, " zeroinitializer");
 			}
 			else if (type_is_pointer(info->sx, type))
 			{
-				uni_printf(info->sx->io, " null");
+				uni_printf(info->io, " null");
 			}
-			uni_printf(info->sx->io, ", align 4\n");
+			uni_printf(info->io, ", align 4\n");
 		}
 	}
+	else if (hash_get_index(&info->arrays, (item_t)id) != SIZE_MAX)
+	{
+		// Массив без инициализатора уже размещён в начале функции
+		return;
+	}
 	else // массив
 	{
 		const size_t dimensions = array_get_dim(info, type);
@@ -2412,111 +2743,657 @@ static void emit_variable_declaration(information *const info, const node *const
 }
 
 /**
- * Emit function definition
+ *	Check if array declaration has no initializer and all its bounds are integer literals
  *
- * @param	info	Encoder
- * @param	nd		Node in AST
+ *	@param	info	Encoder
+ *	@param	nd		Array declaration
+ *
+ *	@return	@c true, if array may be allocated in the entry block of function
  */
-static void emit_function_definition(information *const info, const node *const nd)
+static bool array_has_fixed_size(information *const info, const node *const nd)
 {
-	const size_t ref_ident = declaration_function_get_id(nd);
-	const item_t func_type = ident_get_type(info->sx, ref_ident);
-	const item_t ret_type = ref_ident != info->sx->ref_main ? type_function_get_return_type(info->sx, func_type) : TYPE_INTEGER;
-	const size_t parameters = type_function_get_parameter_amount(info->sx, func_type);
-	info->was_dynamic = false;
-
-	uni_printf(info->sx->io, "define ");
-	type_to_io(info, ret_type);
-	
-	if (ref_ident == info->sx->ref_main)
+	const item_t type = ident_get_type(info->sx, declaration_variable_get_id(nd));
+	const size_t bounds = declaration_variable_get_bounds_amount(nd);
+	if (declaration_variable_has_initializer(nd) || bounds != array_get_dim(info, type))
 	{
-		uni_printf(info->sx->io, " @main(");
-		info->is_main = true;
+		return false;
 	}
-	else
+
+	for (size_t i = 0; i < bounds; i++)
 	{
-		uni_printf(info->sx->io, " @");
-		func_name_to_io(info, ref_ident);
-		uni_printf(info->sx->io, "(");
+		const node bound = declaration_variable_get_bound(nd, i);
+		if (expression_get_class(&bound) != EXPR_LITERAL || !type_is_integer(info->sx, expression_get_type(&bound)))
+		{
+			return false;
+		}
 	}
 
-	for (size_t i = 0; i < parameters; i++)
-	{
-		uni_printf(info->sx->io, i == 0 ? "" : ", ");
+	return true;
+}
 
-		const item_t param_type = type_function_get_parameter_type(info->sx, func_type, i);
-		type_to_io(info, param_type);
-	}
-	uni_printf(info->sx->io, ") {\n");
+/**
+ *	Emit allocation of local variable in the entry block of function
+ *
+ *	@param	info	Encoder
+ *	@param	nd		Variable declaration
+ */
+static void emit_local_allocation(information *const info, const node *const nd)
+{
+	const size_t id = declaration_variable_get_id(nd);
+	const item_t type = ident_get_type(info->sx, id);
 
-	for (size_t i = 0; i < parameters; i++)
+	if (!type_is_array(info->sx, type))
 	{
-		const size_t id = declaration_function_get_parameter(nd, i);
-		const item_t param_type = ident_get_type(info->sx, id);
+		uni_printf(info->io, " %%var.%zu = alloca ", id);
+		type_to_io(info, type);
+		uni_printf(info->io, ", align 4\n");
+		return;
+	}
 
-		uni_printf(info->sx->io, " %%var.%zu = alloca ", id);
-		type_to_io(info, param_type);
-		uni_printf(info->sx->io, ", align 4\n");
+	if (!array_has_fixed_size(info, nd))
+	{
+		return;
+	}
 
-		uni_printf(info->sx->io, " store ");
-		type_to_io(info, param_type);
-		uni_printf(info->sx->io, " %%%zu, ", i);
-		type_to_io(info, param_type);
-		uni_printf(info->sx->io, "* %%var.%zu, align 4\n", id);
+	const size_t dimensions = array_get_dim(info, type);
+	const size_t bounds = declaration_variable_get_bounds_amount(nd);
+	const size_t index = hash_add(&info->arrays, (item_t)id, 1 + dimensions);
+	hash_set_by_index(&info->arrays, index, IS_STATIC, 1);
+	for (size_t i = 0; i < bounds; i++)
+	{
+		const node bound = declaration_variable_get_bound(nd, i);
+		hash_set_by_index(&info->arrays, index, 1 + i, expression_literal_get_integer(&bound));
+	}
 
-		if (type_is_array(info->sx, param_type))
-		{
-			uni_printf(info->sx->io, " %%dynarr.%zu = load ", id);
-			type_to_io(info, param_type);
-			uni_printf(info->sx->io, ", ");
-			type_to_io(info, param_type);
-			uni_printf(info->sx->io, "* %%var.%zu, align 4\n", id);
+	to_code_alloc_array_static(info, index, array_get_type(info, type), true);
+}
 
-			const size_t dimensions = array_get_dim(info, param_type);
-			const size_t index = hash_add(&info->arrays, id, 1 + dimensions);
-			hash_set_by_index(&info->arrays, index, IS_STATIC, 0);
-		}
+/**
+ *	Emit allocations of local variables of function body in its entry block,
+ *	so that they are not repeated in loops and may be promoted to registers
+ *
+ *	@param	info	Encoder
+ *	@param	nd		Node in AST
+ */
+static void emit_local_allocations(information *const info, const node *const nd)
+{
+	if (node_get_type(nd) == OP_DECL_VAR)
+	{
+		emit_local_allocation(info, nd);
 	}
 
-	if (ref_ident == info->sx->ref_main)
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
 	{
-		global_initialization(info);
+		const node child = node_get_child(nd, i);
+		emit_local_allocations(info, &child);
 	}
+}
 
-	const node body = declaration_function_get_body(nd);
-	emit_compound_statement(info, &body, true);
-
-	if (type_is_void(ret_type))
+/**
+ *	Check if subtree allocates stack memory during execution
+ *
+ *	@param	info	Encoder
+ *	@param	nd		Node in AST
+ *
+ *	@return	@c true, if stack has to be restored after subtree
+ */
+static bool node_has_stack_allocation(information *const info, const node *const nd)
+{
+	if (node_get_type(nd) == OP_DECL_VAR)
 	{
-		if (info->was_dynamic)
+		const size_t id = declaration_variable_get_id(nd);
+		if (type_is_array(info->sx, ident_get_type(info->sx, id))
+			&& hash_get_index(&info->arrays, (item_t)id) == SIZE_MAX)
 		{
-			to_code_stack_load(info, -1);
+			return true;
 		}
-		uni_printf(info->sx->io, " ret void\n");
 	}
-	else if (ref_ident == info->sx->ref_main)
+	else if (node_get_type(nd) == OP_INITIALIZER && type_is_array(info->sx, expression_get_type(nd)))
 	{
-		uni_printf(info->sx->io, " ret i32 0\n");
-		info->is_main = false;
+		return true;
 	}
-	uni_printf(info->sx->io, " unreachable\n");
-	uni_printf(info->sx->io, "}\n\n");
-}
 
-static void emit_declaration(information *const info, const node *const nd, const bool is_local)
-{
-	switch (declaration_get_class(nd))
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
 	{
-		case DECL_VAR:
-			emit_variable_declaration(info, nd, is_local);
-			return;
+		const node child = node_get_child(nd, i);
+		if (node_has_stack_allocation(info, &child))
+		{
+			return true;
+		}
+	}
 
-		case DECL_FUNC:
-			emit_function_definition(info, nd);
-			return;
+	return false;
+}
 
-		default:
-			// С объявлением типа ничего делать не нужно
+/**
+ *	Remove attribute from function
+ *
+ *	@param	info		Encoder
+ *	@param	id			Function id
+ *	@param	attribute	Removed attribute
+ */
+static inline void function_clear_attribute(information *const info, const size_t id, const attribute_t attribute)
+{
+	hash_set(&info->functions, (item_t)id, 0, hash_get(&info->functions, (item_t)id, 0) & ~(item_t)attribute);
+}
+
+/**
+ *	Add attribute to function
+ *
+ *	@param	info		Encoder
+ *	@param	id			Function id
+ *	@param	attribute	Added attribute
+ */
+static inline void function_set_attribute(information *const info, const size_t id, const attribute_t attribute)
+{
+	hash_set(&info->functions, (item_t)id, 0, hash_get(&info->functions, (item_t)id, 0) | (item_t)attribute);
+}
+
+/**
+ *	Check if function has attribute
+ *
+ *	@param	info		Encoder
+ *	@param	id			Function id
+ *	@param	attribute	Checked attribute
+ *
+ *	@return	@c true, if function has attribute
+ */
+static inline bool function_has_attribute(information *const info, const size_t id, const attribute_t attribute)
+{
+	return (hash_get(&info->functions, (item_t)id, 0) & (item_t)attribute) != 0;
+}
+
+/**
+ *	Get index of function parameter by its identifier
+ *
+ *	@param	info		Encoder
+ *	@param	function	Function definition
+ *	@param	id			Identifier
+ *
+ *	@return	Index of parameter, @c SIZE_MAX if identifier is not a parameter
+ */
+static size_t function_get_parameter_index(information *const info, const node *const function, const size_t id)
+{
+	const item_t type = ident_get_type(info->sx, declaration_function_get_id(function));
+	const size_t parameters = type_function_get_parameter_amount(info->sx, type);
+	for (size_t i = 0; i < parameters; i++)
+	{
+		if (declaration_function_get_parameter(function, i) == id)
+		{
+			return i;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/**
+ *	Check if expression refers to memory outside of function frame
+ *
+ *	@param	info		Encoder
+ *	@param	function	Function definition
+ *	@param	nd			Base of subscript
+ *
+ *	@return	@c true, if base is not a local array of function
+ */
+static bool function_is_outer_memory(information *const info, const node *const function, const node *const nd)
+{
+	if (node_get_type(nd) == OP_SLICE)
+	{
+		return false;	// Проверяется при обходе вложенной вырезки
+	}
+
+	if (node_get_type(nd) != OP_IDENTIFIER)
+	{
+		return true;
+	}
+
+	const size_t id = expression_identifier_get_id(nd);
+	return !ident_is_local(info->sx, id) || function_get_parameter_index(info, function, id) != SIZE_MAX;
+}
+
+/**
+ *	Get identifier of function definition
+ *
+ *	@param	info		Encoder
+ *	@param	definitions	Definitions by identifiers of predeclarations
+ *	@param	id			Identifier of function definition or predeclaration
+ *
+ *	@return	Identifier of function definition, @c SIZE_MAX if function is not defined
+ */
+static size_t function_get_definition(information *const info, const vector *const definitions, const size_t id)
+{
+	if (hash_get_index(&info->functions, (item_t)id) != SIZE_MAX)
+	{
+		return id;
+	}
+
+	// Вызов функции до её определения ссылается на предварительное объявление
+	const item_t definition = id < vector_size(definitions) ? vector_get(definitions, id) : 0;
+	return definition > 0 ? (size_t)definition : SIZE_MAX;
+}
+
+/**
+ *	Collect facts about function body for function attributes
+ *
+ *	@param	info		Encoder
+ *	@param	function	Function definition
+ *	@param	nd			Node in function body
+ *	@param	definitions	Definitions by identifiers of predeclarations
+ *	@param	calls		Pairs of caller and callee ids of direct calls
+ */
+static void function_analyze(information *const info, const node *const function, const node *const nd
+	, const vector *const definitions, vector *const calls)
+{
+	const size_t function_id = declaration_function_get_id(function);
+	size_t first_child = 0;
+
+	switch (node_get_type(nd))
+	{
+		case OP_IDENTIFIER:
+		{
+			const size_t id = expression_identifier_get_id(nd);
+			const size_t definition = function_get_definition(info, definitions, id);
+			if (definition != SIZE_MAX)
+			{
+				function_set_attribute(info, definition, ATTR_ADDRESS_TAKEN);
+			}
+			else if (!ident_is_local(info->sx, id) || type_is_function(info->sx, ident_get_type(info->sx, id)))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+			}
+
+			// Параметр, использованный не как основание обращения к памяти, считается захваченным
+			const size_t parameter = function_get_parameter_index(info, function, id);
+			if (parameter != SIZE_MAX)
+			{
+				hash_set(&info->functions, (item_t)function_id, 1 + parameter, 0);
+			}
+			return;
+		}
+
+		case OP_LITERAL:
+			if (type_is_array(info->sx, expression_get_type(nd)))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+			}
+			return;
+
+		case OP_CALL:
+		{
+			const node callee = expression_call_get_callee(nd);
+			const size_t id = expression_identifier_get_id(&callee);
+			const size_t definition = function_get_definition(info, definitions, id);
+			if (definition != SIZE_MAX)
+			{
+				vector_add(calls, (item_t)function_id);
+				vector_add(calls, (item_t)definition);
+			}
+			else
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+				if (id >= BEGIN_USER_FUNC)
+				{
+					function_set_attribute(info, function_id, ATTR_INDIRECT_CALLS);
+				}
+				if (id >= BEGIN_USER_FUNC && !ident_is_local(info->sx, id))
+				{
+					// Функция из другой единицы трансляции может вызвать текущую
+					function_set_attribute(info, function_id, ATTR_UNKNOWN_CALLS);
+				}
+			}
+
+			const size_t arguments = expression_call_get_arguments_amount(nd);
+			for (size_t i = 0; i < arguments; i++)
+			{
+				const node argument = expression_call_get_argument(nd, i);
+				if (type_is_function(info->sx, expression_get_type(&argument)))
+				{
+					// Переданная функция может быть вызвана из вызываемой
+					function_set_attribute(info, function_id, ATTR_INDIRECT_CALLS);
+				}
+			}
+
+			first_child = 1;
+			break;
+		}
+
+		case OP_SLICE:
+		{
+			const node base = expression_subscript_get_base(nd);
+			if (function_is_outer_memory(info, function, &base))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+			}
+
+			if (node_get_type(&base) == OP_IDENTIFIER)
+			{
+				first_child = 1;
+			}
+			break;
+		}
+
+		case OP_SELECT:
+		{
+			const node base = expression_member_get_base(nd);
+			if (expression_member_is_arrow(nd))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+				if (node_get_type(&base) == OP_IDENTIFIER)
+				{
+					first_child = 1;
+				}
+			}
+			break;
+		}
+
+		case OP_UNARY:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			if (expression_unary_get_operator(nd) == UN_INDIRECTION)
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+				if (node_get_type(&operand) == OP_IDENTIFIER)
+				{
+					first_child = 1;
+				}
+			}
+			break;
+		}
+
+		case OP_INITIALIZER:
+			if (type_is_array(info->sx, expression_get_type(nd)))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+			}
+			break;
+
+		case OP_DECL_VAR:
+		{
+			// Массивы переменного размера выделяются на стеке вызовами stacksave
+			const size_t id = declaration_variable_get_id(nd);
+			if (type_is_array(info->sx, ident_get_type(info->sx, id)) && !array_has_fixed_size(info, nd))
+			{
+				function_clear_attribute(info, function_id, ATTR_READNONE);
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = first_child; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		function_analyze(info, function, &child, definitions, calls);
+	}
+}
+
+/**
+ *	Derive attributes of function definitions from AST
+ *
+ *	@param	info		Encoder
+ *	@param	nd			Translation unit
+ */
+static void functions_analysis(information *const info, const node *const nd)
+{
+	const size_t size = translation_unit_get_size(nd);
+	vector definitions = vector_create(vector_size(&info->sx->identifiers));
+	vector_increase(&definitions, vector_size(&info->sx->identifiers));
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) == DECL_FUNC)
+		{
+			const size_t id = declaration_function_get_id(&decl);
+			const size_t prev = ident_get_prev(info->sx, id);
+			if (prev != 0 && prev < vector_size(&definitions) && type_is_function(info->sx, ident_get_type(info->sx, prev)))
+			{
+				vector_set(&definitions, prev, (item_t)id);
+			}
+
+			const size_t parameters = type_function_get_parameter_amount(info->sx, ident_get_type(info->sx, id));
+			const size_t index = hash_add(&info->functions, (item_t)id, 1 + parameters);
+
+			// В main до тела выполняется инициализация глобальных переменных
+			hash_set_by_index(&info->functions, index, 0, id != info->sx->ref_main ? ATTR_READNONE : 0);
+			for (size_t j = 0; j < parameters; j++)
+			{
+				hash_set_by_index(&info->functions, index, 1 + j, 1);
+			}
+		}
+	}
+
+	vector calls = vector_create(HASH_TABLE_SIZE);
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) == DECL_FUNC)
+		{
+			const node body = declaration_function_get_body(&decl);
+			function_analyze(info, &decl, &body, &definitions, &calls);
+		}
+	}
+	vector_clear(&definitions);
+
+	// Функция обращается к памяти, если к ней обращается вызываемая
+	const size_t calls_size = vector_size(&calls);
+	for (bool was_changed = true; was_changed; )
+	{
+		was_changed = false;
+		for (size_t i = 0; i < calls_size; i += 2)
+		{
+			const size_t caller = (size_t)vector_get(&calls, i);
+			const size_t callee = (size_t)vector_get(&calls, i + 1);
+			if (function_has_attribute(info, caller, ATTR_READNONE) && !function_has_attribute(info, callee, ATTR_READNONE))
+			{
+				function_clear_attribute(info, caller, ATTR_READNONE);
+				was_changed = true;
+			}
+		}
+	}
+
+	// Функция не лежит на цикле графа вызовов, если среди функций, не отмеченных norecurse,
+	// у неё нет вызываемых или вызывающих.  Функции между циклами остаются без атрибута
+	for (bool was_changed = true; was_changed; )
+	{
+		was_changed = false;
+		bool has_indirect_caller = false;
+		bool has_address_taken = false;
+		for (size_t i = 0; i < size; i++)
+		{
+			const node decl = translation_unit_get_declaration(nd, i);
+			if (declaration_get_class(&decl) == DECL_FUNC)
+			{
+				const size_t id = declaration_function_get_id(&decl);
+				function_clear_attribute(info, id, ATTR_HAS_CALLER | ATTR_HAS_CALLEE);
+				if (!function_has_attribute(info, id, ATTR_NORECURSE))
+				{
+					has_indirect_caller = has_indirect_caller || function_has_attribute(info, id, ATTR_INDIRECT_CALLS);
+					has_address_taken = has_address_taken || function_has_attribute(info, id, ATTR_ADDRESS_TAKEN);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < calls_size; i += 2)
+		{
+			const size_t caller = (size_t)vector_get(&calls, i);
+			const size_t callee = (size_t)vector_get(&calls, i + 1);
+			if (!function_has_attribute(info, caller, ATTR_NORECURSE) && !function_has_attribute(info, callee, ATTR_NORECURSE))
+			{
+				function_set_attribute(info, caller, ATTR_HAS_CALLEE);
+				function_set_attribute(info, callee, ATTR_HAS_CALLER);
+			}
+		}
+
+		for (size_t i = 0; i < size; i++)
+		{
+			const node decl = translation_unit_get_declaration(nd, i);
+			if (declaration_get_class(&decl) != DECL_FUNC)
+			{
+				continue;
+			}
+
+			const size_t id = declaration_function_get_id(&decl);
+			if (function_has_attribute(info, id, ATTR_NORECURSE | ATTR_UNKNOWN_CALLS))
+			{
+				continue;
+			}
+
+			// Вызов по указателю может попасть в любую функцию, адрес которой используется
+			const bool has_callee = function_has_attribute(info, id, ATTR_HAS_CALLEE)
+				|| (function_has_attribute(info, id, ATTR_INDIRECT_CALLS) && has_address_taken);
+			const bool has_caller = function_has_attribute(info, id, ATTR_HAS_CALLER)
+				|| (function_has_attribute(info, id, ATTR_ADDRESS_TAKEN) && has_indirect_caller);
+			if (!has_callee || !has_caller)
+			{
+				function_set_attribute(info, id, ATTR_NORECURSE);
+				was_changed = true;
+			}
+		}
+	}
+
+	vector_clear(&calls);
+}
+
+/**
+ * Emit function definition
+ *
+ * @param	info	Encoder
+ * @param	nd		Node in AST
+ */
+static void emit_function_definition(information *const info, const node *const nd)
+{
+	const size_t ref_ident = declaration_function_get_id(nd);
+	const item_t func_type = ident_get_type(info->sx, ref_ident);
+	const item_t ret_type = ref_ident != info->sx->ref_main ? type_function_get_return_type(info->sx, func_type) : TYPE_INTEGER;
+	const size_t parameters = type_function_get_parameter_amount(info->sx, func_type);
+	info->was_dynamic = false;
+	info->ret_type = ret_type;
+
+	// Нумерация регистров и меток своя в каждой функции, поэтому функции генерируются независимо
+	info->register_num = 1;
+	info->label_num = 1;
+	info->block_num = 1;
+
+	uni_printf(info->io, "define ");
+	type_to_io(info, ret_type);
+	
+	if (ref_ident == info->sx->ref_main)
+	{
+		uni_printf(info->io, " @main(");
+		info->is_main = true;
+	}
+	else
+	{
+		uni_printf(info->io, " @");
+		func_name_to_io(info, ref_ident);
+		uni_printf(info->io, "(");
+	}
+
+	for (size_t i = 0; i < parameters; i++)
+	{
+		uni_printf(info->io, i == 0 ? "" : ", ");
+
+		const item_t param_type = type_function_get_parameter_type(info->sx, func_type, i);
+		type_to_io(info, param_type);
+
+		if ((type_is_pointer(info->sx, param_type) || type_is_array(info->sx, param_type))
+			&& hash_get(&info->functions, (item_t)ref_ident, 1 + i))
+		{
+			uni_printf(info->io, " nocapture");
+		}
+	}
+	uni_printf(info->io, ") nounwind");
+
+	if (function_has_attribute(info, ref_ident, ATTR_READNONE))
+	{
+		uni_printf(info->io, " readnone");
+	}
+	if (function_has_attribute(info, ref_ident, ATTR_NORECURSE))
+	{
+		uni_printf(info->io, " norecurse");
+	}
+	uni_printf(info->io, " {\n");
+
+	for (size_t i = 0; i < parameters; i++)
+	{
+		const size_t id = declaration_function_get_parameter(nd, i);
+		const item_t param_type = ident_get_type(info->sx, id);
+
+		uni_printf(info->io, " %%var.%zu = alloca ", id);
+		type_to_io(info, param_type);
+		uni_printf(info->io, ", align 4\n");
+
+		uni_printf(info->io, " store ");
+		type_to_io(info, param_type);
+		uni_printf(info->io, " %%%zu, ", i);
+		type_to_io(info, param_type);
+		uni_printf(info->io, "* %%var.%zu, align 4", id);
+		to_code_tbaa(info, param_type);
+		uni_printf(info->io, "\n");
+
+		if (type_is_array(info->sx, param_type))
+		{
+			uni_printf(info->io, " %%dynarr.%zu = load ", id);
+			type_to_io(info, param_type);
+			uni_printf(info->io, ", ");
+			type_to_io(info, param_type);
+			uni_printf(info->io, "* %%var.%zu, align 4", id);
+			to_code_tbaa(info, param_type);
+			uni_printf(info->io, "\n");
+
+			const size_t dimensions = array_get_dim(info, param_type);
+			const size_t index = hash_add(&info->arrays, id, 1 + dimensions);
+			hash_set_by_index(&info->arrays, index, IS_STATIC, 0);
+		}
+	}
+
+	const node body = declaration_function_get_body(nd);
+	emit_local_allocations(info, &body);
+
+	if (ref_ident == info->sx->ref_main)
+	{
+		global_initialization(info);
+	}
+
+	emit_compound_statement(info, &body, true);
+
+	if (type_is_void(ret_type))
+	{
+		if (info->was_dynamic)
+		{
+			to_code_stack_load(info, -1);
+		}
+		uni_printf(info->io, " ret void\n");
+	}
+	else if (ref_ident == info->sx->ref_main)
+	{
+		uni_printf(info->io, " ret i32 0\n");
+		info->is_main = false;
+	}
+	uni_printf(info->io, " unreachable\n");
+	uni_printf(info->io, "}\n\n");
+}
+
+static void emit_declaration(information *const info, const node *const nd, const bool is_local)
+{
+	switch (declaration_get_class(nd))
+	{
+		case DECL_VAR:
+			emit_variable_declaration(info, nd, is_local);
+			return;
+
+		case DECL_FUNC:
+			emit_function_definition(info, nd);
+			return;
+
+		default:
+			// С объявлением типа ничего делать не нужно
 			return;
 	}
 }
@@ -2540,7 +3417,8 @@ static void emit_declaration(information *const info, const node *const nd, cons
 static void emit_compound_statement(information *const info, const node *const nd, const bool is_function_body)
 {
 	const item_t block_num = info->block_num++;
-	if (!is_function_body)
+	const bool has_stack_save = !is_function_body && node_has_stack_allocation(info, nd);
+	if (has_stack_save)
 	{
 		to_code_stack_save(info, block_num);
 	}
@@ -2554,7 +3432,7 @@ static void emit_compound_statement(information *const info, const node *const n
 		if ((statement_get_class(&substmt) == STMT_CASE || statement_get_class(&substmt) == STMT_DEFAULT)
 			&& i == size - 1)
 		{
-			if (!is_function_body)
+			if (has_stack_save)
 			{
 				to_code_stack_load(info, block_num);
 			}
@@ -2562,7 +3440,7 @@ static void emit_compound_statement(information *const info, const node *const n
 		}
 		else if (i == size - 1)
 		{
-			if (!is_function_body)
+			if (has_stack_save)
 			{
 				to_code_stack_load(info, block_num);
 			}
@@ -2641,6 +3519,7 @@ static void emit_while_statement(information *const info, const node *const nd)
 	info->variable_location = LFREE;
 	const node condition = statement_while_get_condition(nd);
 	emit_expression(info, &condition);
+	const bool is_constant = info->answer_kind == ACONST;
 
 	check_type_and_branch(info, expression_get_type(&condition));
 
@@ -2649,7 +3528,7 @@ static void emit_while_statement(information *const info, const node *const nd)
 	const node body = statement_while_get_body(nd);
 	emit_statement(info, &body);
 
-	to_code_unconditional_branch(info, label_condition);
+	to_code_loop_branch(info, label_condition, is_constant);
 	to_code_label(info, label_end);
 
 	info->label_true = old_label_true;
@@ -2728,6 +3607,7 @@ static void emit_for_statement(information *const info, const node *const nd)
 		emit_statement(info, &inition);
 	}
 
+	bool is_constant = true;
 	if (statement_for_has_condition(nd))
 	{
 		to_code_unconditional_branch(info, label_condition);
@@ -2736,6 +3616,7 @@ static void emit_for_statement(information *const info, const node *const nd)
 		info->variable_location = LFREE;
 		const node condition = statement_for_get_condition(nd);
 		emit_expression(info, &condition);
+		is_constant = info->answer_kind == ACONST;
 		check_type_and_branch(info, expression_get_type(&condition));
 	}
 	else
@@ -2752,7 +3633,7 @@ static void emit_for_statement(information *const info, const node *const nd)
 
 	if (statement_for_has_condition(nd))
 	{
-		to_code_unconditional_branch(info, label_condition);
+		to_code_loop_branch(info, label_condition, is_constant);
 	}
 	else
 	{
@@ -2798,24 +3679,31 @@ static void emit_return_statement(information *const info, const node *const nd)
 
 		// TODO: добавить обработку других ответов (ALOGIC)
 		const item_t answer_type = expression_get_type(&expression);
-		if (info->answer_kind == ACONST && type_is_integer(info->sx, answer_type))
+		if ((info->answer_kind == ANULL || info->answer_kind == ACONST) && type_is_pointer(info->sx, info->ret_type))
+		{
+			// Функции потоков возвращают нулевой указатель через return 0
+			uni_printf(info->io, " ret ");
+			type_to_io(info, info->ret_type);
+			uni_printf(info->io, " null\n");
+		}
+		else if (info->answer_kind == ACONST && type_is_integer(info->sx, answer_type))
 		{
-			uni_printf(info->sx->io, " ret i32 %" PRIitem "\n", info->answer_const);
+			uni_printf(info->io, " ret i32 %" PRIitem "\n", info->answer_const);
 		}
 		else if (info->answer_kind == ACONST && type_is_floating(info->sx, answer_type))
 		{
-			uni_printf(info->sx->io, " ret double %f\n", info->answer_const_double);
+			uni_printf(info->io, " ret double %f\n", info->answer_const_double);
 		}
 		else if (info->answer_kind == AREG)
 		{
-			uni_printf(info->sx->io, " ret ");
+			uni_printf(info->io, " ret ");
 			type_to_io(info, answer_type);
-			uni_printf(info->sx->io, " %%.%zu\n", info->answer_reg);
+			uni_printf(info->io, " %%.%zu\n", info->answer_reg);
 		}
 	}
 	else
 	{
-		uni_printf(info->sx->io, " ret void\n");
+		uni_printf(info->io, " ret void\n");
 	}
 }
 
@@ -2889,16 +3777,16 @@ static void emit_switch_statement(information *const info, const node *const nd)
 		}
 	}
 
-	uni_printf(info->sx->io, " switch ");
+	uni_printf(info->io, " switch ");
 	type_to_io(info, expression_get_type(&condition));
-	uni_printf(info->sx->io, " %%.%zu, label %%label%zu [\n", info->answer_reg, info->label_switch - case_num - has_default);
+	uni_printf(info->io, " %%.%zu, label %%label%zu [\n", info->answer_reg, info->label_switch - case_num - has_default);
 	for (size_t i = 0; i < case_num; i++)
 	{
-		uni_printf(info->sx->io, "  ");
+		uni_printf(info->io, "  ");
 		type_to_io(info, expression_get_type(&condition));
-		uni_printf(info->sx->io, " %" PRIitem ", label %%label%zu\n", case_values[i], info->label_switch - i);
+		uni_printf(info->io, " %" PRIitem ", label %%label%zu\n", case_values[i], info->label_switch - i);
 	}
-	uni_printf(info->sx->io, " ]\n");
+	uni_printf(info->io, " ]\n");
 
 	info->label_break = info->label_switch - case_num - has_default;
 	if (statement_get_class(&body) == STMT_COMPOUND)
@@ -2908,6 +3796,33 @@ static void emit_switch_statement(information *const info, const node *const nd)
 	to_code_label(info, info->label_break);
 }
 
+/**
+ *	Emit type based alias analysis tree and loop properties
+ *
+ *	@param	info		Encoder
+ */
+static void metadata_declaration(information *const info)
+{
+	uni_printf(info->io, "\n!%i = !{!\"RuC TBAA\"}\n", MD_TBAA_ROOT);
+	uni_printf(info->io, "!%i = !{!\"omnipotent char\", !%i, i64 0}\n", MD_TBAA_CHAR, MD_TBAA_ROOT);
+	uni_printf(info->io, "!%i = !{!\"bool\", !%i, i64 0}\n", MD_TBAA_BOOL, MD_TBAA_CHAR);
+	uni_printf(info->io, "!%i = !{!\"int\", !%i, i64 0}\n", MD_TBAA_INT, MD_TBAA_CHAR);
+	uni_printf(info->io, "!%i = !{!\"double\", !%i, i64 0}\n", MD_TBAA_DOUBLE, MD_TBAA_CHAR);
+	uni_printf(info->io, "!%i = !{!\"any pointer\", !%i, i64 0}\n", MD_TBAA_POINTER, MD_TBAA_CHAR);
+
+	for (int i = MD_TBAA_CHAR; i <= MD_TBAA_POINTER; i++)
+	{
+		uni_printf(info->io, "!%i = !{!%i, !%i, i64 0}\n", MD_TBAA_CHAR_ACCESS + i - MD_TBAA_CHAR, i, i);
+	}
+
+	uni_printf(info->io, "!%i = !{!\"llvm.loop.mustprogress\"}\n", MD_LOOP_MUSTPROGRESS);
+	for (size_t i = 0; i < info->loop_num; i++)
+	{
+		uni_printf(info->io, "!%zu = distinct !{!%zu, !%i}\n", MD_LOOP_BEGIN + i, MD_LOOP_BEGIN + i
+			, MD_LOOP_MUSTPROGRESS);
+	}
+}
+
 /**
  *	Emit translation unit
  *
@@ -2995,50 +3910,183 @@ static void emit_statement(information *const info, const node *const nd)
 	}
 }
 
+/**
+ *	Count loops, which may get loop metadata
+ *
+ *	@param	nd			Node in AST
+ *
+ *	@return	Number of loops
+ */
+static size_t loops_count(const node *const nd)
+{
+	size_t loops = node_get_type(nd) == OP_WHILE || node_get_type(nd) == OP_FOR ? 1 : 0;
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		loops += loops_count(&child);
+	}
+
+	return loops;
+}
+
+/**
+ *	Prepare declaration of translation unit: global declaration is emitted at once,
+ *	function definition gets its own copy of encoder state
+ *
+ *	@param	info		Encoder
+ *	@param	def			Declaration
+ *	@param	nd			Node in AST
+ */
+static void definition_prepare(information *const info, definition *const def, const node *const nd)
+{
+	def->nd = *nd;
+	def->io = io_create();
+	out_set_buffer(&def->io, BUFFER_SIZE);
+
+	if (declaration_get_class(nd) != DECL_FUNC)
+	{
+		universal_io *const io = info->io;
+		info->io = &def->io;
+		emit_declaration(info, nd, false);
+		info->io = io;
+		return;
+	}
+
+	// Функции видны только предшествующие ей глобальные массивы
+	def->info = *info;
+	def->info.io = &def->io;
+	def->info.arrays = vector_create(vector_size(&info->arrays));
+	for (size_t i = 0; i < vector_size(&info->arrays); i++)
+	{
+		vector_add(&def->info.arrays, vector_get(&info->arrays, i));
+	}
+
+	// Номера метаданных циклов выделяются заранее, по одному на каждый цикл функции
+	info->loop_num += loops_count(nd);
+}
+
+/**
+ *	Emit function definition into its buffer, task of thread pool
+ *
+ *	@param	context		Declarations
+ *	@param	index		Declaration index
+ */
+static void definition_emit(void *const context, const size_t index)
+{
+	definition *const def = &((definition *)context)[index];
+	if (declaration_get_class(&def->nd) == DECL_FUNC)
+	{
+		emit_function_definition(&def->info, &def->nd);
+	}
+}
+
+/**
+ *	Move code of declaration to output and merge flags of used declarations
+ *
+ *	@param	info		Encoder
+ *	@param	def			Declaration
+ */
+static void definition_finish(information *const info, definition *const def)
+{
+	char *const buffer = out_extract_buffer(&def->io);
+	if (buffer != NULL)
+	{
+		uni_printf(info->io, "%s", buffer);
+		free(buffer);
+	}
+
+	if (declaration_get_class(&def->nd) != DECL_FUNC)
+	{
+		return;
+	}
+
+	info->was_stack_functions = info->was_stack_functions || def->info.was_stack_functions;
+	info->was_file = info->was_file || def->info.was_file;
+	info->was_abs = info->was_abs || def->info.was_abs;
+	info->was_fabs = info->was_fabs || def->info.was_fabs;
+	for (size_t i = 0; i < BEGIN_USER_FUNC; i++)
+	{
+		info->was_function[i] = info->was_function[i] || def->info.was_function[i];
+	}
+
+	hash_clear(&def->info.arrays);
+}
+
 /**
  *	Emit translation unit
  *
  *	@param	info		Encoder
  *	@param	nd			Node in AST
+ *	@param	threads		Number of threads for function definitions
  */
-static int emit_translation_unit(information *const info, const node *const nd)
+static int emit_translation_unit(information *const info, const node *const nd, const size_t threads)
 {
+	functions_analysis(info, nd);
+
+	// Функции генерируются параллельно в свои буферы, которые выводятся в исходном порядке
 	const size_t size = translation_unit_get_size(nd);
-	for (size_t i = 0; i < size; i++)
+	definition *const defs = malloc(size * sizeof(definition));
+	for (size_t i = 0; i < size && defs != NULL; i++)
 	{
 		const node decl = translation_unit_get_declaration(nd, i);
-		emit_declaration(info, &decl, false);
+		definition_prepare(info, &defs[i], &decl);
+	}
+
+	if (defs != NULL)
+	{
+		pool_run(threads, size, &definition_emit, defs);
+		for (size_t i = 0; i < size; i++)
+		{
+			definition_finish(info, &defs[i]);
+		}
+
+		free(defs);
+	}
+	else
+	{
+		// Без памяти под все объявления они генерируются по одному
+		for (size_t i = 0; i < size; i++)
+		{
+			definition def;
+			const node decl = translation_unit_get_declaration(nd, i);
+			definition_prepare(info, &def, &decl);
+			definition_emit(&def, 0);
+			definition_finish(info, &def);
+		}
 	}
 
 	// FIXME: если это тоже объявление функций, почему тут, а не в functions_declaration?
 	if (info->was_stack_functions)
 	{
-		uni_printf(info->sx->io, "declare i8* @llvm.stacksave()\n");
-		uni_printf(info->sx->io, "declare void @llvm.stackrestore(i8*)\n");
+		uni_printf(info->io, "declare i8* @llvm.stacksave()\n");
+		uni_printf(info->io, "declare void @llvm.stackrestore(i8*)\n");
 	}
 
 	if (info->was_file)
 	{
-		uni_printf(info->sx->io, "%%struct._IO_FILE = type { i32, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, "
+		uni_printf(info->io, "%%struct._IO_FILE = type { i32, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, i8*, "
 			"%%struct._IO_marker*, %%struct._IO_FILE*, i32, i32, i64, i16, i8, [1 x i8], i8*, i64, i8*, i8*, i8*, i8*, "
 			"i64, i32, [20 x i8] }\n");
-		uni_printf(info->sx->io, "%%struct._IO_marker = type { %%struct._IO_marker*, %%struct._IO_FILE*, i32 }\n");
+		uni_printf(info->io, "%%struct._IO_marker = type { %%struct._IO_marker*, %%struct._IO_FILE*, i32 }\n");
 	}
 
 	if (info->was_abs)
 	{
-		uni_printf(info->sx->io, "declare i32 @abs(i32)\n");
+		uni_printf(info->io, "declare i32 @abs(i32)\n");
 	}
 
 	if (info->was_fabs)
 	{
-		uni_printf(info->sx->io, "declare double @llvm.fabs.f64(double)\n");
+		uni_printf(info->io, "declare double @llvm.fabs.f64(double)\n");
 	}
 
+	metadata_declaration(info);
 
 	#ifdef _WIN32
-		uni_printf(info->sx->io, "!llvm.linker.options = !{!0}\n");
-		uni_printf(info->sx->io, "!0 = !{!\"/STACK:268435456\"}\n");
+		uni_printf(info->io, "!llvm.linker.options = !{!0}\n");
+		uni_printf(info->io, "!0 = !{!\"/STACK:268435456\"}\n");
 	#endif
 
 	return info->sx->rprt.errors != 0;
@@ -3065,19 +4113,19 @@ static void structs_declaration(information *const info)
 	{
 		if (type_is_structure(info->sx, (item_t)i))
 		{
-			uni_printf(info->sx->io, "%%struct_opt.%zu = type { ", i);
+			uni_printf(info->io, "%%struct_opt.%zu = type { ", i);
 
 			const size_t fields = type_structure_get_member_amount(info->sx, (item_t)i);
 			for (size_t j = 0; j < fields; j++)
 			{
-				uni_printf(info->sx->io, j == 0 ? "" : ", ");
+				uni_printf(info->io, j == 0 ? "" : ", ");
 				const item_t type_structure_field = type_structure_get_member_type(info->sx, (item_t)i, j);
 
 				if (type_is_array(info->sx, type_structure_field))
 				{
 					// const size_t dimensions = array_get_dim(info, type_structure_field);
 					// const item_t element_type = array_get_type(info, type_structure_field);
-					uni_printf(info->sx->io, "here");
+					uni_printf(info->io, "here");
 				}
 				else
 				{
@@ -3085,10 +4133,10 @@ static void structs_declaration(information *const info)
 				}
 			}
 
-			uni_printf(info->sx->io, " }\n");
+			uni_printf(info->io, " }\n");
 		}
 	}
-	uni_printf(info->sx->io, " \n");
+	uni_printf(info->io, " \n");
 }
 
 static void strings_declaration(information *const info)
@@ -3098,7 +4146,7 @@ static void strings_declaration(information *const info)
 	{
 		const char *string = string_get(info->sx, i);
 		const size_t length = strings_length(info->sx, i);
-		uni_printf(info->sx->io, "@.str%zu = private unnamed_addr constant [%zu x i8] c\""
+		uni_printf(info->io, "@.str%zu = private unnamed_addr constant [%zu x i8] c\""
 			, i, length + 1);
 
 		for (size_t j = 0; j < length; j++)
@@ -3106,16 +4154,16 @@ static void strings_declaration(information *const info)
 			const char ch = string[j];
 			if (ch == '\n')
 			{
-				uni_printf(info->sx->io, "\\0A");
+				uni_printf(info->io, "\\0A");
 			}
 			else
 			{
-				uni_printf(info->sx->io, "%c", ch);
+				uni_printf(info->io, "%c", ch);
 			}
 		}
-		uni_printf(info->sx->io, "\\00\", align 1\n");
+		uni_printf(info->io, "\\00\", align 1\n");
 	}
-	uni_printf(info->sx->io, " \n");
+	uni_printf(info->io, " \n");
 }
 
 
@@ -3129,29 +4177,38 @@ static void builin_functions_declaration(information *const info)
 			continue;
 		}
 
-		if (info->was_function[i])
+		// Сообщения передаются в библиотеку потоков по полям
+		if (info->was_function[i] && i == BI_MSG_SEND)
+		{
+			uni_printf(info->io, "declare void @t_msg_send(i32, i32)\n");
+		}
+		else if (info->was_function[i] && i == BI_MSG_RECEIVE)
+		{
+			uni_printf(info->io, "declare i64 @t_msg_receive()\n");
+		}
+		else if (info->was_function[i])
 		{
 			const item_t func_type = ident_get_type(info->sx, i);
 			const item_t ret_type = type_function_get_return_type(info->sx, func_type);
 			const size_t parameters = type_function_get_parameter_amount(info->sx, func_type);
 
-			uni_printf(info->sx->io, "declare ");
+			uni_printf(info->io, "declare ");
 			if (i == BI_ROUND)
 			{
 				type_to_io(info, TYPE_FLOATING);
-				uni_printf(info->sx->io, " @llvm.round.f64(");
+				uni_printf(info->io, " @llvm.round.f64(");
 			}
 			else
 			{
 				type_to_io(info, ret_type);
-				uni_printf(info->sx->io, " @");
+				uni_printf(info->io, " @");
 				func_name_to_io(info, i);
-				uni_printf(info->sx->io, "(");
+				uni_printf(info->io, "(");
 			}
 
 			for (size_t j = 0; j < parameters; j++)
 			{
-				uni_printf(info->sx->io, j == 0 ? "" : ", ");
+				uni_printf(info->io, j == 0 ? "" : ", ");
 
 				item_t type_parameter = type_function_get_parameter_type(info->sx, func_type, j);
 				if (type_is_pointer(info->sx, type_parameter))
@@ -3163,7 +4220,7 @@ static void builin_functions_declaration(information *const info)
 				}
 				type_to_io(info, type_parameter);
 			}
-			uni_printf(info->sx->io, ")\n");
+			uni_printf(info->io, ")\n");
 		}
 	}
 }
@@ -3173,7 +4230,7 @@ static void builin_functions_declaration(information *const info)
 static void runtime(information *const info)
 {
 	// assert
-	uni_printf(info->sx->io, "@.str = private unnamed_addr constant [3 x i8] c\"%%s\\00\", align 1\n"
+	uni_printf(info->io, "@.str = private unnamed_addr constant [3 x i8] c\"%%s\\00\", align 1\n"
 		"define void @assert(i1, i8*) {\n"
 		" %%3 = alloca i1, align 4\n"
 		" %%4 = alloca i8*, align 8\n"
@@ -3193,18 +4250,18 @@ static void runtime(information *const info)
 
 	// TODO: тут пока заглушки
 	// print
-	uni_printf(info->sx->io, "define void @print(...) {\n"
+	uni_printf(info->io, "define void @print(...) {\n"
 		" ret void\n"
 		"}\n");
 
 	// printid
-	uni_printf(info->sx->io, "define void @printid(...) {\n"
+	uni_printf(info->io, "define void @printid(...) {\n"
 		" ret void\n"
 		"}\n\n");
 	info->was_function[BI_PRINTF] = true;
 
 	// getid
-	uni_printf(info->sx->io, "define void @getid(...) {\n"
+	uni_printf(info->io, "define void @getid(...) {\n"
 		" ret void\n"
 		"}\n\n");
 }
@@ -3228,6 +4285,7 @@ int encode_to_llvm(const workspace *const ws, syntax *const sx)
 
 	information info;
 	info.sx = sx;
+	info.io = sx->io;
 	info.register_num = 1;
 	info.label_num = 1;
 	info.label_switch = 0;
@@ -3250,6 +4308,8 @@ int encode_to_llvm(const workspace *const ws, syntax *const sx)
 	}
 
 	info.arrays = hash_create(HASH_TABLE_SIZE);
+	info.functions = hash_create(HASH_TABLE_SIZE);
+	info.loop_num = 0;
 
 	architecture(ws, sx);
 	structs_declaration(&info);
@@ -3258,9 +4318,10 @@ int encode_to_llvm(const workspace *const ws, syntax *const sx)
 
 	// TODO: нормальное получение корня
 	const node root = node_get_root(&info.sx->tree);
-	const int ret = emit_translation_unit(&info, &root);
+	const int ret = emit_translation_unit(&info, &root, pool_get_threads(ws));
 	builin_functions_declaration(&info);
 
 	hash_clear(&info.arrays);
+	hash_clear(&info.functions);
 	return ret;
 }
@@ -26,6 +26,7 @@ extern "C" {
 
 /**
  *	Encode to low level virtual machine codes
+ *	@note	Flag @c -j<number> sets number of threads for function definitions
  *
  *	@param	ws				Compiler workspace
  *	@param	sx				Syntax structure
@@ -15,19 +15,37 @@
  */
 
 #include "mipsgen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "AST.h"
 #include "hash.h"
 #include "operations.h"
+#include "pool.h"
 #include "tree.h"
 #include "uniprinter.h"
+#include "vector.h"
 
 
 #ifndef max
 	#define max(a, b) ((a) > (b) ? (a) : (b))
 #endif
 
+#ifndef min
+	#define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+
+#define ELF_HEADER_SIZE 52
+#define ELF_SECTION_HEADER_SIZE 40
+#define ELF_SYMBOL_SIZE 16
+#define ELF_RELOCATION_SIZE 8
+#define ELF_ABIFLAGS_SIZE 24
+#define ELF_FLAGS 0x70001004				/**< mips32r2, o32, cpic */
+#define ELF_FLAG_NOREORDER 0x1
+
 
 static const size_t BUFFER_SIZE = 65536;			/**< Размер буфера для тела функции */
+static const size_t CODE_SIZE = 1024;				/**< Начальный размер массива инструкций тела функции */
 static const size_t HASH_TABLE_SIZE = 1024;			/**< Размер хеш-таблицы для смещений и регистров */
 static const bool IS_ON_STACK = true;				/**< Хранится ли переменная на стеке */
 
@@ -49,6 +67,11 @@ static const size_t PRESERVED_FP_REG_AMOUNT = 10;	/**< Количество со
 
 static const bool FROM_LVALUE = 1;					/**< Получен ли rvalue из lvalue */
 
+static const size_t MIN_TABLE_CASES = 4;			/**< Минимальное количество case для таблицы переходов */
+static const size_t SCHEDULE_WINDOW = 128;			/**< Наибольшая длина участка кода для планирования инструкций */
+static const item_t MIN_IMMEDIATE = -32768;			/**< Минимальное значение 16-битного непосредственного операнда */
+static const item_t MAX_IMMEDIATE = 32767;			/**< Максимальное значение 16-битного непосредственного операнда */
+
 /**< Смещение в стеке для сохранения оберегаемых регистров, без учёта оптимизаций */
 static const size_t FUNC_DISPL_PRESEREVED = /* за $sp */ 4 + /* за $ra */ 4 +
 											/* fs0-fs10 (одинарная точность): */ 5 * 4 + /* s0-s7: */ 8 * 4;
@@ -157,7 +180,9 @@ typedef enum INSTRUCTION
 	IC_MIPS_NOT,		/**< MIPS Pseudo-Instruction. Flips the bits of the source register and
 							stores them in the destination register (не из вышеуказанной книги) */
 
+	IC_MIPS_LUI,		/**< To load a constant into the upper half of a word */
 	IC_MIPS_ADDI,		/**< To add a constant to a 32-bit integer. If overflow occurs, then trap */
+	IC_MIPS_ADDIU,		/**< To add a constant to a 32-bit integer */
 	IC_MIPS_SLL,		/**< To left-shift a word by a fixed number of bits */
 	IC_MIPS_SRA,		/**< To execute an arithmetic right-shift of a word by a fixed number of bits */
 	IC_MIPS_ANDI,		/**< To do a bitwise logical AND with a constant */
@@ -166,6 +191,8 @@ typedef enum INSTRUCTION
 
 	IC_MIPS_ADD,		/**< To add 32-bit integers. If an overflow occurs, then trap */
 	IC_MIPS_SUB,		/**< To subtract 32-bit integers. If overflow occurs, then trap */
+	IC_MIPS_ADDU,		/**< To add 32-bit integers */
+	IC_MIPS_SUBU,		/**< To subtract 32-bit integers */
 	IC_MIPS_MUL,		/**< To multiply two words and write the result to a GPR */
 	IC_MIPS_DIV,		/**< DIV performs a signed 32-bit integer division, and places
 							the 32-bit quotient result in the destination register */
@@ -203,6 +230,12 @@ typedef enum INSTRUCTION
 
 	IC_MIPS_SLTIU,		/**< Set on Less Than Immediate Unsigned.
 							To record the result of an unsigned less-than comparison with a constant. */
+	IC_MIPS_SLTI,		/**< Set on Less Than Immediate.
+							To record the result of a less-than comparison with a constant. */
+	IC_MIPS_SLTU,		/**< Set on Less Than Unsigned.
+							To record the result of an unsigned less-than comparison. */
+	IC_MIPS_SLT,		/**< Set on Less Than.
+							To record the result of a less-than comparison. */
 
 	IC_MIPS_NOP,		/**< To perform no operation */
 
@@ -244,6 +277,8 @@ typedef enum LABEL
 	L_END,				/**< Тип метки -- переход в конец конструкции */
 	L_BEGIN_CYCLE,		/**< Тип метки -- переход в начало цикла */
 	L_CASE,				/**< Тип метки -- переход по case */
+	L_TABLE,			/**< Тип метки -- таблица переходов switch */
+	L_ARRAY,			/**< Тип метки -- статический массив */
 } mips_label_t;
 
 typedef struct label
@@ -252,6 +287,53 @@ typedef struct label
 	size_t num;
 } label;
 
+/** Case label of switch statement */
+typedef struct case_label
+{
+	item_t value;						/**< Case value */
+	size_t num;							/**< Number of case label */
+} case_label;
+
+/** Operands format of MIPS instruction */
+typedef enum INSTRUCTION_FORMAT
+{
+	FORMAT_NONE,						/**< instr */
+	FORMAT_R,							/**< instr fst_reg */
+	FORMAT_2R,							/**< instr fst_reg, snd_reg */
+	FORMAT_3R,							/**< instr fst_reg, snd_reg, thd_reg */
+	FORMAT_R_I,							/**< instr fst_reg, imm */
+	FORMAT_2R_I,						/**< instr fst_reg, snd_reg, imm */
+	FORMAT_R_I_R,						/**< instr fst_reg, imm(snd_reg) */
+	FORMAT_R_F,							/**< instr fst_reg, float_imm */
+	FORMAT_L,							/**< instr lbl */
+	FORMAT_R_L,							/**< instr fst_reg, lbl */
+	FORMAT_2R_L,						/**< instr fst_reg, snd_reg, lbl */
+	FORMAT_R_HI,						/**< instr fst_reg, %hi(lbl) */
+	FORMAT_2R_LO,						/**< instr fst_reg, snd_reg, %lo(lbl) */
+	FORMAT_LABEL,						/**< lbl: */
+	FORMAT_WORD,						/**< .word lbl */
+	FORMAT_DATA,						/**< .word imm */
+	FORMAT_FLOAT,						/**< .float float_imm */
+	FORMAT_SPACE,						/**< .space imm */
+	FORMAT_ASCII,						/**< .ascii "symbol\0", imm is the length of symbol */
+	FORMAT_DIRECTIVE,					/**< Assembler directive */
+} instruction_format_t;
+
+/** Instruction of function body */
+typedef struct mips_code
+{
+	instruction_format_t format;		/**< Operands format */
+	mips_instruction_t instruction;		/**< Instruction */
+	mips_register_t fst_reg;			/**< First register */
+	mips_register_t snd_reg;			/**< Second register */
+	mips_register_t thd_reg;			/**< Third register */
+	item_t imm;							/**< Immediate operand or displacement */
+	double float_imm;					/**< Floating immediate operand */
+	label lbl;							/**< Label operand */
+	const char *symbol;					/**< External symbol instead of label, directive or string */
+	size_t text;						/**< Position of preceding comments in function body buffer */
+} mips_code;
+
 
 /** Kinds of lvalue */
 typedef enum LVALUE_KIND
@@ -299,6 +381,7 @@ typedef struct rvalue
 typedef struct encoder
 {
 	syntax *sx;								/**< Структура syntax с таблицами */
+	universal_io *io;						/**< Вывод кода */
 
 	size_t max_displ;						/**< Максимальное смещение от $sp */
 	size_t global_displ;					/**< Смещение от $gp */
@@ -321,14 +404,229 @@ typedef struct encoder
 	bool registers[22];						/**< Информация о занятых регистрах */
 
 	size_t scope_displ;						/**< Смещение */
+
+	hash local_registers;					/**< Хеш таблица с распределением локальных переменных по регистрам:
+												@c key		- ссылка на таблицу идентификаторов
+												@c value[0]	- сохраняемый регистр переменной */
+
+	mips_code *code;						/**< Инструкции тела текущей функции */
+	size_t code_size;						/**< Количество инструкций */
+	size_t code_capacity;					/**< Размер выделенной памяти */
+	bool is_buffered;						/**< Set, if instructions are collected into function body */
+	bool is_optimized;						/**< Set, if peephole optimizer is enabled */
+
+	mips_code *object;						/**< Records of the whole program for object file */
+	size_t object_size;						/**< Количество записей */
+	size_t object_capacity;					/**< Размер выделенной памяти */
+	bool is_binary;							/**< Set, if object file is written instead of assembler text */
 } encoder;
 
+/** Live interval of local variable */
+typedef struct live_interval
+{
+	size_t identifier;						/**< Идентификатор переменной */
+	size_t start;							/**< Позиция объявления в обходе тела функции */
+	size_t end;								/**< Позиция последнего использования */
+	size_t reg;								/**< Номер сохраняемого регистра или @c SIZE_MAX */
+	bool is_excluded;						/**< Переменная не может быть размещена на регистре */
+} live_interval;
+
+/** Liveness analysis of function body */
+typedef struct liveness
+{
+	live_interval *intervals;				/**< Интервалы жизни в порядке объявления */
+	size_t size;							/**< Количество интервалов */
+	size_t capacity;						/**< Размер выделенной памяти */
+	size_t position;						/**< Текущая позиция обхода */
+} liveness;
+
+/** Function definition, body of which is emitted into its own buffer */
+typedef struct definition
+{
+	node nd;								/**< Определение функции */
+	encoder enc;							/**< Состояние генерации тела функции */
+	universal_io io;						/**< Буфер с телом функции */
+	char *buffer;							/**< Текст тела функции с комментариями */
+
+	bool has_call;							/**< Set, if function calls other functions */
+	bool has_frame;							/**< Set, if function needs its own frame */
+	unsigned int preserved;					/**< Used preserved registers: bits 0-7 for $s0-$s7, then $fs pairs */
+} definition;
+
+
+/** Sections of object file, numbered as in section header table */
+typedef enum OBJECT_SECTION
+{
+	SECTION_UNDEFINED,
+	SECTION_TEXT,
+	SECTION_REL_TEXT,
+	SECTION_RODATA,
+	SECTION_REL_RODATA,
+	SECTION_DATA,
+	SECTION_REL_DATA,
+	SECTION_BSS,
+	SECTION_ABIFLAGS,
+	SECTION_SYMTAB,
+	SECTION_STRTAB,
+	SECTION_SHSTRTAB,
+	SECTION_AMOUNT,
+} object_section_t;
+
+/** Relocation types of MIPS ELF */
+typedef enum RELOCATION
+{
+	R_MIPS_32 = 2,						/**< Word of data */
+	R_MIPS_26 = 4,						/**< Target of j and jal */
+	R_MIPS_HI16 = 5,					/**< %hi of address */
+	R_MIPS_LO16 = 6,					/**< %lo of address */
+	R_MIPS_PC16 = 10,					/**< Branch to external symbol */
+} mips_relocation_t;
+
+/** Symbol of object file */
+typedef struct object_symbol
+{
+	label lbl;								/**< Label of symbol */
+	const char *name;						/**< Named symbol instead of label */
+	object_section_t section;				/**< Section of definition, @c SECTION_UNDEFINED for external symbol */
+	size_t value;							/**< Offset in section */
+	bool is_section;						/**< Set, if symbol stands for section itself */
+	bool is_global;							/**< Set, if symbol is visible for linker */
+	size_t index;							/**< Index in symbol table of object file */
+} object_symbol;
+
+/** Contents of section with relocations */
+typedef struct object_data
+{
+	uint8_t *bytes;							/**< Contents */
+	size_t size;							/**< Size of contents */
+	size_t capacity;						/**< Размер выделенной памяти */
+	vector relocations;						/**< Relocations: offset, symbol, type */
+} object_data;
+
+/** Assembler of object file */
+typedef struct object
+{
+	object_data text;						/**< Section .text */
+	object_data rodata;						/**< Section .rodata */
+	object_data data;						/**< Section .data */
+	object_section_t section;				/**< Current section */
+
+	object_symbol *symbols;					/**< Symbols in order of definition */
+	size_t symbols_size;					/**< Количество символов */
+	size_t symbols_capacity;				/**< Размер выделенной памяти */
+	hash labels;							/**< Хеш таблица символов меток:
+												@c key		- вид и номер метки
+												@c value[0]	- индекс символа */
+
+	bool is_reordered;						/**< Set, if assembler fills delay slots by nop */
+	bool has_noreorder;						/**< Set, if some code is written in noreorder mode */
+	bool is_final;							/**< Set on second pass, when all labels are defined */
+	bool has_error;							/**< Set, if some instruction can not be encoded */
+	const mips_code *failed;				/**< Record, which can not be encoded */
+	const mips_code *label;					/**< The last label before current record */
+} object;
+
 
 static const rvalue RVALUE_ONE = { .kind = RVALUE_KIND_CONST, .type = TYPE_INTEGER, .val.int_val = 1 };
 static const rvalue RVALUE_NEGATIVE_ONE = { .kind = RVALUE_KIND_CONST, .type = TYPE_INTEGER, .val.int_val = -1 };
 static const rvalue RVALUE_ZERO = { .kind = RVALUE_KIND_CONST, .type = TYPE_INTEGER, .val.int_val = 0 };
 static const rvalue RVALUE_VOID = { .kind = RVALUE_KIND_CONST };
 
+/** Opcodes of MIPS32 machine instructions */
+typedef enum OPCODE
+{
+	OP_SPECIAL = 0x00,
+	OP_REGIMM = 0x01,
+	OP_J = 0x02,
+	OP_JAL = 0x03,
+	OP_BEQ = 0x04,
+	OP_BNE = 0x05,
+	OP_BLEZ = 0x06,
+	OP_BGTZ = 0x07,
+	OP_ADDI = 0x08,
+	OP_ADDIU = 0x09,
+	OP_SLTI = 0x0a,
+	OP_SLTIU = 0x0b,
+	OP_ANDI = 0x0c,
+	OP_ORI = 0x0d,
+	OP_XORI = 0x0e,
+	OP_LUI = 0x0f,
+	OP_COP1 = 0x11,
+	OP_SPECIAL2 = 0x1c,
+	OP_LW = 0x23,
+	OP_SW = 0x2b,
+	OP_LWC1 = 0x31,
+	OP_SWC1 = 0x39,
+} mips_opcode_t;
+
+/** Function fields of MIPS32 machine instructions with opcodes SPECIAL, SPECIAL2 and COP1 */
+typedef enum FUNCTION
+{
+	FN_SLL = 0x00,
+	FN_SRA = 0x03,
+	FN_SLLV = 0x04,
+	FN_SRAV = 0x07,
+	FN_JR = 0x08,
+	FN_BREAK = 0x0d,
+	FN_MFLO = 0x12,
+	FN_MULT = 0x18,
+	FN_DIV = 0x1a,
+	FN_ADD = 0x20,
+	FN_ADDU = 0x21,
+	FN_SUB = 0x22,
+	FN_SUBU = 0x23,
+	FN_AND = 0x24,
+	FN_OR = 0x25,
+	FN_XOR = 0x26,
+	FN_NOR = 0x27,
+	FN_SLT = 0x2a,
+	FN_SLTU = 0x2b,
+
+	FN_MUL = 0x02,						/**< SPECIAL2 */
+
+	FN_ADD_FMT = 0x00,					/**< COP1 */
+	FN_SUB_FMT = 0x01,
+	FN_MUL_FMT = 0x02,
+	FN_DIV_FMT = 0x03,
+	FN_ABS_FMT = 0x05,
+	FN_MOV_FMT = 0x06,
+	FN_CVT_S = 0x20,
+	FN_CVT_D = 0x21,
+	FN_CVT_W = 0x24,
+} mips_function_t;
+
+/** Format fields of COP1 instructions */
+typedef enum COP1_FORMAT
+{
+	FMT_MF = 0x00,						/**< mfc1 */
+	FMT_MFH = 0x03,						/**< mfhc1 */
+	FMT_MT = 0x04,						/**< mtc1 */
+	FMT_S = 0x10,						/**< Single precision */
+	FMT_W = 0x14,						/**< Fixed point word */
+} mips_cop1_format_t;
+
+
+/** Names of sections of object file */
+static const char *const SECTION_NAMES[SECTION_AMOUNT] =
+{
+	"", ".text", ".rel.text", ".rodata", ".rel.rodata", ".data", ".rel.data", ".bss",
+	".MIPS.abiflags", ".symtab", ".strtab", ".shstrtab"
+};
+
+/** Types of sections: PROGBITS, REL, NOBITS, MIPS_ABIFLAGS, SYMTAB, STRTAB */
+static const uint32_t SECTION_TYPES[SECTION_AMOUNT] = { 0, 1, 9, 1, 9, 1, 9, 8, 0x7000002a, 2, 3, 3 };
+
+/** Flags of sections: WRITE 0x1, ALLOC 0x2, EXECINSTR 0x4, INFO_LINK 0x40 */
+static const uint32_t SECTION_FLAGS[SECTION_AMOUNT] = { 0, 0x6, 0x40, 0x2, 0x40, 0x3, 0x40, 0x3, 0x2, 0, 0, 0 };
+
+/** Alignments of sections */
+static const size_t SECTION_ALIGNS[SECTION_AMOUNT] = { 1, 4, 4, 4, 4, 4, 4, 4, 8, 4, 1, 1 };
+
+/** Sizes of section entries */
+static const size_t SECTION_ENTRY_SIZES[SECTION_AMOUNT] =
+	{ 0, 0, ELF_RELOCATION_SIZE, 0, ELF_RELOCATION_SIZE, 0, ELF_RELOCATION_SIZE, 0, ELF_ABIFLAGS_SIZE
+	, ELF_SYMBOL_SIZE, 0, 0 };
+
 
 static lvalue emit_lvalue(encoder *const enc, const node *const nd);
 static void emit_binary_operation(encoder *const enc, const rvalue *const dest
@@ -534,6 +832,45 @@ static void free_rvalue(encoder *const enc, const rvalue *const rval)
 	}
 }
 
+/**
+ *	Check if register is temporary
+ *
+ *	@param	reg					Register
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_temporary_register(const mips_register_t reg)
+{
+	return ((reg >= R_T0) && (reg <= R_T7)) || (reg == R_T8) || (reg == R_T9)
+		|| ((reg >= R_FT0) && (reg <= R_FT11));
+}
+
+/**
+ *	Count free temporary registers
+ *
+ *	@param	enc					Encoder
+ *	@param	is_floating			Set to count floating point registers
+ *
+ *	@return	Amount of free registers
+ */
+static size_t get_free_register_amount(const encoder *const enc, const bool is_floating)
+{
+	const size_t begin = is_floating ? TEMP_REG_AMOUNT : 0;
+	const size_t end = is_floating ? TEMP_REG_AMOUNT + TEMP_FP_REG_AMOUNT : TEMP_REG_AMOUNT;
+	const size_t step = is_floating ? 2 /* т.к. операции с одинарной точностью */ : 1;
+
+	size_t amount = 0;
+	for (size_t i = begin; i < end; i += step)
+	{
+		if (!enc->registers[i])
+		{
+			amount++;
+		}
+	}
+
+	return amount;
+}
+
 /**	Get MIPS assembler binary instruction from binary_t type
  *
  *	@param	operation_type		Type of operation in AST
@@ -830,9 +1167,15 @@ static void instruction_to_io(universal_io *const io, const mips_instruction_t i
 			uni_printf(io, "not");
 			break;
 
+		case IC_MIPS_LUI:
+			uni_printf(io, "lui");
+			break;
 		case IC_MIPS_ADDI:
 			uni_printf(io, "addi");
 			break;
+		case IC_MIPS_ADDIU:
+			uni_printf(io, "addiu");
+			break;
 		case IC_MIPS_SLL:
 			uni_printf(io, "sll");
 			break;
@@ -855,6 +1198,12 @@ static void instruction_to_io(universal_io *const io, const mips_instruction_t i
 		case IC_MIPS_SUB:
 			uni_printf(io, "sub");
 			break;
+		case IC_MIPS_ADDU:
+			uni_printf(io, "addu");
+			break;
+		case IC_MIPS_SUBU:
+			uni_printf(io, "subu");
+			break;
 		case IC_MIPS_MUL:
 			uni_printf(io, "mul");
 			break;
@@ -919,6 +1268,15 @@ static void instruction_to_io(universal_io *const io, const mips_instruction_t i
 		case IC_MIPS_SLTIU:
 			uni_printf(io, "sltiu");
 			break;
+		case IC_MIPS_SLTI:
+			uni_printf(io, "slti");
+			break;
+		case IC_MIPS_SLTU:
+			uni_printf(io, "sltu");
+			break;
+		case IC_MIPS_SLT:
+			uni_printf(io, "slt");
+			break;
 
 		case IC_MIPS_NOP:
 			uni_printf(io, "nop");
@@ -978,119 +1336,375 @@ static void instruction_to_io(universal_io *const io, const mips_instruction_t i
 	}
 }
 
-// Вид инструкции:	instr	fst_reg, snd_reg
-static void to_code_2R(universal_io *const io, const mips_instruction_t instruction
-	, const mips_register_t fst_reg, const mips_register_t snd_reg)
-{
-	uni_printf(io, "\t");
-	instruction_to_io(io, instruction);
-	uni_printf(io, " ");
-	mips_register_to_io(io, fst_reg);
-	uni_printf(io, ", ");
-	mips_register_to_io(io, snd_reg);
-	uni_printf(io, "\n");
-}
-
-// Вид инструкции:	instr	fst_reg, snd_reg, imm
-static void to_code_2R_I(universal_io *const io, const mips_instruction_t instruction
-	, const mips_register_t fst_reg, const mips_register_t snd_reg, const item_t imm)
+/**
+ *	Writes label to io
+ *
+ *	@param	io					Universal io structure
+ *	@param	lbl					Label to write
+ */
+static void label_to_io(universal_io *const io, const label *const lbl)
 {
-	uni_printf(io, "\t");
-	instruction_to_io(io, instruction);
-	uni_printf(io, " ");
-	mips_register_to_io(io, fst_reg);
-	uni_printf(io, ", ");
-	mips_register_to_io(io, snd_reg);
-	uni_printf(io, ", %" PRIitem "\n", imm);
-}
+	switch (lbl->kind)
+	{
+		case L_MAIN:
+			uni_printf(io, "MAIN");
+			break;
+		case L_FUNC:
+			uni_printf(io, "FUNC");
+			break;
+		case L_NEXT:
+			uni_printf(io, "NEXT");
+			break;
+		case L_FUNCEND:
+			uni_printf(io, "FUNCEND");
+			break;
+		case L_STRING:
+			uni_printf(io, "STRING");
+			break;
+		case L_ELSE:
+			uni_printf(io, "ELSE");
+			break;
+		case L_END:
+			uni_printf(io, "END");
+			break;
+		case L_BEGIN_CYCLE:
+			uni_printf(io, "BEGIN_CYCLE");
+			break;
+		case L_CASE:
+			uni_printf(io, "CASE");
+			break;
+		case L_TABLE:
+			uni_printf(io, "TABLE");
+			break;
+		case L_ARRAY:
+			uni_printf(io, "ARRAY");
+			break;
+	}
 
-// Вид инструкции:	instr	fst_reg, imm(snd_reg)
-static void to_code_R_I_R(universal_io *const io, const mips_instruction_t instruction
-	, const mips_register_t fst_reg, const item_t imm, const mips_register_t snd_reg)
-{
-	uni_printf(io, "\t");
-	instruction_to_io(io, instruction);
-	uni_printf(io, " ");
-	mips_register_to_io(io, fst_reg);
-	uni_printf(io, ", %" PRIitem "(", imm);
-	mips_register_to_io(io, snd_reg);
-	uni_printf(io, ")\n");
+	uni_printf(io, "%zu", lbl->num);
 }
 
-// Вид инструкции:	instr	reg, imm
-static void to_code_R_I(universal_io *const io, const mips_instruction_t instruction
-	, const mips_register_t reg, const item_t imm)
+/**
+ *	Writes label operand of instruction to io
+ *
+ *	@param	io					Universal io structure
+ *	@param	code				Instruction
+ */
+static void code_label_to_io(universal_io *const io, const mips_code *const code)
 {
-	uni_printf(io, "\t");
-	instruction_to_io(io, instruction);
-	uni_printf(io, " ");
-	mips_register_to_io(io, reg);
-	uni_printf(io, ", %" PRIitem "\n", imm);
+	if (code->symbol != NULL)
+	{
+		uni_printf(io, "%s", code->symbol);
+	}
+	else
+	{
+		label_to_io(io, &code->lbl);
+	}
 }
 
 /**
- *	Writes @c val field of rvalue structure to io
+ *	Writes instruction to io
  *
  *	@param	io					Universal io structure
- *	@param	rval				Rvalue whose value is to be printed
+ *	@param	code				Instruction to write
  */
-static void rvalue_const_to_io(universal_io *const io, const rvalue *const rval)
+static void code_to_io(universal_io *const io, const mips_code *const code)
 {
-	switch (rval->type)
+	switch (code->format)
 	{
-		case TYPE_BOOLEAN:
-		case TYPE_CHARACTER:
-		case TYPE_INTEGER:
-			uni_printf(io, "%" PRIitem, rval->val.int_val);
+		case FORMAT_LABEL:
+			code_label_to_io(io, code);
+			uni_printf(io, ":\n");
+			return;
+		case FORMAT_WORD:
+			uni_printf(io, "\t.word ");
+			label_to_io(io, &code->lbl);
+			uni_printf(io, "\n");
+			return;
+		case FORMAT_DATA:
+			uni_printf(io, "\t.word %" PRIitem "\n", code->imm);
+			return;
+		case FORMAT_FLOAT:
+			uni_printf(io, "\t.float %f\n", code->float_imm);
+			return;
+		case FORMAT_SPACE:
+			uni_printf(io, "\t.space %" PRIitem "\n", code->imm);
+			return;
+		case FORMAT_ASCII:
+			uni_printf(io, "\t.ascii \"");
+			for (item_t i = 0; i < code->imm; i++)
+			{
+				if (code->symbol[i] == '\n')
+				{
+					uni_printf(io, "\\n");
+				}
+				else
+				{
+					uni_printf(io, "%c", code->symbol[i]);
+				}
+			}
+			uni_printf(io, "\\0\"\n");
+			return;
+		case FORMAT_DIRECTIVE:
+			uni_printf(io, "\t%s\n", code->symbol);
+			return;
+		default:
 			break;
+	}
 
-		case TYPE_FLOATING:
-			uni_printf(io, "%f", rval->val.float_val);
+	uni_printf(io, "\t");
+	instruction_to_io(io, code->instruction);
+
+	switch (code->format)
+	{
+		case FORMAT_R:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			break;
+
+		case FORMAT_2R:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->snd_reg);
+			break;
+
+		case FORMAT_3R:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->snd_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->thd_reg);
+			break;
+
+		case FORMAT_R_I:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", %" PRIitem, code->imm);
+			break;
+
+		case FORMAT_2R_I:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->snd_reg);
+			uni_printf(io, ", %" PRIitem, code->imm);
+			break;
+
+		case FORMAT_R_I_R:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", %" PRIitem "(", code->imm);
+			mips_register_to_io(io, code->snd_reg);
+			uni_printf(io, ")");
+			break;
+
+		case FORMAT_R_F:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", %f", code->float_imm);
+			break;
+
+		case FORMAT_L:
+			uni_printf(io, " ");
+			code_label_to_io(io, code);
+			break;
+
+		case FORMAT_R_L:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			code_label_to_io(io, code);
+			break;
+
+		case FORMAT_2R_L:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->snd_reg);
+			uni_printf(io, ", ");
+			code_label_to_io(io, code);
+			break;
+
+		case FORMAT_R_HI:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", %%hi(");
+			code_label_to_io(io, code);
+			uni_printf(io, ")");
+			break;
+
+		case FORMAT_2R_LO:
+			uni_printf(io, " ");
+			mips_register_to_io(io, code->fst_reg);
+			uni_printf(io, ", ");
+			mips_register_to_io(io, code->snd_reg);
+			uni_printf(io, ", %%lo(");
+			code_label_to_io(io, code);
+			uni_printf(io, ")");
 			break;
 
 		default:
-			system_error(node_unexpected);
 			break;
 	}
+
+	uni_printf(io, "\n");
 }
 
 /**
- *	Writes rvalue to io
+ *	Append record to array of records
  *
- *	@param	enc					Encoder
- *	@param	rval				Rvalue to write
+ *	@param	codes				Array of records
+ *	@param	size				Number of records
+ *	@param	capacity			Size of allocated memory
+ *	@param	code				Record to append
+ *
+ *	@return	Appended record, @c NULL on failure
  */
-static void rvalue_to_io(encoder *const enc, const rvalue *const rval)
+static mips_code *code_append(mips_code **const codes, size_t *const size, size_t *const capacity
+	, const mips_code *const code)
 {
-	assert(rval->kind != RVALUE_KIND_VOID);
+	if (*size == *capacity)
+	{
+		const size_t new_capacity = *capacity == 0 ? CODE_SIZE : 2 * *capacity;
+		mips_code *const new_codes = realloc(*codes, new_capacity * sizeof(mips_code));
+		if (new_codes == NULL)
+		{
+			return NULL;
+		}
+
+		*codes = new_codes;
+		*capacity = new_capacity;
+	}
+
+	(*codes)[*size] = *code;
+	return &(*codes)[(*size)++];
+}
 
-	if (rval->kind == RVALUE_KIND_CONST)
+/**
+ *	Write record to io or keep it for object file
+ *
+ *	@param	enc					Encoder
+ *	@param	code				Record to write
+ */
+static void code_write(encoder *const enc, const mips_code *const code)
+{
+	if (enc->is_binary)
 	{
-		rvalue_const_to_io(enc->sx->io, rval);
+		code_append(&enc->object, &enc->object_size, &enc->object_capacity, code);
 	}
 	else
 	{
-		mips_register_to_io(enc->sx->io, rval->val.reg_num);
+		code_to_io(enc->io, code);
+	}
+}
+
+/**
+ *	Emit instruction. Instructions of function body are collected for peephole optimizer,
+ *	other ones are written immediately
+ *
+ *	@param	enc					Encoder
+ *	@param	code				Instruction to emit
+ */
+static void emit_code(encoder *const enc, const mips_code *const code)
+{
+	if (!enc->is_buffered)
+	{
+		code_write(enc, code);
+		return;
+	}
+
+	mips_code *const record = code_append(&enc->code, &enc->code_size, &enc->code_capacity, code);
+	if (record != NULL)
+	{
+		record->text = out_get_position(enc->io);
 	}
 }
 
+// Вид инструкции:	instr	fst_reg, snd_reg
+static void to_code_2R(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t fst_reg, const mips_register_t snd_reg)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R, .instruction = instruction
+		, .fst_reg = fst_reg, .snd_reg = snd_reg });
+}
+
+// Вид инструкции:	instr	fst_reg, snd_reg, imm
+static void to_code_2R_I(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t fst_reg, const mips_register_t snd_reg, const item_t imm)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_I, .instruction = instruction
+		, .fst_reg = fst_reg, .snd_reg = snd_reg, .imm = imm });
+}
+
+// Вид инструкции:	instr	fst_reg, snd_reg, thd_reg
+static void to_code_3R(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t fst_reg, const mips_register_t snd_reg, const mips_register_t thd_reg)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_3R, .instruction = instruction
+		, .fst_reg = fst_reg, .snd_reg = snd_reg, .thd_reg = thd_reg });
+}
+
+// Вид инструкции:	instr	fst_reg, imm(snd_reg)
+static void to_code_R_I_R(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t fst_reg, const item_t imm, const mips_register_t snd_reg)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_I_R, .instruction = instruction
+		, .fst_reg = fst_reg, .snd_reg = snd_reg, .imm = imm });
+}
+
+// Вид инструкции:	instr	reg, imm
+static void to_code_R_I(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t reg, const item_t imm)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_I, .instruction = instruction, .fst_reg = reg, .imm = imm });
+}
+
+// Вид инструкции:	instr	reg, float_imm
+static void to_code_R_F(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t reg, const double float_imm)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_F, .instruction = instruction, .fst_reg = reg
+		, .float_imm = float_imm });
+}
+
+// Вид инструкции:	instr	symbol
+static void to_code_S(encoder *const enc, const mips_instruction_t instruction, const char *const symbol)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_L, .instruction = instruction, .symbol = symbol });
+}
+
+// Вид инструкции:	directive
+static void to_code_directive(encoder *const enc, const char *const directive)
+{
+	emit_code(enc, &(mips_code){ .format = FORMAT_DIRECTIVE, .symbol = directive });
+}
+
 /**
- *	Writes lvalue to io
+ *	Emit instruction with rvalue operands. Constant second operand is used as immediate
  *
  *	@param	enc					Encoder
- *	@param	lvalue				Lvalue
+ *	@param	instruction			Instruction
+ *	@param	dest				Destination register
+ *	@param	fst_operand			First operand
+ *	@param	snd_operand			Second operand
  */
-static void lvalue_to_io(encoder *const enc, const lvalue *const value)
+static void to_code_rvalues(encoder *const enc, const mips_instruction_t instruction, const mips_register_t dest
+	, const rvalue *const fst_operand, const rvalue *const snd_operand)
 {
-	if (value->kind == LVALUE_KIND_REGISTER)
+	assert(fst_operand->kind == RVALUE_KIND_REGISTER);
+
+	if (snd_operand->kind == RVALUE_KIND_CONST)
 	{
-		mips_register_to_io(enc->sx->io, value->loc.reg_num);
+		const item_t imm = type_is_floating(enc->sx, snd_operand->type)
+			? (item_t)snd_operand->val.float_val
+			: snd_operand->val.int_val;
+		to_code_2R_I(enc, instruction, dest, fst_operand->val.reg_num, imm);
 	}
 	else
 	{
-		uni_printf(enc->sx->io, "%" PRIitem "(", value->loc.displ);
-		mips_register_to_io(enc->sx->io, value->base_reg);
-		uni_printf(enc->sx->io, ")\n");
+		to_code_3R(enc, instruction, dest, fst_operand->val.reg_num, snd_operand->val.reg_num);
 	}
 }
 
@@ -1099,13 +1713,12 @@ static void lvalue_to_io(encoder *const enc, const lvalue *const value)
  *
  *	@param	enc					Encoder
  *	@param	identifier			Identifier for adding to the table
+ *	@param	is_register			Set, if identifier is allocated to saved register
  *
  *	@return	Identifier lvalue
  */
 static lvalue displacements_add(encoder *const enc, const size_t identifier, const bool is_register)
 {
-	// TODO: выдача сохраняемых регистров 
-	assert(is_register == false);
 	const bool is_local = ident_is_local(enc->sx, identifier);
 	const mips_register_t base_reg = is_local ? R_FP : R_GP;
 	const item_t type = ident_get_type(enc->sx, identifier);
@@ -1114,7 +1727,9 @@ static lvalue displacements_add(encoder *const enc, const size_t identifier, con
 		enc->scope_displ += mips_type_size(enc->sx, type);
 		enc->max_displ = max(enc->scope_displ, enc->max_displ);
 	}
-	const item_t location = is_local ? -(item_t)enc->scope_displ : (item_t)enc->global_displ;
+	const item_t location = is_register
+		? hash_get(&enc->local_registers, identifier, 0)
+		: is_local ? -(item_t)enc->scope_displ : (item_t)enc->global_displ;
 
 	if ((!is_local) && (is_register))	// Запрет на глобальные регистровые переменные
 	{
@@ -1171,46 +1786,226 @@ static lvalue displacements_get(encoder *const enc, const size_t identifier)
 }
 
 /**
- *	Emit label
+ *	Check if expression contains function call
+ *
+ *	@param	nd					Node in AST
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool has_call(const node *const nd)
+{
+	if (node_get_type(nd) == OP_CALL)
+	{
+		return true;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (has_call(&child))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Add live interval of local variable
  *
  *	@param	enc					Encoder
- *	@param	label				Label for emitting
+ *	@param	lvn					Liveness analysis
+ *	@param	identifier			Variable identifier
+ *	@param	position			Position of declaration
  */
-static void emit_label(encoder *const enc, const label *const lbl)
+static void liveness_add(encoder *const enc, liveness *const lvn, const size_t identifier, const size_t position)
 {
-	universal_io *const io = enc->sx->io;
-	switch (lbl->kind)
+	if (lvn->size == lvn->capacity)
 	{
-		case L_MAIN:
-			uni_printf(io, "MAIN");
-			break;
-		case L_FUNC:
-			uni_printf(io, "FUNC");
-			break;
-		case L_NEXT:
-			uni_printf(io, "NEXT");
-			break;
-		case L_FUNCEND:
-			uni_printf(io, "FUNCEND");
-			break;
-		case L_STRING:
-			uni_printf(io, "STRING");
-			break;
-		case L_ELSE:
-			uni_printf(io, "ELSE");
-			break;
-		case L_END:
-			uni_printf(io, "END");
-			break;
-		case L_BEGIN_CYCLE:
-			uni_printf(io, "BEGIN_CYCLE");
-			break;
-		case L_CASE:
-			uni_printf(io, "CASE");
+		const size_t capacity = lvn->capacity == 0 ? 16 : 2 * lvn->capacity;
+		live_interval *const intervals = realloc(lvn->intervals, capacity * sizeof(live_interval));
+		if (intervals == NULL)
+		{
+			// Без памяти переменная остается на стеке
+			return;
+		}
+
+		lvn->intervals = intervals;
+		lvn->capacity = capacity;
+	}
+
+	// На время анализа в таблице хранится номер интервала
+	const size_t index = hash_add(&enc->local_registers, (item_t)identifier, 1);
+	hash_set_by_index(&enc->local_registers, index, 0, (item_t)lvn->size);
+
+	lvn->intervals[lvn->size++] = (live_interval){ .identifier = identifier, .start = position, .end = position
+		, .reg = SIZE_MAX, .is_excluded = false };
+}
+
+/**
+ *	Get live interval of local variable
+ *
+ *	@param	enc					Encoder
+ *	@param	lvn					Liveness analysis
+ *	@param	identifier			Variable identifier
+ *
+ *	@return	Live interval, @c NULL if variable is not a candidate
+ */
+static live_interval *liveness_get(encoder *const enc, liveness *const lvn, const size_t identifier)
+{
+	const size_t index = hash_get_index(&enc->local_registers, (item_t)identifier);
+	return index == SIZE_MAX ? NULL : &lvn->intervals[hash_get_by_index(&enc->local_registers, index, 0)];
+}
+
+/**
+ *	Build live intervals of local variables in order of their positions in function body.
+ *	Scalar local variables without taken address are candidates for registers.
+ *	Intervals of variables used in a loop are extended to the whole loop
+ *
+ *	@param	enc					Encoder
+ *	@param	lvn					Liveness analysis
+ *	@param	nd					Node in AST
+ */
+static void liveness_build(encoder *const enc, liveness *const lvn, const node *const nd)
+{
+	const size_t position = lvn->position++;
+
+	switch (node_get_type(nd))
+	{
+		case OP_DECL_VAR:
+		{
+			const size_t identifier = declaration_variable_get_id(nd);
+			const item_t type = ident_get_type(enc->sx, identifier);
+			if (ident_is_local(enc->sx, identifier) && (type_is_integer(enc->sx, type)
+				|| type_is_pointer(enc->sx, type) || type_is_boolean(enc->sx, type)))
+			{
+				liveness_add(enc, lvn, identifier, position);
+			}
+		}
+		break;
+
+		case OP_IDENTIFIER:
+		{
+			live_interval *const interval = liveness_get(enc, lvn, expression_identifier_get_id(nd));
+			if (interval != NULL)
+			{
+				interval->end = position;
+			}
+		}
+		break;
+
+		case OP_UNARY:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			if (expression_unary_get_operator(nd) == UN_ADDRESS && expression_get_class(&operand) == EXPR_IDENTIFIER)
+			{
+				live_interval *const interval = liveness_get(enc, lvn, expression_identifier_get_id(&operand));
+				if (interval != NULL)
+				{
+					interval->is_excluded = true;
+				}
+			}
+		}
+		break;
+
+		default:
 			break;
 	}
 
-	uni_printf(io, "%zu", lbl->num);
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		liveness_build(enc, lvn, &child);
+	}
+
+	const operation_t type = node_get_type(nd);
+	if (type == OP_WHILE || type == OP_DO || type == OP_FOR)
+	{
+		// Значение, используемое в цикле, может понадобиться на следующей итерации
+		for (size_t i = 0; i < lvn->size; i++)
+		{
+			if (lvn->intervals[i].end >= position)
+			{
+				lvn->intervals[i].end = lvn->position;
+			}
+		}
+	}
+}
+
+/**
+ *	Allocate saved registers to local variables of function by linear scan.
+ *	If all registers are occupied, the variable with the furthest end of interval stays on stack
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Function body
+ */
+static void liveness_allocate(encoder *const enc, const node *const nd)
+{
+	liveness lvn = { .intervals = NULL, .size = 0, .capacity = 0, .position = 0 };
+	liveness_build(enc, &lvn, nd);
+
+	size_t active[8 /* за $s0-$s7 */];
+	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+	{
+		active[i] = SIZE_MAX;
+	}
+
+	// Интервалы упорядочены по началу, так как добавлялись в порядке обхода
+	for (size_t i = 0; i < lvn.size; i++)
+	{
+		live_interval *const interval = &lvn.intervals[i];
+		hash_remove(&enc->local_registers, (item_t)interval->identifier);
+		if (interval->is_excluded)
+		{
+			continue;
+		}
+
+		size_t free_reg = SIZE_MAX;
+		size_t furthest = SIZE_MAX;
+		for (size_t j = 0; j < PRESERVED_REG_AMOUNT; j++)
+		{
+			if (active[j] != SIZE_MAX && lvn.intervals[active[j]].end < interval->start)
+			{
+				active[j] = SIZE_MAX;
+			}
+
+			if (active[j] == SIZE_MAX)
+			{
+				free_reg = free_reg == SIZE_MAX ? j : free_reg;
+			}
+			else if (furthest == SIZE_MAX || lvn.intervals[active[j]].end > lvn.intervals[active[furthest]].end)
+			{
+				furthest = j;
+			}
+		}
+
+		if (free_reg == SIZE_MAX && lvn.intervals[active[furthest]].end > interval->end)
+		{
+			// Вытесняем на стек переменную, которая живет дольше
+			lvn.intervals[active[furthest]].reg = SIZE_MAX;
+			free_reg = furthest;
+		}
+
+		if (free_reg != SIZE_MAX)
+		{
+			active[free_reg] = i;
+			interval->reg = free_reg;
+		}
+	}
+
+	for (size_t i = 0; i < lvn.size; i++)
+	{
+		if (lvn.intervals[i].reg != SIZE_MAX)
+		{
+			const size_t index = hash_add(&enc->local_registers, (item_t)lvn.intervals[i].identifier, 1);
+			hash_set_by_index(&enc->local_registers, index, 0, (item_t)(R_S0 + lvn.intervals[i].reg));
+		}
+	}
+
+	free(lvn.intervals);
 }
 
 /**
@@ -1221,8 +2016,7 @@ static void emit_label(encoder *const enc, const label *const lbl)
  */
 static void emit_label_declaration(encoder *const enc, const label *const lbl)
 {
-	emit_label(enc, lbl);
-	uni_printf(enc->sx->io, ":\n");
+	emit_code(enc, &(mips_code){ .format = FORMAT_LABEL, .lbl = *lbl });
 }
 
 /**
@@ -1235,11 +2029,7 @@ static void emit_unconditional_branch(encoder *const enc, const mips_instruction
 {
 	assert(instruction == IC_MIPS_J || instruction == IC_MIPS_JAL);
 
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, instruction);
-	uni_printf(enc->sx->io, " ");
-	emit_label(enc, lbl);
-	uni_printf(enc->sx->io, "\n");
+	emit_code(enc, &(mips_code){ .format = FORMAT_L, .instruction = instruction, .lbl = *lbl });
 }
 
 /**
@@ -1258,24 +2048,37 @@ static void emit_conditional_branch(encoder *const enc, const mips_instruction_t
 			emit_unconditional_branch(enc, IC_MIPS_J, lbl);
 		}
 	}
+	else if (instruction == IC_MIPS_BEQ || instruction == IC_MIPS_BNE)
+	{
+		emit_code(enc, &(mips_code){ .format = FORMAT_2R_L, .instruction = instruction
+			, .fst_reg = value->val.reg_num, .snd_reg = R_ZERO, .lbl = *lbl });
+	}
 	else
 	{
-		uni_printf(enc->sx->io, "\t");
-		instruction_to_io(enc->sx->io, instruction);
-		uni_printf(enc->sx->io, " ");
-		rvalue_to_io(enc, value);
-		uni_printf(enc->sx->io, ", ");
-		if (instruction == IC_MIPS_BEQ || instruction == IC_MIPS_BNE)
-		{
-			mips_register_to_io(enc->sx->io, R_ZERO);
-			uni_printf(enc->sx->io, ", ");
-		}
-		// иначе инструкции вида B..Z -- сравнение с нулём прямо в них
-		emit_label(enc, lbl);
-		uni_printf(enc->sx->io, "\n");
+		// Инструкции вида B..Z -- сравнение с нулём прямо в них
+		emit_code(enc, &(mips_code){ .format = FORMAT_R_L, .instruction = instruction
+			, .fst_reg = value->val.reg_num, .lbl = *lbl });
 	}
 }
 
+/**
+ *	Emit conditional branch by comparison of two registers
+ *
+ *	@param	enc					Encoder
+ *	@param	instruction			Branch instruction
+ *	@param	fst_reg				First register
+ *	@param	snd_reg				Second register
+ *	@param	lbl					Label for conditional jump
+ */
+static void emit_comparison_branch(encoder *const enc, const mips_instruction_t instruction
+	, const mips_register_t fst_reg, const mips_register_t snd_reg, const label *const lbl)
+{
+	assert(instruction == IC_MIPS_BEQ || instruction == IC_MIPS_BNE);
+
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_L, .instruction = instruction
+		, .fst_reg = fst_reg, .snd_reg = snd_reg, .lbl = *lbl });
+}
+
 /**
  *	Emit branching with register
  *
@@ -1286,2642 +2089,5540 @@ static void emit_register_branch(encoder *const enc, const mips_instruction_t in
 {
 	assert(instruction == IC_MIPS_JR);
 
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, instruction);
-	uni_printf(enc->sx->io, " ");
-	mips_register_to_io(enc->sx->io, reg);
-	uni_printf(enc->sx->io, "\n");
+	emit_code(enc, &(mips_code){ .format = FORMAT_R, .instruction = instruction, .fst_reg = reg });
 }
 
-
-/*
- *	 ______     __  __     ______   ______     ______     ______     ______     __     ______     __   __     ______
- *	/\  ___\   /\_\_\_\   /\  == \ /\  == \   /\  ___\   /\  ___\   /\  ___\   /\ \   /\  __ \   /\ "-.\ \   /\  ___\
- *	\ \  __\   \/_/\_\/_  \ \  _-/ \ \  __<   \ \  __\   \ \___  \  \ \___  \  \ \ \  \ \ \/\ \  \ \ \-.  \  \ \___  \
- *	 \ \_____\   /\_\/\_\  \ \_\    \ \_\ \_\  \ \_____\  \/\_____\  \/\_____\  \ \_\  \ \_____\  \ \_\\"\_\  \/\_____\
- *	  \/_____/   \/_/\/_/   \/_/     \/_/ /_/   \/_____/   \/_____/   \/_____/   \/_/   \/_____/   \/_/ \/_/   \/_____/
+/**
+ *	Check if labels are equal
+ *
+ *	@param	fst					First label
+ *	@param	snd					Second label
+ *
+ *	@return	@c true on equal labels
  */
-
+static bool label_is_equal(const label *const fst, const label *const snd)
+{
+	return fst->kind == snd->kind && fst->num == snd->num;
+}
 
 /**
- *	Creates register kind rvalue and stores there constant kind rvalue
+ *	Check if instruction is branch or jump to label of function body
  *
- *	@param	enc					Encoder
- *	@param	value				Rvalue of constant kind
+ *	@param	code				Instruction
  *
- *	@return	Created rvalue
+ *	@return	@c true on branch to label
  */
-static rvalue emit_load_of_immediate(encoder *const enc, const rvalue *const value)
+static bool code_is_branch(const mips_code *const code)
 {
-	assert(value->kind == RVALUE_KIND_CONST);
+	if (code->symbol != NULL)
+	{
+		return false;
+	}
 
-	const mips_register_t reg = (type_is_floating(enc->sx, value->type)) ? get_float_register(enc) : get_register(enc);
-	const mips_instruction_t instruction = (type_is_floating(enc->sx, value->type)) ? IC_MIPS_LI_S : IC_MIPS_LI;
+	switch (code->instruction)
+	{
+		case IC_MIPS_J:
+			return code->format == FORMAT_L;
+		case IC_MIPS_BEQ:
+		case IC_MIPS_BNE:
+			return code->format == FORMAT_2R_L;
+		case IC_MIPS_BLEZ:
+		case IC_MIPS_BLTZ:
+		case IC_MIPS_BGEZ:
+		case IC_MIPS_BGTZ:
+			return code->format == FORMAT_R_L;
+		default:
+			return false;
+	}
+}
 
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, instruction);
-	uni_printf(enc->sx->io, " ");
-	mips_register_to_io(enc->sx->io, reg);
-	uni_printf(enc->sx->io, ", ");
-	rvalue_to_io(enc, value);
-	uni_printf(enc->sx->io, "\n");
+/**
+ *	Check if instruction transfers control unconditionally
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	@c true on unconditional jump
+ */
+static bool code_is_jump(const mips_code *const code)
+{
+	return (code->instruction == IC_MIPS_J && code->format == FORMAT_L)
+		|| (code->instruction == IC_MIPS_JR && code->format == FORMAT_R);
+}
 
-	return (rvalue) {
-		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_REGISTER,
-		.val.reg_num = reg,
-		.type = value->type
-	};
+/**
+ *	Check if record is executable instruction, not label or directive
+ *
+ *	@param	code				Record
+ *
+ *	@return	@c true on instruction
+ */
+static bool code_is_instruction(const mips_code *const code)
+{
+	return code->format != FORMAT_LABEL && code->format != FORMAT_WORD && code->format != FORMAT_DATA
+		&& code->format != FORMAT_FLOAT && code->format != FORMAT_SPACE && code->format != FORMAT_ASCII
+		&& code->format != FORMAT_DIRECTIVE;
 }
 
 /**
- *	Loads lvalue to register and forms rvalue. If lvalue kind is @c LVALUE_KIND_REGISTER,
- *	returns rvalue on the same register
+ *	Check if record refers to label
  *
- *	@param	enc					Encoder
- *	@param	lval				Lvalue to load
+ *	@param	code				Record
+ *	@param	lbl					Label
  *
- *	@return	Formed rvalue
+ *	@return	@c true on reference
  */
-static rvalue emit_load_of_lvalue(encoder *const enc, const lvalue *const lval)
+static bool code_refers_to(const mips_code *const code, const label *const lbl)
 {
-	if (lval->kind == LVALUE_KIND_REGISTER)
+	switch (code->format)
 	{
-		return (rvalue) {
-			.kind = RVALUE_KIND_REGISTER,
-			.val.reg_num = lval->loc.reg_num,
-			.from_lvalue = FROM_LVALUE,
-			.type = lval->type
-		};
+		case FORMAT_L:
+		case FORMAT_R_L:
+		case FORMAT_2R_L:
+		case FORMAT_WORD:
+			return code->symbol == NULL && label_is_equal(&code->lbl, lbl);
+		default:
+			return false;
 	}
+}
 
-	if (type_is_structure(enc->sx, lval->type) || type_is_array(enc->sx, lval->type))
+/**
+ *	Check if instruction reads register
+ *
+ *	@param	code				Instruction
+ *	@param	reg					Register
+ *
+ *	@return	@c true on reading
+ */
+static bool code_uses(const mips_code *const code, const mips_register_t reg)
+{
+	switch (code->format)
 	{
-		// Грузим адрес первого элемента на регистр
-		const rvalue tmp = { .kind = RVALUE_KIND_CONST, .val.int_val = lval->loc.displ, .type = TYPE_INTEGER };
-		const rvalue displ_rvalue = emit_load_of_immediate(enc, &tmp);
-
-		const rvalue base_reg_rvalue = { .kind = RVALUE_KIND_REGISTER, .val.reg_num = lval->base_reg, .type = TYPE_INTEGER };
-
-		emit_binary_operation(enc, &displ_rvalue, &displ_rvalue, &base_reg_rvalue, BIN_ADD);
-		return displ_rvalue;
+		case FORMAT_R:
+		case FORMAT_R_L:
+			return code->instruction != IC_MIPS_LA && code->fst_reg == reg;
+		case FORMAT_2R:
+		case FORMAT_2R_I:
+		case FORMAT_2R_LO:
+			return code->snd_reg == reg;
+		case FORMAT_3R:
+			return code->snd_reg == reg || code->thd_reg == reg;
+		case FORMAT_2R_L:
+			return code->fst_reg == reg || code->snd_reg == reg;
+		case FORMAT_R_I_R:
+			return code->snd_reg == reg
+				|| ((code->instruction == IC_MIPS_SW || code->instruction == IC_MIPS_S_S) && code->fst_reg == reg);
+		default:
+			return false;
 	}
-
-	const bool is_floating = type_is_floating(enc->sx, lval->type);
-	const mips_register_t reg = is_floating ? get_float_register(enc) : get_register(enc);
-	const mips_instruction_t instruction = is_floating ? IC_MIPS_L_S : IC_MIPS_LW;
-
-	const rvalue result = {
-		.kind = RVALUE_KIND_REGISTER,
-		.val.reg_num = reg,
-		.from_lvalue = !FROM_LVALUE,
-		.type = lval->type,
-	};
-
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, instruction);
-	uni_printf(enc->sx->io, " ");
-	rvalue_to_io(enc, &result);
-	uni_printf(enc->sx->io, ", %" PRIitem "(", lval->loc.displ);
-	mips_register_to_io(enc->sx->io, lval->base_reg);
-	uni_printf(enc->sx->io, ")\n");
-
-	// Для любых скалярных типов ничего не произойдёт,
-	// а для остальных освобождается base_reg, в котором хранилось смещение
-	free_register(enc, lval->base_reg);
-
-	return result;
 }
 
 /**
- *	Emit identifier lvalue
+ *	Check if instruction writes register
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	code				Instruction
+ *	@param	reg					Register
  *
- *	@return	Identifier lvalue
+ *	@return	@c true on writing
  */
-static lvalue emit_identifier_lvalue(encoder *const enc, const node *const nd)
+static bool code_defines(const mips_code *const code, const mips_register_t reg)
 {
-	return displacements_get(enc, expression_identifier_get_id(nd));
+	switch (code->format)
+	{
+		case FORMAT_2R:
+		case FORMAT_3R:
+		case FORMAT_R_I:
+		case FORMAT_2R_I:
+		case FORMAT_R_F:
+		case FORMAT_R_HI:
+		case FORMAT_2R_LO:
+			return code->fst_reg == reg;
+		case FORMAT_R_L:
+			return code->instruction == IC_MIPS_LA && code->fst_reg == reg;
+		case FORMAT_R_I_R:
+			return (code->instruction == IC_MIPS_LW || code->instruction == IC_MIPS_L_S) && code->fst_reg == reg;
+		default:
+			return false;
+	}
 }
 
 /**
- *	Emit subscript lvalue
+ *	Check if value of register is not used after instruction.
+ *	Analysis is limited by basic block, so the value is live at its end
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	index				Index of first instruction after definition
+ *	@param	reg					Register
  *
- *	@return	Subscript lvalue
+ *	@return	@c true if the value is dead
  */
-static lvalue emit_subscript_lvalue(encoder *const enc, const node *const nd)
+static bool peephole_is_dead(const encoder *const enc, const size_t index, const mips_register_t reg)
 {
-	const item_t type = expression_get_type(nd);
+	for (size_t i = index; i < enc->code_size; i++)
+	{
+		const mips_code *const code = &enc->code[i];
+		if (!code_is_instruction(code) || code_uses(code, reg))
+		{
+			return false;
+		}
 
-	const node base = expression_subscript_get_base(nd);
-	const rvalue base_value = emit_expression(enc, &base);
+		if (code_defines(code, reg))
+		{
+			return true;
+		}
 
-	const node index = expression_subscript_get_index(nd);
-	const rvalue index_value = emit_expression(enc, &index);
+		if (code->format == FORMAT_L || code->format == FORMAT_R_L || code->format == FORMAT_2R_L
+			|| code->format == FORMAT_R)
+		{
+			return false;
+		}
+	}
 
-	// base_value гарантированно имеет kind == RVALUE_KIND_REGISTER
-	if (index_value.kind == RVALUE_KIND_CONST)
+	return false;
+}
+
+/**
+ *	Find declaration of label in function body
+ *
+ *	@param	enc					Encoder
+ *	@param	lbl					Label
+ *
+ *	@return	Index of declaration, @c SIZE_MAX if label is not declared
+ */
+static size_t peephole_find_label(const encoder *const enc, const label *const lbl)
+{
+	for (size_t i = 0; i < enc->code_size; i++)
 	{
-		return (lvalue) {
-			.kind = LVALUE_KIND_STACK,
-			.base_reg = base_value.val.reg_num,
-			.loc.displ = -(item_t)index_value.val.int_val * mips_type_size(enc->sx, type),
-			.type = type
-		};
+		if (enc->code[i].format == FORMAT_LABEL && label_is_equal(&enc->code[i].lbl, lbl))
+		{
+			return i;
+		}
 	}
 
-	const rvalue type_size_value = {	// Можно было бы сделать отдельным конструктором
-		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_CONST,
-		.val.int_val = mips_type_size(enc->sx, type),
-		.type = TYPE_INTEGER
-	};
-	const rvalue offset = {
-		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_REGISTER,
-		.val.reg_num = get_register(enc),
-		.type = TYPE_INTEGER
-	};
-
-	emit_binary_operation(enc, &offset, &index_value, &type_size_value, BIN_MUL);
-	free_rvalue(enc, &index_value);
-
-	emit_binary_operation(enc, &base_value, &base_value, &offset, BIN_SUB);
-	free_rvalue(enc, &offset);
-
-	return (lvalue) { .kind = LVALUE_KIND_STACK, .base_reg = base_value.val.reg_num, .loc.displ = 0, .type = type };
+	return SIZE_MAX;
 }
 
 /**
- *	Emit member lvalue
+ *	Fold constant loaded by @c li into the following operation with immediate operand
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	index				Index of @c li instruction
  *
- *	@return	Created lvalue
+ *	@return	@c true if operation is rewritten and @c li is not needed
  */
-static lvalue emit_member_lvalue(encoder *const enc, const node *const nd)
+static bool peephole_fold_immediate(encoder *const enc, const size_t index)
 {
-	const node base = expression_member_get_base(nd);
-	const item_t base_type = expression_get_type(&base);
+	const mips_code *const code = &enc->code[index];
+	mips_code *const next = &enc->code[index + 1];
+	const mips_register_t reg = code->fst_reg;
 
-	const bool is_arrow = expression_member_is_arrow(nd);
-	const item_t struct_type = is_arrow ? type_pointer_get_element_type(enc->sx, base_type) : base_type;
-
-	size_t member_displ = 0;
-	const size_t member_index = expression_member_get_member_index(nd);
-	for (size_t i = 0; i < member_index; i++)
+	if (code->instruction != IC_MIPS_LI || code->format != FORMAT_R_I || next->format != FORMAT_3R
+		|| !is_temporary_register(reg) || (next->snd_reg == reg) == (next->thd_reg == reg))
 	{
-		const item_t member_type = type_structure_get_member_type(enc->sx, struct_type, i);
-		member_displ += mips_type_size(enc->sx, member_type);
+		return false;
 	}
 
-	const item_t type = expression_get_type(nd);
-
-	if (is_arrow)
+	const mips_register_t operand = next->snd_reg == reg ? next->thd_reg : next->snd_reg;
+	mips_instruction_t instruction = IC_MIPS_NOP;
+	item_t imm = code->imm;
+	switch (next->instruction)
 	{
-		const rvalue struct_pointer = emit_expression(enc, &base);
-		// FIXME: грузить константу на регистр в случае константных указателей
-		return (lvalue) {
-			.kind = LVALUE_KIND_STACK,
-			.base_reg = struct_pointer.val.reg_num,
-			.loc.displ = member_displ,
-			.type = type
-		};
+		case IC_MIPS_ADD:
+			instruction = IC_MIPS_ADDI;
+			break;
+		case IC_MIPS_ADDU:
+			instruction = IC_MIPS_ADDIU;
+			break;
+		case IC_MIPS_SUB:
+			instruction = next->thd_reg == reg ? IC_MIPS_ADDI : IC_MIPS_NOP;
+			imm = -imm;
+			break;
+		case IC_MIPS_SUBU:
+			instruction = next->thd_reg == reg ? IC_MIPS_ADDIU : IC_MIPS_NOP;
+			imm = -imm;
+			break;
+		case IC_MIPS_AND:
+			instruction = IC_MIPS_ANDI;
+			break;
+		case IC_MIPS_OR:
+			instruction = IC_MIPS_ORI;
+			break;
+		case IC_MIPS_XOR:
+			instruction = IC_MIPS_XORI;
+			break;
+		default:
+			break;
 	}
-	else
+
+	// Логические операции расширяют непосредственный операнд нулями
+	const bool is_logical = instruction == IC_MIPS_ANDI || instruction == IC_MIPS_ORI || instruction == IC_MIPS_XORI;
+	const bool is_fit = is_logical
+		? imm >= 0 && imm <= 2 * MAX_IMMEDIATE + 1
+		: imm >= MIN_IMMEDIATE && imm <= MAX_IMMEDIATE;
+
+	if (instruction == IC_MIPS_NOP || !is_fit
+		|| (next->fst_reg != reg && !peephole_is_dead(enc, index + 2, reg)))
 	{
-		const lvalue base_lvalue = emit_lvalue(enc, &base);
-		const size_t displ = (size_t)(base_lvalue.loc.displ + member_displ);
-		return (lvalue) {
-			.kind = LVALUE_KIND_STACK,
-			.base_reg = base_lvalue.base_reg,
-			.loc.displ = displ,
-			.type = type
-		};
+		return false;
 	}
+
+	next->format = FORMAT_2R_I;
+	next->instruction = instruction;
+	next->snd_reg = operand;
+	next->imm = imm;
+	return true;
 }
 
 /**
- *	Emit indirection lvalue
+ *	Write result of instruction directly to destination of the following move
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	index				Index of instruction
  *
- *	@return	Indirected lvalue
+ *	@return	@c true if instruction is rewritten and move is not needed
  */
-static lvalue emit_indirection_lvalue(encoder *const enc, const node *const nd)
+static bool peephole_coalesce_move(encoder *const enc, const size_t index)
 {
-	assert(expression_unary_get_operator(nd) == UN_INDIRECTION);
-
-	const node operand = expression_unary_get_operand(nd);
-	const rvalue base = emit_expression(enc, &operand);
-	// FIXME: грузить константу на регистр в случае константных указателей
-	const item_t type = expression_get_type(nd);
+	mips_code *const code = &enc->code[index];
+	const mips_code *const next = &enc->code[index + 1];
+	const mips_register_t reg = next->snd_reg;
+
+	if ((next->instruction != IC_MIPS_MOVE && next->instruction != IC_MIPS_MOV_S) || next->format != FORMAT_2R
+		|| !is_temporary_register(reg) || !code_defines(code, reg) || code->instruction == IC_MIPS_CVT_D_S
+		|| code->instruction == IC_MIPS_MFC_1 || code->instruction == IC_MIPS_MFHC_1
+		|| !peephole_is_dead(enc, index + 2, reg))
+	{
+		return false;
+	}
 
-	return (lvalue) {
-		.kind = LVALUE_KIND_STACK,
-		.base_reg = base.val.reg_num,
-		.loc.displ = 0,
-		.type = type
-	};
+	code->fst_reg = next->fst_reg;
+	return true;
 }
 
 /**
- *	Emit lvalue expression
+ *	Remove moves of register to itself, forward stored values to the following loads,
+ *	fold constants into operations and coalesce moves of temporary values
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
  *
- *	@return	Lvalue
+ *	@return	@c true on changes
  */
-static lvalue emit_lvalue(encoder *const enc, const node *const nd)
+static bool peephole_rewrite(encoder *const enc)
 {
-	assert(expression_is_lvalue(nd));
-
-	switch (expression_get_class(nd))
+	size_t size = 0;
+	for (size_t i = 0; i < enc->code_size; i++)
 	{
-		case EXPR_IDENTIFIER:
-			return emit_identifier_lvalue(enc, nd);
+		mips_code *const code = &enc->code[i];
+		mips_code *const next = i + 1 < enc->code_size ? &enc->code[i + 1] : NULL;
 
-		case EXPR_SUBSCRIPT:
-			return emit_subscript_lvalue(enc, nd);
+		if ((code->instruction == IC_MIPS_MOVE || code->instruction == IC_MIPS_MOV_S)
+			&& code->format == FORMAT_2R && code->fst_reg == code->snd_reg)
+		{
+			continue;
+		}
 
-		case EXPR_MEMBER:
-			return emit_member_lvalue(enc, nd);
+		if (next == NULL)
+		{
+			enc->code[size++] = *code;
+			continue;
+		}
 
-		case EXPR_UNARY:	// Только UN_INDIRECTION
-			return emit_indirection_lvalue(enc, nd);
+		if (code->format == FORMAT_R_I_R && next->format == FORMAT_R_I_R
+			&& code->imm == next->imm && code->snd_reg == next->snd_reg)
+		{
+			const bool is_word = code->instruction == IC_MIPS_SW && next->instruction == IC_MIPS_LW;
+			const bool is_float = code->instruction == IC_MIPS_S_S && next->instruction == IC_MIPS_L_S;
+			if (is_word || is_float)
+			{
+				// Загружается только что сохраненное значение
+				next->format = FORMAT_2R;
+				next->instruction = is_word ? IC_MIPS_MOVE : IC_MIPS_MOV_S;
+				next->snd_reg = code->fst_reg;
+			}
 
-		default:
-			// Не может быть lvalue
-			system_error(node_unexpected, nd);
-			return (lvalue) { .loc.displ = ITEM_MAX };
-	}
-}
+			const bool is_reload = (code->instruction == IC_MIPS_LW && next->instruction == IC_MIPS_SW)
+				|| (code->instruction == IC_MIPS_L_S && next->instruction == IC_MIPS_S_S);
+			if (is_reload && code->fst_reg == next->fst_reg && code->fst_reg != code->snd_reg)
+			{
+				// Сохраняется только что загруженное значение
+				enc->code[size++] = *code;
+				i++;
+				continue;
+			}
+		}
 
-/**
- *	Stores one rvalue of register kind to another
- *
- *	@param	enc					Encoder
- *	@param	target				Target register
- *	@param	value				Rvalue to store
- */
-static void emit_move_rvalue_to_register(encoder *const enc
-	, const mips_register_t target, const rvalue *const value)
-{
-	if (value->kind == RVALUE_KIND_CONST)
-	{
-		const mips_instruction_t instruction = !type_is_floating(enc->sx, value->type) ? IC_MIPS_LI : IC_MIPS_LI_S;
-		uni_printf(enc->sx->io, "\t");
-		instruction_to_io(enc->sx->io, instruction);
-		uni_printf(enc->sx->io, " ");
-		mips_register_to_io(enc->sx->io, target);
-		uni_printf(enc->sx->io, ", ");
-		rvalue_to_io(enc, value);
-		uni_printf(enc->sx->io, "\n");
-		return;
-	}
+		if (peephole_fold_immediate(enc, i))
+		{
+			continue;
+		}
 
-	if (value->val.reg_num == target)
-	{
-		uni_printf(enc->sx->io, "\t# stays in register ");
-		mips_register_to_io(enc->sx->io, target);
-		uni_printf(enc->sx->io, ":\n");
-	}
-	else
-	{
-		const mips_instruction_t instruction = !type_is_floating(enc->sx, value->type) ? IC_MIPS_MOVE : IC_MIPS_MFC_1;
-		uni_printf(enc->sx->io, "\t");
-		instruction_to_io(enc->sx->io, instruction);
-		uni_printf(enc->sx->io, " ");
-		mips_register_to_io(enc->sx->io, target);
-		uni_printf(enc->sx->io, ", ");
-		rvalue_to_io(enc, value);
-		uni_printf(enc->sx->io, "\n");
+		if (peephole_coalesce_move(enc, i))
+		{
+			enc->code[size++] = *code;
+			i++;
+			continue;
+		}
+
+		enc->code[size++] = *code;
 	}
+
+	const bool is_changed = size != enc->code_size;
+	enc->code_size = size;
+	return is_changed;
 }
 
 /**
- *	Stores rvalue to lvalue. Frees value parameter register for a pointer
+ *	Thread jumps to unconditional jumps and remove unreachable instructions,
+ *	branches to the following labels and unused labels
  *
  *	@param	enc					Encoder
- *	@param	target				Target lvalue
- *	@param	value				Rvalue to store
+ *
+ *	@return	@c true on changes
  */
-static void emit_store_of_rvalue(encoder *const enc, const lvalue *const target, const rvalue *const value)
+static bool peephole_branches(encoder *const enc)
 {
-	assert(value->kind != RVALUE_KIND_VOID);
-	assert(value->type == target->type);
-
-	const rvalue reg_value = (value->kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, value) : *value;
-
-	if (target->kind == LVALUE_KIND_REGISTER)
+	bool is_changed = false;
+	for (size_t i = 0; i < enc->code_size; i++)
 	{
-		if (value->val.reg_num != target->loc.reg_num)
+		mips_code *const code = &enc->code[i];
+		for (size_t hops = 0; code_is_branch(code) && hops < enc->code_size; hops++)
 		{
-			const mips_instruction_t instruction = type_is_floating(enc->sx, value->type) ? IC_MIPS_MOV_S : IC_MIPS_MOVE;
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, instruction);
-			uni_printf(enc->sx->io, " ");
-			lvalue_to_io(enc, target);
-			uni_printf(enc->sx->io, ", ");
-			rvalue_to_io(enc, &reg_value);
-			uni_printf(enc->sx->io, "\n");
+			size_t target = peephole_find_label(enc, &code->lbl);
+			while (target < enc->code_size && enc->code[target].format == FORMAT_LABEL)
+			{
+				target++;
+			}
+
+			if (target == enc->code_size || enc->code[target].instruction != IC_MIPS_J
+				|| !code_is_branch(&enc->code[target]) || label_is_equal(&enc->code[target].lbl, &code->lbl))
+			{
+				break;
+			}
+
+			code->lbl = enc->code[target].lbl;
+			is_changed = true;
 		}
 	}
-	else
+
+	size_t size = 0;
+	bool is_reachable = true;
+	for (size_t i = 0; i < enc->code_size; i++)
 	{
-		if ((!type_is_structure(enc->sx, target->type)) && (!type_is_array(enc->sx, target->type)))
+		const mips_code *const code = &enc->code[i];
+		if (!code_is_instruction(code))
 		{
-			const mips_instruction_t instruction = type_is_floating(enc->sx, value->type) ? IC_MIPS_S_S : IC_MIPS_SW;
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, instruction);
-			uni_printf(enc->sx->io, " ");
-			rvalue_to_io(enc, &reg_value);
-			uni_printf(enc->sx->io, ", ");
-			lvalue_to_io(enc, target);
-			uni_printf(enc->sx->io, "\n");
+			is_reachable = true;
+		}
+		else if (!is_reachable)
+		{
+			continue;
+		}
 
-			// Освобождаем регистр только в том случае, если он был занят на этом уровне. Выше не лезем.
-			if (value->kind == RVALUE_KIND_CONST)
+		if (code_is_branch(code))
+		{
+			bool is_next = false;
+			for (size_t j = i + 1; j < enc->code_size && enc->code[j].format == FORMAT_LABEL && !is_next; j++)
 			{
-				free_rvalue(enc, &reg_value);
+				is_next = label_is_equal(&enc->code[j].lbl, &code->lbl);
 			}
 
-			free_register(enc, target->base_reg);
+			if (is_next)
+			{
+				continue;
+			}
 		}
-		else
+
+		if (code->format == FORMAT_LABEL)
 		{
-			if (type_is_array(enc->sx, target->type))
+			bool is_used = false;
+			for (size_t j = 0; j < enc->code_size && !is_used; j++)
 			{
-				// Загружаем указатель на массив
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(enc->sx->io, IC_MIPS_SW);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, &reg_value);
-				uni_printf(enc->sx->io, ", %" PRIitem "(", target->loc.displ);
-				mips_register_to_io(enc->sx->io, target->base_reg);
-				uni_printf(enc->sx->io, ")\n\n");
-				return;
+				is_used = code_refers_to(&enc->code[j], &code->lbl);
+			}
+
+			if (!is_used)
+			{
+				continue;
 			}
-			// else кусок должен быть не достижим
 		}
+
+		is_reachable = !code_is_jump(code);
+		enc->code[size++] = *code;
 	}
+
+	is_changed = is_changed || size != enc->code_size;
+	enc->code_size = size;
+	return is_changed;
 }
 
 /**
- *	Gets original operands and loads them depending on the needs of operation
+ *	Optimize instructions of function body by peephole optimizer
+ *	@note	Optimizer removes redundant moves and loads of stored values, folds constants
+ *			into additions, threads jumps, deletes unreachable instructions and branches
+ *			to the following instructions
  *
  *	@param	enc					Encoder
- *	@param	operand 			Original operand rvalue
- *	@param  operation			Operation in which this operand used
- *	@param  is_first_operand    Bool which defines if the operand is first in binary expression
- *
- *	@return new operand rvalue
  */
-static rvalue emit_operand_load(encoder *const enc, const rvalue *const operand, const binary_t operation, const bool is_first_operand)
+static void emit_peephole(encoder *const enc)
 {
-	switch (operation)
+	// Проходы повторяются, пока удаляются инструкции или укорачиваются цепочки переходов
+	for (bool is_changed = true; is_changed;)
 	{
-		case BIN_LT:
-		case BIN_GT:
-		case BIN_LE:
-		case BIN_GE:
-		case BIN_EQ:
-		case BIN_NE:
-		case BIN_SUB:
-		case BIN_DIV:
-		case BIN_MUL:
-		case BIN_REM:
-			// Сравнение => Используется BIN_SUB, поэтому грузим на регистр
-			// sub, div, mul, rem => Нет команд работающих с константными значениями, поэтому грузим его на регистр
-			return (operand->kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, operand):  *operand;
-		case BIN_SHL:
-		case BIN_SHR:
-			// Нет команд работающих с первым операндом в виде константы и операции не коммутативны, поэтому грузим его на регистр
-			return !is_first_operand || operand->kind != RVALUE_KIND_CONST ? *operand
-																		   : emit_load_of_immediate(enc, operand);
-		case BIN_ADD:
-		case BIN_AND:
-		case BIN_OR:
-		case BIN_XOR:
-			// Операции коммутативны и есть операция работающая с одним значением на регистре и одним в виде константы
-			// Логика замены операндов вне функции
-			return *operand;
-		default:
-			// Не может быть других операций
-			system_error(node_unexpected);
-			return RVALUE_VOID;
+		is_changed = peephole_rewrite(enc);
+		is_changed = peephole_branches(enc) || is_changed;
 	}
 }
 
 /**
- *	Emit binary operation with two rvalues
+ *	Get mask of register for dependency analysis.
+ *	Floating point registers are taken in pairs, as double precision value occupies both of them
  *
- *	@param	enc					Encoder
- *	@param	dest				Destination rvalue
- *	@param	first_operand		First rvalue operand
- *	@param	second_operand		Second rvalue operand
- *	@param	operator			Operator
+ *	@param	reg					Register
+ *
+ *	@return	Register mask
  */
-static void emit_binary_operation(encoder *const enc, const rvalue *const dest
-	, const rvalue *const first_operand, const rvalue *const second_operand, const binary_t operator)
+static uint64_t register_mask(const mips_register_t reg)
 {
-	assert(operator != BIN_LOG_AND);
-	assert(operator != BIN_LOG_OR);
-
-	assert(dest->kind == RVALUE_KIND_REGISTER);
-	assert(first_operand->kind != RVALUE_KIND_VOID);
-	assert(second_operand->kind != RVALUE_KIND_VOID);
-
-	if ((first_operand->kind == RVALUE_KIND_REGISTER) && (second_operand->kind == RVALUE_KIND_REGISTER))
+	if (reg == R_ZERO)
 	{
-		switch (operator)
-		{
-			case BIN_LT:
-			case BIN_GT:
-			case BIN_LE:
-			case BIN_GE:
-			case BIN_EQ:
-			case BIN_NE:
-			{
-				const item_t curr_label_num = enc->label_num++;
-				const label label_else = { .kind = L_END, .num = (size_t)curr_label_num };
-
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(enc->sx->io, IC_MIPS_SUB);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, first_operand);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, second_operand);
-				uni_printf(enc->sx->io, "\n");
-
-				const mips_instruction_t instruction = get_bin_instruction(operator, false);
-				emit_conditional_branch(enc, instruction, dest, &label_else);
-
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(enc->sx->io, IC_MIPS_LI);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", 1\n");
-
-				emit_label_declaration(enc, &label_else);
-
-				uni_printf(enc->sx->io, "\n");
-			}
-			break;
-
-			default:
-			{
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(
-					enc->sx->io,
-					get_bin_instruction(operator, /* Два регистра => 0 в get_bin_instruction() -> */ 0)
-				);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, first_operand);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, second_operand);
-				uni_printf(enc->sx->io, "\n");
-			}
-			break;
-		}
+		return 0;
 	}
-	else
-	{
-		const rvalue real_first_operand = emit_operand_load(enc, first_operand, operator, true);
-		const rvalue real_second_operand = emit_operand_load(enc, second_operand, operator, false);
 
-		switch (operator)
-		{
-			case BIN_LT:
-			case BIN_GT:
-			case BIN_LE:
-			case BIN_GE:
-			case BIN_EQ:
-			case BIN_NE:
-			{
-				const item_t curr_label_num = enc->label_num++;
-				const label label_else = { .kind = L_ELSE, .num = (size_t)curr_label_num };
+	if (reg >= R_FV0)
+	{
+		return (uint64_t)3 << (R_FV0 + ((reg - R_FV0) & ~1u));
+	}
 
-				// Записываем <значение из first_operand> - <значение из second_operand> в dest
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(enc->sx->io, IC_MIPS_SUB);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, &real_first_operand);
-				uni_printf(enc->sx->io, ", ");
-				rvalue_to_io(enc, &real_second_operand);
-				uni_printf(enc->sx->io, "\n");
+	return (uint64_t)1 << reg;
+}
 
-				const mips_instruction_t instruction = get_bin_instruction(operator, false);
-				emit_conditional_branch(enc, instruction, dest, &label_else);
+/**
+ *	Check if instruction is store to memory
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	@c true on store
+ */
+static bool code_is_store(const mips_code *const code)
+{
+	return code->format == FORMAT_R_I_R && (code->instruction == IC_MIPS_SW || code->instruction == IC_MIPS_S_S);
+}
 
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(enc->sx->io, IC_MIPS_LI);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", 1\n");
+/**
+ *	Check if instruction is load from memory or store to memory
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	@c true on memory access
+ */
+static bool code_is_memory(const mips_code *const code)
+{
+	return code->format == FORMAT_R_I_R;
+}
 
-				emit_label_declaration(enc, &label_else);
+/**
+ *	Check if instruction transfers control and has delay slot
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	@c true on branch, jump or call
+ */
+static bool code_is_control(const mips_code *const code)
+{
+	if (!code_is_instruction(code))
+	{
+		return false;
+	}
 
-				uni_printf(enc->sx->io, "\n");
-				break;
-			}
+	switch (code->instruction)
+	{
+		case IC_MIPS_J:
+		case IC_MIPS_JAL:
+		case IC_MIPS_JR:
+		case IC_MIPS_BLEZ:
+		case IC_MIPS_BLTZ:
+		case IC_MIPS_BGEZ:
+		case IC_MIPS_BGTZ:
+		case IC_MIPS_BEQ:
+		case IC_MIPS_BNE:
+			return true;
+		default:
+			return false;
+	}
+}
 
-			default:
+/**
+ *	Check if instruction is assembled into single machine instruction,
+ *	so it can be placed into delay slot
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	@c true on single machine instruction
+ */
+static bool code_is_single(const mips_code *const code)
+{
+	switch (code->format)
+	{
+		case FORMAT_3R:
+			return code->instruction != IC_MIPS_DIV && code->instruction != IC_MIPS_MOD;
+		case FORMAT_2R:
+			return code->instruction != IC_MIPS_ABS;
+		case FORMAT_R_I:
+			return code->instruction == IC_MIPS_LI && code->imm >= MIN_IMMEDIATE && code->imm <= 2 * MAX_IMMEDIATE + 1;
+		case FORMAT_R_I_R:
+			return code->imm >= MIN_IMMEDIATE && code->imm <= MAX_IMMEDIATE;
+		case FORMAT_R_HI:
+		case FORMAT_2R_LO:
+			return true;
+		case FORMAT_2R_I:
+			switch (code->instruction)
 			{
-				bool does_need_instruction_working_with_both_operands_in_registers =
-					// Нет команд работающих с операндами в виде константы
-					(operator == BIN_SUB) || (operator == BIN_DIV) || (operator == BIN_MUL) || (operator == BIN_REM)
-					// Нет команд работающих с первым операндом в виде константы и операция не коммутативна
-					|| ((operator == BIN_SHL || operator == BIN_SHR) && first_operand->kind == RVALUE_KIND_CONST);
-
-				// Все остальные операции коммутативны, поэтому используем инструкцию с константой, меняя порядок если надо
-				bool change_order = (operator == BIN_ADD || operator == BIN_OR || operator == BIN_XOR || operator == BIN_AND) && first_operand->kind == RVALUE_KIND_CONST;
-
-				// Выписываем операцию, её результат будет записан в result
-				uni_printf(enc->sx->io, "\t");
-				instruction_to_io(
-					enc->sx->io,
-					get_bin_instruction(operator,
-										/* Один регистр => true в get_bin_instruction() -> */ !does_need_instruction_working_with_both_operands_in_registers)
-				);
-				uni_printf(enc->sx->io, " ");
-				rvalue_to_io(enc, dest);
-				uni_printf(enc->sx->io, ", ");
-				if (change_order)
-				{
-					rvalue_to_io(enc, &real_second_operand);
-					uni_printf(enc->sx->io, ", ");
-					rvalue_to_io(enc, &real_first_operand);
-				}
-				else
-				{
-					rvalue_to_io(enc, &real_first_operand);
-					uni_printf(enc->sx->io, ", ");
-					rvalue_to_io(enc, &real_second_operand);
-				}
-
-				uni_printf(enc->sx->io, "\n");
+				case IC_MIPS_ADDI:
+				case IC_MIPS_ADDIU:
+				case IC_MIPS_SLTI:
+				case IC_MIPS_SLTIU:
+					return code->imm >= MIN_IMMEDIATE && code->imm <= MAX_IMMEDIATE;
+				case IC_MIPS_ANDI:
+				case IC_MIPS_ORI:
+				case IC_MIPS_XORI:
+					return code->imm >= 0 && code->imm <= 2 * MAX_IMMEDIATE + 1;
+				case IC_MIPS_SLL:
+				case IC_MIPS_SRA:
+					return code->imm >= 0 && code->imm < 32;
+				default:
+					return false;
 			}
-		}
+		default:
+			return false;
 	}
 }
 
 /**
- *	Emit literal expression
+ *	Get mask of registers read by instruction
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	code				Instruction
  *
- *	@return	Rvalue of literal expression
+ *	@return	Registers mask
  */
-static rvalue emit_literal_expression(encoder *const enc, const node *const nd)
+static uint64_t code_uses_mask(const mips_code *const code)
 {
-	const item_t type = expression_get_type(nd);
-	switch (type_get_class(enc->sx, type))
+	switch (code->format)
 	{
-		case TYPE_BOOLEAN:
-			return (rvalue) {
-				.kind = RVALUE_KIND_CONST,
-				.val.int_val = (expression_literal_get_boolean(nd)) ? 1 : 0,
-				.type = TYPE_INTEGER
-			};
+		case FORMAT_R:
+			return register_mask(code->fst_reg);
+		case FORMAT_R_L:
+			return code->instruction == IC_MIPS_LA ? 0 : register_mask(code->fst_reg);
+		case FORMAT_2R:
+		case FORMAT_2R_I:
+		case FORMAT_2R_LO:
+			return register_mask(code->snd_reg);
+		case FORMAT_3R:
+			return register_mask(code->snd_reg) | register_mask(code->thd_reg);
+		case FORMAT_2R_L:
+			return register_mask(code->fst_reg) | register_mask(code->snd_reg);
+		case FORMAT_R_I_R:
+			return register_mask(code->snd_reg) | (code_is_store(code) ? register_mask(code->fst_reg) : 0);
+		default:
+			return 0;
+	}
+}
 
-		case TYPE_CHARACTER:
-			return (rvalue) {
-				.kind = RVALUE_KIND_CONST,
-				.val.int_val = expression_literal_get_character(nd),
-				.type = TYPE_INTEGER
-			};
+/**
+ *	Get mask of registers written by instruction
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	Registers mask
+ */
+static uint64_t code_defines_mask(const mips_code *const code)
+{
+	switch (code->format)
+	{
+		case FORMAT_2R:
+		case FORMAT_3R:
+		case FORMAT_R_I:
+		case FORMAT_2R_I:
+		case FORMAT_R_F:
+		case FORMAT_R_HI:
+		case FORMAT_2R_LO:
+			return register_mask(code->fst_reg);
+		case FORMAT_R_L:
+			return code->instruction == IC_MIPS_LA ? register_mask(code->fst_reg) : 0;
+		case FORMAT_R_I_R:
+			return code_is_store(code) ? 0 : register_mask(code->fst_reg);
+		case FORMAT_L:
+			// Адрес возврата записывается до выполнения слота задержки
+			return code->instruction == IC_MIPS_JAL ? register_mask(R_RA) : 0;
+		default:
+			return 0;
+	}
+}
 
-		case TYPE_INTEGER:
-			return (rvalue) {
-				.kind = RVALUE_KIND_CONST,
-				.val.int_val = expression_literal_get_integer(nd),
-				.type = TYPE_INTEGER
-			};
+/**
+ *	Check if instruction has to be executed after previous one
+ *
+ *	@param	fst					Previous instruction
+ *	@param	snd					Next instruction
+ *
+ *	@return	@c true on dependence
+ */
+static bool code_is_dependent(const mips_code *const fst, const mips_code *const snd)
+{
+	if ((code_defines_mask(fst) & (code_uses_mask(snd) | code_defines_mask(snd)))
+		|| (code_uses_mask(fst) & code_defines_mask(snd)))
+	{
+		return true;
+	}
 
-		case TYPE_FLOATING:
-			return (rvalue) {
-				.kind = RVALUE_KIND_CONST,
-				.val.float_val = expression_literal_get_floating(nd),
-				.type = TYPE_FLOATING
-			};
+	if (!code_is_memory(fst) || !code_is_memory(snd) || (!code_is_store(fst) && !code_is_store(snd)))
+	{
+		return false;
+	}
 
-		case TYPE_ARRAY:
-			assert(type_is_string(enc->sx, type));
-			return (rvalue) {
-				.kind = RVALUE_KIND_CONST,
-				.val.str_index = expression_literal_get_string(nd),
-				.type = type
-			};
+	// Слова по одному базовому регистру с разными смещениями не пересекаются
+	return fst->snd_reg != snd->snd_reg
+		|| (fst->imm - snd->imm < (item_t)WORD_LENGTH && snd->imm - fst->imm < (item_t)WORD_LENGTH);
+}
 
+/**
+ *	Get latency of instruction result.
+ *	Values approximate in-order pipelines of Baikal-T1 and uemu:
+ *	results of loads, multiplier and floating point unit come later than results of ALU
+ *
+ *	@param	code				Instruction
+ *
+ *	@return	Latency in cycles
+ */
+static size_t code_latency(const mips_code *const code)
+{
+	switch (code->instruction)
+	{
+		case IC_MIPS_LW:
+		case IC_MIPS_L_S:
+		case IC_MIPS_MFC_1:
+		case IC_MIPS_MFHC_1:
+			return 2;
+		case IC_MIPS_MUL:
+			return 3;
+		case IC_MIPS_ADD_S:
+		case IC_MIPS_SUB_S:
+		case IC_MIPS_MUL_S:
+		case IC_MIPS_CVT_D_S:
+		case IC_MIPS_CVT_S_W:
+		case IC_MIPS_CVT_W_S:
+			return 4;
+		case IC_MIPS_DIV:
+		case IC_MIPS_MOD:
+			return 10;
+		case IC_MIPS_DIV_S:
+			return 12;
 		default:
-			return RVALUE_VOID;
+			return 1;
 	}
 }
 
 /**
- *	Emit printf expression
+ *	Reorder instructions of basic block by list scheduling: from the instructions,
+ *	which operands are ready, the one on the longest path to the end of block goes first
  *
  *	@param	enc					Encoder
- *	@param	nd					AST node
- *	@param	parameters_amount	Number of function parameters
+ *	@param	begin				Index of first instruction
+ *	@param	end					Index after last instruction
  */
-static rvalue emit_printf_expression(encoder *const enc, const node *const nd)
+static void schedule_block(encoder *const enc, const size_t begin, const size_t end)
 {
-	const node string = expression_call_get_argument(nd, 0);
-	const size_t index = expression_literal_get_string(&string);
-	const size_t amount = strings_amount(enc->sx);
-	const size_t parameters_amount = expression_call_get_arguments_amount(nd);
+	const size_t size = end - begin;
+	if (size < 2)
+	{
+		return;
+	}
 
-	for (size_t i = 1; i < parameters_amount; i++)
+	size_t *const priority = malloc(4 * size * sizeof(size_t));
+	mips_code *const block = malloc(size * sizeof(mips_code));
+	if (priority == NULL || block == NULL)
 	{
-		const node arg = expression_call_get_argument(nd, i);
-		const rvalue val = emit_expression(enc, &arg);
-		const rvalue arg_rvalue = (val.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &val) : val;
-		const item_t arg_rvalue_type = arg_rvalue.type;
-
-		// Всегда хотим сохранять $a0 и $a1
-		to_code_2R_I(
-			enc->sx->io,
-			IC_MIPS_ADDI,
-			R_SP,
-			R_SP,
-			-(item_t)WORD_LENGTH * (!type_is_floating(enc->sx, arg_rvalue_type) ? /* $a0 и $a1 */ 1 : /* $a0, $a1 и $a2 */ 2)
-		);
-		uni_printf(enc->sx->io, "\n");
-
-		const lvalue a0_lval = {
-			.base_reg = R_SP,
-			// по call convention: первый на WORD_LENGTH выше предыдущего положения $fp,
-			// второй на 2*WORD_LENGTH и т.д.
-			.loc.displ = 0,
-			.kind = LVALUE_KIND_STACK,
-			.type = arg_rvalue.type
-		};
-		const rvalue a0_rval = {
-			.kind = RVALUE_KIND_REGISTER,
-			.val.reg_num = R_A0,
-			.type = TYPE_INTEGER,
-			.from_lvalue = !FROM_LVALUE
-		};
-		emit_store_of_rvalue(enc, &a0_lval, &a0_rval);
+		free(priority);
+		free(block);
+		return;
+	}
 
-		const lvalue a1_lval = {
-			.base_reg = R_SP,
-			// по call convention: первый на WORD_LENGTH выше предыдущего положения $fp,
-			// второй на 2*WORD_LENGTH и т.д.
-			.loc.displ = WORD_LENGTH,
-			.kind = LVALUE_KIND_STACK,
-			.type = arg_rvalue.type
-		};
-		const rvalue a1_rval = {
-			.kind = RVALUE_KIND_REGISTER,
-			.val.reg_num = R_A1,
-			.type = TYPE_INTEGER,
-			.from_lvalue = !FROM_LVALUE
-		};
-		emit_store_of_rvalue(enc, &a1_lval, &a1_rval);
+	size_t *const ready = &priority[size];
+	size_t *const preds = &priority[2 * size];
+	size_t *const texts = &priority[3 * size];
+	const mips_code *const codes = &enc->code[begin];
+	const mips_code *const control = end < enc->code_size && code_is_control(&enc->code[end]) ? &enc->code[end] : NULL;
 
-		if (!type_is_floating(enc->sx, arg_rvalue.type))
+	for (size_t i = size; i-- > 0;)
+	{
+		// Приоритет -- длина самого долгого пути от инструкции до конца блока
+		size_t path = control != NULL && code_is_dependent(&codes[i], control) ? 1 : 0;
+		preds[i] = 0;
+		for (size_t j = i + 1; j < size; j++)
 		{
-			uni_printf(enc->sx->io, "\n");
-			emit_move_rvalue_to_register(enc, R_A1, &arg_rvalue);
-
-			uni_printf(enc->sx->io, "\tlui $t1, %%hi(STRING%zu)\n", index + (i - 1) * amount);
-			uni_printf(enc->sx->io, "\taddiu $a0, $t1, %%lo(STRING%zu)\n", index + (i - 1) * amount);
+			if (code_is_dependent(&codes[i], &codes[j]))
+			{
+				path = max(path, priority[j]);
+				preds[j]++;
+			}
+		}
 
-			uni_printf(enc->sx->io, "\tjal printf\n");
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, IC_MIPS_NOP);
-			uni_printf(enc->sx->io, "\n");
+		priority[i] = code_latency(&codes[i]) + path;
+		ready[i] = 0;
+		texts[i] = codes[i].text;
+	}
 
-			free_rvalue(enc, &arg_rvalue);
+	size_t cycle = 0;
+	for (size_t k = 0; k < size; k++)
+	{
+		size_t best = SIZE_MAX;
+		for (size_t j = 0; j < size; j++)
+		{
+			if (preds[j] != 0)
+			{
+				continue;
+			}
 
-			uni_printf(enc->sx->io, "\n\t# data restoring:\n");
+			if (best == SIZE_MAX || max(ready[j], cycle) < max(ready[best], cycle)
+				|| (max(ready[j], cycle) == max(ready[best], cycle) && priority[j] > priority[best]))
+			{
+				best = j;
+			}
 		}
-		else
+
+		const size_t issue = max(ready[best], cycle);
+		const uint64_t defines = code_defines_mask(&codes[best]);
+		for (size_t j = best + 1; j < size; j++)
 		{
-			const lvalue a2_lval = {
-				.base_reg = R_SP,
-				// по call convention: первый на WORD_LENGTH выше предыдущего положения
-				// $fp, второй на 2*WORD_LENGTH и т.д.
-				.loc.displ = 2 * WORD_LENGTH,
-				.type = TYPE_INTEGER,
-				.kind = LVALUE_KIND_STACK
-			};
-			const rvalue a2_rval = {
-				.kind = RVALUE_KIND_REGISTER,
-				.val.reg_num = R_A2,
-				.type = TYPE_INTEGER,
-				.from_lvalue = !FROM_LVALUE
-			};
-			emit_store_of_rvalue(enc, &a2_lval, &a2_rval);
-			uni_printf(enc->sx->io, "\n");
-
-			// Конвертируем single to double
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, IC_MIPS_CVT_D_S);
-			uni_printf(enc->sx->io, " ");
-			rvalue_to_io(enc, &arg_rvalue);
-			uni_printf(enc->sx->io, ", ");
-			rvalue_to_io(enc, &arg_rvalue);
-			uni_printf(enc->sx->io, "\n");
-
-			// Следующие действия необходимы, т.к. аргументы в builtin-функции обязаны передаваться в $a0-$a3
-			// Даже для floating point!
-			// %lo из arg_rvalue в $a1
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, IC_MIPS_MFC_1);
-			uni_printf(enc->sx->io, " ");
-			mips_register_to_io(enc->sx->io, R_A1);
-			uni_printf(enc->sx->io, ", ");
-			rvalue_to_io(enc, &arg_rvalue);
-			uni_printf(enc->sx->io, "\n");
-
-			// %hi из arg_rvalue в $a2
-			uni_printf(enc->sx->io, "\t");
-			instruction_to_io(enc->sx->io, IC_MIPS_MFHC_1);
-			uni_printf(enc->sx->io, " ");
-			mips_register_to_io(enc->sx->io, R_A2);
-			uni_printf(enc->sx->io, ", ");
-			rvalue_to_io(enc, &arg_rvalue);
-			uni_printf(enc->sx->io, "\n");
-
-			uni_printf(enc->sx->io, "\tlui $t1, %%hi(STRING%zu)\n", index + (i - 1) * amount);
-			uni_printf(enc->sx->io, "\taddiu $a0, $t1, %%lo(STRING%zu)\n", index + (i - 1) * amount);
-
-			uni_printf(enc->sx->io, "\tjal printf\n\t");
-			instruction_to_io(enc->sx->io, IC_MIPS_NOP);
-			uni_printf(enc->sx->io, "\n");
-
-			// Восстановление регистров-аргументов -- они могут понадобится в дальнейшем
-			uni_printf(enc->sx->io, "\n\t# data restoring:\n");
-
-			const rvalue a2_rval_to_copy = emit_load_of_lvalue(enc, &a2_lval);
-			emit_move_rvalue_to_register(enc, R_A2, &a2_rval_to_copy);
-
-			free_rvalue(enc, &a2_rval);
-			free_rvalue(enc, &arg_rvalue);
-			uni_printf(enc->sx->io, "\n");
+			if (preds[j] != SIZE_MAX && code_is_dependent(&codes[best], &codes[j]))
+			{
+				const size_t latency = (defines & code_uses_mask(&codes[j])) ? code_latency(&codes[best]) : 1;
+				ready[j] = max(ready[j], issue + latency);
+				preds[j]--;
+			}
 		}
 
-		const rvalue a0_rval_to_copy = emit_load_of_lvalue(enc, &a0_lval);
-		emit_move_rvalue_to_register(enc, R_A0, &a0_rval_to_copy);
-
-		free_rvalue(enc, &a0_rval_to_copy);
-		uni_printf(enc->sx->io, "\n");
+		block[k] = codes[best];
+		block[k].text = texts[k];
+		preds[best] = SIZE_MAX;
+		cycle = issue + 1;
+	}
 
-		const rvalue a1_rval_to_copy = emit_load_of_lvalue(enc, &a1_lval);
-		emit_move_rvalue_to_register(enc, R_A1, &a1_rval_to_copy);
+	memcpy(&enc->code[begin], block, size * sizeof(mips_code));
+	free(priority);
+	free(block);
+}
 
-		free_rvalue(enc, &a1_rval_to_copy);
-		uni_printf(enc->sx->io, "\n");
+/**
+ *	Fill delay slot of control transfer by independent instruction of its basic block,
+ *	if there is no such instruction, @c nop is placed into delay slot
+ *
+ *	@param	enc					Encoder
+ *	@param	begin				Index of first instruction of basic block
+ *	@param	index				Index of control transfer
+ *
+ *	@return	Index after delay slot
+ */
+static size_t schedule_delay_slot(encoder *const enc, const size_t begin, const size_t index)
+{
+	size_t slot = index;
+	for (size_t i = index; i-- > begin && slot == index;)
+	{
+		bool is_independent = code_is_single(&enc->code[i]);
+		for (size_t j = i + 1; j <= index && is_independent; j++)
+		{
+			is_independent = !code_is_dependent(&enc->code[i], &enc->code[j]);
+		}
 
-		to_code_2R_I(
-			enc->sx->io,
-			IC_MIPS_ADDI,
-			R_SP,
-			R_SP,
-			(item_t)WORD_LENGTH * (!type_is_floating(enc->sx, arg_rvalue_type) ? /* $a0 и $a1 */ 1 : /* $a0, $a1 и $a2 */ 2)
-		);
-		uni_printf(enc->sx->io, "\n");
+		slot = is_independent ? i : slot;
 	}
 
-	const lvalue a0_lval = {
-		.base_reg = R_SP,
-		// по call convention: первый на WORD_LENGTH выше предыдущего положения $fp,
-		// второй на 2*WORD_LENGTH и т.д.
-		.loc.displ = 0,
-		.kind = LVALUE_KIND_STACK,
-		.type = TYPE_INTEGER
-	};
-	const rvalue a0_rval = {
-		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_REGISTER,
-		.val.reg_num = R_A0,
-		.type = TYPE_INTEGER
-	};
-	emit_store_of_rvalue(enc, &a0_lval, &a0_rval);
+	if (slot != index)
+	{
+		// Инструкция переносится за переход, комментарии остаются на своих местах
+		const mips_code code = enc->code[slot];
+		for (size_t i = slot; i < index; i++)
+		{
+			const size_t text = enc->code[i].text;
+			enc->code[i] = enc->code[i + 1];
+			enc->code[i].text = text;
+		}
 
-	uni_printf(enc->sx->io, "\tlui $t1, %%hi(STRING%zu)\n", index + (parameters_amount - 1) * amount);
-	uni_printf(enc->sx->io, "\taddiu $a0, $t1, %%lo(STRING%zu)\n", index + (parameters_amount - 1) * amount);
-	uni_printf(enc->sx->io, "\tjal printf\n");
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, IC_MIPS_NOP);
-	uni_printf(enc->sx->io, "\n");
+		const size_t text = enc->code[index].text;
+		enc->code[index] = code;
+		enc->code[index].text = text;
+		return index + 1;
+	}
 
-	uni_printf(enc->sx->io, "\n\t# data restoring:\n");
-	const rvalue a0_rval_to_copy = emit_load_of_lvalue(enc, &a0_lval);
-	emit_move_rvalue_to_register(enc, R_A0, &a0_rval_to_copy);
+	if (enc->code_size == enc->code_capacity)
+	{
+		const size_t capacity = 2 * enc->code_capacity;
+		mips_code *const codes = realloc(enc->code, capacity * sizeof(mips_code));
+		if (codes == NULL)
+		{
+			return index + 1;
+		}
 
-	free_rvalue(enc, &a0_rval_to_copy);
+		enc->code = codes;
+		enc->code_capacity = capacity;
+	}
 
-	// FIXME: Возвращает число распечатанных символов (включая '\0'?)
-	return RVALUE_VOID;
+	memmove(&enc->code[index + 2], &enc->code[index + 1], (enc->code_size - index - 1) * sizeof(mips_code));
+	enc->code[index + 1] = (mips_code){ .format = FORMAT_NONE, .instruction = IC_MIPS_NOP, .text = enc->code[index].text };
+	enc->code_size++;
+	return index + 2;
 }
 
 /**
- *	Emit builtin function call
+ *	Schedule instructions of function body and fill delay slots of control transfers.
+ *	@note	Scheduled body has to be written in @c noreorder mode of assembler
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
- *
- *	@return	Rvalue of builtin function call expression
  */
-static rvalue emit_builtin_call(encoder *const enc, const node *const nd)
+static void emit_schedule(encoder *const enc)
 {
-	const node callee = expression_call_get_callee(nd);
-	const size_t func_ref = expression_identifier_get_id(&callee);
-	switch (func_ref)
+	size_t begin = 0;
+	for (size_t i = 0; i < enc->code_size; i++)
 	{
-		case BI_PRINTF:
-			return emit_printf_expression(enc, nd);
-
-		default:
-			return RVALUE_VOID;
+		const mips_code *const code = &enc->code[i];
+		if (code_is_control(code))
+		{
+			schedule_block(enc, begin, i);
+			i = schedule_delay_slot(enc, begin, i) - 1;
+			begin = i + 1;
+		}
+		else if (!code_is_instruction(code))
+		{
+			schedule_block(enc, begin, i);
+			begin = i + 1;
+		}
+		else if (i - begin == SCHEDULE_WINDOW)
+		{
+			// Длинные блоки планируются по частям
+			schedule_block(enc, begin, i);
+			begin = i;
+		}
 	}
+
+	schedule_block(enc, begin, enc->code_size);
 }
 
 /**
- *	Emit call expression
+ *	Write instructions of function body with comments between them to io
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
- *
- *	@return	Rvalue of the result of call expression
+ *	@param	def					Function definition
  */
-static rvalue emit_call_expression(encoder *const enc, const node *const nd)
+static void emit_function_body(encoder *const enc, const definition *const def)
 {
-	const node callee = expression_call_get_callee(nd);
-	// Конвертируем в указатель на функцию
-	// FIXME: хотим рассмотреть любой callee как указатель
-	// на данный момент это не поддержано в билдере, когда будет сделано -- добавить в emit_expression()
-	// и применяем функцию emit_identifier_expression (т.к. его категория в билдере будет проставлена как rvalue)
-	const size_t func_ref = expression_identifier_get_id(&callee);
-	const size_t params_amount = expression_call_get_arguments_amount(nd);
-
-	const item_t return_type = type_function_get_return_type(enc->sx, expression_get_type(&callee));
-
-	uni_printf(enc->sx->io, "\t# \"%s\" function call:\n", ident_get_spelling(enc->sx, func_ref));
-
-	if (func_ref >= BEGIN_USER_FUNC)
+	const char *const buffer = def->buffer != NULL ? def->buffer : "";
+	size_t position = 0;
+	for (size_t i = 0; i < def->enc.code_size; i++)
 	{
-		size_t f_arg_count = 0;
-		size_t arg_count = 0;
-		size_t displ_for_parameters = (params_amount - 1) * WORD_LENGTH;
-		lvalue prev_arg_displ[4 /* за $a0-$a3 */
-									+ 4 / 2 /* за $fa0, $fa2 (т.к. single precision)*/];
-
-		uni_printf(enc->sx->io, "\t# setting up $sp:\n");
-		if (displ_for_parameters)
-		{
-			to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_SP, R_SP, -(item_t)(displ_for_parameters));
-		}
-
-		uni_printf(enc->sx->io, "\n\t# parameters passing:\n");
-
-		// TODO: структуры / массивы в параметры
-		size_t arg_reg_count = 0;
-		for (size_t i = 0; i < params_amount; i++)
-		{
-			const node arg = expression_call_get_argument(nd, i);
-			const rvalue tmp = emit_expression(enc, &arg);
-			const rvalue arg_rvalue = (tmp.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &tmp) : tmp;
-
-			if ((type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT)
-			{
-				uni_printf(enc->sx->io, "\t# saving ");
-				mips_register_to_io(enc->sx->io, (type_is_floating(enc->sx, arg_rvalue.type)
-					? R_FA0 + f_arg_count
-					: R_A0 + arg_count));
-				uni_printf(enc->sx->io, " value on stack:\n");
-			}
-			else
-			{
-				uni_printf(enc->sx->io, "\t# parameter on stack:\n");
-			}
-
-			const lvalue tmp_arg_lvalue = {
-				.base_reg = R_SP,
-				// по call convention: первый на WORD_LENGTH выше предыдущего положения $fp,
-				// второй на 2*WORD_LENGTH и т.д.
-				.loc.displ = i * WORD_LENGTH,
-				.kind = LVALUE_KIND_STACK,
-				.type = arg_rvalue.type
-			};
-
-			const rvalue arg_saved_rvalue = {
-				.kind = RVALUE_KIND_REGISTER,
-				.val.reg_num = (type_is_floating(enc->sx, arg_rvalue.type)
-					? R_FA0 + f_arg_count
-					: R_A0 + arg_count),
-				.type = arg_rvalue.type,
-				.from_lvalue = !FROM_LVALUE
-			};
-			// Сохранение текущего регистра-аргумента на стек либо передача аргументов на стек
-			emit_store_of_rvalue(
-				enc,
-				&tmp_arg_lvalue,
-				(type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT
-					? &arg_saved_rvalue	// Сохранение значения в регистре-аргументе
-					: &arg_rvalue		// Передача аргумента
-			);
-
-			// Если это передача параметров в регистры-аргументы
-			if ((type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT)
-			{
-				// Аргументы рассматриваются в данном случае как регистровые переменные
-				emit_move_rvalue_to_register(
-					enc,
-					type_is_floating(enc->sx, arg_rvalue.type)
-						? (R_FA0 + f_arg_count)
-						: (R_A0 + arg_count),
-					&arg_rvalue);
-
-				// Запоминаем, куда положили текущее значение, лежавшее в регистре-аргументе
-				prev_arg_displ[arg_reg_count++] = tmp_arg_lvalue;
-			}
-
-			if (type_is_floating(enc->sx, arg_rvalue.type))
-			{
-				f_arg_count += 2;
-			}
-			else
-			{
-				arg_count += 1;
-			}
-
-			free_rvalue(enc, &arg_rvalue);
-		}
+		const size_t text = def->enc.code[i].text;
+		uni_printf(enc->io, "%.*s", (int)(text - position), &buffer[position]);
+		code_write(enc, &def->enc.code[i]);
+		position = text;
+	}
 
-		const label label_func = { .kind = L_FUNC, .num = func_ref };
-		emit_unconditional_branch(enc, IC_MIPS_JAL, &label_func);
+	uni_printf(enc->io, "%s", &buffer[position]);
+}
 
-		// Восстановление регистров-аргументов -- они могут понадобится в дальнейшем
-		uni_printf(enc->sx->io, "\n\t# data restoring:\n");
 
-		size_t i = 0, j = 0;	// Счётчик обычных и floating point регистров-аргументов соответственно
-		while (i + j < arg_reg_count)
-		{
-			uni_printf(enc->sx->io, "\n");
+/*
+ *	 ______     __  __     ______   ______     ______     ______     ______     __     ______     __   __     ______
+ *	/\  ___\   /\_\_\_\   /\  == \ /\  == \   /\  ___\   /\  ___\   /\  ___\   /\ \   /\  __ \   /\ "-.\ \   /\  ___\
+ *	\ \  __\   \/_/\_\/_  \ \  _-/ \ \  __<   \ \  __\   \ \___  \  \ \___  \  \ \ \  \ \ \/\ \  \ \ \-.  \  \ \___  \
+ *	 \ \_____\   /\_\/\_\  \ \_\    \ \_\ \_\  \ \_____\  \/\_____\  \/\_____\  \ \_\  \ \_____\  \ \_\\"\_\  \/\_____\
+ *	  \/_____/   \/_/\/_/   \/_/     \/_/ /_/   \/_____/   \/_____/   \/_____/   \/_/   \/_____/   \/_/ \/_/   \/_____/
+ */
 
-			const rvalue tmp_rval = emit_load_of_lvalue(enc, &prev_arg_displ[i + j]);
-			emit_move_rvalue_to_register(
-				enc,
-				type_is_floating(enc->sx, prev_arg_displ[i + j].type) ? (R_FA0 + 2 * j++) : (R_A0 + i++),
-				&tmp_rval
-			);
 
-			free_rvalue(enc, &tmp_rval);
-		}
+/**
+ *	Creates register kind rvalue and stores there constant kind rvalue
+ *
+ *	@param	enc					Encoder
+ *	@param	value				Rvalue of constant kind
+ *
+ *	@return	Created rvalue
+ */
+static rvalue emit_load_of_immediate(encoder *const enc, const rvalue *const value)
+{
+	assert(value->kind == RVALUE_KIND_CONST);
 
-		if (displ_for_parameters)
-		{
-			to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_SP, R_SP, (item_t)displ_for_parameters);
-		}
+	const mips_register_t reg = (type_is_floating(enc->sx, value->type)) ? get_float_register(enc) : get_register(enc);
 
-		uni_printf(enc->sx->io, "\n");
+	if (type_is_floating(enc->sx, value->type))
+	{
+		to_code_R_F(enc, IC_MIPS_LI_S, reg, value->val.float_val);
 	}
 	else
 	{
-		return emit_builtin_call(enc, nd);
+		to_code_R_I(enc, IC_MIPS_LI, reg, value->val.int_val);
 	}
 
 	return (rvalue) {
+		.from_lvalue = !FROM_LVALUE,
 		.kind = RVALUE_KIND_REGISTER,
-		.type = return_type,
-		.val.reg_num = type_is_floating(enc->sx, return_type) ? R_FV0 : R_V0,
-		.from_lvalue = !FROM_LVALUE
+		.val.reg_num = reg,
+		.type = value->type
 	};
 }
 
 /**
- *	Emit member expression
+ *	Forms rvalue which register can be overwritten. Constant is loaded to a new register,
+ *	value of register variable is copied to a new register
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	value				Rvalue to form from
  *
- *	@return	Rvalue of member expression
+ *	@return	Formed rvalue
  */
-static rvalue emit_member_expression(encoder *const enc, const node *const nd)
+static rvalue emit_writable_rvalue(encoder *const enc, const rvalue *const value)
 {
-	(void)enc;
-	(void)nd;
-	// FIXME: возврат структуры из функции. Указателя тут оказаться не может
-	return RVALUE_VOID;
+	if (value->kind == RVALUE_KIND_CONST)
+	{
+		return emit_load_of_immediate(enc, value);
+	}
+
+	if (!value->from_lvalue)
+	{
+		return *value;
+	}
+
+	const bool is_floating = type_is_floating(enc->sx, value->type);
+	const rvalue result = {
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = is_floating ? get_float_register(enc) : get_register(enc),
+		.from_lvalue = !FROM_LVALUE,
+		.type = value->type
+	};
+
+	to_code_2R(enc, is_floating ? IC_MIPS_MOV_S : IC_MIPS_MOVE, result.val.reg_num, value->val.reg_num);
+	return result;
 }
 
 /**
- *	Emit cast expression
+ *	Spill kept value to the stack frame before evaluation of expression if the expression
+ *	calls functions or there are not enough free temporary registers for it
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	kept				Rvalue kept in register during evaluation
+ *	@param	nd					Expression to evaluate
  *
- *	@return	Rvalue of cast expression
+ *	@return	Displacement of spilled value from $fp, @c 0 if value stays in register
  */
-static rvalue emit_cast_expression(encoder *const enc, const node *const nd)
+static item_t emit_spill(encoder *const enc, const rvalue *const kept, const node *const nd)
 {
-	const node operand = expression_cast_get_operand(nd);
-	const rvalue value = emit_expression(enc, &operand);
-
-	const item_t target_type = expression_get_type(nd);
-	const item_t source_type = expression_get_type(&operand);
-
-	if (type_is_integer(enc->sx, source_type) && type_is_floating(enc->sx, target_type))
+	if ((kept->kind != RVALUE_KIND_REGISTER) || (kept->from_lvalue))
 	{
-		// int -> float
-		const rvalue result = {
-			.kind = RVALUE_KIND_REGISTER,
-			.from_lvalue = !FROM_LVALUE,
-			.val.reg_num = get_float_register(enc),
-			.type = target_type
-		};
-
-		// FIXME: избавится от to_code функций
-		to_code_2R(enc->sx->io, IC_MIPS_MFC_1, value.val.reg_num, result.val.reg_num);
-		to_code_2R(enc->sx->io, IC_MIPS_CVT_S_W, result.val.reg_num, result.val.reg_num);
-
-		free_rvalue(enc, &value);
-		return result;
+		// Регистровые переменные и параметры не портятся вызовами
+		return 0;
 	}
-	else
+
+	const bool is_floating = type_is_floating(enc->sx, kept->type);
+	const expression_t class = expression_get_class(nd);
+	const bool is_leaf = (class == EXPR_IDENTIFIER) || (class == EXPR_LITERAL);
+	if (!has_call(nd) && (is_leaf || get_free_register_amount(enc, is_floating) >= 2))
 	{
-		// char -> int пока не поддержано в билдере
-		return (rvalue) {
-			.from_lvalue = value.from_lvalue,
-			.kind = value.kind,
-			.val.int_val = value.val.int_val,
-			.type = TYPE_INTEGER
-		};
+		return 0;
 	}
+
+	enc->scope_displ += WORD_LENGTH;
+	enc->max_displ = max(enc->scope_displ, enc->max_displ);
+	const item_t displ = -(item_t)enc->scope_displ;
+
+	uni_printf(enc->io, "\t# spilling ");
+	mips_register_to_io(enc->io, kept->val.reg_num);
+	uni_printf(enc->io, ":\n");
+	to_code_R_I_R(enc, is_floating ? IC_MIPS_S_S : IC_MIPS_SW, kept->val.reg_num, displ, R_FP);
+	free_rvalue(enc, kept);
+
+	return displ;
 }
 
 /**
- *	Emit increment or decrement expression
+ *	Reload value spilled by @ref emit_spill() to a new register
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	kept				Kept rvalue
+ *	@param	displ				Displacement of spilled value
  *
- *	@return	Rvalue of the result of increment or decrement expression
+ *	@return	Kept rvalue on its register
  */
-static rvalue emit_increment_expression(encoder *const enc, const node *const nd)
+static rvalue emit_reload(encoder *const enc, const rvalue *const kept, const item_t displ)
 {
-	const node operand = expression_unary_get_operand(nd);
-	const lvalue operand_lvalue = emit_lvalue(enc, &operand);
-	const rvalue operand_rvalue = emit_load_of_lvalue(enc, &operand_lvalue);
+	if (displ == 0)
+	{
+		return *kept;
+	}
 
-	const unary_t operator = expression_unary_get_operator(nd);
-	const bool is_prefix = (operator == UN_PREDEC) || (operator == UN_PREINC);
-	const rvalue imm_rvalue = {
+	const bool is_floating = type_is_floating(enc->sx, kept->type);
+	const rvalue result = {
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = is_floating ? get_float_register(enc) : get_register(enc),
 		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_CONST,
-		.val.int_val = ((operator == UN_PREINC) || (operator == UN_POSTINC)) ? 1 : -1,
-		.type = TYPE_INTEGER
+		.type = kept->type
 	};
 
-	if (is_prefix)
-	{
-		emit_binary_operation(enc, &operand_rvalue, &operand_rvalue, &imm_rvalue, BIN_ADD);
-		emit_store_of_rvalue(enc, &operand_lvalue, &operand_rvalue);
-	}
-	else
-	{
-		const rvalue post_result_rvalue = {
-			.from_lvalue = !FROM_LVALUE,
-			.kind = RVALUE_KIND_REGISTER,
-			.val.reg_num = get_register(enc),
-			.type = operand_lvalue.type
-		};
-
-		emit_binary_operation(enc, &post_result_rvalue, &operand_rvalue, &imm_rvalue, BIN_ADD);
-		emit_store_of_rvalue(enc, &operand_lvalue, &post_result_rvalue);
-		free_rvalue(enc, &post_result_rvalue);
-	}
+	uni_printf(enc->io, "\t# reloading ");
+	mips_register_to_io(enc->io, result.val.reg_num);
+	uni_printf(enc->io, ":\n");
+	to_code_R_I_R(enc, is_floating ? IC_MIPS_L_S : IC_MIPS_LW, result.val.reg_num, displ, R_FP);
 
-	return operand_rvalue;
+	enc->scope_displ -= WORD_LENGTH;
+	return result;
 }
 
 /**
- *	Emit unary expression
+ *	Loads lvalue to register and forms rvalue. If lvalue kind is @c LVALUE_KIND_REGISTER,
+ *	returns rvalue on the same register
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	lval				Lvalue to load
  *
- *	@return	Rvalue of the result of unary expression
+ *	@return	Formed rvalue
  */
-static rvalue emit_unary_expression(encoder *const enc, const node *const nd)
+static rvalue emit_load_of_lvalue(encoder *const enc, const lvalue *const lval)
 {
-	const unary_t operator = expression_unary_get_operator(nd);
-	assert(operator != UN_INDIRECTION);
-
-	switch (operator)
+	if (lval->kind == LVALUE_KIND_REGISTER)
 	{
-		case UN_POSTINC:
-		case UN_POSTDEC:
-		case UN_PREINC:
-		case UN_PREDEC:
-			return emit_increment_expression(enc, nd);
-
-		case UN_MINUS:
-		case UN_NOT:
-		{
-			const node operand = expression_unary_get_operand(nd);
-			const rvalue operand_rvalue = emit_expression(enc, &operand);
-			const binary_t instruction = (operator == UN_MINUS) ? BIN_MUL : BIN_XOR;
-
-			emit_binary_operation(enc, &operand_rvalue, &operand_rvalue, &RVALUE_NEGATIVE_ONE, instruction);
-			return operand_rvalue;
-		}
-
-		case UN_LOGNOT:
-		{
-			const node operand = expression_unary_get_operand(nd);
-			const rvalue value = emit_expression(enc, &operand);
-
-			to_code_2R_I(enc->sx->io, IC_MIPS_SLTIU, value.val.reg_num, value.val.reg_num, 1);
-			return value;
-		}
+		return (rvalue) {
+			.kind = RVALUE_KIND_REGISTER,
+			.val.reg_num = lval->loc.reg_num,
+			.from_lvalue = FROM_LVALUE,
+			.type = lval->type
+		};
+	}
 
-		case UN_ABS:
-		{
-			const node operand = expression_unary_get_operand(nd);
-			const rvalue operand_rvalue = emit_expression(enc, &operand);
-			const mips_instruction_t instruction = type_is_floating(enc->sx, operand_rvalue.type) ? IC_MIPS_ABS_S : IC_MIPS_ABS;
+	// Глобальный массив хранит адрес первого элемента, он загружается как скалярное значение
+	if (type_is_structure(enc->sx, lval->type) || (type_is_array(enc->sx, lval->type) && lval->base_reg != R_GP))
+	{
+		// Грузим адрес первого элемента на регистр
+		const rvalue tmp = { .kind = RVALUE_KIND_CONST, .val.int_val = lval->loc.displ, .type = TYPE_INTEGER };
+		const rvalue displ_rvalue = emit_load_of_immediate(enc, &tmp);
 
-			to_code_2R(enc->sx->io, instruction, operand_rvalue.val.reg_num, operand_rvalue.val.reg_num);
-			return operand_rvalue;
-		}
+		const rvalue base_reg_rvalue = { .kind = RVALUE_KIND_REGISTER, .val.reg_num = lval->base_reg, .type = TYPE_INTEGER };
 
-		case UN_ADDRESS:
-		{
-			const node operand = expression_unary_get_operand(nd);
-			const lvalue operand_lvalue = emit_lvalue(enc, &operand);
+		emit_binary_operation(enc, &displ_rvalue, &displ_rvalue, &base_reg_rvalue, BIN_ADD);
+		return displ_rvalue;
+	}
 
-			assert(operand_lvalue.kind != LVALUE_KIND_REGISTER);
+	const bool is_floating = type_is_floating(enc->sx, lval->type);
+	const mips_register_t reg = is_floating ? get_float_register(enc) : get_register(enc);
+	const mips_instruction_t instruction = is_floating ? IC_MIPS_L_S : IC_MIPS_LW;
 
-			const rvalue result_rvalue = {
-				.from_lvalue = !FROM_LVALUE,
-				.kind = RVALUE_KIND_REGISTER,
-				.val.reg_num = get_register(enc),
-				.type = TYPE_INTEGER
-			};
+	const rvalue result = {
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = reg,
+		.from_lvalue = !FROM_LVALUE,
+		.type = lval->type,
+	};
 
-			to_code_2R_I(
-				enc->sx->io,
-				IC_MIPS_ADDI,
-				result_rvalue.val.reg_num,
-				operand_lvalue.base_reg,
-				operand_lvalue.loc.displ
-			);
-			return result_rvalue;
-		}
+	to_code_R_I_R(enc, instruction, reg, lval->loc.displ, lval->base_reg);
 
-		case UN_UPB:
-		{
-			const node operand = expression_unary_get_operand(nd);
-			const rvalue array_address = emit_expression(enc, &operand);
-			const lvalue size_lvalue = {
-				.base_reg = array_address.val.reg_num,
-				.kind = LVALUE_KIND_STACK,
-				.loc.displ = WORD_LENGTH,
-				.type = TYPE_INTEGER
-			};
-			return emit_load_of_lvalue(enc, &size_lvalue);
-		}
+	// Для любых скалярных типов ничего не произойдёт,
+	// а для остальных освобождается base_reg, в котором хранилось смещение
+	free_register(enc, lval->base_reg);
 
-		default:
-			system_error(node_unexpected);
-			return RVALUE_VOID;
-	}
+	return result;
 }
 
 /**
- *	Emit binary expression
+ *	Emit identifier lvalue
  *
  *	@param	enc					Encoder
  *	@param	nd					Node in AST
  *
- *	@return	Rvalue of the result of binary expression
+ *	@return	Identifier lvalue
  */
-static rvalue emit_binary_expression(encoder *const enc, const node *const nd)
+static lvalue emit_identifier_lvalue(encoder *const enc, const node *const nd)
 {
-	const binary_t operator = expression_binary_get_operator(nd);
-	const node LHS = expression_binary_get_LHS(nd);
-	const node RHS = expression_binary_get_RHS(nd);
-
-	switch (operator)
-	{
-		case BIN_COMMA:
-		{
-			emit_void_expression(enc, &LHS);
-			return emit_expression(enc, &RHS);
-		}
-
-		case BIN_LOG_OR:
-		case BIN_LOG_AND:
-		{
-			const rvalue lhs_rvalue = emit_expression(enc, &LHS);
-			// Случай константы нужно сделать в билдере, на данный момент отсутствует
-
-			const item_t curr_label_num = enc->label_num++;
-			const label label_end = { .kind = L_END, .num = (size_t)curr_label_num };
-
-			const mips_instruction_t instruction = (operator == BIN_LOG_OR) ? IC_MIPS_BNE : IC_MIPS_BEQ;
-			emit_conditional_branch(enc, instruction, &lhs_rvalue, &label_end);
-
-			free_rvalue(enc, &lhs_rvalue);
-
-			const rvalue rhs_rvalue = emit_expression(enc, &RHS);
-			assert(lhs_rvalue.val.reg_num == rhs_rvalue.val.reg_num);
-
-			emit_label_declaration(enc, &label_end);
-			return rhs_rvalue;
-		}
-
-		default:
-		{
-			const rvalue lhs_rvalue = emit_expression(enc, &LHS);
-			const rvalue rhs_rvalue = emit_expression(enc, &RHS);
-
-			emit_binary_operation(enc, &lhs_rvalue, &lhs_rvalue, &rhs_rvalue, operator);
-
-			free_rvalue(enc, &rhs_rvalue);
-			return lhs_rvalue;
-		}
-	}
+	return displacements_get(enc, expression_identifier_get_id(nd));
 }
 
 /**
- *	Emit ternary expression
+ *	Emit subscript lvalue
  *
  *	@param	enc					Encoder
  *	@param	nd					Node in AST
  *
- *	@return	Rvalue of the result of ternary expression
+ *	@return	Subscript lvalue
  */
-static rvalue emit_ternary_expression(encoder *const enc, const node *const nd)
+static lvalue emit_subscript_lvalue(encoder *const enc, const node *const nd)
 {
-	const node condition = expression_ternary_get_condition(nd);
-	const rvalue value = emit_expression(enc, &condition);
-
-	const size_t label_num = enc->label_num++;
-	const label label_else = { .kind = L_ELSE, .num = label_num };
+	const item_t type = expression_get_type(nd);
 
-	const mips_instruction_t instruction = IC_MIPS_BNE;
-	emit_conditional_branch(enc, instruction, &value, &label_else);
-	free_rvalue(enc, &value);
+	const node base = expression_subscript_get_base(nd);
+	const rvalue base_kept = emit_expression(enc, &base);
 
-	const rvalue result = {.kind = RVALUE_KIND_REGISTER, .val.reg_num = get_register(enc), .from_lvalue = !FROM_LVALUE, .type = expression_get_type(nd)};
+	const node index = expression_subscript_get_index(nd);
+	const item_t base_displ = emit_spill(enc, &base_kept, &index);
+	const rvalue index_value = emit_expression(enc, &index);
+	const rvalue base_value = emit_reload(enc, &base_kept, base_displ);
 
-	const node LHS = expression_ternary_get_LHS(nd);
-	const rvalue LHS_rvalue = emit_expression(enc, &LHS);
-	emit_move_rvalue_to_register(enc, result.val.reg_num, &LHS_rvalue);
-	free_rvalue(enc, &LHS_rvalue);
+	// base_value гарантированно имеет kind == RVALUE_KIND_REGISTER
+	if (index_value.kind == RVALUE_KIND_CONST)
+	{
+		return (lvalue) {
+			.kind = LVALUE_KIND_STACK,
+			.base_reg = base_value.val.reg_num,
+			.loc.displ = -(item_t)index_value.val.int_val * mips_type_size(enc->sx, type),
+			.type = type
+		};
+	}
 
-	const label label_end = { .kind = L_END, .num = label_num };
-	emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
-	emit_label_declaration(enc, &label_else);
+	const rvalue type_size_value = {	// Можно было бы сделать отдельным конструктором
+		.from_lvalue = !FROM_LVALUE,
+		.kind = RVALUE_KIND_CONST,
+		.val.int_val = mips_type_size(enc->sx, type),
+		.type = TYPE_INTEGER
+	};
+	const rvalue offset = {
+		.from_lvalue = !FROM_LVALUE,
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = get_register(enc),
+		.type = TYPE_INTEGER
+	};
 
-	const node RHS = expression_ternary_get_RHS(nd);
-	const rvalue RHS_rvalue = emit_expression(enc, &RHS);
-	emit_move_rvalue_to_register(enc, result.val.reg_num, &RHS_rvalue);
-	free_rvalue(enc, &RHS_rvalue);
+	emit_binary_operation(enc, &offset, &index_value, &type_size_value, BIN_MUL);
+	free_rvalue(enc, &index_value);
 
-	emit_label_declaration(enc, &label_end);
+	// Адрес элемента не должен попасть в регистровую переменную-указатель
+	const rvalue address_value = emit_writable_rvalue(enc, &base_value);
+	emit_binary_operation(enc, &address_value, &address_value, &offset, BIN_SUB);
+	free_rvalue(enc, &offset);
 
-	return result;
+	return (lvalue) { .kind = LVALUE_KIND_STACK, .base_reg = address_value.val.reg_num, .loc.displ = 0, .type = type };
 }
 
 /**
- *	Emit structure assignment
+ *	Emit member lvalue
  *
  *	@param	enc					Encoder
- *	@param	target				Target lvalue
- *	@param	value				Value to assign to target
+ *	@param	nd					Node in AST
  *
- *	@return	Rvalue of the result of assignment expression
+ *	@return	Created lvalue
  */
-static rvalue emit_struct_assignment(encoder *const enc, const lvalue *const target, const node *const value)
+static lvalue emit_member_lvalue(encoder *const enc, const node *const nd)
 {
-	if (expression_get_class(value) == EXPR_INITIALIZER)	// Присваивание списком
+	const node base = expression_member_get_base(nd);
+	const item_t base_type = expression_get_type(&base);
+
+	const bool is_arrow = expression_member_is_arrow(nd);
+	const item_t struct_type = is_arrow ? type_pointer_get_element_type(enc->sx, base_type) : base_type;
+
+	size_t member_displ = 0;
+	const size_t member_index = expression_member_get_member_index(nd);
+	for (size_t i = 0; i < member_index; i++)
 	{
-		emit_structure_init(enc, target, value);
+		const item_t member_type = type_structure_get_member_type(enc->sx, struct_type, i);
+		member_displ += mips_type_size(enc->sx, member_type);
 	}
-	else	// Присваивание другой структуры
-	{
-		// FIXME: возврат структуры из функции
-		// FIXME: массив структур
-		const size_t RHS_identifier = expression_identifier_get_id(value);
-		const lvalue RHS_lvalue = displacements_get(enc, RHS_identifier);
 
-		// Копирование всех данных из RHS
-		const item_t type = expression_get_type(value);
-		const size_t struct_size = mips_type_size(enc->sx, type);
-		for (size_t i = 0; i < struct_size; i += WORD_LENGTH)
-		{
-			// Грузим данные из RHS
-			const lvalue value_word = {
-				.base_reg = RHS_lvalue.base_reg,
-				.loc.displ = RHS_lvalue.loc.displ + i,
-				.kind = LVALUE_KIND_STACK,
-				.type = TYPE_INTEGER
-			};
-			const rvalue proxy = emit_load_of_lvalue(enc, &value_word);
-
-			// Отправляем их в variable
-			const lvalue target_word = {
-				.base_reg = target->base_reg,
-				.kind = LVALUE_KIND_STACK,
-				.loc.displ = target->loc.displ + i,
-				.type = TYPE_INTEGER
-			};
-			emit_store_of_rvalue(enc, &target_word, &proxy);
-
-			free_rvalue(enc, &proxy);
-		}
-	}
-
-	return emit_load_of_lvalue(enc, target);
-}
-
-/**
- *	Emit assignment expression
- *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
- *
- *	@return	Rvalue of the result of assignment expression
- */
-static rvalue emit_assignment_expression(encoder *const enc, const node *const nd)
-{
-	const node LHS = expression_assignment_get_LHS(nd);
-	const lvalue target = emit_lvalue(enc, &LHS);
-
-	const node RHS = expression_assignment_get_RHS(nd);
-	const item_t RHS_type = expression_get_type(&RHS);
-	if (type_is_structure(enc->sx, RHS_type))
-	{
-		return emit_struct_assignment(enc, &target, &RHS);
-	}
-
-	const rvalue value = emit_expression(enc, &RHS);
+	const item_t type = expression_get_type(nd);
 
-	const binary_t operator = expression_assignment_get_operator(nd);
-	if (operator == BIN_ASSIGN)
+	if (is_arrow)
 	{
-		emit_store_of_rvalue(enc, &target, &value);
-		return value;
+		const rvalue struct_pointer = emit_expression(enc, &base);
+		// FIXME: грузить константу на регистр в случае константных указателей
+		return (lvalue) {
+			.kind = LVALUE_KIND_STACK,
+			.base_reg = struct_pointer.val.reg_num,
+			.loc.displ = member_displ,
+			.type = type
+		};
 	}
-
-	// это "+=", "-=" и т.п.
-	const rvalue target_value = emit_load_of_lvalue(enc, &target);
-	binary_t correct_operation;
-	switch (operator)
+	else
 	{
-		case BIN_ADD_ASSIGN:
-			correct_operation = BIN_ADD;
-			break;
-
-		case BIN_SUB_ASSIGN:
-			correct_operation = BIN_SUB;
-			break;
-
-		case BIN_MUL_ASSIGN:
-			correct_operation = BIN_MUL;
-			break;
-
-		case BIN_DIV_ASSIGN:
-			correct_operation = BIN_DIV;
-			break;
-
-		case BIN_SHL_ASSIGN:
-			correct_operation = BIN_SHL;
-			break;
-
-		case BIN_SHR_ASSIGN:
-			correct_operation = BIN_SHR;
-			break;
-
-		case BIN_AND_ASSIGN:
-			correct_operation = BIN_AND;
-			break;
-
-		case BIN_XOR_ASSIGN:
-			correct_operation = BIN_XOR;
-			break;
-
-		case BIN_OR_ASSIGN:
-			correct_operation = BIN_OR;
-			break;
-
-		default:
-			system_error(node_unexpected);
-			return RVALUE_VOID;
+		const lvalue base_lvalue = emit_lvalue(enc, &base);
+		const size_t displ = (size_t)(base_lvalue.loc.displ + member_displ);
+		return (lvalue) {
+			.kind = LVALUE_KIND_STACK,
+			.base_reg = base_lvalue.base_reg,
+			.loc.displ = displ,
+			.type = type
+		};
 	}
-
-	emit_binary_operation(enc, &target_value, &target_value, &value, correct_operation);
-	free_rvalue(enc, &value);
-
-	emit_store_of_rvalue(enc, &target, &target_value);
-	return target_value;
 }
 
 /**
- *	Emit inline expression
+ *	Emit indirection lvalue
  *
  *	@param	enc					Encoder
  *	@param	nd					Node in AST
  *
- *	@return	Rvalue of inline expression
+ *	@return	Indirected lvalue
  */
-// TODO: текущая ветка от feature, а туда inline_expression'ы пока не влили
-/* static rvalue emit_inline_expression(encoder *const enc, const node *const nd)
+static lvalue emit_indirection_lvalue(encoder *const enc, const node *const nd)
 {
-	// FIXME: inline expression cannot return value at the moment
-	const size_t amount = expression_inline_get_size(nd);
+	assert(expression_unary_get_operator(nd) == UN_INDIRECTION);
 
-	for (size_t i = 0; i < amount; i++)
-	{
-		const node substmt = expression_inline_get_substmt(nd, i);
-		emit_statement(enc, &substmt);
-	}
+	const node operand = expression_unary_get_operand(nd);
+	const rvalue base = emit_expression(enc, &operand);
+	// FIXME: грузить константу на регистр в случае константных указателей
+	const item_t type = expression_get_type(nd);
 
-	return RVALUE_VOID;
-} */
+	return (lvalue) {
+		.kind = LVALUE_KIND_STACK,
+		.base_reg = base.val.reg_num,
+		.loc.displ = 0,
+		.type = type
+	};
+}
 
 /**
- *	Emit expression
+ *	Emit lvalue expression
  *
  *	@param	enc					Encoder
  *	@param	nd					Node in AST
  *
- *	@return	Rvalue of the expression
+ *	@return	Lvalue
  */
-static rvalue emit_expression(encoder *const enc, const node *const nd)
+static lvalue emit_lvalue(encoder *const enc, const node *const nd)
 {
-	if (expression_is_lvalue(nd))
-	{
-		const lvalue lval = emit_lvalue(enc, nd);
-		return emit_load_of_lvalue(enc, &lval);
-	}
+	assert(expression_is_lvalue(nd));
 
-	// Иначе rvalue:
 	switch (expression_get_class(nd))
 	{
-		case EXPR_LITERAL:
-			return emit_literal_expression(enc, nd);
+		case EXPR_IDENTIFIER:
+			return emit_identifier_lvalue(enc, nd);
 
-		case EXPR_CALL:
-			return emit_call_expression(enc, nd);
+		case EXPR_SUBSCRIPT:
+			return emit_subscript_lvalue(enc, nd);
 
 		case EXPR_MEMBER:
-			return emit_member_expression(enc, nd);
-
-		case EXPR_CAST:
-			return emit_cast_expression(enc, nd);
-
-		case EXPR_UNARY:
-			return emit_unary_expression(enc, nd);
-
-		case EXPR_BINARY:
-			return emit_binary_expression(enc, nd);
-
-		case EXPR_ASSIGNMENT:
-			return emit_assignment_expression(enc, nd);
-
-		case EXPR_TERNARY:
-			return emit_ternary_expression(enc, nd);
-
-		/*
-		// TODO: текущая ветка от feature, а туда inline_expression'ы пока не влили
-		case EXPR_INLINE:
-			return emit_inline_expression(enc, nd);
-		*/
+			return emit_member_lvalue(enc, nd);
 
-		case EXPR_INITIALIZER:
-			system_error(node_unexpected);
-			return RVALUE_VOID;
+		case EXPR_UNARY:	// Только UN_INDIRECTION
+			return emit_indirection_lvalue(enc, nd);
 
 		default:
-			system_error(node_unexpected);
-			return RVALUE_VOID;
+			// Не может быть lvalue
+			system_error(node_unexpected, nd);
+			return (lvalue) { .loc.displ = ITEM_MAX };
 	}
 }
 
 /**
- *	Emit expression which will be evaluated as a void expression
+ *	Stores one rvalue of register kind to another
  *
  *	@param	enc					Encoder
- *	@param	nd					Node in AST
- *
- *	@return	Rvalue of void type
+ *	@param	target				Target register
+ *	@param	value				Rvalue to store
  */
-static rvalue emit_void_expression(encoder *const enc, const node *const nd)
+static void emit_move_rvalue_to_register(encoder *const enc
+	, const mips_register_t target, const rvalue *const value)
 {
-	if (expression_is_lvalue(nd))
+	if (value->kind == RVALUE_KIND_CONST)
 	{
-		emit_lvalue(enc, nd);	// Либо регистровая переменная, либо на стеке => ничего освобождать не надо
+		if (!type_is_floating(enc->sx, value->type))
+		{
+			to_code_R_I(enc, IC_MIPS_LI, target, value->val.int_val);
+		}
+		else
+		{
+			to_code_R_F(enc, IC_MIPS_LI_S, target, value->val.float_val);
+		}
+		return;
+	}
+
+	if (value->val.reg_num == target)
+	{
+		uni_printf(enc->io, "\t# stays in register ");
+		mips_register_to_io(enc->io, target);
+		uni_printf(enc->io, ":\n");
 	}
 	else
 	{
-		const rvalue result = emit_expression(enc, nd);
-		free_rvalue(enc, &result);
+		const mips_instruction_t instruction = !type_is_floating(enc->sx, value->type) ? IC_MIPS_MOVE : IC_MIPS_MFC_1;
+		to_code_2R(enc, instruction, target, value->val.reg_num);
 	}
-	return RVALUE_VOID;
 }
 
-
-/*
- *	 _____     ______     ______     __         ______     ______     ______     ______   __     ______     __   __     ______
- *	/\  __-.  /\  ___\   /\  ___\   /\ \       /\  __ \   /\  == \   /\  __ \   /\__  _\ /\ \   /\  __ \   /\ "-.\ \   /\  ___\
- *	\ \ \/\ \ \ \  __\   \ \ \____  \ \ \____  \ \  __ \  \ \  __<   \ \  __ \  \/_/\ \/ \ \ \  \ \ \/\ \  \ \ \-.  \  \ \___  \
- *	 \ \____-  \ \_____\  \ \_____\  \ \_____\  \ \_\ \_\  \ \_\ \_\  \ \_\ \_\    \ \_\  \ \_\  \ \_____\  \ \_\\"\_\  \/\_____\
- *	  \/____/   \/_____/   \/_____/   \/_____/   \/_/\/_/   \/_/ /_/   \/_/\/_/     \/_/   \/_/   \/_____/   \/_/ \/_/   \/_____/
+/**
+ *	Stores rvalue to lvalue. Frees value parameter register for a pointer
+ *
+ *	@param	enc					Encoder
+ *	@param	target				Target lvalue
+ *	@param	value				Rvalue to store
  */
-
-
-static void emit_array_init(encoder *const enc, const node *const nd, const size_t dimension
-	, const node *const init, const rvalue *const addr)
+static void emit_store_of_rvalue(encoder *const enc, const lvalue *const target, const rvalue *const value)
 {
-	const size_t amount = expression_initializer_get_size(init);
-
-	// Проверка на соответствие размеров массива и инициализатора
-	uni_printf(enc->sx->io, "\n\t# Check for array and initializer sizes equality:\n");
-
-	const node bound = declaration_variable_get_bound(nd, dimension);
-	const rvalue tmp = emit_expression(enc, &bound);
-	const rvalue bound_rvalue = (tmp.kind == RVALUE_KIND_REGISTER) ? tmp : emit_load_of_immediate(enc, &tmp);
-
-	// FIXME: через emit_binary_operation()
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, IC_MIPS_ADDI);
-	uni_printf(enc->sx->io, " ");
-	rvalue_to_io(enc, &bound_rvalue);
-	uni_printf(enc->sx->io, ", ");
-	rvalue_to_io(enc, &bound_rvalue);
-	uni_printf(enc->sx->io, ", %" PRIitem "\n", -(item_t)amount);
-
-	uni_printf(enc->sx->io, "\t");
-	instruction_to_io(enc->sx->io, IC_MIPS_BNE);
-	uni_printf(enc->sx->io, " ");
-	rvalue_to_io(enc, &bound_rvalue);
-	uni_printf(enc->sx->io, ", ");
-	mips_register_to_io(enc->sx->io, R_ZERO);
-	uni_printf(enc->sx->io, ", error\n");	// FIXME: error согласно RUNTIME'му
-
-	free_rvalue(enc, &bound_rvalue);
+	assert(value->kind != RVALUE_KIND_VOID);
+	assert(value->type == target->type);
 
-	for (size_t i = 0; i < amount; i++)
+	if (target->kind == LVALUE_KIND_REGISTER)
 	{
-		const node subexpr = expression_initializer_get_subexpr(init, i);
-		uni_printf(enc->sx->io, "\n");
-		if (expression_get_class(&subexpr) == EXPR_INITIALIZER)
+		if (value->kind == RVALUE_KIND_CONST)
 		{
-			// Сдвиг адреса на размер массива + 1 (за размер следующего измерения)
-			const mips_register_t reg = get_register(enc);
-			// FIXME: создать отдельные rvalue и lvalue и через emit_load_of_lvalue()
-			to_code_R_I_R(enc->sx->io, IC_MIPS_LW, reg, 0, addr->val.reg_num);	// адрес следующего измерения
-
-			const rvalue next_addr = {
-				.from_lvalue = !FROM_LVALUE,
-				.kind = RVALUE_KIND_REGISTER,
-				.val.reg_num = reg,
-				.type = TYPE_INTEGER
-			};
+			emit_move_rvalue_to_register(enc, target->loc.reg_num, value);
+		}
+		else if (value->val.reg_num != target->loc.reg_num)
+		{
+			const mips_instruction_t instruction = type_is_floating(enc->sx, value->type) ? IC_MIPS_MOV_S : IC_MIPS_MOVE;
+			to_code_2R(enc, instruction, target->loc.reg_num, value->val.reg_num);
+		}
+	}
+	else
+	{
+		const rvalue reg_value = (value->kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, value) : *value;
+		if ((!type_is_structure(enc->sx, target->type)) && (!type_is_array(enc->sx, target->type)))
+		{
+			const mips_instruction_t instruction = type_is_floating(enc->sx, value->type) ? IC_MIPS_S_S : IC_MIPS_SW;
+			to_code_R_I_R(enc, instruction, reg_value.val.reg_num, target->loc.displ, target->base_reg);
+			uni_printf(enc->io, "\n");
 
-			emit_array_init(enc, nd, dimension + 1, &subexpr, &next_addr);
+			// Освобождаем регистр только в том случае, если он был занят на этом уровне. Выше не лезем.
+			if (value->kind == RVALUE_KIND_CONST)
+			{
+				free_rvalue(enc, &reg_value);
+			}
 
-			// Сдвиг адреса
-			to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, addr->val.reg_num, addr->val.reg_num, -(item_t)WORD_LENGTH);
-			uni_printf(enc->sx->io, "\n");
-			free_register(enc, reg);
+			free_register(enc, target->base_reg);
 		}
 		else
 		{
-			const rvalue subexpr_value = emit_expression(enc, &subexpr);	// rvalue элемента
-			const lvalue array_index_value = {
-				.base_reg = addr->val.reg_num,
-				.loc.displ = 0,
-				.kind = LVALUE_KIND_STACK,
-				.type = TYPE_INTEGER
-			};
-			emit_store_of_rvalue(enc, &array_index_value, &subexpr_value);
-			lock_register(enc, addr->val.reg_num);
-			if (i != amount - 1)
+			if (type_is_array(enc->sx, target->type))
 			{
-				to_code_2R_I(
-					enc->sx->io,
-					IC_MIPS_ADDI,
-					addr->val.reg_num,
-					addr->val.reg_num,
-					-4
-				);
+				// Загружаем указатель на массив
+				to_code_R_I_R(enc, IC_MIPS_SW, reg_value.val.reg_num, target->loc.displ, target->base_reg);
+				uni_printf(enc->io, "\n");
+				return;
 			}
-			free_rvalue(enc, &subexpr_value);
+			// else кусок должен быть не достижим
 		}
 	}
 }
 
 /**
- *	Emit bound expression in array declaration
+ *	Gets original operands and loads them depending on the needs of operation
  *
  *	@param	enc					Encoder
- *	@param	bound				Bound node
- *	@param	nd					Declaration node
+ *	@param	operand 			Original operand rvalue
+ *	@param  operation			Operation in which this operand used
+ *	@param  is_first_operand    Bool which defines if the operand is first in binary expression
  *
- *	@return	Bound expression
+ *	@return new operand rvalue
  */
-static rvalue emit_bound(encoder *const enc, const node *const bound, const node *const nd)
+static rvalue emit_operand_load(encoder *const enc, const rvalue *const operand, const binary_t operation, const bool is_first_operand)
 {
-	// Если границы у массива не проставлены -- смотрим на инициализатор, чтобы их узнать
-	node dim_size = *bound;
-	const size_t dim = declaration_variable_get_bounds_amount(nd);
-	if (expression_get_class(bound) == EXPR_EMPTY_BOUND)
+	switch (operation)
 	{
-		const node init = declaration_variable_get_initializer(nd);
-		dim_size = expression_initializer_get_subexpr(&init, dim - 1);
-		const size_t size = expression_initializer_get_size(&init);
-		const rvalue result = {
-			.from_lvalue = !FROM_LVALUE,
-			.kind = RVALUE_KIND_CONST,
-			.val.int_val = (item_t)size,
-			.type = TYPE_INTEGER
-		};
-		return emit_load_of_immediate(enc, &result);
+		case BIN_LT:
+		case BIN_GT:
+		case BIN_LE:
+		case BIN_GE:
+		case BIN_EQ:
+		case BIN_NE:
+		case BIN_SUB:
+		case BIN_DIV:
+		case BIN_MUL:
+		case BIN_REM:
+			// Сравнение => Используется BIN_SUB, поэтому грузим на регистр
+			// sub, div, mul, rem => Нет команд работающих с константными значениями, поэтому грузим его на регистр
+			return (operand->kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, operand):  *operand;
+		case BIN_SHL:
+		case BIN_SHR:
+			// Нет команд работающих с первым операндом в виде константы и операции не коммутативны, поэтому грузим его на регистр
+			return !is_first_operand || operand->kind != RVALUE_KIND_CONST ? *operand
+																		   : emit_load_of_immediate(enc, operand);
+		case BIN_ADD:
+		case BIN_AND:
+		case BIN_OR:
+		case BIN_XOR:
+			// Операции коммутативны и есть операция работающая с одним значением на регистре и одним в виде константы
+			// Логика замены операндов вне функции
+			return *operand;
+		default:
+			// Не может быть других операций
+			system_error(node_unexpected);
+			return RVALUE_VOID;
+	}
+}
+
+/**
+ *	Emit binary operation with two rvalues
+ *
+ *	@param	enc					Encoder
+ *	@param	dest				Destination rvalue
+ *	@param	first_operand		First rvalue operand
+ *	@param	second_operand		Second rvalue operand
+ *	@param	operator			Operator
+ */
+static void emit_binary_operation(encoder *const enc, const rvalue *const dest
+	, const rvalue *const first_operand, const rvalue *const second_operand, const binary_t operator)
+{
+	assert(operator != BIN_LOG_AND);
+	assert(operator != BIN_LOG_OR);
+
+	assert(dest->kind == RVALUE_KIND_REGISTER);
+	assert(first_operand->kind != RVALUE_KIND_VOID);
+	assert(second_operand->kind != RVALUE_KIND_VOID);
+
+	if ((first_operand->kind == RVALUE_KIND_REGISTER) && (second_operand->kind == RVALUE_KIND_REGISTER))
+	{
+		switch (operator)
+		{
+			case BIN_LT:
+			case BIN_GT:
+			case BIN_LE:
+			case BIN_GE:
+			case BIN_EQ:
+			case BIN_NE:
+			{
+				const item_t curr_label_num = enc->label_num++;
+				const label label_else = { .kind = L_END, .num = (size_t)curr_label_num };
+
+				to_code_rvalues(enc, IC_MIPS_SUB, dest->val.reg_num, first_operand, second_operand);
+
+				const mips_instruction_t instruction = get_bin_instruction(operator, false);
+				emit_conditional_branch(enc, instruction, dest, &label_else);
+
+				to_code_R_I(enc, IC_MIPS_LI, dest->val.reg_num, 1);
+
+				emit_label_declaration(enc, &label_else);
+
+				uni_printf(enc->io, "\n");
+			}
+			break;
+
+			default:
+			{
+				to_code_rvalues(enc
+					, get_bin_instruction(operator, /* Два регистра => 0 в get_bin_instruction() -> */ 0)
+					, dest->val.reg_num, first_operand, second_operand);
+			}
+			break;
+		}
+	}
+	else
+	{
+		const rvalue real_first_operand = emit_operand_load(enc, first_operand, operator, true);
+		const rvalue real_second_operand = emit_operand_load(enc, second_operand, operator, false);
+
+		switch (operator)
+		{
+			case BIN_LT:
+			case BIN_GT:
+			case BIN_LE:
+			case BIN_GE:
+			case BIN_EQ:
+			case BIN_NE:
+			{
+				const item_t curr_label_num = enc->label_num++;
+				const label label_else = { .kind = L_ELSE, .num = (size_t)curr_label_num };
+
+				// Записываем <значение из first_operand> - <значение из second_operand> в dest
+				to_code_rvalues(enc, IC_MIPS_SUB, dest->val.reg_num, &real_first_operand, &real_second_operand);
+
+				const mips_instruction_t instruction = get_bin_instruction(operator, false);
+				emit_conditional_branch(enc, instruction, dest, &label_else);
+
+				to_code_R_I(enc, IC_MIPS_LI, dest->val.reg_num, 1);
+
+				emit_label_declaration(enc, &label_else);
+
+				uni_printf(enc->io, "\n");
+				break;
+			}
+
+			default:
+			{
+				bool does_need_instruction_working_with_both_operands_in_registers =
+					// Нет команд работающих с операндами в виде константы
+					(operator == BIN_SUB) || (operator == BIN_DIV) || (operator == BIN_MUL) || (operator == BIN_REM)
+					// Нет команд работающих с первым операндом в виде константы и операция не коммутативна
+					|| ((operator == BIN_SHL || operator == BIN_SHR) && first_operand->kind == RVALUE_KIND_CONST);
+
+				// Все остальные операции коммутативны, поэтому используем инструкцию с константой, меняя порядок если надо
+				bool change_order = (operator == BIN_ADD || operator == BIN_OR || operator == BIN_XOR || operator == BIN_AND) && first_operand->kind == RVALUE_KIND_CONST;
+
+				// Выписываем операцию, её результат будет записан в result
+				const mips_instruction_t instruction = get_bin_instruction(operator,
+					/* Один регистр => true в get_bin_instruction() -> */ !does_need_instruction_working_with_both_operands_in_registers);
+				if (change_order)
+				{
+					to_code_rvalues(enc, instruction, dest->val.reg_num, &real_second_operand, &real_first_operand);
+				}
+				else
+				{
+					to_code_rvalues(enc, instruction, dest->val.reg_num, &real_first_operand, &real_second_operand);
+				}
+			}
+		}
+
+		// Загруженные на регистры константы больше не нужны
+		if (first_operand->kind == RVALUE_KIND_CONST)
+		{
+			free_rvalue(enc, &real_first_operand);
+		}
+		if (second_operand->kind == RVALUE_KIND_CONST)
+		{
+			free_rvalue(enc, &real_second_operand);
+		}
+	}
+}
+
+/**
+ *	Emit literal expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of literal expression
+ */
+static rvalue emit_literal_expression(encoder *const enc, const node *const nd)
+{
+	const item_t type = expression_get_type(nd);
+	switch (type_get_class(enc->sx, type))
+	{
+		case TYPE_BOOLEAN:
+			return (rvalue) {
+				.kind = RVALUE_KIND_CONST,
+				.val.int_val = (expression_literal_get_boolean(nd)) ? 1 : 0,
+				.type = TYPE_INTEGER
+			};
+
+		case TYPE_CHARACTER:
+			return (rvalue) {
+				.kind = RVALUE_KIND_CONST,
+				.val.int_val = expression_literal_get_character(nd),
+				.type = TYPE_INTEGER
+			};
+
+		case TYPE_INTEGER:
+			return (rvalue) {
+				.kind = RVALUE_KIND_CONST,
+				.val.int_val = expression_literal_get_integer(nd),
+				.type = TYPE_INTEGER
+			};
+
+		case TYPE_FLOATING:
+			return (rvalue) {
+				.kind = RVALUE_KIND_CONST,
+				.val.float_val = expression_literal_get_floating(nd),
+				.type = TYPE_FLOATING
+			};
+
+		case TYPE_ARRAY:
+			assert(type_is_string(enc->sx, type));
+			return (rvalue) {
+				.kind = RVALUE_KIND_CONST,
+				.val.str_index = expression_literal_get_string(nd),
+				.type = type
+			};
+
+		default:
+			return RVALUE_VOID;
+	}
+}
+
+/**
+ *	Emit loading of string address via $t1
+ *
+ *	@param	enc					Encoder
+ *	@param	reg					Register for address
+ *	@param	index				Index of string label
+ */
+static void emit_string_address(encoder *const enc, const mips_register_t reg, const size_t index)
+{
+	const label string_label = { .kind = L_STRING, .num = index };
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_HI, .instruction = IC_MIPS_LUI
+		, .fst_reg = R_T1, .lbl = string_label });
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_LO, .instruction = IC_MIPS_ADDIU
+		, .fst_reg = reg, .snd_reg = R_T1, .lbl = string_label });
+}
+
+/**
+ *	Count parameters of current function, which are passed in argument registers
+ *
+ *	@param	enc					Encoder
+ *	@param	is_floating			Set to count floating point parameters
+ *
+ *	@return	Number of parameters
+ */
+static size_t register_parameters_amount(const encoder *const enc, const bool is_floating)
+{
+	const item_t type = ident_get_type(enc->sx, enc->curr_function_ident);
+	const size_t parameters = type_function_get_parameter_amount(enc->sx, type);
+
+	size_t amount = 0;
+	for (size_t i = 0; i < parameters; i++)
+	{
+		if (type_is_floating(enc->sx, type_function_get_parameter_type(enc->sx, type, i)) == is_floating)
+		{
+			amount++;
+		}
+	}
+
+	// Как в emit_function_definition: $a0-$a3 и пары $fa0, $fa2
+	return min(amount, is_floating ? ARG_REG_AMOUNT / 2 : ARG_REG_AMOUNT);
+}
+
+/**
+ *	Emit printf expression as a single call with the whole format string.
+ *	Arguments are passed by o32 calling convention: argument words go to $a0-$a3 and to the stack above
+ *	the space reserved for $a0-$a3, double takes a pair of words starting from an even one
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					AST node
+ *
+ *	@return	Rvalue of printf expression
+ */
+static rvalue emit_printf_expression(encoder *const enc, const node *const nd)
+{
+	const node string = expression_call_get_argument(nd, 0);
+	const size_t index = expression_literal_get_string(&string);
+	const size_t parameters_amount = expression_call_get_arguments_amount(nd);
+
+	// Первое слово -- адрес строки формата, float передаётся как double
+	size_t words = 1;
+	bool has_floating = false;
+	for (size_t i = 1; i < parameters_amount; i++)
+	{
+		const node arg = expression_call_get_argument(nd, i);
+		const bool is_floating = type_is_floating(enc->sx, expression_get_type(&arg));
+		words = is_floating ? (words + 1) / 2 * 2 + 2 : words + 1;
+		has_floating |= is_floating;
+	}
+
+	// Место под $a0-$a3 резервируется всегда, printf может их туда сохранить
+	const item_t area_size = (item_t)(max(words, ARG_REG_AMOUNT) * WORD_LENGTH);
+
+	// Регистры-аргументы текущей функции сохраняются в кадре, printf их не сохраняет
+	const size_t registers = register_parameters_amount(enc, false);
+	const size_t float_registers = register_parameters_amount(enc, true);
+	const size_t saved_displ = (registers + float_registers + (has_floating ? 1 : 0)) * WORD_LENGTH;
+	enc->scope_displ += saved_displ;
+	enc->max_displ = max(enc->scope_displ, enc->max_displ);
+	const item_t displ = -(item_t)enc->scope_displ;
+
+	uni_printf(enc->io, "\t# setting up $sp:\n");
+	if (has_floating)
+	{
+		// Пары слов double выравниваются по двойному слову и в стеке, поэтому выравнивается $sp,
+		// а прежнее значение сохраняется в кадре
+		to_code_R_I_R(enc, IC_MIPS_SW, R_SP, displ + (item_t)(saved_displ - WORD_LENGTH), R_FP);
+		const mips_register_t area = get_register(enc);
+		to_code_2R_I(enc, IC_MIPS_ADDI, area, R_SP, -area_size);
+		to_code_2R_I(enc, IC_MIPS_SRA, area, area, 3);
+		to_code_2R_I(enc, IC_MIPS_SLL, area, area, 3);
+		to_code_2R(enc, IC_MIPS_MOVE, R_SP, area);
+		free_register(enc, area);
+	}
+	else
+	{
+		to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, -area_size);
+	}
+
+	uni_printf(enc->io, "\n\t# parameters passing:\n");
+	size_t word = 1;
+	for (size_t i = 1; i < parameters_amount; i++)
+	{
+		const node arg = expression_call_get_argument(nd, i);
+		const rvalue value = emit_expression(enc, &arg);
+
+		if (type_is_floating(enc->sx, value.type))
+		{
+			const rvalue single = (value.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &value) : value;
+			const mips_register_t reg = single.from_lvalue ? get_float_register(enc) : single.val.reg_num;
+			const mips_register_t half = get_register(enc);
+			word = (word + 1) / 2 * 2;
+
+			// Конвертируем single to double, младшее слово идёт первым
+			to_code_2R(enc, IC_MIPS_CVT_D_S, reg, single.val.reg_num);
+			to_code_2R(enc, IC_MIPS_MFC_1, half, reg);
+			to_code_R_I_R(enc, IC_MIPS_SW, half, (item_t)(word * WORD_LENGTH), R_SP);
+			to_code_2R(enc, IC_MIPS_MFHC_1, half, reg);
+			to_code_R_I_R(enc, IC_MIPS_SW, half, (item_t)((word + 1) * WORD_LENGTH), R_SP);
+			word += 2;
+
+			free_register(enc, half);
+			free_register(enc, reg);
+		}
+		else
+		{
+			const lvalue target = {
+				.kind = LVALUE_KIND_STACK,
+				.type = value.type,
+				.loc.displ = word * WORD_LENGTH,
+				.base_reg = R_SP
+			};
+
+			if (value.kind == RVALUE_KIND_CONST && type_is_string(enc->sx, value.type))
+			{
+				const rvalue address = {
+					.kind = RVALUE_KIND_REGISTER,
+					.type = value.type,
+					.val.reg_num = get_register(enc),
+					.from_lvalue = !FROM_LVALUE
+				};
+				emit_string_address(enc, address.val.reg_num, value.val.str_index);
+				emit_store_of_rvalue(enc, &target, &address);
+				free_rvalue(enc, &address);
+			}
+			else
+			{
+				emit_store_of_rvalue(enc, &target, &value);
+				free_rvalue(enc, &value);
+			}
+			word++;
+		}
+	}
+
+	for (size_t i = 0; i < registers; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_SW, R_A0 + i, displ + (item_t)(i * WORD_LENGTH), R_FP);
+	}
+	for (size_t i = 0; i < float_registers; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_S_S, R_FA0 + 2 * i, displ + (item_t)((registers + i) * WORD_LENGTH), R_FP);
+	}
+
+	for (size_t i = 1; i < min(words, ARG_REG_AMOUNT); i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_LW, R_A0 + i, (item_t)(i * WORD_LENGTH), R_SP);
+	}
+	emit_string_address(enc, R_A0, index);
+	to_code_S(enc, IC_MIPS_JAL, "printf");
+
+	uni_printf(enc->io, "\n\t# data restoring:\n");
+	for (size_t i = 0; i < registers; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_LW, R_A0 + i, displ + (item_t)(i * WORD_LENGTH), R_FP);
+	}
+	for (size_t i = 0; i < float_registers; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_L_S, R_FA0 + 2 * i, displ + (item_t)((registers + i) * WORD_LENGTH), R_FP);
+	}
+	if (has_floating)
+	{
+		to_code_R_I_R(enc, IC_MIPS_LW, R_SP, displ + (item_t)(saved_displ - WORD_LENGTH), R_FP);
+	}
+	else
+	{
+		to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, area_size);
+	}
+	enc->scope_displ -= saved_displ;
+
+	// FIXME: Возвращает число распечатанных символов (включая '\0'?)
+	return RVALUE_VOID;
+}
+
+/**
+ *	Emit builtin function call
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of builtin function call expression
+ */
+static rvalue emit_builtin_call(encoder *const enc, const node *const nd)
+{
+	const node callee = expression_call_get_callee(nd);
+	const size_t func_ref = expression_identifier_get_id(&callee);
+	switch (func_ref)
+	{
+		case BI_PRINTF:
+			return emit_printf_expression(enc, nd);
+
+		default:
+			return RVALUE_VOID;
+	}
+}
+
+/**
+ *	Emit call expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of call expression
+ */
+static rvalue emit_call_expression(encoder *const enc, const node *const nd)
+{
+	const node callee = expression_call_get_callee(nd);
+	// Конвертируем в указатель на функцию
+	// FIXME: хотим рассмотреть любой callee как указатель
+	// на данный момент это не поддержано в билдере, когда будет сделано -- добавить в emit_expression()
+	// и применяем функцию emit_identifier_expression (т.к. его категория в билдере будет проставлена как rvalue)
+	const size_t func_ref = expression_identifier_get_id(&callee);
+	const size_t params_amount = expression_call_get_arguments_amount(nd);
+
+	const item_t return_type = type_function_get_return_type(enc->sx, expression_get_type(&callee));
+
+	uni_printf(enc->io, "\t# \"%s\" function call:\n", ident_get_spelling(enc->sx, func_ref));
+
+	if (func_ref >= BEGIN_USER_FUNC)
+	{
+		size_t f_arg_count = 0;
+		size_t arg_count = 0;
+		size_t displ_for_parameters = (params_amount - 1) * WORD_LENGTH;
+		lvalue prev_arg_displ[4 /* за $a0-$a3 */
+									+ 4 / 2 /* за $fa0, $fa2 (т.к. single precision)*/];
+
+		uni_printf(enc->io, "\t# setting up $sp:\n");
+		if (displ_for_parameters)
+		{
+			to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, -(item_t)(displ_for_parameters));
+		}
+
+		uni_printf(enc->io, "\n\t# parameters passing:\n");
+
+		// TODO: структуры / массивы в параметры
+		size_t arg_reg_count = 0;
+		for (size_t i = 0; i < params_amount; i++)
+		{
+			const node arg = expression_call_get_argument(nd, i);
+			const rvalue tmp = emit_expression(enc, &arg);
+			const rvalue arg_rvalue = (tmp.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &tmp) : tmp;
+
+			if ((type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT)
+			{
+				uni_printf(enc->io, "\t# saving ");
+				mips_register_to_io(enc->io, (type_is_floating(enc->sx, arg_rvalue.type)
+					? R_FA0 + f_arg_count
+					: R_A0 + arg_count));
+				uni_printf(enc->io, " value on stack:\n");
+			}
+			else
+			{
+				uni_printf(enc->io, "\t# parameter on stack:\n");
+			}
+
+			const lvalue tmp_arg_lvalue = {
+				.base_reg = R_SP,
+				// по call convention: первый на WORD_LENGTH выше предыдущего положения $fp,
+				// второй на 2*WORD_LENGTH и т.д.
+				.loc.displ = i * WORD_LENGTH,
+				.kind = LVALUE_KIND_STACK,
+				.type = arg_rvalue.type
+			};
+
+			const rvalue arg_saved_rvalue = {
+				.kind = RVALUE_KIND_REGISTER,
+				.val.reg_num = (type_is_floating(enc->sx, arg_rvalue.type)
+					? R_FA0 + f_arg_count
+					: R_A0 + arg_count),
+				.type = arg_rvalue.type,
+				.from_lvalue = !FROM_LVALUE
+			};
+			// Сохранение текущего регистра-аргумента на стек либо передача аргументов на стек
+			emit_store_of_rvalue(
+				enc,
+				&tmp_arg_lvalue,
+				(type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT
+					? &arg_saved_rvalue	// Сохранение значения в регистре-аргументе
+					: &arg_rvalue		// Передача аргумента
+			);
+
+			// Если это передача параметров в регистры-аргументы
+			if ((type_is_floating(enc->sx, arg_rvalue.type) ? f_arg_count : arg_count) < ARG_REG_AMOUNT)
+			{
+				// Аргументы рассматриваются в данном случае как регистровые переменные
+				emit_move_rvalue_to_register(
+					enc,
+					type_is_floating(enc->sx, arg_rvalue.type)
+						? (R_FA0 + f_arg_count)
+						: (R_A0 + arg_count),
+					&arg_rvalue);
+
+				// Запоминаем, куда положили текущее значение, лежавшее в регистре-аргументе
+				prev_arg_displ[arg_reg_count++] = tmp_arg_lvalue;
+			}
+
+			if (type_is_floating(enc->sx, arg_rvalue.type))
+			{
+				f_arg_count += 2;
+			}
+			else
+			{
+				arg_count += 1;
+			}
+
+			free_rvalue(enc, &arg_rvalue);
+		}
+
+		const label label_func = { .kind = L_FUNC, .num = func_ref };
+		emit_unconditional_branch(enc, IC_MIPS_JAL, &label_func);
+
+		// Восстановление регистров-аргументов -- они могут понадобится в дальнейшем
+		uni_printf(enc->io, "\n\t# data restoring:\n");
+
+		size_t i = 0, j = 0;	// Счётчик обычных и floating point регистров-аргументов соответственно
+		while (i + j < arg_reg_count)
+		{
+			uni_printf(enc->io, "\n");
+
+			const rvalue tmp_rval = emit_load_of_lvalue(enc, &prev_arg_displ[i + j]);
+			emit_move_rvalue_to_register(
+				enc,
+				type_is_floating(enc->sx, prev_arg_displ[i + j].type) ? (R_FA0 + 2 * j++) : (R_A0 + i++),
+				&tmp_rval
+			);
+
+			free_rvalue(enc, &tmp_rval);
+		}
+
+		if (displ_for_parameters)
+		{
+			to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, (item_t)displ_for_parameters);
+		}
+
+		uni_printf(enc->io, "\n");
+	}
+	else
+	{
+		return emit_builtin_call(enc, nd);
+	}
+
+	return (rvalue) {
+		.kind = RVALUE_KIND_REGISTER,
+		.type = return_type,
+		.val.reg_num = type_is_floating(enc->sx, return_type) ? R_FV0 : R_V0,
+		.from_lvalue = !FROM_LVALUE
+	};
+}
+
+/**
+ *	Emit member expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of member expression
+ */
+static rvalue emit_member_expression(encoder *const enc, const node *const nd)
+{
+	(void)enc;
+	(void)nd;
+	// FIXME: возврат структуры из функции. Указателя тут оказаться не может
+	return RVALUE_VOID;
+}
+
+/**
+ *	Emit cast expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of cast expression
+ */
+static rvalue emit_cast_expression(encoder *const enc, const node *const nd)
+{
+	const node operand = expression_cast_get_operand(nd);
+	const rvalue value = emit_expression(enc, &operand);
+
+	const item_t target_type = expression_get_type(nd);
+	const item_t source_type = expression_get_type(&operand);
+
+	if (type_is_integer(enc->sx, source_type) && type_is_floating(enc->sx, target_type))
+	{
+		// int -> float
+		const rvalue result = {
+			.kind = RVALUE_KIND_REGISTER,
+			.from_lvalue = !FROM_LVALUE,
+			.val.reg_num = get_float_register(enc),
+			.type = target_type
+		};
+
+		// FIXME: избавится от to_code функций
+		to_code_2R(enc, IC_MIPS_MFC_1, value.val.reg_num, result.val.reg_num);
+		to_code_2R(enc, IC_MIPS_CVT_S_W, result.val.reg_num, result.val.reg_num);
+
+		free_rvalue(enc, &value);
+		return result;
+	}
+	else
+	{
+		// char -> int пока не поддержано в билдере
+		return (rvalue) {
+			.from_lvalue = value.from_lvalue,
+			.kind = value.kind,
+			.val.int_val = value.val.int_val,
+			.type = TYPE_INTEGER
+		};
+	}
+}
+
+/**
+ *	Emit increment or decrement expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of increment or decrement expression
+ */
+static rvalue emit_increment_expression(encoder *const enc, const node *const nd)
+{
+	const node operand = expression_unary_get_operand(nd);
+	const lvalue operand_lvalue = emit_lvalue(enc, &operand);
+	const rvalue operand_value = emit_load_of_lvalue(enc, &operand_lvalue);
+
+	const unary_t operator = expression_unary_get_operator(nd);
+	const bool is_prefix = (operator == UN_PREDEC) || (operator == UN_PREINC);
+
+	// Для постфиксной формы прежнее значение регистровой переменной нужно скопировать
+	const rvalue operand_rvalue = is_prefix ? operand_value : emit_writable_rvalue(enc, &operand_value);
+	const rvalue imm_rvalue = {
+		.from_lvalue = !FROM_LVALUE,
+		.kind = RVALUE_KIND_CONST,
+		.val.int_val = ((operator == UN_PREINC) || (operator == UN_POSTINC)) ? 1 : -1,
+		.type = TYPE_INTEGER
+	};
+
+	if (is_prefix)
+	{
+		emit_binary_operation(enc, &operand_rvalue, &operand_rvalue, &imm_rvalue, BIN_ADD);
+		emit_store_of_rvalue(enc, &operand_lvalue, &operand_rvalue);
+	}
+	else
+	{
+		const rvalue post_result_rvalue = {
+			.from_lvalue = !FROM_LVALUE,
+			.kind = RVALUE_KIND_REGISTER,
+			.val.reg_num = get_register(enc),
+			.type = operand_lvalue.type
+		};
+
+		emit_binary_operation(enc, &post_result_rvalue, &operand_rvalue, &imm_rvalue, BIN_ADD);
+		emit_store_of_rvalue(enc, &operand_lvalue, &post_result_rvalue);
+		free_rvalue(enc, &post_result_rvalue);
+	}
+
+	return operand_rvalue;
+}
+
+/**
+ *	Emit unary expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of unary expression
+ */
+static rvalue emit_unary_expression(encoder *const enc, const node *const nd)
+{
+	const unary_t operator = expression_unary_get_operator(nd);
+	assert(operator != UN_INDIRECTION);
+
+	switch (operator)
+	{
+		case UN_POSTINC:
+		case UN_POSTDEC:
+		case UN_PREINC:
+		case UN_PREDEC:
+			return emit_increment_expression(enc, nd);
+
+		case UN_MINUS:
+		case UN_NOT:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			const rvalue operand_value = emit_expression(enc, &operand);
+			const rvalue operand_rvalue = emit_writable_rvalue(enc, &operand_value);
+			const binary_t instruction = (operator == UN_MINUS) ? BIN_MUL : BIN_XOR;
+
+			emit_binary_operation(enc, &operand_rvalue, &operand_rvalue, &RVALUE_NEGATIVE_ONE, instruction);
+			return operand_rvalue;
+		}
+
+		case UN_LOGNOT:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			const rvalue operand_value = emit_expression(enc, &operand);
+			const rvalue value = emit_writable_rvalue(enc, &operand_value);
+
+			to_code_2R_I(enc, IC_MIPS_SLTIU, value.val.reg_num, value.val.reg_num, 1);
+			return value;
+		}
+
+		case UN_ABS:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			const rvalue operand_value = emit_expression(enc, &operand);
+			const rvalue operand_rvalue = emit_writable_rvalue(enc, &operand_value);
+			const mips_instruction_t instruction = type_is_floating(enc->sx, operand_rvalue.type) ? IC_MIPS_ABS_S : IC_MIPS_ABS;
+
+			to_code_2R(enc, instruction, operand_rvalue.val.reg_num, operand_rvalue.val.reg_num);
+			return operand_rvalue;
+		}
+
+		case UN_ADDRESS:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			const lvalue operand_lvalue = emit_lvalue(enc, &operand);
+
+			assert(operand_lvalue.kind != LVALUE_KIND_REGISTER);
+
+			const rvalue result_rvalue = {
+				.from_lvalue = !FROM_LVALUE,
+				.kind = RVALUE_KIND_REGISTER,
+				.val.reg_num = get_register(enc),
+				.type = TYPE_INTEGER
+			};
+
+			to_code_2R_I(
+				enc,
+				IC_MIPS_ADDI,
+				result_rvalue.val.reg_num,
+				operand_lvalue.base_reg,
+				operand_lvalue.loc.displ
+			);
+			return result_rvalue;
+		}
+
+		case UN_UPB:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			const rvalue array_address = emit_expression(enc, &operand);
+			const lvalue size_lvalue = {
+				.base_reg = array_address.val.reg_num,
+				.kind = LVALUE_KIND_STACK,
+				.loc.displ = WORD_LENGTH,
+				.type = TYPE_INTEGER
+			};
+			return emit_load_of_lvalue(enc, &size_lvalue);
+		}
+
+		default:
+			system_error(node_unexpected);
+			return RVALUE_VOID;
+	}
+}
+
+/**
+ *	Emit binary expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of binary expression
+ */
+static rvalue emit_binary_expression(encoder *const enc, const node *const nd)
+{
+	const binary_t operator = expression_binary_get_operator(nd);
+	const node LHS = expression_binary_get_LHS(nd);
+	const node RHS = expression_binary_get_RHS(nd);
+
+	switch (operator)
+	{
+		case BIN_COMMA:
+		{
+			emit_void_expression(enc, &LHS);
+			return emit_expression(enc, &RHS);
+		}
+
+		case BIN_LOG_OR:
+		case BIN_LOG_AND:
+		{
+			const rvalue lhs_value = emit_expression(enc, &LHS);
+			const rvalue lhs_rvalue = emit_writable_rvalue(enc, &lhs_value);
+
+			const item_t curr_label_num = enc->label_num++;
+			const label label_end = { .kind = L_END, .num = (size_t)curr_label_num };
+
+			const mips_instruction_t instruction = (operator == BIN_LOG_OR) ? IC_MIPS_BNE : IC_MIPS_BEQ;
+			emit_conditional_branch(enc, instruction, &lhs_rvalue, &label_end);
+
+			// Значение левого операнда больше не нужно, правый вычисляется на его место
+			free_rvalue(enc, &lhs_rvalue);
+
+			const rvalue rhs_rvalue = emit_expression(enc, &RHS);
+			lock_register(enc, lhs_rvalue.val.reg_num);
+			if ((rhs_rvalue.kind == RVALUE_KIND_CONST) || (rhs_rvalue.val.reg_num != lhs_rvalue.val.reg_num))
+			{
+				emit_move_rvalue_to_register(enc, lhs_rvalue.val.reg_num, &rhs_rvalue);
+				free_rvalue(enc, &rhs_rvalue);
+			}
+
+			emit_label_declaration(enc, &label_end);
+			return lhs_rvalue;
+		}
+
+		default:
+		{
+			// Результат записывается на место левого операнда, поэтому константу нужно загрузить на регистр
+			const rvalue lhs_value = emit_expression(enc, &LHS);
+			const rvalue lhs_kept = lhs_value.kind == RVALUE_KIND_CONST ? emit_load_of_immediate(enc, &lhs_value) : lhs_value;
+			const item_t lhs_displ = emit_spill(enc, &lhs_kept, &RHS);
+			const rvalue rhs_rvalue = emit_expression(enc, &RHS);
+			const rvalue lhs_rvalue = emit_reload(enc, &lhs_kept, lhs_displ);
+
+			// Регистровая переменная не должна измениться
+			const bool is_floating = type_is_floating(enc->sx, lhs_rvalue.type);
+			const rvalue result = !lhs_rvalue.from_lvalue ? lhs_rvalue : (rvalue){
+				.kind = RVALUE_KIND_REGISTER,
+				.val.reg_num = is_floating ? get_float_register(enc) : get_register(enc),
+				.from_lvalue = !FROM_LVALUE,
+				.type = lhs_rvalue.type
+			};
+
+			emit_binary_operation(enc, &result, &lhs_rvalue, &rhs_rvalue, operator);
+
+			free_rvalue(enc, &rhs_rvalue);
+			return result;
+		}
+	}
+}
+
+/**
+ *	Emit ternary expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of ternary expression
+ */
+static rvalue emit_ternary_expression(encoder *const enc, const node *const nd)
+{
+	const node condition = expression_ternary_get_condition(nd);
+	const rvalue value = emit_expression(enc, &condition);
+
+	const size_t label_num = enc->label_num++;
+	const label label_else = { .kind = L_ELSE, .num = label_num };
+
+	const mips_instruction_t instruction = IC_MIPS_BNE;
+	emit_conditional_branch(enc, instruction, &value, &label_else);
+	free_rvalue(enc, &value);
+
+	// Результат ветки получает регистр, который на время другой ветки освобождается
+	const node LHS = expression_ternary_get_LHS(nd);
+	const rvalue LHS_value = emit_expression(enc, &LHS);
+	const rvalue result = emit_writable_rvalue(enc, &LHS_value);
+	free_rvalue(enc, &result);
+
+	const label label_end = { .kind = L_END, .num = label_num };
+	emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
+	emit_label_declaration(enc, &label_else);
+
+	const node RHS = expression_ternary_get_RHS(nd);
+	const rvalue RHS_rvalue = emit_expression(enc, &RHS);
+	lock_register(enc, result.val.reg_num);
+	if ((RHS_rvalue.kind == RVALUE_KIND_CONST) || (RHS_rvalue.val.reg_num != result.val.reg_num))
+	{
+		emit_move_rvalue_to_register(enc, result.val.reg_num, &RHS_rvalue);
+		free_rvalue(enc, &RHS_rvalue);
+	}
+
+	emit_label_declaration(enc, &label_end);
+
+	return result;
+}
+
+/**
+ *	Emit structure assignment
+ *
+ *	@param	enc					Encoder
+ *	@param	target				Target lvalue
+ *	@param	value				Value to assign to target
+ *
+ *	@return	Rvalue of the result of assignment expression
+ */
+static rvalue emit_struct_assignment(encoder *const enc, const lvalue *const target, const node *const value)
+{
+	if (expression_get_class(value) == EXPR_INITIALIZER)	// Присваивание списком
+	{
+		emit_structure_init(enc, target, value);
+	}
+	else	// Присваивание другой структуры
+	{
+		// FIXME: возврат структуры из функции
+		// FIXME: массив структур
+		const size_t RHS_identifier = expression_identifier_get_id(value);
+		const lvalue RHS_lvalue = displacements_get(enc, RHS_identifier);
+
+		// Копирование всех данных из RHS
+		const item_t type = expression_get_type(value);
+		const size_t struct_size = mips_type_size(enc->sx, type);
+		for (size_t i = 0; i < struct_size; i += WORD_LENGTH)
+		{
+			// Грузим данные из RHS
+			const lvalue value_word = {
+				.base_reg = RHS_lvalue.base_reg,
+				.loc.displ = RHS_lvalue.loc.displ + i,
+				.kind = LVALUE_KIND_STACK,
+				.type = TYPE_INTEGER
+			};
+			const rvalue proxy = emit_load_of_lvalue(enc, &value_word);
+
+			// Отправляем их в variable
+			const lvalue target_word = {
+				.base_reg = target->base_reg,
+				.kind = LVALUE_KIND_STACK,
+				.loc.displ = target->loc.displ + i,
+				.type = TYPE_INTEGER
+			};
+			emit_store_of_rvalue(enc, &target_word, &proxy);
+
+			free_rvalue(enc, &proxy);
+		}
+	}
+
+	return emit_load_of_lvalue(enc, target);
+}
+
+/**
+ *	Emit assignment expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the result of assignment expression
+ */
+static rvalue emit_assignment_expression(encoder *const enc, const node *const nd)
+{
+	const node LHS = expression_assignment_get_LHS(nd);
+	lvalue target = emit_lvalue(enc, &LHS);
+
+	const node RHS = expression_assignment_get_RHS(nd);
+	const item_t RHS_type = expression_get_type(&RHS);
+	if (type_is_structure(enc->sx, RHS_type))
+	{
+		return emit_struct_assignment(enc, &target, &RHS);
+	}
+
+	// Адрес цели на временном регистре сохраняется на время вычисления правой части
+	const rvalue target_address = {
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = target.base_reg,
+		.from_lvalue = (target.kind == LVALUE_KIND_REGISTER) || !is_temporary_register(target.base_reg),
+		.type = TYPE_INTEGER
+	};
+	const item_t target_displ = emit_spill(enc, &target_address, &RHS);
+	const rvalue value = emit_expression(enc, &RHS);
+	target.base_reg = emit_reload(enc, &target_address, target_displ).val.reg_num;
+
+	const binary_t operator = expression_assignment_get_operator(nd);
+	if (operator == BIN_ASSIGN)
+	{
+		emit_store_of_rvalue(enc, &target, &value);
+		return value;
+	}
+
+	// это "+=", "-=" и т.п.
+	const rvalue target_value = emit_load_of_lvalue(enc, &target);
+	binary_t correct_operation;
+	switch (operator)
+	{
+		case BIN_ADD_ASSIGN:
+			correct_operation = BIN_ADD;
+			break;
+
+		case BIN_SUB_ASSIGN:
+			correct_operation = BIN_SUB;
+			break;
+
+		case BIN_MUL_ASSIGN:
+			correct_operation = BIN_MUL;
+			break;
+
+		case BIN_DIV_ASSIGN:
+			correct_operation = BIN_DIV;
+			break;
+
+		case BIN_SHL_ASSIGN:
+			correct_operation = BIN_SHL;
+			break;
+
+		case BIN_SHR_ASSIGN:
+			correct_operation = BIN_SHR;
+			break;
+
+		case BIN_AND_ASSIGN:
+			correct_operation = BIN_AND;
+			break;
+
+		case BIN_XOR_ASSIGN:
+			correct_operation = BIN_XOR;
+			break;
+
+		case BIN_OR_ASSIGN:
+			correct_operation = BIN_OR;
+			break;
+
+		default:
+			system_error(node_unexpected);
+			return RVALUE_VOID;
+	}
+
+	emit_binary_operation(enc, &target_value, &target_value, &value, correct_operation);
+	free_rvalue(enc, &value);
+
+	emit_store_of_rvalue(enc, &target, &target_value);
+	return target_value;
+}
+
+/**
+ *	Emit inline expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of inline expression
+ */
+// TODO: текущая ветка от feature, а туда inline_expression'ы пока не влили
+/* static rvalue emit_inline_expression(encoder *const enc, const node *const nd)
+{
+	// FIXME: inline expression cannot return value at the moment
+	const size_t amount = expression_inline_get_size(nd);
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node substmt = expression_inline_get_substmt(nd, i);
+		emit_statement(enc, &substmt);
+	}
+
+	return RVALUE_VOID;
+} */
+
+/**
+ *	Emit expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of the expression
+ */
+static rvalue emit_expression(encoder *const enc, const node *const nd)
+{
+	if (expression_is_lvalue(nd))
+	{
+		const lvalue lval = emit_lvalue(enc, nd);
+		return emit_load_of_lvalue(enc, &lval);
+	}
+
+	// Иначе rvalue:
+	switch (expression_get_class(nd))
+	{
+		case EXPR_LITERAL:
+			return emit_literal_expression(enc, nd);
+
+		case EXPR_CALL:
+			return emit_call_expression(enc, nd);
+
+		case EXPR_MEMBER:
+			return emit_member_expression(enc, nd);
+
+		case EXPR_CAST:
+			return emit_cast_expression(enc, nd);
+
+		case EXPR_UNARY:
+			return emit_unary_expression(enc, nd);
+
+		case EXPR_BINARY:
+			return emit_binary_expression(enc, nd);
+
+		case EXPR_ASSIGNMENT:
+			return emit_assignment_expression(enc, nd);
+
+		case EXPR_TERNARY:
+			return emit_ternary_expression(enc, nd);
+
+		/*
+		// TODO: текущая ветка от feature, а туда inline_expression'ы пока не влили
+		case EXPR_INLINE:
+			return emit_inline_expression(enc, nd);
+		*/
+
+		case EXPR_INITIALIZER:
+			system_error(node_unexpected);
+			return RVALUE_VOID;
+
+		default:
+			system_error(node_unexpected);
+			return RVALUE_VOID;
+	}
+}
+
+/**
+ *	Emit expression which will be evaluated as a void expression
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ *
+ *	@return	Rvalue of void type
+ */
+static rvalue emit_void_expression(encoder *const enc, const node *const nd)
+{
+	if (expression_is_lvalue(nd))
+	{
+		emit_lvalue(enc, nd);	// Либо регистровая переменная, либо на стеке => ничего освобождать не надо
+	}
+	else
+	{
+		const rvalue result = emit_expression(enc, nd);
+		free_rvalue(enc, &result);
+	}
+	return RVALUE_VOID;
+}
+
+
+/*
+ *	 _____     ______     ______     __         ______     ______     ______     ______   __     ______     __   __     ______
+ *	/\  __-.  /\  ___\   /\  ___\   /\ \       /\  __ \   /\  == \   /\  __ \   /\__  _\ /\ \   /\  __ \   /\ "-.\ \   /\  ___\
+ *	\ \ \/\ \ \ \  __\   \ \ \____  \ \ \____  \ \  __ \  \ \  __<   \ \  __ \  \/_/\ \/ \ \ \  \ \ \/\ \  \ \ \-.  \  \ \___  \
+ *	 \ \____-  \ \_____\  \ \_____\  \ \_____\  \ \_\ \_\  \ \_\ \_\  \ \_\ \_\    \ \_\  \ \_\  \ \_____\  \ \_\\"\_\  \/\_____\
+ *	  \/____/   \/_____/   \/_____/   \/_____/   \/_/\/_/   \/_/ /_/   \/_/\/_/     \/_/   \/_/   \/_____/   \/_/ \/_/   \/_____/
+ */
+
+
+static void emit_array_init(encoder *const enc, const node *const nd, const size_t dimension
+	, const node *const init, const rvalue *const addr)
+{
+	const size_t amount = expression_initializer_get_size(init);
+
+	// Проверка на соответствие размеров массива и инициализатора
+	uni_printf(enc->io, "\n\t# Check for array and initializer sizes equality:\n");
+
+	const node bound = declaration_variable_get_bound(nd, dimension);
+	const rvalue tmp = emit_expression(enc, &bound);
+	const rvalue bound_rvalue = (tmp.kind == RVALUE_KIND_REGISTER) ? tmp : emit_load_of_immediate(enc, &tmp);
+
+	// FIXME: через emit_binary_operation()
+	to_code_2R_I(enc, IC_MIPS_ADDI, bound_rvalue.val.reg_num, bound_rvalue.val.reg_num, -(item_t)amount);
+
+	// FIXME: error согласно RUNTIME'му
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_L, .instruction = IC_MIPS_BNE
+		, .fst_reg = bound_rvalue.val.reg_num, .snd_reg = R_ZERO, .symbol = "error" });
+
+	free_rvalue(enc, &bound_rvalue);
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node subexpr = expression_initializer_get_subexpr(init, i);
+		uni_printf(enc->io, "\n");
+		if (expression_get_class(&subexpr) == EXPR_INITIALIZER)
+		{
+			// Сдвиг адреса на размер массива + 1 (за размер следующего измерения)
+			const mips_register_t reg = get_register(enc);
+			// FIXME: создать отдельные rvalue и lvalue и через emit_load_of_lvalue()
+			to_code_R_I_R(enc, IC_MIPS_LW, reg, 0, addr->val.reg_num);	// адрес следующего измерения
+
+			const rvalue next_addr = {
+				.from_lvalue = !FROM_LVALUE,
+				.kind = RVALUE_KIND_REGISTER,
+				.val.reg_num = reg,
+				.type = TYPE_INTEGER
+			};
+
+			emit_array_init(enc, nd, dimension + 1, &subexpr, &next_addr);
+
+			// Сдвиг адреса
+			to_code_2R_I(enc, IC_MIPS_ADDI, addr->val.reg_num, addr->val.reg_num, -(item_t)WORD_LENGTH);
+			uni_printf(enc->io, "\n");
+			free_register(enc, reg);
+		}
+		else
+		{
+			const rvalue subexpr_value = emit_expression(enc, &subexpr);	// rvalue элемента
+			const lvalue array_index_value = {
+				.base_reg = addr->val.reg_num,
+				.loc.displ = 0,
+				.kind = LVALUE_KIND_STACK,
+				.type = TYPE_INTEGER
+			};
+			emit_store_of_rvalue(enc, &array_index_value, &subexpr_value);
+			lock_register(enc, addr->val.reg_num);
+			if (i != amount - 1)
+			{
+				to_code_2R_I(
+					enc,
+					IC_MIPS_ADDI,
+					addr->val.reg_num,
+					addr->val.reg_num,
+					-4
+				);
+			}
+			free_rvalue(enc, &subexpr_value);
+		}
+	}
+}
+
+/**
+ *	Emit bound expression in array declaration
+ *
+ *	@param	enc					Encoder
+ *	@param	bound				Bound node
+ *	@param	nd					Declaration node
+ *
+ *	@return	Bound expression
+ */
+static rvalue emit_bound(encoder *const enc, const node *const bound, const node *const nd)
+{
+	// Если границы у массива не проставлены -- смотрим на инициализатор, чтобы их узнать
+	node dim_size = *bound;
+	const size_t dim = declaration_variable_get_bounds_amount(nd);
+	if (expression_get_class(bound) == EXPR_EMPTY_BOUND)
+	{
+		const node init = declaration_variable_get_initializer(nd);
+		dim_size = expression_initializer_get_subexpr(&init, dim - 1);
+		const size_t size = expression_initializer_get_size(&init);
+		const rvalue result = {
+			.from_lvalue = !FROM_LVALUE,
+			.kind = RVALUE_KIND_CONST,
+			.val.int_val = (item_t)size,
+			.type = TYPE_INTEGER
+		};
+		return emit_load_of_immediate(enc, &result);
+	}
+	return emit_expression(enc, &dim_size);
+}
+
+/**
+ *	Get bound of one-dimensional array, if it is known at compile time
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Declaration node
+ *
+ *	@return	Bound of array, @c 0 if it is not constant
+ */
+static item_t array_get_static_bound(const encoder *const enc, const node *const nd)
+{
+	const node bound = declaration_variable_get_bound(nd, 0);
+	if (expression_get_class(&bound) == EXPR_LITERAL && type_is_integer(enc->sx, expression_get_type(&bound)))
+	{
+		return max(expression_literal_get_integer(&bound), 0);
+	}
+
+	if (expression_get_class(&bound) != EXPR_EMPTY_BOUND || !declaration_variable_has_initializer(nd))
+	{
+		return 0;
+	}
+
+	// Пустая граница берётся из инициализатора
+	const node init = declaration_variable_get_initializer(nd);
+	return node_get_type(&init) == OP_INITIALIZER ? (item_t)expression_initializer_get_size(&init) : 0;
+}
+
+/**
+ *	Check if global array may be placed in data section instead of allocation on stack.
+ *	Only one-dimensional arrays of scalars with constant bound and literal initializers are placed
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Declaration node
+ *
+ *	@return	@c true on static array
+ */
+static bool array_is_static(encoder *const enc, const node *const nd)
+{
+	const size_t identifier = declaration_variable_get_id(nd);
+	const item_t type = ident_get_type(enc->sx, identifier);
+	const item_t element_type = type_array_get_element_type(enc->sx, type);
+	if (ident_is_local(enc->sx, identifier) || type_is_array(enc->sx, element_type)
+		|| type_is_structure(enc->sx, element_type) || array_get_static_bound(enc, nd) == 0)
+	{
+		return false;
+	}
+
+	if (!declaration_variable_has_initializer(nd))
+	{
+		return true;
+	}
+
+	const node init = declaration_variable_get_initializer(nd);
+	if (node_get_type(&init) != OP_INITIALIZER
+		|| (item_t)expression_initializer_get_size(&init) != array_get_static_bound(enc, nd))
+	{
+		return false;
+	}
+
+	const size_t amount = expression_initializer_get_size(&init);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node subexpr = expression_initializer_get_subexpr(&init, i);
+		const rvalue value = expression_get_class(&subexpr) == EXPR_LITERAL
+			? emit_literal_expression(enc, &subexpr)
+			: RVALUE_VOID;
+		if (value.type != TYPE_INTEGER && value.type != TYPE_FLOATING)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *	Emit declaration of global array with contents in data section.
+ *	Layout is the same as DEFARR makes on stack: elements go from the end to the beginning,
+ *	and the bound follows the first element
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_static_array_declaration(encoder *const enc, const node *const nd)
+{
+	const size_t identifier = declaration_variable_get_id(nd);
+	const lvalue variable = displacements_add(enc, identifier, false);
+	const label array_label = { .kind = L_ARRAY, .num = enc->label_num++ };
+	const item_t bound = array_get_static_bound(enc, nd);
+
+	to_code_directive(enc, ".data");
+	to_code_directive(enc, ".align 2");
+
+	if (!declaration_variable_has_initializer(nd))
+	{
+		if (bound > 1)
+		{
+			emit_code(enc, &(mips_code){ .format = FORMAT_SPACE, .imm = (bound - 1) * (item_t)WORD_LENGTH });
+		}
+		emit_label_declaration(enc, &array_label);
+		emit_code(enc, &(mips_code){ .format = FORMAT_DATA, .imm = 0 });
+	}
+	else
+	{
+		const node init = declaration_variable_get_initializer(nd);
+		const bool is_floating = type_is_floating(enc->sx
+			, type_array_get_element_type(enc->sx, ident_get_type(enc->sx, identifier)));
+
+		for (item_t i = bound - 1; i >= 0; i--)
+		{
+			if (i == 0)
+			{
+				emit_label_declaration(enc, &array_label);
+			}
+
+			const node subexpr = expression_initializer_get_subexpr(&init, (size_t)i);
+			const rvalue value = emit_literal_expression(enc, &subexpr);
+			if (is_floating)
+			{
+				const double float_value = value.type == TYPE_FLOATING ? value.val.float_val : (double)value.val.int_val;
+				emit_code(enc, &(mips_code){ .format = FORMAT_FLOAT, .float_imm = float_value });
+			}
+			else
+			{
+				emit_code(enc, &(mips_code){ .format = FORMAT_DATA, .imm = value.val.int_val });
+			}
+		}
+	}
+
+	emit_code(enc, &(mips_code){ .format = FORMAT_DATA, .imm = bound });
+	to_code_directive(enc, ".text");
+	to_code_directive(enc, ".align 2");
+
+	// В глобальной переменной хранится адрес первого элемента
+	const rvalue value = {
+		.from_lvalue = !FROM_LVALUE,
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = get_register(enc),
+		.type = TYPE_INTEGER
+	};
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_L, .instruction = IC_MIPS_LA, .fst_reg = value.val.reg_num
+		, .lbl = array_label });
+	const lvalue target = { .kind = variable.kind, .type = TYPE_INTEGER, .loc = variable.loc, .base_reg = variable.base_reg };
+	emit_store_of_rvalue(enc, &target, &value);
+	free_rvalue(enc, &value);
+}
+
+/**
+ *	Emit array declaration
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_array_declaration(encoder *const enc, const node *const nd)
+{
+	const size_t identifier = declaration_variable_get_id(nd);
+	const bool has_init = declaration_variable_has_initializer(nd);
+
+	// Сдвигаем, чтобы размер первого измерения был перед массивом
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, -4);
+	const lvalue variable = displacements_add(enc, identifier, false);
+	const rvalue value = {
+		.from_lvalue = !FROM_LVALUE,
+		.kind = RVALUE_KIND_REGISTER,
+		.val.reg_num = get_register(enc),
+		.type = TYPE_INTEGER
+	};
+	to_code_2R(enc, IC_MIPS_MOVE, value.val.reg_num, R_SP);
+	const lvalue target = {.kind = variable.kind, .type = TYPE_INTEGER, .loc = variable.loc, .base_reg = variable.base_reg};
+	emit_store_of_rvalue(enc, &target, &value);
+	free_rvalue(enc, &value);
+
+	// Регистры-аргументы сохраняются в кадре, сохраняемые регистры заняты переменными
+	enc->scope_displ += ARG_REG_AMOUNT * WORD_LENGTH;
+	enc->max_displ = max(enc->scope_displ, enc->max_displ);
+	const item_t arguments_displ = -(item_t)enc->scope_displ;
+	for (size_t i = 0; i < ARG_REG_AMOUNT; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_SW, R_A0 + i, arguments_displ + (item_t)(i * WORD_LENGTH), R_FP);
+	}
+
+	// Загрузка адреса в $a0
+	to_code_2R(enc, IC_MIPS_MOVE, R_A0, R_SP);
+
+	// Загрузка размера массива в $a1
+	const node dim_size = declaration_variable_get_bound(nd, 0);
+	const rvalue tmp = emit_expression(enc, &dim_size);
+	const rvalue second_arg_rvalue = (tmp.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &tmp) : tmp;
+	emit_move_rvalue_to_register(enc, R_A1, &second_arg_rvalue);
+	free_rvalue(enc, &second_arg_rvalue);
+
+	const size_t dim = declaration_variable_get_bounds_amount(nd);
+	if (dim >= 2)
+	{
+		// Предварительно загрузим в $a2 и $a3 адрес первого элемента и размер соответственно
+		to_code_2R(enc, IC_MIPS_MOVE, R_A2, R_A0);
+		to_code_2R(enc, IC_MIPS_MOVE, R_A3, R_A1);
+	}
+
+	to_code_S(enc, IC_MIPS_JAL, "DEFARR1");
+
+	for (size_t j = 1; j < dim; j++)
+	{
+		// Загрузка адреса в $a0
+		to_code_2R(enc, IC_MIPS_MOVE, R_A0, R_V0);
+		// Загрузка размера массива в $a1
+		const node try_dim_size = declaration_variable_get_bound(nd, j);
+		const rvalue bound = emit_bound(enc, &try_dim_size, nd);
+		emit_move_rvalue_to_register(enc, R_A1, &bound);
+		free_rvalue(enc, &bound);
+
+		to_code_S(enc, IC_MIPS_JAL, "DEFARR2");
+
+		if (j != dim - 1)
+		{
+			// Предварительно загрузим в $a2 и $a3 адрес первого элемента и размер соответственно
+			to_code_2R(enc, IC_MIPS_MOVE, R_A2, R_T5);
+			to_code_2R(enc, IC_MIPS_MOVE, R_A3, R_T6);
+		}
+	}
+
+	if (has_init)
+	{
+		uni_printf(enc->io, "\n");
+
+		const rvalue variable_value = emit_load_of_lvalue(enc, &variable);
+		const node init = declaration_variable_get_initializer(nd);
+		emit_array_init(enc, nd, 0, &init, &variable_value);
+
+		free_rvalue(enc, &variable_value);
+	}
+
+	to_code_2R(enc, IC_MIPS_MOVE, R_SP, R_V0);
+
+	for (size_t i = 0; i < ARG_REG_AMOUNT; i++)
+	{
+		to_code_R_I_R(enc, IC_MIPS_LW, R_A0 + i, arguments_displ + (item_t)(i * WORD_LENGTH), R_FP);
+	}
+	enc->scope_displ -= ARG_REG_AMOUNT * WORD_LENGTH;
+}
+
+/**
+ *	Emit struct initialization
+ *
+ *	@param	enc					Encoder
+ *	@param	target				Lvalue to initialize
+ *	@param	initializer			Initializer node in AST
+ */
+static void emit_structure_init(encoder *const enc, const lvalue *const target, const node *const initializer)
+{
+	assert(type_is_structure(enc->sx, target->type));
+
+	size_t displ = 0;
+
+	const size_t amount = type_structure_get_member_amount(enc->sx, target->type);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const item_t type = type_structure_get_member_type(enc->sx, target->type, i);
+		const lvalue member_lvalue = {
+			.base_reg = target->base_reg,
+			.kind = target->kind,
+			.loc.displ = target->loc.displ + displ,
+			.type = type
+		};
+		displ += mips_type_size(enc->sx, type);
+
+		const node subexpr = expression_initializer_get_subexpr(initializer, i);
+		if (expression_get_class(&subexpr) == EXPR_INITIALIZER)
+		{
+			emit_structure_init(enc, &member_lvalue, &subexpr);
+			continue;
+		}
+
+		if (type_is_structure(enc->sx, expression_get_type(&subexpr)))
+		{
+			emit_struct_assignment(enc, &member_lvalue, &subexpr);
+		}
+		else
+		{
+			const rvalue subexpr_rvalue = emit_expression(enc, &subexpr);
+			emit_store_of_rvalue(enc, &member_lvalue, &subexpr_rvalue);
+			free_rvalue(enc, &subexpr_rvalue);
+		}
+	}
+}
+
+/**
+ *	Emit variable declaration
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_variable_declaration(encoder *const enc, const node *const nd)
+{
+	const size_t identifier = declaration_variable_get_id(nd);
+	uni_printf(enc->io, "\t# \"%s\" variable declaration:\n", ident_get_spelling(enc->sx, identifier));
+
+	const item_t type = ident_get_type(enc->sx, identifier);
+	if (type_is_array(enc->sx, type) && array_is_static(enc, nd))
+	{
+		emit_static_array_declaration(enc, nd);
+	}
+	else if (type_is_array(enc->sx, type))
+	{
+		emit_array_declaration(enc, nd);
+	}
+	else
+	{
+		const bool is_register = hash_get_index(&enc->local_registers, (item_t)identifier) != SIZE_MAX;
+		const lvalue variable = displacements_add(enc, identifier, is_register);
+		if (is_register)
+		{
+			uni_printf(enc->io, "\t# is in register ");
+			mips_register_to_io(enc->io, variable.loc.reg_num);
+			uni_printf(enc->io, "\n");
+		}
+
+		if (declaration_variable_has_initializer(nd))
+		{
+			const node initializer = declaration_variable_get_initializer(nd);
+
+			if (type_is_structure(enc->sx, type))
+			{
+				const rvalue tmp = emit_struct_assignment(enc, &variable, &initializer);
+				free_rvalue(enc, &tmp);
+			}
+			else
+			{
+				const rvalue value = emit_expression(enc, &initializer);
+
+				emit_store_of_rvalue(enc, &variable, &value);
+				free_rvalue(enc, &value);
+			}
+		}
+	}
+}
+
+/**
+ *	Check if instruction has register among its operands
+ *
+ *	@param	code				Instruction
+ *	@param	reg					Register
+ *
+ *	@return	@c true if register is an operand
+ */
+static bool code_has_register(const mips_code *const code, const mips_register_t reg)
+{
+	switch (code->format)
+	{
+		case FORMAT_R:
+		case FORMAT_R_I:
+		case FORMAT_R_F:
+		case FORMAT_R_L:
+		case FORMAT_R_HI:
+			return code->fst_reg == reg;
+		case FORMAT_2R:
+		case FORMAT_2R_I:
+		case FORMAT_R_I_R:
+		case FORMAT_2R_L:
+		case FORMAT_2R_LO:
+			return code->fst_reg == reg || code->snd_reg == reg;
+		case FORMAT_3R:
+			return code->fst_reg == reg || code->snd_reg == reg || code->thd_reg == reg;
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Check if function body has register among operands of its instructions
+ *
+ *	@param	enc					Encoder
+ *	@param	reg					Register
+ *
+ *	@return	@c true if register is used
+ */
+static bool function_uses_register(const encoder *const enc, const mips_register_t reg)
+{
+	for (size_t i = 0; i < enc->code_size; i++)
+	{
+		if (code_has_register(&enc->code[i], reg))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Check if function body calls other functions
+ *
+ *	@param	enc					Encoder
+ *
+ *	@return	@c true if there is a call
+ */
+static bool function_has_call(const encoder *const enc)
+{
+	for (size_t i = 0; i < enc->code_size; i++)
+	{
+		if (enc->code[i].format == FORMAT_L && enc->code[i].instruction == IC_MIPS_JAL)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Prepare function definition: its body is emitted with own copy of encoder state into own buffer
+ *
+ *	@param	enc					Encoder
+ *	@param	def					Function definition
+ *	@param	nd					Node in AST
+ */
+static void definition_prepare(encoder *const enc, definition *const def, const node *const nd)
+{
+	def->nd = *nd;
+	def->io = io_create();
+	out_set_buffer(&def->io, BUFFER_SIZE);
+	def->buffer = NULL;
+
+	def->enc = *enc;
+	def->enc.io = &def->io;
+	def->enc.displacements = vector_create(vector_size(&enc->displacements));
+	for (size_t i = 0; i < vector_size(&enc->displacements); i++)
+	{
+		vector_add(&def->enc.displacements, vector_get(&enc->displacements, i));
+	}
+	def->enc.local_registers = hash_create(HASH_TABLE_SIZE);
+
+	def->enc.label_num = 0;
+	def->enc.case_label_num = 0;
+	def->enc.code = NULL;
+	def->enc.code_size = 0;
+	def->enc.code_capacity = 0;
+	def->enc.is_buffered = true;
+	def->enc.object = NULL;
+	def->enc.object_size = 0;
+	def->enc.object_capacity = 0;
+}
+
+/**
+ *	Emit function body into buffer of definition,
+ *	it depends only on global declarations, so bodies may be emitted in parallel
+ *
+ *	@param	def					Function definition
+ */
+static void emit_function_code(definition *const def)
+{
+	encoder *const enc = &def->enc;
+	const node *const nd = &def->nd;
+	const size_t ref_ident = declaration_function_get_id(nd);
+	const item_t func_type = ident_get_type(enc->sx, ref_ident);
+	const size_t parameters = type_function_get_parameter_amount(enc->sx, func_type);
+
+	enc->curr_function_ident = ref_ident;
+	enc->max_displ = 0;
+	enc->scope_displ = 0;
+
+	uni_printf(enc->io, "\n\t# function parameters:\n");
+
+	size_t register_arguments_amount = 0;
+	size_t floating_register_arguments_amount = 0;
+
+	for (size_t i = 0; i < parameters; i++)
+	{
+		const size_t id = declaration_function_get_parameter(nd, i);
+		uni_printf(enc->io, "\t# parameter \"%s\" ", ident_get_spelling(enc->sx, id));
+
+		const bool argument_is_float = type_is_floating(enc->sx, ident_get_type(enc->sx, id));
+
+		const bool argument_is_register = !argument_is_float 
+			? register_arguments_amount < ARG_REG_AMOUNT 
+			: floating_register_arguments_amount < ARG_REG_AMOUNT / 2;
+
+		if (argument_is_register)
+		{
+			// Рассматриваем их как регистровые переменные
+			const item_t type = ident_get_type(enc->sx, id);
+			const mips_register_t curr_reg = argument_is_float 
+				? R_FA0 + 2 * floating_register_arguments_amount++
+				: R_A0 + register_arguments_amount++;
+			uni_printf(enc->io, "is in register ");
+			mips_register_to_io(enc->io, curr_reg);
+			uni_printf(enc->io, "\n");
+
+			// Вносим переменную в таблицу символов
+			const lvalue value = {.kind = LVALUE_KIND_REGISTER, .type = type, .loc.reg_num = curr_reg, .base_reg = R_FP };
+			displacements_set(enc, id, &value);
+		}
+		else
+		{
+			const item_t type = ident_get_type(enc->sx, id);
+			const size_t displ = i * WORD_LENGTH + FUNC_DISPL_PRESEREVED + WORD_LENGTH;
+			uni_printf(enc->io, "is on stack at offset %zu from $fp\n", displ);
+
+			const lvalue value = {.kind = LVALUE_KIND_STACK, .type = type, .loc.displ = displ, .base_reg = R_FP };
+			displacements_set(enc, id, &value);
+		}
+	}
+
+	uni_printf(enc->io, "\n\t# function body:\n");
+	node body = declaration_function_get_body(nd);
+	liveness_allocate(enc, &body);
+	emit_statement(enc, &body);
+
+	const label end_label = { .kind = L_FUNCEND, .num = ref_ident };
+	emit_label_declaration(enc, &end_label);
+
+	if (enc->is_optimized)
+	{
+		emit_peephole(enc);
+	}
+
+	// Листовой функции без локальных данных на стеке не нужны ни $ra, ни собственный кадр
+	const bool has_call = function_has_call(enc);
+	const bool has_frame = has_call || enc->max_displ != 0
+		|| function_uses_register(enc, R_FP) || function_uses_register(enc, R_SP);
+
+	// Сохраняются только используемые в теле оберегаемые регистры: биты 0-7 для $s0-$s7, далее пары $fs
+	unsigned int preserved = 0;
+	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+	{
+		if (function_uses_register(enc, R_S0 + i))
+		{
+			preserved |= 1u << i;
+		}
+	}
+	for (size_t i = 0; i < PRESERVED_FP_REG_AMOUNT / 2; i++)
+	{
+		if (function_uses_register(enc, R_FS0 + 2 * i) || function_uses_register(enc, R_FS0 + 2 * i + 1))
+		{
+			preserved |= 1u << (PRESERVED_REG_AMOUNT + i);
+		}
+	}
+
+	// Восстановление стека после работы функции
+	uni_printf(enc->io, "\n\t# data restoring:\n");
+
+	if (has_frame)
+	{
+		// Ставим $fp на его положение в предыдущей функции
+		to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_FP, (item_t)(FUNC_DISPL_PRESEREVED + WORD_LENGTH));
+	}
+
+	uni_printf(enc->io, "\n");
+
+	// Восстановление $s0-$s7
+	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+	{
+		if (preserved & (1u << i))
+		{
+			to_code_R_I_R(enc, IC_MIPS_LW, R_S0 + i, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH), R_SP);
+		}
+	}
+
+	uni_printf(enc->io, "\n");
+
+	// Восстановление $fs0-$fs7
+	for (size_t i = 0; i < PRESERVED_FP_REG_AMOUNT / 2; i++)
+	{
+		if (preserved & (1u << (PRESERVED_REG_AMOUNT + i)))
+		{
+			to_code_R_I_R(enc, IC_MIPS_L_S, R_FS0 + 2 * i
+				, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH + /* за s0-s7 */ 8 * WORD_LENGTH), R_SP);
+		}
+	}
+
+	uni_printf(enc->io, "\n");
+
+	if (has_frame)
+	{
+		// Возвращаем $sp его положение в предыдущей функции
+		to_code_R_I_R(enc, IC_MIPS_LW, R_FP, -(item_t)(RA_SIZE + SP_SIZE), R_SP);
+	}
+	if (has_call)
+	{
+		to_code_R_I_R(enc, IC_MIPS_LW, R_RA, -(item_t)(RA_SIZE), R_SP);
+	}
+
+	// Прыгаем далее
+	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+	enc->is_buffered = false;
+
+	if (enc->is_optimized)
+	{
+		emit_schedule(enc);
+	}
+
+	def->buffer = out_extract_buffer(enc->io);
+	def->has_call = has_call;
+	def->has_frame = has_frame;
+	def->preserved = preserved;
+}
+
+/**
+ *	Emit function body, task of thread pool
+ *
+ *	@param	context				Function definitions
+ *	@param	index				Definition index
+ */
+static void definition_emit(void *const context, const size_t index)
+{
+	emit_function_code(&((definition *)context)[index]);
+}
+
+/**
+ *	Emit function definition with prologue and already emitted body
+ *
+ *	@param	enc					Encoder
+ *	@param	def					Function definition
+ */
+static void emit_function_definition(encoder *const enc, definition *const def)
+{
+	const size_t ref_ident = declaration_function_get_id(&def->nd);
+	const label func_label = { .kind = L_FUNC, .num = ref_ident };
+	emit_label_declaration(enc, &func_label);
+
+	if (ref_ident == enc->sx->ref_main)
+	{
+		// FIXME: пока тут будут две метки для функции main
+		emit_code(enc, &(mips_code){ .format = FORMAT_LABEL, .symbol = "MAIN" });
+	}
+
+	uni_printf(enc->io, "\t# \"%s\" function:\n", ident_get_spelling(enc->sx, ref_ident));
+
+	// Метки тела нумеровались с нуля, они продолжают нумерацию меток предыдущих функций
+	for (size_t i = 0; i < def->enc.code_size; i++)
+	{
+		label *const lbl = &def->enc.code[i].lbl;
+		switch (lbl->kind)
+		{
+			case L_MAIN:
+			case L_FUNC:
+			case L_FUNCEND:
+			case L_STRING:
+				break;
+			case L_CASE:
+				lbl->num += enc->case_label_num;
+				break;
+			default:
+				lbl->num += enc->label_num;
+				break;
+		}
+	}
+	enc->label_num += def->enc.label_num;
+	enc->case_label_num += def->enc.case_label_num;
+
+	const bool has_call = def->has_call;
+	const bool has_frame = def->has_frame;
+	const unsigned int preserved = def->preserved;
+	size_t max_displ = def->enc.max_displ;
+
+	// Сохранение оберегаемых регистров перед началом работы функции
+	// FIXME: избавиться от функций to_code
+	uni_printf(enc->io, "\n\t# preserved registers:\n");
+	if (has_call)
+	{
+		to_code_R_I_R(enc, IC_MIPS_SW, R_RA, -(item_t)RA_SIZE, R_SP);
+	}
+	if (has_frame)
+	{
+		to_code_R_I_R(enc, IC_MIPS_SW, R_FP, -(item_t)(RA_SIZE + SP_SIZE), R_SP);
+	}
+
+	// Сохранение s0-s7, смещения остаются прежними
+	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+	{
+		if (preserved & (1u << i))
+		{
+			to_code_R_I_R(enc, IC_MIPS_SW, R_S0 + i, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH), R_SP);
+		}
+	}
+
+	uni_printf(enc->io, "\n");
+
+	// Сохранение fs0-fs10 (в цикле 5, т.к. операции одинарной точности => нужны только четные регистры)
+	for (size_t i = 0; i < PRESERVED_FP_REG_AMOUNT / 2; i++)
+	{
+		if (preserved & (1u << (PRESERVED_REG_AMOUNT + i)))
+		{
+			to_code_R_I_R(enc, IC_MIPS_S_S, R_FS0 + 2 * i
+				, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH + PRESERVED_REG_AMOUNT * WORD_LENGTH /* за $s0-$s7 */)
+				, R_SP);
+		}
+	}
+
+	// Выравнивание смещения на 8
+	if (max_displ % 8)
+	{
+		const size_t padding = 8 - (max_displ % 8);
+		max_displ += padding;
+		if (padding)
+		{
+			uni_printf(enc->io, "\n\t# padding -- max displacement == %zu\n", max_displ);
+		}
+	}
+
+	if (has_frame)
+	{
+		uni_printf(enc->io, "\n\t# setting up $fp:\n");
+		// $fp указывает на конец статики (которое в данный момент равно концу динамики)
+		to_code_2R_I(enc, IC_MIPS_ADDI, R_FP, R_SP, -(item_t)(FUNC_DISPL_PRESEREVED + WORD_LENGTH));
+
+		uni_printf(enc->io, "\n\t# setting up $sp:\n");
+		// $sp указывает на конец динамики (которое в данный момент равно концу статики)
+		// Смещаем $sp ниже конца статики (чтобы он не совпадал с $fp)
+		to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_FP, -(item_t)(WORD_LENGTH + max_displ));
+	}
+
+	if (enc->is_optimized)
+	{
+		// Инструкции тела уже расписаны, слоты задержки заполнены
+		to_code_directive(enc, ".set\tnoreorder");
+	}
+
+	emit_function_body(enc, def);
+
+	if (enc->is_optimized)
+	{
+		to_code_directive(enc, ".set\treorder");
+	}
+
+	free(def->buffer);
+	free(def->enc.code);
+	hash_clear(&def->enc.displacements);
+	hash_clear(&def->enc.local_registers);
+}
+
+static void emit_declaration(encoder *const enc, const node *const nd)
+{
+	switch (declaration_get_class(nd))
+	{
+		case DECL_VAR:
+			emit_variable_declaration(enc, nd);
+			break;
+
+		case DECL_FUNC:
+		{
+			definition def;
+			definition_prepare(enc, &def, nd);
+			emit_function_code(&def);
+			emit_function_definition(enc, &def);
+		}
+		break;
+
+		default:
+			// С объявлением типа ничего делать не нужно
+			return;
+	}
+
+	uni_printf(enc->io, "\n");
+}
+
+
+/*
+ *	 ______     ______   ______     ______   ______     __    __     ______     __   __     ______   ______
+ *	/\  ___\   /\__  _\ /\  __ \   /\__  _\ /\  ___\   /\ "-./  \   /\  ___\   /\ "-.\ \   /\__  _\ /\  ___\
+ *	\ \___  \  \/_/\ \/ \ \  __ \  \/_/\ \/ \ \  __\   \ \ \-./\ \  \ \  __\   \ \ \-.  \  \/_/\ \/ \ \___  \
+ *	 \/\_____\    \ \_\  \ \_\ \_\    \ \_\  \ \_____\  \ \_\ \ \_\  \ \_____\  \ \_\\"\_\    \ \_\  \/\_____\
+ *	  \/_____/     \/_/   \/_/\/_/     \/_/   \/_____/   \/_/  \/_/   \/_____/   \/_/ \/_/     \/_/   \/_____/
+ */
+
+
+/**
+ *	Emit declaration statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_declaration_statement(encoder *const enc, const node *const nd)
+{
+	const size_t size = statement_declaration_get_size(nd);
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = statement_declaration_get_declarator(nd, i);
+		emit_declaration(enc, &decl);
+	}
+}
+
+/**
+ *	Emit case statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_case_statement(encoder *const enc, const node *const nd, const size_t label_num)
+{
+	const label label_case = { .kind = L_CASE, .num = label_num };
+	emit_label_declaration(enc, &label_case);
+
+	const node substmt = statement_case_get_substmt(nd);
+	emit_statement(enc, &substmt);
+}
+
+/**
+ *	Emit default statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_default_statement(encoder *const enc, const node *const nd, const size_t label_num)
+{
+	const label label_default = { .kind = L_CASE, .num = label_num };
+	emit_label_declaration(enc, &label_default);
+
+	const node substmt = statement_default_get_substmt(nd);
+	emit_statement(enc, &substmt);
+}
+
+/**
+ *	Emit compound statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_compound_statement(encoder *const enc, const node *const nd)
+{
+	const size_t scope_displacement = enc->scope_displ;
+
+	const size_t size = statement_compound_get_size(nd);
+	for (size_t i = 0; i < size; i++)
+	{
+		const node substmt = statement_compound_get_substmt(nd, i);
+		emit_statement(enc, &substmt);
+	}
+
+	enc->max_displ = max(enc->scope_displ, enc->max_displ);
+	enc->scope_displ = scope_displacement;
+}
+
+/**
+ *	Emit if statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_if_statement(encoder *const enc, const node *const nd)
+{
+	const node condition = statement_if_get_condition(nd);
+	const rvalue value = emit_expression(enc, &condition);
+
+	const size_t label_num = enc->label_num++;
+	const label label_else = { .kind = L_ELSE, .num = label_num };
+	const label label_end = { .kind = L_END, .num = label_num };
+
+	const bool has_else = statement_if_has_else_substmt(nd);
+	const mips_instruction_t instruction = IC_MIPS_BEQ;
+	emit_conditional_branch(enc, instruction, &value, has_else ? &label_else : &label_end);
+	free_rvalue(enc, &value);
+
+	const node then_substmt = statement_if_get_then_substmt(nd);
+	emit_statement(enc, &then_substmt);
+
+	if (has_else)
+	{
+		emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
+		emit_label_declaration(enc, &label_else);
+
+		const node else_substmt = statement_if_get_else_substmt(nd);
+		emit_statement(enc, &else_substmt);
+	}
+
+	emit_label_declaration(enc, &label_end);
+}
+
+/**
+ *	Compare case labels by value
+ *
+ *	@param	fst					First label
+ *	@param	snd					Second label
+ *
+ *	@return	Comparison result for @c qsort
+ */
+static int case_label_compare(const void *const fst, const void *const snd)
+{
+	const case_label *const lhs = fst;
+	const case_label *const rhs = snd;
+
+	if (lhs->value != rhs->value)
+	{
+		return lhs->value < rhs->value ? -1 : 1;
+	}
+
+	return lhs->num < rhs->num ? -1 : lhs->num > rhs->num;
+}
+
+/**
+ *	Emit jump table for switch value
+ *	@note	Table is placed in read-only data, values out of range jump to default label
+ *
+ *	@param	enc					Encoder
+ *	@param	value				Register with switch value
+ *	@param	labels				Sorted case labels
+ *	@param	begin				First label
+ *	@param	end					Label after the last one
+ *	@param	label_default		Label for values without case
+ */
+static void emit_case_table(encoder *const enc, const mips_register_t value, const case_label *const labels
+	, const size_t begin, const size_t end, const label *const label_default)
+{
+	const item_t low = labels[begin].value;
+	const item_t size = labels[end - 1].value - low + 1;
+	const label label_table = { .kind = L_TABLE, .num = enc->label_num++ };
+
+	const mips_register_t index = get_register(enc);
+	const mips_register_t temp = get_register(enc);
+
+	// Сдвиг к нулю без ловушки переполнения, отрицательные значения станут большими беззнаковыми
+	if (-low >= MIN_IMMEDIATE && -low <= MAX_IMMEDIATE)
+	{
+		to_code_2R_I(enc, IC_MIPS_ADDIU, index, value, -low);
+	}
+	else
+	{
+		to_code_R_I(enc, IC_MIPS_LI, index, low);
+		to_code_3R(enc, IC_MIPS_SUBU, index, value, index);
+	}
+
+	if (size <= MAX_IMMEDIATE)
+	{
+		to_code_2R_I(enc, IC_MIPS_SLTIU, temp, index, size);
+	}
+	else
+	{
+		to_code_R_I(enc, IC_MIPS_LI, temp, size);
+		to_code_3R(enc, IC_MIPS_SLTU, temp, index, temp);
+	}
+
+	emit_comparison_branch(enc, IC_MIPS_BEQ, temp, R_ZERO, label_default);
+
+	to_code_2R_I(enc, IC_MIPS_SLL, index, index, 2);
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_L, .instruction = IC_MIPS_LA, .fst_reg = temp, .lbl = label_table });
+	to_code_3R(enc, IC_MIPS_ADDU, index, index, temp);
+	to_code_R_I_R(enc, IC_MIPS_LW, index, 0, index);
+	emit_register_branch(enc, IC_MIPS_JR, index);
+
+	free_register(enc, temp);
+	free_register(enc, index);
+
+	to_code_directive(enc, ".rdata");
+	to_code_directive(enc, ".align 2");
+	emit_label_declaration(enc, &label_table);
+
+	size_t i = begin;
+	for (item_t curr = low; curr < low + size; curr++)
+	{
+		const label label_case = { .kind = L_CASE, .num = labels[i].num };
+		emit_code(enc, &(mips_code){ .format = FORMAT_WORD, .lbl = labels[i].value == curr ? label_case : *label_default });
+
+		i += labels[i].value == curr;
+	}
+
+	to_code_directive(enc, ".text");
+	to_code_directive(enc, ".align 2");
+}
+
+/**
+ *	Emit comparisons of switch value with case labels
+ *
+ *	@param	enc					Encoder
+ *	@param	value				Register with switch value
+ *	@param	labels				Sorted case labels
+ *	@param	begin				First label
+ *	@param	end					Label after the last one
+ *	@param	label_default		Label for values without case, no jump if @c NULL
+ */
+static void emit_case_labels(encoder *const enc, const mips_register_t value, const case_label *const labels
+	, const size_t begin, const size_t end, const label *const label_default)
+{
+	const mips_register_t temp = get_register(enc);
+	for (size_t i = begin; i < end; i++)
+	{
+		const label label_case = { .kind = L_CASE, .num = labels[i].num };
+		if (labels[i].value == 0)
+		{
+			emit_comparison_branch(enc, IC_MIPS_BEQ, value, R_ZERO, &label_case);
+		}
+		else
+		{
+			to_code_R_I(enc, IC_MIPS_LI, temp, labels[i].value);
+			emit_comparison_branch(enc, IC_MIPS_BEQ, value, temp, &label_case);
+		}
+	}
+
+	free_register(enc, temp);
+	if (label_default != NULL)
+	{
+		emit_unconditional_branch(enc, IC_MIPS_J, label_default);
+	}
+}
+
+/**
+ *	Emit binary search of switch value among clusters of case labels
+ *
+ *	@param	enc					Encoder
+ *	@param	value				Register with switch value
+ *	@param	labels				Sorted case labels
+ *	@param	clusters			First labels of clusters
+ *	@param	begin				First cluster
+ *	@param	end					Cluster after the last one
+ *	@param	label_default		Label for values without case
+ */
+static void emit_case_search(encoder *const enc, const mips_register_t value, const case_label *const labels
+	, const size_t *const clusters, const size_t begin, const size_t end, const label *const label_default)
+{
+	const size_t first = clusters[begin];
+	const size_t last = clusters[end];
+
+	if (end - begin == 1 && last - first >= MIN_TABLE_CASES)
+	{
+		emit_case_table(enc, value, labels, first, last, label_default);
+		return;
+	}
+
+	if (end - begin == 1 || last - first < MIN_TABLE_CASES)
+	{
+		emit_case_labels(enc, value, labels, first, last, label_default);
+		return;
+	}
+
+	const size_t middle = begin + (end - begin) / 2;
+	const item_t pivot = labels[clusters[middle]].value;
+	const label label_less = { .kind = L_ELSE, .num = enc->label_num++ };
+
+	const mips_register_t temp = get_register(enc);
+	if (pivot >= MIN_IMMEDIATE && pivot <= MAX_IMMEDIATE)
+	{
+		to_code_2R_I(enc, IC_MIPS_SLTI, temp, value, pivot);
+	}
+	else
+	{
+		to_code_R_I(enc, IC_MIPS_LI, temp, pivot);
+		to_code_3R(enc, IC_MIPS_SLT, temp, value, temp);
+	}
+
+	emit_comparison_branch(enc, IC_MIPS_BNE, temp, R_ZERO, &label_less);
+	free_register(enc, temp);
+
+	emit_case_search(enc, value, labels, clusters, middle, end, label_default);
+	emit_label_declaration(enc, &label_less);
+	emit_case_search(enc, value, labels, clusters, begin, middle, label_default);
+}
+
+/**
+ *	Emit switch statement
+ *	@note	Dense case values are dispatched by jump table, sparse ones by binary search
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_switch_statement(encoder *const enc, const node *const nd)
+{
+	const size_t label_num = enc->label_num++;
+	size_t curr_case_label_num = enc->case_label_num;
+
+	const label old_label_break = enc->label_break;
+	enc->label_break = (label){ .kind = L_END, .num = label_num };
+
+	const node condition = statement_switch_get_condition(nd);
+	const rvalue tmp_condtion = emit_expression(enc, &condition);
+	const rvalue condition_rvalue = (tmp_condtion.kind == RVALUE_KIND_CONST)
+		? emit_load_of_immediate(enc, &tmp_condtion)
+		: tmp_condtion;
+
+	// Сбор меток case, default получает метку после всех case'ов
+	const node body = statement_switch_get_body(nd);
+	const size_t amount = statement_compound_get_size(&body);	// Гарантируется compound statement
+	case_label *const labels = malloc(amount * sizeof(case_label) + 1);
+	size_t *const clusters = malloc((amount + 1) * sizeof(size_t));
+	const bool is_sorted = labels != NULL && clusters != NULL;
+
+	label label_default = enc->label_break;
+	size_t cases = 0;
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node substmt = statement_compound_get_substmt(&body, i);
+		const item_t substmt_class = statement_get_class(&substmt);
+
+		if (substmt_class == STMT_CASE)
+		{
+			const node case_expr = statement_case_get_expression(&substmt);
+			const case_label curr = { .value = expression_literal_get_integer(&case_expr)
+				, .num = enc->case_label_num++ };
+
+			if (is_sorted)
+			{
+				labels[cases++] = curr;
+			}
+			else
+			{
+				// Без памяти под метки сравниваем в порядке следования
+				emit_case_labels(enc, condition_rvalue.val.reg_num, &curr, 0, 1, NULL);
+			}
+		}
+		else if (substmt_class == STMT_DEFAULT)
+		{
+			label_default = (label){ .kind = L_CASE, .num = enc->case_label_num++ };
+		}
+	}
+
+	size_t amount_clusters = 0;
+	if (is_sorted)
+	{
+		// Метки сортируются по значению, из повторяющихся остается первая
+		qsort(labels, cases, sizeof(case_label), &case_label_compare);
+		size_t unique = 0;
+		for (size_t i = 0; i < cases; i++)
+		{
+			if (unique == 0 || labels[unique - 1].value != labels[i].value)
+			{
+				labels[unique++] = labels[i];
+			}
+		}
+
+		// Кластер продолжается, пока таблица переходов заполнена хотя бы наполовину
+		for (size_t i = 0; i < unique;)
+		{
+			clusters[amount_clusters++] = i;
+
+			size_t j = i + 1;
+			while (j < unique && (size_t)(labels[j].value - labels[i].value) < 2 * (j - i + 1))
+			{
+				j++;
+			}
+			i = j;
+		}
+		clusters[amount_clusters] = unique;
+	}
+
+	if (amount_clusters == 0)
+	{
+		emit_unconditional_branch(enc, IC_MIPS_J, &label_default);
+	}
+	else
+	{
+		emit_case_search(enc, condition_rvalue.val.reg_num, labels, clusters, 0, amount_clusters, &label_default);
+	}
+
+	free(labels);
+	free(clusters);
+	free_rvalue(enc, &condition_rvalue);
+
+	uni_printf(enc->io, "\n");
+
+	// Размещение тел всех case и default statements
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node substmt = statement_compound_get_substmt(&body, i);
+		const item_t substmt_class = statement_get_class(&substmt);
+
+		if (substmt_class == STMT_CASE)
+		{
+			emit_case_statement(enc, &substmt, curr_case_label_num++);
+		}
+		else if (substmt_class == STMT_DEFAULT)
+		{
+			emit_default_statement(enc, &substmt, curr_case_label_num++);
+		}
+		else
+		{
+			emit_statement(enc, &substmt);
+		}
+	}
+
+	emit_label_declaration(enc, &enc->label_break);
+	enc->label_break = old_label_break;
+}
+
+/**
+ *	Emit while statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_while_statement(encoder *const enc, const node *const nd)
+{
+	const size_t label_num = enc->label_num++;
+	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
+	const label label_end = { .kind = L_END, .num = label_num };
+
+	const label old_continue = enc->label_continue;
+	const label old_break = enc->label_break;
+
+	enc->label_continue = label_begin;
+	enc->label_break = label_end;
+
+	emit_label_declaration(enc, &label_begin);
+
+	const node condition = statement_while_get_condition(nd);
+	const rvalue value = emit_expression(enc, &condition);
+
+	const mips_instruction_t instruction = IC_MIPS_BEQ;
+	emit_conditional_branch(enc, instruction, &value, &label_end);
+	free_rvalue(enc, &value);
+
+	const node body = statement_while_get_body(nd);
+	emit_statement(enc, &body);
+
+	emit_unconditional_branch(enc, IC_MIPS_J, &label_begin);
+	emit_label_declaration(enc, &label_end);
+
+	enc->label_continue = old_continue;
+	enc->label_break = old_break;
+}
+
+/**
+ *	Emit do statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_do_statement(encoder *const enc, const node *const nd)
+{
+	const size_t label_num = enc->label_num++;
+	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
+	emit_label_declaration(enc, &label_begin);
+
+	const label label_condition = { .kind = L_NEXT, .num = label_num };
+	const label label_end = { .kind = L_END, .num = label_num };
+
+	const label old_continue = enc->label_continue;
+	const label old_break = enc->label_break;
+	enc->label_continue = label_condition;
+	enc->label_break = label_end;
+
+	const node body = statement_do_get_body(nd);
+	emit_statement(enc, &body);
+	emit_label_declaration(enc, &label_condition);
+
+	const node condition = statement_do_get_condition(nd);
+	const rvalue value = emit_expression(enc, &condition);
+
+	const mips_instruction_t instruction = IC_MIPS_BNE;
+	emit_conditional_branch(enc, instruction, &value, &label_begin);
+	emit_label_declaration(enc, &label_end);
+	free_rvalue(enc, &value);
+
+	enc->label_continue = old_continue;
+	enc->label_break = old_break;
+}
+
+/**
+ *	Emit for statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_for_statement(encoder *const enc, const node *const nd)
+{
+	const size_t scope_displacement = enc->scope_displ;
+
+	if (statement_for_has_inition(nd))
+	{
+		const node inition = statement_for_get_inition(nd);
+		emit_statement(enc, &inition);
+	}
+
+	const size_t label_num = enc->label_num++;
+	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
+	const label label_end = { .kind = L_END, .num = label_num };
+
+	const label old_continue = enc->label_continue;
+	const label old_break = enc->label_break;
+	enc->label_continue = label_begin;
+	enc->label_break = label_end;
+
+	emit_label_declaration(enc, &label_begin);
+	if (statement_for_has_condition(nd))
+	{
+		const node condition = statement_for_get_condition(nd);
+		const rvalue value = emit_expression(enc, &condition);
+		const mips_instruction_t instruction = IC_MIPS_BEQ;
+		emit_conditional_branch(enc, instruction, &value, &label_end);
+		free_rvalue(enc, &value);
+	}
+
+	const node body = statement_for_get_body(nd);
+	emit_statement(enc, &body);
+
+	if (statement_for_has_increment(nd))
+	{
+		const node increment = statement_for_get_increment(nd);
+		emit_void_expression(enc, &increment);
+	}
+
+	emit_unconditional_branch(enc, IC_MIPS_J, &label_begin);
+	emit_label_declaration(enc, &label_end);
+
+	enc->label_continue = old_continue;
+	enc->label_break = old_break;
+
+	enc->scope_displ = scope_displacement;
+}
+
+/**
+ *	Emit continue statement
+ *
+ *	@param	enc					Encoder
+ */
+static void emit_continue_statement(encoder *const enc)
+{
+	emit_unconditional_branch(enc, IC_MIPS_J, &enc->label_continue);
+}
+
+/**
+ *	Emit break statement
+ *
+ *	@param	enc					Encoder
+ */
+static void emit_break_statement(encoder *const enc)
+{
+	emit_unconditional_branch(enc, IC_MIPS_J, &enc->label_break);
+}
+
+/**
+ *	Emit return statement
+ *
+ *	@param	enc					Encoder
+ *	@param	nd					Node in AST
+ */
+static void emit_return_statement(encoder *const enc, const node *const nd)
+{
+	if (statement_return_has_expression(nd))
+	{
+		const node expression = statement_return_get_expression(nd);
+		const rvalue value = emit_expression(enc, &expression);
+
+		const lvalue return_lval = { .kind = LVALUE_KIND_REGISTER, .loc.reg_num = R_V0, .type = value.type };
+
+		emit_store_of_rvalue(enc, &return_lval, &value);
+		free_rvalue(enc, &value);
 	}
-	return emit_expression(enc, &dim_size);
+
+	const label label_end = { .kind = L_FUNCEND, .num = enc->curr_function_ident };
+	emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
 }
 
 /**
- *	Emit array declaration
+ *	Emit statement
  *
  *	@param	enc					Encoder
  *	@param	nd					Node in AST
  */
-static void emit_array_declaration(encoder *const enc, const node *const nd)
+static void emit_statement(encoder *const enc, const node *const nd)
 {
-	const size_t identifier = declaration_variable_get_id(nd);
-	const bool has_init = declaration_variable_has_initializer(nd);
+	switch (statement_get_class(nd))
+	{
+		case STMT_DECL:
+			emit_declaration_statement(enc, nd);
+			break;
 
-	// Сдвигаем, чтобы размер первого измерения был перед массивом
-	to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_SP, R_SP, -4);
-	const lvalue variable = displacements_add(enc, identifier, false);
-	const rvalue value = {
-		.from_lvalue = !FROM_LVALUE,
-		.kind = RVALUE_KIND_REGISTER,
-		.val.reg_num = get_register(enc),
-		.type = TYPE_INTEGER
-	};
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, value.val.reg_num, R_SP);
-	const lvalue target = {.kind = variable.kind, .type = TYPE_INTEGER, .loc = variable.loc, .base_reg = variable.base_reg};
-	emit_store_of_rvalue(enc, &target, &value);
-	free_rvalue(enc, &value);
+		case STMT_CASE:
+			system_error(node_unexpected);
+			break;
 
-	// FIXME: Переделать регистры-аргументы
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S0, R_A0);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S1, R_A1);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S2, R_A2);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S3, R_A3);
+		case STMT_DEFAULT:
+			system_error(node_unexpected);
+			break;
 
-	// Загрузка адреса в $a0
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A0, R_SP);
+		case STMT_COMPOUND:
+			emit_compound_statement(enc, nd);
+			break;
 
-	// Загрузка размера массива в $a1
-	const node dim_size = declaration_variable_get_bound(nd, 0);
-	const rvalue tmp = emit_expression(enc, &dim_size);
-	const rvalue second_arg_rvalue = (tmp.kind == RVALUE_KIND_CONST) ? emit_load_of_immediate(enc, &tmp) : tmp;
-	emit_move_rvalue_to_register(enc, R_A1, &second_arg_rvalue);
-	free_rvalue(enc, &second_arg_rvalue);
+		case STMT_EXPR:
+			emit_void_expression(enc, nd);
+			break;
 
-	const size_t dim = declaration_variable_get_bounds_amount(nd);
-	if (dim >= 2)
-	{
-		// Предварительно загрузим в $a2 и $a3 адрес первого элемента и размер соответственно
-		to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A2, R_A0);
-		to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A3, R_A1);
-	}
+		case STMT_NULL:
+			break;
 
-	uni_printf(enc->sx->io, "\tjal DEFARR1\n");
+		case STMT_IF:
+			emit_if_statement(enc, nd);
+			break;
 
-	for (size_t j = 1; j < dim; j++)
-	{
-		// Загрузка адреса в $a0
-		to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A0, R_V0);
-		// Загрузка размера массива в $a1
-		const node try_dim_size = declaration_variable_get_bound(nd, j);
-		const rvalue bound = emit_bound(enc, &try_dim_size, nd);
-		emit_move_rvalue_to_register(enc, R_A1, &bound);
-		free_rvalue(enc, &bound);
+		case STMT_SWITCH:
+			emit_switch_statement(enc, nd);
+			break;
 
-		to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S5, R_A0);
-		to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_S6, R_A1);
+		case STMT_WHILE:
+			emit_while_statement(enc, nd);
+			break;
 
-		uni_printf(enc->sx->io, "\tjal DEFARR2\n");
+		case STMT_DO:
+			emit_do_statement(enc, nd);
+			break;
 
-		if (j != dim - 1)
-		{
-			// Предварительно загрузим в $a2 и $a3 адрес первого элемента и размер соответственно
-			to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A2, R_T5);
-			to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A3, R_T6);
-		}
-	}
+		case STMT_FOR:
+			emit_for_statement(enc, nd);
+			break;
 
-	if (has_init)
-	{
-		uni_printf(enc->sx->io, "\n");
+		case STMT_CONTINUE:
+			emit_continue_statement(enc);
+			break;
 
-		const rvalue variable_value = emit_load_of_lvalue(enc, &variable);
-		const node init = declaration_variable_get_initializer(nd);
-		emit_array_init(enc, nd, 0, &init, &variable_value);
+		case STMT_BREAK:
+			emit_break_statement(enc);
+			break;
 
-		free_rvalue(enc, &variable_value);
-	}
+		case STMT_RETURN:
+			emit_return_statement(enc, nd);
+			break;
 
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_SP, R_V0);
+		default:
+			break;
+	}
 
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A0, R_S0);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A1, R_S1);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A2, R_S2);
-	to_code_2R(enc->sx->io, IC_MIPS_MOVE, R_A3, R_S3);
+	uni_printf(enc->io, "\n");
 }
 
 /**
- *	Emit struct initialization
+ *	Emit translation unit
  *
  *	@param	enc					Encoder
- *	@param	target				Lvalue to initialize
- *	@param	initializer			Initializer node in AST
+ *	@param	nd					Node in AST
+ *	@param	threads				Number of threads for function definitions
  */
-static void emit_structure_init(encoder *const enc, const lvalue *const target, const node *const initializer)
+static int emit_translation_unit(encoder *const enc, const node *const nd, const size_t threads)
 {
-	assert(type_is_structure(enc->sx, target->type));
-
-	size_t displ = 0;
-
-	const size_t amount = type_structure_get_member_amount(enc->sx, target->type);
-	for (size_t i = 0; i < amount; i++)
+	// Глобальные переменные инициализируются до вызова главной функции
+	const size_t size = translation_unit_get_size(nd);
+	for (size_t i = 0; i < size; i++)
 	{
-		const item_t type = type_structure_get_member_type(enc->sx, target->type, i);
-		const lvalue member_lvalue = {
-			.base_reg = target->base_reg,
-			.kind = target->kind,
-			.loc.displ = target->loc.displ + displ,
-			.type = type
-		};
-		displ += mips_type_size(enc->sx, type);
-
-		const node subexpr = expression_initializer_get_subexpr(initializer, i);
-		if (expression_get_class(&subexpr) == EXPR_INITIALIZER)
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) == DECL_VAR)
 		{
-			emit_structure_init(enc, &member_lvalue, &subexpr);
-			continue;
+			emit_declaration(enc, &decl);
 		}
+	}
 
-		if (type_is_structure(enc->sx, expression_get_type(&subexpr)))
+	// Прыжок на главную метку
+	to_code_S(enc, IC_MIPS_JAL, "MAIN");
+
+	// Выход из программы в конце работы
+	to_code_R_I_R(enc, IC_MIPS_LW, R_RA, -(item_t)WORD_LENGTH, R_FP);
+	to_code_2R(enc, IC_MIPS_MOVE, R_SP, R_FP);
+	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+
+	// Тела функций генерируются параллельно, а выводятся в исходном порядке
+	definition *const defs = malloc(size * sizeof(definition));
+	if (defs == NULL)
+	{
+		for (size_t i = 0; i < size; i++)
 		{
-			emit_struct_assignment(enc, &member_lvalue, &subexpr);
+			const node decl = translation_unit_get_declaration(nd, i);
+			if (declaration_get_class(&decl) != DECL_VAR)
+			{
+				emit_declaration(enc, &decl);
+			}
 		}
-		else
+
+		return enc->sx->rprt.errors != 0;
+	}
+
+	size_t amount = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) == DECL_FUNC)
 		{
-			const rvalue subexpr_rvalue = emit_expression(enc, &subexpr);
-			emit_store_of_rvalue(enc, &member_lvalue, &subexpr_rvalue);
-			free_rvalue(enc, &subexpr_rvalue);
+			definition_prepare(enc, &defs[amount++], &decl);
 		}
 	}
+
+	pool_run(threads, amount, &definition_emit, defs);
+	for (size_t i = 0; i < amount; i++)
+	{
+		emit_function_definition(enc, &defs[i]);
+		uni_printf(enc->io, "\n");
+	}
+
+	free(defs);
+	return enc->sx->rprt.errors != 0;
 }
 
-/**
- *	Emit variable declaration
- *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
- */
-static void emit_variable_declaration(encoder *const enc, const node *const nd)
+// В дальнейшем при необходимости сюда можно передавать флаги вывода директив
+// TODO: подписать, что значит каждая директива и команда
+static void pregen(encoder *const enc)
 {
-	const size_t identifier = declaration_variable_get_id(nd);
-	uni_printf(enc->sx->io, "\t# \"%s\" variable declaration:\n", ident_get_spelling(enc->sx, identifier));
+	// Подпись "GNU As:" для директив GNU
+	// Подпись "MIPS Assembler:" для директив ассемблера MIPS
 
-	const item_t type = ident_get_type(enc->sx, identifier);
-	if (type_is_array(enc->sx, type))
+	uni_printf(enc->io, "\t.section .mdebug.abi32\n");	// ?
+	uni_printf(enc->io, "\t.previous\n");				// следующая инструкция будет перенесена в секцию, описанную выше
+	uni_printf(enc->io, "\t.nan\tlegacy\n");			// ?
+	uni_printf(enc->io, "\t.module fp=xx\n");			// ?
+	uni_printf(enc->io, "\t.module nooddspreg\n");		// ?
+	uni_printf(enc->io, "\t.abicalls\n");				// ?
+	uni_printf(enc->io, "\t.option pic0\n");			// как если бы при компиляции была включена опция "-fpic" (что означает?)
+	uni_printf(enc->io, "\t.text\n");					// последующий код будет перенесён в текстовый сегмент памяти
+	// выравнивание последующих данных / команд по границе, кратной 2^n байт (в данном случае 2^2 = 4)
+	uni_printf(enc->io, "\t.align 2\n");
+
+	// делает метку main глобальной -- её можно вызывать извне кода (например, используется при линковке)
+	uni_printf(enc->io, "\n\t.globl\tmain\n");
+	uni_printf(enc->io, "\t.ent\tmain\n");				// начало процедуры main
+	uni_printf(enc->io, "\t.type\tmain, @function\n");	// тип "main" -- функция
+	emit_code(enc, &(mips_code){ .format = FORMAT_LABEL, .symbol = "main" });
+
+	// инициализация gp
+	// "__gnu_local_gp" -- локация в памяти, где лежит Global Pointer
+	emit_code(enc, &(mips_code){ .format = FORMAT_R_HI, .instruction = IC_MIPS_LUI, .fst_reg = R_GP
+		, .symbol = "__gnu_local_gp" });
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_LO, .instruction = IC_MIPS_ADDIU, .fst_reg = R_GP
+		, .snd_reg = R_GP, .symbol = "__gnu_local_gp" });
+
+	// FIXME: сделать для $ra, $sp и $fp отдельные глобальные rvalue
+	// Кадр верхнего уровня: $ra, регистры-аргументы при объявлении глобальных массивов
+	// и слово под границу первого из них, см. emit_array_declaration
+	enc->scope_displ = WORD_LENGTH;
+	to_code_2R(enc, IC_MIPS_MOVE, R_FP, R_SP);
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_SP, R_SP, -(item_t)((ARG_REG_AMOUNT + 2) * WORD_LENGTH));
+	to_code_R_I_R(enc, IC_MIPS_SW, R_RA, -(item_t)WORD_LENGTH, R_FP);
+	to_code_R_I(enc, IC_MIPS_LI, R_T0, LOW_DYN_BORDER);
+	to_code_R_I_R(enc, IC_MIPS_SW, R_T0, -(item_t)HEAP_DISPL - 60, R_GP);
+	uni_printf(enc->io, "\n");
+}
+
+// создаём метки всех строк в программе
+static void strings_declaration(encoder *const enc)
+{
+	to_code_directive(enc, ".rdata");
+	to_code_directive(enc, ".align 2");
+
+	const size_t amount = strings_amount(enc->sx);
+	for (size_t i = 0; i < amount; i++)
 	{
-		emit_array_declaration(enc, nd);
+		const label string_label = { .kind = L_STRING, .num = i };
+		emit_label_declaration(enc, &string_label);
+
+		const char *const string = string_get(enc->sx, i);
+		emit_code(enc, &(mips_code){ .format = FORMAT_ASCII, .symbol = string, .imm = (item_t)strlen(string) });
 	}
-	else
-	{
-		const lvalue variable = displacements_add(enc, identifier, false);
-		if (declaration_variable_has_initializer(nd))
-		{
-			const node initializer = declaration_variable_get_initializer(nd);
 
-			if (type_is_structure(enc->sx, type))
-			{
-				const rvalue tmp = emit_struct_assignment(enc, &variable, &initializer);
-				free_rvalue(enc, &tmp);
-			}
-			else
-			{
-				const rvalue value = emit_expression(enc, &initializer);
+	// Следующие за строками литералы li.s и таблицы переходов должны быть выровнены на слово
+	to_code_directive(enc, ".align 2");
+	to_code_directive(enc, ".text");
+	to_code_directive(enc, ".align 2");
+	uni_printf(enc->io, "\n");
+}
 
-				emit_store_of_rvalue(enc, &variable, &value);
-				free_rvalue(enc, &value);
-			}
-		}
-	}
+static void postgen(encoder *const enc)
+{
+	// FIXME: целиком runtime.s не вставить, т.к. не понятно, что делать с modetab
+	// По этой причине вставляю только defarr
+	uni_printf(enc->io, "\n\n# defarr\n");
+	uni_printf(enc->io, "# объявление одномерного массива\n");
+	uni_printf(enc->io, "# $a0 -- адрес первого элемента\n");
+	uni_printf(enc->io, "# $a1 -- размер измерения\n");
+	emit_code(enc, &(mips_code){ .format = FORMAT_LABEL, .symbol = "DEFARR1" });
+	uni_printf(enc->io, "\t# Сохранение границы\n");
+	to_code_R_I_R(enc, IC_MIPS_SW, R_A1, 4, R_A0);
+	uni_printf(enc->io, "\t# Подсчёт размера первого измерения массива в байтах\n");
+	to_code_R_I(enc, IC_MIPS_LI, R_V0, 4);
+	to_code_3R(enc, IC_MIPS_MUL, R_V0, R_V0, R_A1);
+	uni_printf(enc->io, "\t# Считаем адрес после конца массива, т.е. $v0 -- на слово ниже последнего элемента\n");
+	to_code_3R(enc, IC_MIPS_SUB, R_V0, R_A0, R_V0);
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_V0, R_V0, -4);
+	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+
+	uni_printf(enc->io, "\n# объявление многомерного массива, но сначала обязана вызываться процедура DEFARR1\n");
+	uni_printf(enc->io, "# $a0 -- адрес первого элемента\n");
+	uni_printf(enc->io, "# $a1 -- размер измерения\n");
+	uni_printf(enc->io, "# $a2 -- адрес первого элемента предыдущего измерения\n");
+	uni_printf(enc->io, "# $a3 -- размер предыдущего измерения\n");
+	emit_code(enc, &(mips_code){ .format = FORMAT_LABEL, .symbol = "DEFARR2" });
+	uni_printf(enc->io, "\t# Сохраняем адрес в элементе предыдущего измерения\n");
+	to_code_R_I_R(enc, IC_MIPS_SW, R_A0, 0, R_A2);
+	uni_printf(enc->io, "\t# Выделение памяти под массив, $ra сохраняется в $t0\n");
+	to_code_2R(enc, IC_MIPS_MOVE, R_T0, R_RA);
+	to_code_S(enc, IC_MIPS_JAL, "DEFARR1");
+	to_code_2R(enc, IC_MIPS_MOVE, R_RA, R_T0);
+	uni_printf(enc->io, "\t# В $a2 следующий элемент в предыдущем измерении\n");
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_A2, R_A2, -4);
+	uni_printf(enc->io, "\t# В $a0 первый элемент массива в текущем измерении, плюс выделяется место под размеры\n");
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_A0, R_V0, -4);
+	uni_printf(enc->io, "\t# Уменьшаем счётчик и прыгаем, если ещё не всё выделили\n");
+	to_code_2R_I(enc, IC_MIPS_ADDI, R_A3, R_A3, -1);
+	emit_code(enc, &(mips_code){ .format = FORMAT_2R_L, .instruction = IC_MIPS_BNE, .fst_reg = R_A3
+		, .snd_reg = R_ZERO, .symbol = "DEFARR2" });
+	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+
+	uni_printf(enc->io, "\n\n\t.end\tmain\n");
+	uni_printf(enc->io, "\t.size\tmain, .-main\n");
 }
 
+
 /**
- *	Emit function definition
+ *	Store value in little-endian byte order
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	buffer				Output buffer
+ *	@param	value				Stored value
+ *	@param	width				Number of bytes
  */
-static void emit_function_definition(encoder *const enc, const node *const nd)
+static inline void store_little_endian(uint8_t *const buffer, const uint64_t value, const size_t width)
 {
-	const size_t ref_ident = declaration_function_get_id(nd);
-	const label func_label = { .kind = L_FUNC, .num = ref_ident };
-	emit_label_declaration(enc, &func_label);
-
-	const item_t func_type = ident_get_type(enc->sx, ref_ident);
-	const size_t parameters = type_function_get_parameter_amount(enc->sx, func_type);
-
-	if (ref_ident == enc->sx->ref_main)
+	for (size_t i = 0; i < width; i++)
 	{
-		// FIXME: пока тут будут две метки для функции main
-		uni_printf(enc->sx->io, "MAIN:\n");
+		buffer[i] = (uint8_t)(value >> (8 * i));
 	}
+}
 
-	uni_printf(enc->sx->io, "\t# \"%s\" function:\n", ident_get_spelling(enc->sx, ref_ident));
-
-	enc->curr_function_ident = ref_ident;
-	enc->max_displ = 0;
-	enc->scope_displ = 0;
-
-	// Сохранение оберегаемых регистров перед началом работы функции
-	// FIXME: избавиться от функций to_code
-	uni_printf(enc->sx->io, "\n\t# preserved registers:\n");
-	to_code_R_I_R(enc->sx->io, IC_MIPS_SW, R_RA, -(item_t)RA_SIZE, R_SP);
-	to_code_R_I_R(enc->sx->io, IC_MIPS_SW, R_FP, -(item_t)(RA_SIZE + SP_SIZE), R_SP);
+/**
+ *	Get key of label in hash table of symbols
+ *
+ *	@param	lbl					Label
+ *
+ *	@return	Key of label
+ */
+static item_t object_label_key(const label *const lbl)
+{
+	// Вид метки занимает младшие разряды ключа
+	return (item_t)(lbl->num * (L_ARRAY + 1) + lbl->kind);
+}
 
-	// Сохранение s0-s7
-	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+/**
+ *	Get index of symbol, which stands for section.
+ *	Symbols of .text and .rodata are added first, symbol of .data is added on its first directive
+ *
+ *	@param	obj					Object file
+ *	@param	section				Section
+ *
+ *	@return	Index of symbol, @c SIZE_MAX if there is no such symbol
+ */
+static size_t object_section_symbol(const object *const obj, const object_section_t section)
+{
+	for (size_t i = 0; i < obj->symbols_size; i++)
 	{
-		to_code_R_I_R(enc->sx->io, IC_MIPS_SW, R_S0 + i, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH), R_SP);
+		if (obj->symbols[i].is_section && obj->symbols[i].section == section)
+		{
+			return i;
+		}
 	}
 
-	uni_printf(enc->sx->io, "\n");
+	return SIZE_MAX;
+}
 
-	// Сохранение fs0-fs10 (в цикле 5, т.к. операции одинарной точности => нужны только четные регистры)
-	for (size_t i = 0; i < PRESERVED_FP_REG_AMOUNT / 2; i++)
+/**
+ *	Find symbol of label operand
+ *
+ *	@param	obj					Object file
+ *	@param	code				Record with label or named symbol
+ *
+ *	@return	Index of symbol, @c SIZE_MAX if there is no such symbol
+ */
+static size_t object_find_symbol(const object *const obj, const mips_code *const code)
+{
+	if (code->symbol == NULL)
 	{
-		to_code_R_I_R(enc->sx->io, IC_MIPS_S_S, R_FS0 + 2 * i
-			, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH + PRESERVED_REG_AMOUNT * WORD_LENGTH /* за $s0-$s7 */)
-			, R_SP);
+		const size_t index = hash_get_index(&obj->labels, object_label_key(&code->lbl));
+		return index == SIZE_MAX ? SIZE_MAX : (size_t)hash_get_by_index(&obj->labels, index, 0);
 	}
 
-	// Выравнивание смещения на 8
-	if (enc->max_displ % 8)
+	for (size_t i = 0; i < obj->symbols_size; i++)
 	{
-		const size_t padding = 8 - (enc->max_displ % 8);
-		enc->max_displ += padding;
-		if (padding)
+		if (obj->symbols[i].name != NULL && strcmp(obj->symbols[i].name, code->symbol) == 0)
 		{
-			uni_printf(enc->sx->io, "\n\t# padding -- max displacement == %zu\n", enc->max_displ);
+			return i;
 		}
 	}
 
-	// Создание буфера для тела функции
-	universal_io *const old_io = enc->sx->io;
-	universal_io new_io = io_create();
-	out_set_buffer(&new_io, BUFFER_SIZE);
-	enc->sx->io = &new_io;
+	return SIZE_MAX;
+}
 
-	uni_printf(enc->sx->io, "\n\t# function parameters:\n");
+/**
+ *	Add symbol to object file
+ *
+ *	@param	obj					Object file
+ *	@param	symbol				Symbol
+ *
+ *	@return	Index of symbol, @c SIZE_MAX on failure
+ */
+static size_t object_add_symbol(object *const obj, const object_symbol *const symbol)
+{
+	if (obj->symbols_size == obj->symbols_capacity)
+	{
+		const size_t capacity = obj->symbols_capacity == 0 ? CODE_SIZE : 2 * obj->symbols_capacity;
+		object_symbol *const symbols = realloc(obj->symbols, capacity * sizeof(object_symbol));
+		if (symbols == NULL)
+		{
+			obj->has_error = true;
+			return SIZE_MAX;
+		}
 
-	size_t register_arguments_amount = 0;
-	size_t floating_register_arguments_amount = 0;
+		obj->symbols = symbols;
+		obj->symbols_capacity = capacity;
+	}
 
-	for (size_t i = 0; i < parameters; i++)
+	const size_t index = obj->symbols_size++;
+	obj->symbols[index] = *symbol;
+
+	if (!symbol->is_section && symbol->name == NULL)
 	{
-		const size_t id = declaration_function_get_parameter(nd, i);
-		uni_printf(enc->sx->io, "\t# parameter \"%s\" ", ident_get_spelling(enc->sx, id));
+		const size_t record = hash_add(&obj->labels, object_label_key(&symbol->lbl), 1);
+		hash_set_by_index(&obj->labels, record, 0, (item_t)index);
+	}
 
-		const bool argument_is_float = type_is_floating(enc->sx, ident_get_type(enc->sx, id));
+	return index;
+}
 
-		const bool argument_is_register = !argument_is_float 
-			? register_arguments_amount < ARG_REG_AMOUNT 
-			: floating_register_arguments_amount < ARG_REG_AMOUNT / 2;
+/**
+ *	Get contents of current section
+ *
+ *	@param	obj					Object file
+ *
+ *	@return	Section contents
+ */
+static object_data *object_get_data(object *const obj)
+{
+	switch (obj->section)
+	{
+		case SECTION_TEXT:
+			return &obj->text;
+		case SECTION_DATA:
+			return &obj->data;
+		default:
+			return &obj->rodata;
+	}
+}
 
-		if (argument_is_register)
+/**
+ *	Append bytes to current section
+ *
+ *	@param	obj					Object file
+ *	@param	bytes				Bytes
+ *	@param	size				Number of bytes
+ */
+static void object_put(object *const obj, const void *const bytes, const size_t size)
+{
+	object_data *const data = object_get_data(obj);
+	if (data->size + size > data->capacity)
+	{
+		size_t capacity = data->capacity == 0 ? BUFFER_SIZE : data->capacity;
+		while (data->size + size > capacity)
 		{
-			// Рассматриваем их как регистровые переменные
-			const item_t type = ident_get_type(enc->sx, id);
-			const mips_register_t curr_reg = argument_is_float 
-				? R_FA0 + 2 * floating_register_arguments_amount++
-				: R_A0 + register_arguments_amount++;
-			uni_printf(enc->sx->io, "is in register ");
-			mips_register_to_io(enc->sx->io, curr_reg);
-			uni_printf(enc->sx->io, "\n");
-
-			// Вносим переменную в таблицу символов
-			const lvalue value = {.kind = LVALUE_KIND_REGISTER, .type = type, .loc.reg_num = curr_reg, .base_reg = R_FP };
-			displacements_set(enc, id, &value);
+			capacity *= 2;
 		}
-		else
-		{
-			const item_t type = ident_get_type(enc->sx, id);
-			const size_t displ = i * WORD_LENGTH + FUNC_DISPL_PRESEREVED + WORD_LENGTH;
-			uni_printf(enc->sx->io, "is on stack at offset %zu from $fp\n", displ);
 
-			const lvalue value = {.kind = LVALUE_KIND_STACK, .type = type, .loc.displ = displ, .base_reg = R_FP };
-			displacements_set(enc, id, &value);
+		uint8_t *const new_bytes = realloc(data->bytes, capacity);
+		if (new_bytes == NULL)
+		{
+			obj->has_error = true;
+			return;
 		}
-	}
-
-	uni_printf(enc->sx->io, "\n\t# function body:\n");
-	node body = declaration_function_get_body(nd);
-	emit_statement(enc, &body);
 
-	// Извлечение буфера с телом функции в старый io
-	char *buffer = out_extract_buffer(enc->sx->io);
-	enc->sx->io = old_io;
+		data->bytes = new_bytes;
+		data->capacity = capacity;
+	}
 
-	uni_printf(enc->sx->io, "\n\t# setting up $fp:\n");
-	// $fp указывает на конец статики (которое в данный момент равно концу динамики)
-	to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_FP, R_SP, -(item_t)(FUNC_DISPL_PRESEREVED + WORD_LENGTH));
+	memcpy(&data->bytes[data->size], bytes, size);
+	data->size += size;
+}
 
-	uni_printf(enc->sx->io, "\n\t# setting up $sp:\n");
-	// $sp указывает на конец динамики (которое в данный момент равно концу статики)
-	// Смещаем $sp ниже конца статики (чтобы он не совпадал с $fp)
-	to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_SP, R_FP, -(item_t)(WORD_LENGTH + enc->max_displ));
+/**
+ *	Append word to current section
+ *
+ *	@param	obj					Object file
+ *	@param	word				Word
+ */
+static void object_put_word(object *const obj, const uint32_t word)
+{
+	uint8_t bytes[4];
+	store_little_endian(bytes, word, sizeof(bytes));
+	object_put(obj, bytes, sizeof(bytes));
+}
 
-	uni_printf(enc->sx->io, "%s", buffer);
-	free(buffer);
+// Вид инструкции:	op rs, rt, rd, sa, funct
+static void object_put_r(object *const obj, const mips_opcode_t opcode, const uint32_t rs, const uint32_t rt
+	, const uint32_t rd, const uint32_t sa, const mips_function_t function)
+{
+	object_put_word(obj, (uint32_t)opcode << 26 | rs << 21 | rt << 16 | rd << 11 | (sa & 0x1f) << 6 | function);
+}
 
-	const label end_label = { .kind = L_FUNCEND, .num = ref_ident };
-	emit_label_declaration(enc, &end_label);
+// Вид инструкции:	op rs, rt, imm
+static void object_put_i(object *const obj, const mips_opcode_t opcode, const uint32_t rs, const uint32_t rt
+	, const uint32_t imm)
+{
+	object_put_word(obj, (uint32_t)opcode << 26 | rs << 21 | rt << 16 | (imm & 0xffff));
+}
 
-	// Восстановление стека после работы функции
-	uni_printf(enc->sx->io, "\n\t# data restoring:\n");
+// Вид инструкции:	cop1 fmt, ft, fs, fd, funct
+static void object_put_cop1(object *const obj, const mips_cop1_format_t format, const uint32_t ft
+	, const uint32_t fs, const uint32_t fd, const mips_function_t function)
+{
+	object_put_word(obj, (uint32_t)OP_COP1 << 26 | (uint32_t)format << 21 | ft << 16 | fs << 11 | fd << 6 | function);
+}
 
-	// Ставим $fp на его положение в предыдущей функции
-	to_code_2R_I(enc->sx->io, IC_MIPS_ADDI, R_SP, R_FP, (item_t)(FUNC_DISPL_PRESEREVED + WORD_LENGTH));
+/**
+ *	Get number of general purpose register
+ *
+ *	@param	obj					Object file
+ *	@param	reg					Register
+ *
+ *	@return	Register number
+ */
+static uint32_t object_gpr(object *const obj, const mips_register_t reg)
+{
+	if (reg >= R_FV0)
+	{
+		obj->has_error = true;
+		return 0;
+	}
 
-	uni_printf(enc->sx->io, "\n");
+	return (uint32_t)reg;
+}
 
-	// Восстановление $s0-$s7
-	for (size_t i = 0; i < PRESERVED_REG_AMOUNT; i++)
+/**
+ *	Get number of floating point register
+ *
+ *	@param	obj					Object file
+ *	@param	reg					Register
+ *
+ *	@return	Register number
+ */
+static uint32_t object_fpr(object *const obj, const mips_register_t reg)
+{
+	if (reg < R_FV0)
 	{
-		to_code_R_I_R(enc->sx->io, IC_MIPS_LW, R_S0 + i, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH), R_SP);
+		obj->has_error = true;
+		return 0;
 	}
 
-	uni_printf(enc->sx->io, "\n");
+	// Нумерация как в mips_register_to_io
+	if (reg < R_FA0)
+	{
+		return (uint32_t)(reg - R_FV0);
+	}
+	if (reg < R_FT0)
+	{
+		return (uint32_t)(reg - R_FA0) + 12;
+	}
+	if (reg < R_FT8)
+	{
+		return (uint32_t)(reg - R_FT0) + 4;
+	}
+	if (reg < R_FS0)
+	{
+		return (uint32_t)(reg - R_FT8) + 16;
+	}
+	return (uint32_t)(reg - R_FS0) + 20;
+}
 
-	// Восстановление $fs0-$fs7
-	for (size_t i = 0; i < PRESERVED_FP_REG_AMOUNT / 2; i++)
+/**
+ *	Add relocation at current position of current section
+ *
+ *	@param	obj					Object file
+ *	@param	symbol				Index of symbol
+ *	@param	type				Relocation type
+ */
+static void object_relocate(object *const obj, const size_t symbol, const mips_relocation_t type)
+{
+	if (obj->is_final)
 	{
-		to_code_R_I_R(enc->sx->io, IC_MIPS_L_S, R_FS0 + 2 * i
-			, -(item_t)(RA_SIZE + SP_SIZE + (i + 1) * WORD_LENGTH + /* за s0-s7 */ 8 * WORD_LENGTH), R_SP);
+		object_data *const data = object_get_data(obj);
+		vector_add(&data->relocations, (item_t)data->size);
+		vector_add(&data->relocations, (item_t)symbol);
+		vector_add(&data->relocations, type);
 	}
+}
 
-	uni_printf(enc->sx->io, "\n");
+/**
+ *	Add relocation by label operand at current position of current section.
+ *	Local labels are relocated against symbol of their section with addend in relocated field
+ *
+ *	@param	obj					Object file
+ *	@param	code				Record with label operand
+ *	@param	type				Relocation type
+ *
+ *	@return	Addend of relocation
+ */
+static uint32_t object_reference(object *const obj, const mips_code *const code, const mips_relocation_t type)
+{
+	if (!obj->is_final)
+	{
+		return 0;
+	}
 
-	// Возвращаем $sp его положение в предыдущей функции
-	to_code_R_I_R(enc->sx->io, IC_MIPS_LW, R_FP, -(item_t)(RA_SIZE + SP_SIZE), R_SP);
+	size_t index = object_find_symbol(obj, code);
+	if (index == SIZE_MAX)
+	{
+		// Неопределённая метка -- внешний символ, её разрешает компоновщик
+		index = object_add_symbol(obj, &(object_symbol){ .lbl = code->lbl, .name = code->symbol
+			, .section = SECTION_UNDEFINED, .is_global = true });
+		if (index == SIZE_MAX)
+		{
+			return 0;
+		}
+	}
 
-	to_code_R_I_R(enc->sx->io, IC_MIPS_LW, R_RA, -(item_t)(RA_SIZE), R_SP);
+	const object_symbol *const symbol = &obj->symbols[index];
+	if (symbol->is_global)
+	{
+		object_relocate(obj, index, type);
+		return 0;
+	}
 
-	// Прыгаем далее
-	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+	object_relocate(obj, object_section_symbol(obj, symbol->section), type);
+	return (uint32_t)symbol->value;
 }
 
-static void emit_declaration(encoder *const enc, const node *const nd)
+/**
+ *	Get offset field of branch to label operand
+ *
+ *	@param	obj					Object file
+ *	@param	code				Branch
+ *
+ *	@return	Offset field
+ */
+static uint32_t object_branch_offset(object *const obj, const mips_code *const code)
 {
-	switch (declaration_get_class(nd))
+	if (!obj->is_final)
 	{
-		case DECL_VAR:
-			emit_variable_declaration(enc, nd);
-			break;
+		return 0;
+	}
 
-		case DECL_FUNC:
-			emit_function_definition(enc, nd);
-			break;
+	const size_t index = object_find_symbol(obj, code);
+	if (index != SIZE_MAX && !obj->symbols[index].is_global && obj->symbols[index].section == obj->section)
+	{
+		// Смещение отсчитывается от слота задержки
+		const int64_t displ = (int64_t)obj->symbols[index].value - (int64_t)(object_get_data(obj)->size + 4);
+		if (displ < 4 * MIN_IMMEDIATE || displ > 4 * MAX_IMMEDIATE)
+		{
+			obj->has_error = true;
+		}
 
-		default:
-			// С объявлением типа ничего делать не нужно
-			return;
+		return (uint32_t)(displ / 4) & 0xffff;
 	}
 
-	uni_printf(enc->sx->io, "\n");
+	object_reference(obj, code, R_MIPS_PC16);
+	return 0xffff;
 }
 
-
-/*
- *	 ______     ______   ______     ______   ______     __    __     ______     __   __     ______   ______
- *	/\  ___\   /\__  _\ /\  __ \   /\__  _\ /\  ___\   /\ "-./  \   /\  ___\   /\ "-.\ \   /\__  _\ /\  ___\
- *	\ \___  \  \/_/\ \/ \ \  __ \  \/_/\ \/ \ \  __\   \ \ \-./\ \  \ \  __\   \ \ \-.  \  \/_/\ \/ \ \___  \
- *	 \/\_____\    \ \_\  \ \_\ \_\    \ \_\  \ \_____\  \ \_\ \ \_\  \ \_____\  \ \_\\"\_\    \ \_\  \/\_____\
- *	  \/_____/     \/_/   \/_/\/_/     \/_/   \/_____/   \/_/  \/_/   \/_____/   \/_/ \/_/     \/_/   \/_____/
- */
-
-
 /**
- *	Emit declaration statement
+ *	Load constant into register, as li pseudo-instruction
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	reg					Register number
+ *	@param	value				Constant
  */
-static void emit_declaration_statement(encoder *const enc, const node *const nd)
+static void object_put_li(object *const obj, const uint32_t reg, const item_t value)
 {
-	const size_t size = statement_declaration_get_size(nd);
-	for (size_t i = 0; i < size; i++)
+	if (value >= MIN_IMMEDIATE && value <= MAX_IMMEDIATE)
 	{
-		const node decl = statement_declaration_get_declarator(nd, i);
-		emit_declaration(enc, &decl);
+		object_put_i(obj, OP_ADDIU, R_ZERO, reg, (uint32_t)value);
+	}
+	else if (value >= 0 && value <= 2 * MAX_IMMEDIATE + 1)
+	{
+		object_put_i(obj, OP_ORI, R_ZERO, reg, (uint32_t)value);
+	}
+	else if (value >= INT32_MIN && value <= UINT32_MAX)
+	{
+		object_put_i(obj, OP_LUI, R_ZERO, reg, (uint32_t)value >> 16);
+		if (value & 0xffff)
+		{
+			object_put_i(obj, OP_ORI, reg, reg, (uint32_t)value);
+		}
+	}
+	else
+	{
+		obj->has_error = true;
 	}
 }
 
 /**
- *	Emit case statement
+ *	Get high part of address, which is added to sign-extended low part
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	value				Address
+ *
+ *	@return	High part
  */
-static void emit_case_statement(encoder *const enc, const node *const nd, const size_t label_num)
+static uint32_t object_high(const item_t value)
 {
-	const label label_case = { .kind = L_CASE, .num = label_num };
-	emit_label_declaration(enc, &label_case);
-
-	const node substmt = statement_case_get_substmt(nd);
-	emit_statement(enc, &substmt);
+	return (uint32_t)((value + 0x8000) >> 16) & 0xffff;
 }
 
 /**
- *	Emit default statement
+ *	Encode instruction with two registers
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_default_statement(encoder *const enc, const node *const nd, const size_t label_num)
+static void object_emit_2R(object *const obj, const mips_code *const code)
 {
-	const label label_default = { .kind = L_CASE, .num = label_num };
-	emit_label_declaration(enc, &label_default);
+	switch (code->instruction)
+	{
+		case IC_MIPS_MOVE:
+			object_put_r(obj, OP_SPECIAL, object_gpr(obj, code->snd_reg), R_ZERO, object_gpr(obj, code->fst_reg)
+				, 0, FN_OR);
+			return;
+		case IC_MIPS_NOT:
+			object_put_r(obj, OP_SPECIAL, object_gpr(obj, code->snd_reg), R_ZERO, object_gpr(obj, code->fst_reg)
+				, 0, FN_NOR);
+			return;
+		case IC_MIPS_ABS:
+		{
+			// bgez rs, 1f; move rd, rs; neg rd, rs; 1:
+			const uint32_t rd = object_gpr(obj, code->fst_reg);
+			const uint32_t rs = object_gpr(obj, code->snd_reg);
+			object_put_i(obj, OP_REGIMM, rs, 1, 2);
+			if (rd == rs)
+			{
+				object_put_word(obj, 0);
+			}
+			else
+			{
+				object_put_r(obj, OP_SPECIAL, rs, R_ZERO, rd, 0, FN_ADDU);
+			}
+			object_put_r(obj, OP_SPECIAL, R_ZERO, rs, rd, 0, FN_SUB);
+			return;
+		}
 
-	const node substmt = statement_default_get_substmt(nd);
-	emit_statement(enc, &substmt);
+		case IC_MIPS_MOV_S:
+			object_put_cop1(obj, FMT_S, 0, object_fpr(obj, code->snd_reg), object_fpr(obj, code->fst_reg), FN_MOV_FMT);
+			return;
+		case IC_MIPS_ABS_S:
+			object_put_cop1(obj, FMT_S, 0, object_fpr(obj, code->snd_reg), object_fpr(obj, code->fst_reg), FN_ABS_FMT);
+			return;
+		case IC_MIPS_CVT_D_S:
+			object_put_cop1(obj, FMT_S, 0, object_fpr(obj, code->snd_reg), object_fpr(obj, code->fst_reg), FN_CVT_D);
+			return;
+		case IC_MIPS_CVT_W_S:
+			object_put_cop1(obj, FMT_S, 0, object_fpr(obj, code->snd_reg), object_fpr(obj, code->fst_reg), FN_CVT_W);
+			return;
+		case IC_MIPS_CVT_S_W:
+			object_put_cop1(obj, FMT_W, 0, object_fpr(obj, code->snd_reg), object_fpr(obj, code->fst_reg), FN_CVT_S);
+			return;
+
+		case IC_MIPS_MFC_1:
+			object_put_cop1(obj, FMT_MF, object_gpr(obj, code->fst_reg), object_fpr(obj, code->snd_reg), 0, 0);
+			return;
+		case IC_MIPS_MFHC_1:
+			object_put_cop1(obj, FMT_MFH, object_gpr(obj, code->fst_reg), object_fpr(obj, code->snd_reg), 0, 0);
+			return;
+
+		default:
+			obj->has_error = true;
+			return;
+	}
 }
 
 /**
- *	Emit compound statement
+ *	Encode instruction with three registers
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_compound_statement(encoder *const enc, const node *const nd)
+static void object_emit_3R(object *const obj, const mips_code *const code)
 {
-	const size_t scope_displacement = enc->scope_displ;
+	mips_function_t function = FN_ADD;
+	switch (code->instruction)
+	{
+		case IC_MIPS_ADD_S:
+		case IC_MIPS_SUB_S:
+		case IC_MIPS_MUL_S:
+		case IC_MIPS_DIV_S:
+			function = code->instruction == IC_MIPS_ADD_S ? FN_ADD_FMT
+				: code->instruction == IC_MIPS_SUB_S ? FN_SUB_FMT
+				: code->instruction == IC_MIPS_MUL_S ? FN_MUL_FMT
+				: FN_DIV_FMT;
+			object_put_cop1(obj, FMT_S, object_fpr(obj, code->thd_reg), object_fpr(obj, code->snd_reg)
+				, object_fpr(obj, code->fst_reg), function);
+			return;
+
+		case IC_MIPS_SLLV:
+		case IC_MIPS_SRAV:
+			// Сдвигаемое значение в поле rt, величина сдвига в поле rs
+			object_put_r(obj, OP_SPECIAL, object_gpr(obj, code->thd_reg), object_gpr(obj, code->snd_reg)
+				, object_gpr(obj, code->fst_reg), 0, code->instruction == IC_MIPS_SLLV ? FN_SLLV : FN_SRAV);
+			return;
+
+		case IC_MIPS_MUL:
+			object_put_r(obj, OP_SPECIAL2, object_gpr(obj, code->snd_reg), object_gpr(obj, code->thd_reg)
+				, object_gpr(obj, code->fst_reg), 0, FN_MUL);
+			return;
+
+		case IC_MIPS_DIV:
+		{
+			const uint32_t rd = object_gpr(obj, code->fst_reg);
+			const uint32_t rs = object_gpr(obj, code->snd_reg);
+			const uint32_t rt = object_gpr(obj, code->thd_reg);
+			if (rt == R_ZERO)
+			{
+				object_put_r(obj, OP_SPECIAL, 0, 7, 0, 0, FN_BREAK);
+				return;
+			}
+
+			// Как у ассемблера: ловушки при делении на ноль и при переполнении
+			object_put_i(obj, OP_BNE, rt, R_ZERO, 2);
+			object_put_r(obj, OP_SPECIAL, rs, rt, R_ZERO, 0, FN_DIV);
+			object_put_r(obj, OP_SPECIAL, 0, 7, 0, 0, FN_BREAK);
+			object_put_i(obj, OP_ADDIU, R_ZERO, R_AT, (uint32_t)-1);
+			object_put_i(obj, OP_BNE, rt, R_AT, 4);
+			object_put_i(obj, OP_LUI, R_ZERO, R_AT, 0x8000);
+			object_put_i(obj, OP_BNE, rs, R_AT, 2);
+			object_put_word(obj, 0);
+			object_put_r(obj, OP_SPECIAL, 0, 6, 0, 0, FN_BREAK);
+			object_put_r(obj, OP_SPECIAL, R_ZERO, R_ZERO, rd, 0, FN_MFLO);
+			return;
+		}
+
+		case IC_MIPS_ADD:
+			function = FN_ADD;
+			break;
+		case IC_MIPS_SUB:
+			function = FN_SUB;
+			break;
+		case IC_MIPS_ADDU:
+			function = FN_ADDU;
+			break;
+		case IC_MIPS_SUBU:
+			function = FN_SUBU;
+			break;
+		case IC_MIPS_AND:
+			function = FN_AND;
+			break;
+		case IC_MIPS_OR:
+			function = FN_OR;
+			break;
+		case IC_MIPS_XOR:
+			function = FN_XOR;
+			break;
+		case IC_MIPS_SLT:
+			function = FN_SLT;
+			break;
+		case IC_MIPS_SLTU:
+			function = FN_SLTU;
+			break;
 
-	const size_t size = statement_compound_get_size(nd);
-	for (size_t i = 0; i < size; i++)
-	{
-		const node substmt = statement_compound_get_substmt(nd, i);
-		emit_statement(enc, &substmt);
+		default:
+			// В том числе mod, которой нет в MIPS32
+			obj->has_error = true;
+			return;
 	}
 
-	enc->max_displ = max(enc->scope_displ, enc->max_displ);
-	enc->scope_displ = scope_displacement;
+	object_put_r(obj, OP_SPECIAL, object_gpr(obj, code->snd_reg), object_gpr(obj, code->thd_reg)
+		, object_gpr(obj, code->fst_reg), 0, function);
 }
 
 /**
- *	Emit if statement
+ *	Encode instruction with two registers and immediate
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_if_statement(encoder *const enc, const node *const nd)
+static void object_emit_2R_I(object *const obj, const mips_code *const code)
 {
-	const node condition = statement_if_get_condition(nd);
-	const rvalue value = emit_expression(enc, &condition);
+	const uint32_t rt = object_gpr(obj, code->fst_reg);
+	const uint32_t rs = object_gpr(obj, code->snd_reg);
+	const item_t imm = code->instruction == IC_MIPS_SUB ? -code->imm : code->imm;
 
-	const size_t label_num = enc->label_num++;
-	const label label_else = { .kind = L_ELSE, .num = label_num };
-	const label label_end = { .kind = L_END, .num = label_num };
+	switch (code->instruction)
+	{
+		case IC_MIPS_ADD:
+		case IC_MIPS_SUB:
+		case IC_MIPS_ADDI:
+		case IC_MIPS_ADDIU:
+			// Ассемблер принимает и беззнаковые 16-битные значения
+			if (imm < MIN_IMMEDIATE || imm > 2 * MAX_IMMEDIATE + 1)
+			{
+				obj->has_error = true;
+			}
+			object_put_i(obj, code->instruction == IC_MIPS_ADDIU ? OP_ADDIU : OP_ADDI, rs, rt, (uint32_t)imm);
+			return;
 
-	const bool has_else = statement_if_has_else_substmt(nd);
-	const mips_instruction_t instruction = IC_MIPS_BEQ;
-	emit_conditional_branch(enc, instruction, &value, has_else ? &label_else : &label_end);
-	free_rvalue(enc, &value);
+		case IC_MIPS_SLTI:
+		case IC_MIPS_SLTIU:
+			if (imm < MIN_IMMEDIATE || imm > MAX_IMMEDIATE)
+			{
+				obj->has_error = true;
+			}
+			object_put_i(obj, code->instruction == IC_MIPS_SLTI ? OP_SLTI : OP_SLTIU, rs, rt, (uint32_t)imm);
+			return;
 
-	const node then_substmt = statement_if_get_then_substmt(nd);
-	emit_statement(enc, &then_substmt);
+		case IC_MIPS_ANDI:
+		case IC_MIPS_ORI:
+		case IC_MIPS_XORI:
+			if (imm < 0 || imm > 2 * MAX_IMMEDIATE + 1)
+			{
+				obj->has_error = true;
+			}
+			object_put_i(obj, code->instruction == IC_MIPS_ANDI ? OP_ANDI
+				: code->instruction == IC_MIPS_ORI ? OP_ORI : OP_XORI, rs, rt, (uint32_t)imm);
+			return;
 
-	if (has_else)
-	{
-		emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
-		emit_label_declaration(enc, &label_else);
+		case IC_MIPS_SLL:
+		case IC_MIPS_SRA:
+			if (imm < 0 || imm > 31)
+			{
+				obj->has_error = true;
+			}
+			object_put_r(obj, OP_SPECIAL, R_ZERO, rs, rt, (uint32_t)imm, code->instruction == IC_MIPS_SLL ? FN_SLL : FN_SRA);
+			return;
 
-		const node else_substmt = statement_if_get_else_substmt(nd);
-		emit_statement(enc, &else_substmt);
-	}
+		case IC_MIPS_MUL:
+			object_put_li(obj, R_AT, imm);
+			object_put_r(obj, OP_SPECIAL, rs, R_AT, R_ZERO, 0, FN_MULT);
+			object_put_r(obj, OP_SPECIAL, R_ZERO, R_ZERO, rt, 0, FN_MFLO);
+			return;
 
-	emit_label_declaration(enc, &label_end);
+		default:
+			obj->has_error = true;
+			return;
+	}
 }
 
 /**
- *	Emit switch statement
+ *	Encode load or store
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_switch_statement(encoder *const enc, const node *const nd)
+static void object_emit_memory(object *const obj, const mips_code *const code)
 {
-	const size_t label_num = enc->label_num++;
-	size_t curr_case_label_num = enc->case_label_num;
-
-	const label old_label_break = enc->label_break;
-	enc->label_break = (label){ .kind = L_END, .num = label_num };
-
-	const node condition = statement_switch_get_condition(nd);
-	const rvalue tmp_condtion = emit_expression(enc, &condition);
-	const rvalue condition_rvalue = (tmp_condtion.kind == RVALUE_KIND_CONST)
-		? emit_load_of_immediate(enc, &tmp_condtion)
-		: tmp_condtion;
-
-	item_t default_index = -1;
-
-	// Размещение меток согласно условиям
-	const node body = statement_switch_get_body(nd);
-	const size_t amount = statement_compound_get_size(&body);	// Гарантируется compound statement
-	for (size_t i = 0; i < amount; i++)
+	const bool is_floating = code->instruction == IC_MIPS_L_S || code->instruction == IC_MIPS_S_S;
+	const mips_opcode_t opcode = code->instruction == IC_MIPS_LW ? OP_LW
+		: code->instruction == IC_MIPS_SW ? OP_SW
+		: code->instruction == IC_MIPS_L_S ? OP_LWC1
+		: OP_SWC1;
+	if (!is_floating && code->instruction != IC_MIPS_LW && code->instruction != IC_MIPS_SW)
 	{
-		const node substmt = statement_compound_get_substmt(&body, i);
-		const item_t substmt_class = statement_get_class(&substmt);
-
-		if (substmt_class == STMT_CASE)
-		{
-			const size_t case_num = enc->case_label_num++;
-			const label label_case = { .kind = L_CASE, .num = case_num };
-
-			const node case_expr = statement_case_get_expression(&substmt);
-			const rvalue case_expr_rvalue = emit_literal_expression(enc, &case_expr);
-
-			// Пользуемся тем, что это integer type
-			const rvalue result_rvalue = {
-				.from_lvalue = !FROM_LVALUE,
-				.kind = RVALUE_KIND_REGISTER,
-				.val.reg_num = get_register(enc),
-				.type = TYPE_INTEGER
-			};
-			emit_binary_operation(enc, &result_rvalue, &condition_rvalue, &case_expr_rvalue, BIN_EQ);
-			emit_conditional_branch(enc, IC_MIPS_BEQ, &result_rvalue, &label_case);
-
-			free_rvalue(enc, &result_rvalue);
-		}
-		else if (substmt_class == STMT_DEFAULT)
-		{
-			// Только получаем индекс, а размещение прыжка по нужной метке будет после всех case'ов
-			default_index = enc->case_label_num++;
-		}
+		obj->has_error = true;
 	}
 
-	if (default_index != -1)
-	{
-		const label label_default = { .kind = L_CASE, .num = (size_t)default_index };
-		emit_unconditional_branch(enc, IC_MIPS_J, &label_default);
-	}
-	else
+	const uint32_t rt = is_floating ? object_fpr(obj, code->fst_reg) : object_gpr(obj, code->fst_reg);
+	const uint32_t base = object_gpr(obj, code->snd_reg);
+	const item_t imm = code->imm;
+
+	if (imm >= MIN_IMMEDIATE && imm <= MAX_IMMEDIATE)
 	{
-		// Нет default => можем попасть в ситуацию, когда требуется пропустить все case'ы
-		emit_unconditional_branch(enc, IC_MIPS_J, &enc->label_break);
+		object_put_i(obj, opcode, base, rt, (uint32_t)imm);
 	}
-
-	free_rvalue(enc, &condition_rvalue);
-
-	uni_printf(enc->sx->io, "\n");
-
-	// Размещение тел всех case и default statements
-	for (size_t i = 0; i < amount; i++)
+	else if (!is_floating && imm >= INT32_MIN && imm <= INT32_MAX)
 	{
-		const node substmt = statement_compound_get_substmt(&body, i);
-		const item_t substmt_class = statement_get_class(&substmt);
-
-		if (substmt_class == STMT_CASE)
-		{
-			emit_case_statement(enc, &substmt, curr_case_label_num++);
-		}
-		else if (substmt_class == STMT_DEFAULT)
-		{
-			emit_default_statement(enc, &substmt, curr_case_label_num++);
-		}
-		else
+		// Старшая часть смещения прибавляется к базе во вспомогательном регистре
+		const uint32_t temp = code->instruction == IC_MIPS_LW && rt != base ? rt : R_AT;
+		object_put_i(obj, OP_LUI, R_ZERO, temp, object_high(imm));
+		if (base != R_ZERO)
 		{
-			emit_statement(enc, &substmt);
+			object_put_r(obj, OP_SPECIAL, temp, base, temp, 0, FN_ADDU);
 		}
+		object_put_i(obj, opcode, temp, rt, (uint32_t)imm);
+	}
+	else
+	{
+		obj->has_error = true;
 	}
-
-	emit_label_declaration(enc, &enc->label_break);
-	enc->label_break = old_label_break;
 }
 
 /**
- *	Emit while statement
+ *	Get bits of single precision floating point constant
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	value				Constant
+ *
+ *	@return	Bits of constant
  */
-static void emit_while_statement(encoder *const enc, const node *const nd)
+static uint32_t object_float_bits(const double value)
 {
-	const size_t label_num = enc->label_num++;
-	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
-	const label label_end = { .kind = L_END, .num = label_num };
-
-	const label old_continue = enc->label_continue;
-	const label old_break = enc->label_break;
-
-	enc->label_continue = label_begin;
-	enc->label_break = label_end;
-
-	emit_label_declaration(enc, &label_begin);
-
-	const node condition = statement_while_get_condition(nd);
-	const rvalue value = emit_expression(enc, &condition);
-
-	const mips_instruction_t instruction = IC_MIPS_BEQ;
-	emit_conditional_branch(enc, instruction, &value, &label_end);
-	free_rvalue(enc, &value);
-
-	const node body = statement_while_get_body(nd);
-	emit_statement(enc, &body);
-
-	emit_unconditional_branch(enc, IC_MIPS_J, &label_begin);
-	emit_label_declaration(enc, &label_end);
-
-	enc->label_continue = old_continue;
-	enc->label_break = old_break;
+	// Значение берётся в том же виде, в каком оно записывается в текст ассемблера.
+	// Самое большое значение double в виде "%f" занимает 317 символов
+	char buffer[512];
+	snprintf(buffer, sizeof(buffer), "%f", value);
+	const float single = (float)strtod(buffer, NULL);
+	uint32_t bits = 0;
+	memcpy(&bits, &single, sizeof(bits));
+	return bits;
 }
 
 /**
- *	Emit do statement
+ *	Encode loading of floating point constant, as li.s pseudo-instruction
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_do_statement(encoder *const enc, const node *const nd)
+static void object_emit_float_immediate(object *const obj, const mips_code *const code)
 {
-	const size_t label_num = enc->label_num++;
-	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
-	emit_label_declaration(enc, &label_begin);
-
-	const label label_condition = { .kind = L_NEXT, .num = label_num };
-	const label label_end = { .kind = L_END, .num = label_num };
-
-	const label old_continue = enc->label_continue;
-	const label old_break = enc->label_break;
-	enc->label_continue = label_condition;
-	enc->label_break = label_end;
-
-	const node body = statement_do_get_body(nd);
-	emit_statement(enc, &body);
-	emit_label_declaration(enc, &label_condition);
-
-	const node condition = statement_do_get_condition(nd);
-	const rvalue value = emit_expression(enc, &condition);
-
-	const mips_instruction_t instruction = IC_MIPS_BNE;
-	emit_conditional_branch(enc, instruction, &value, &label_begin);
-	emit_label_declaration(enc, &label_end);
-	free_rvalue(enc, &value);
+	if (code->instruction != IC_MIPS_LI_S)
+	{
+		obj->has_error = true;
+		return;
+	}
 
-	enc->label_continue = old_continue;
-	enc->label_break = old_break;
+	const uint32_t bits = object_float_bits(code->float_imm);
+	const uint32_t fs = object_fpr(obj, code->fst_reg);
+	if (bits == 0)
+	{
+		object_put_cop1(obj, FMT_MT, R_ZERO, fs, 0, 0);
+	}
+	else if ((bits & 0xffff) == 0)
+	{
+		object_put_i(obj, OP_LUI, R_ZERO, R_AT, bits >> 16);
+		object_put_cop1(obj, FMT_MT, R_AT, fs, 0, 0);
+	}
+	else
+	{
+		// Константа помещается в конец .rodata
+		const object_section_t section = obj->section;
+		obj->section = SECTION_RODATA;
+		const size_t offset = obj->rodata.size;
+		object_put_word(obj, bits);
+		obj->section = section;
+
+		object_relocate(obj, object_section_symbol(obj, SECTION_RODATA), R_MIPS_HI16);
+		object_put_i(obj, OP_LUI, R_ZERO, R_AT, object_high((item_t)offset));
+		object_relocate(obj, object_section_symbol(obj, SECTION_RODATA), R_MIPS_LO16);
+		object_put_i(obj, OP_LWC1, R_AT, fs, (uint32_t)offset);
+	}
 }
 
 /**
- *	Emit for statement
+ *	Encode branch to label operand
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	code				Instruction
  */
-static void emit_for_statement(encoder *const enc, const node *const nd)
+static void object_emit_branch(object *const obj, const mips_code *const code)
 {
-	const size_t scope_displacement = enc->scope_displ;
-
-	if (statement_for_has_inition(nd))
+	const uint32_t rs = object_gpr(obj, code->fst_reg);
+	switch (code->instruction)
 	{
-		const node inition = statement_for_get_inition(nd);
-		emit_statement(enc, &inition);
+		case IC_MIPS_BEQ:
+		case IC_MIPS_BNE:
+		{
+			const uint32_t rt = object_gpr(obj, code->snd_reg);
+			object_put_i(obj, code->instruction == IC_MIPS_BEQ ? OP_BEQ : OP_BNE, rs, rt
+				, object_branch_offset(obj, code));
+			return;
+		}
+		case IC_MIPS_BLEZ:
+			object_put_i(obj, OP_BLEZ, rs, 0, object_branch_offset(obj, code));
+			return;
+		case IC_MIPS_BGTZ:
+			object_put_i(obj, OP_BGTZ, rs, 0, object_branch_offset(obj, code));
+			return;
+		case IC_MIPS_BLTZ:
+			object_put_i(obj, OP_REGIMM, rs, 0, object_branch_offset(obj, code));
+			return;
+		case IC_MIPS_BGEZ:
+			object_put_i(obj, OP_REGIMM, rs, 1, object_branch_offset(obj, code));
+			return;
+		default:
+			obj->has_error = true;
+			return;
 	}
+}
 
-	const size_t label_num = enc->label_num++;
-	const label label_begin = { .kind = L_BEGIN_CYCLE, .num = label_num };
-	const label label_end = { .kind = L_END, .num = label_num };
-
-	const label old_continue = enc->label_continue;
-	const label old_break = enc->label_break;
-	enc->label_continue = label_begin;
-	enc->label_break = label_end;
-
-	emit_label_declaration(enc, &label_begin);
-	if (statement_for_has_condition(nd))
+/**
+ *	Apply assembler directive
+ *
+ *	@param	obj					Object file
+ *	@param	directive			Directive
+ */
+static void object_emit_directive(object *const obj, const char *const directive)
+{
+	if (strcmp(directive, ".text") == 0)
+	{
+		obj->section = SECTION_TEXT;
+	}
+	else if (strcmp(directive, ".rdata") == 0)
+	{
+		obj->section = SECTION_RODATA;
+	}
+	else if (strcmp(directive, ".data") == 0)
+	{
+		obj->section = SECTION_DATA;
+		if (object_section_symbol(obj, SECTION_DATA) == SIZE_MAX)
+		{
+			object_add_symbol(obj, &(object_symbol){ .section = SECTION_DATA, .is_section = true });
+		}
+	}
+	else if (strcmp(directive, ".align 2") == 0)
+	{
+		while (object_get_data(obj)->size % WORD_LENGTH != 0 && !obj->has_error)
+		{
+			object_put(obj, "", 1);
+		}
+	}
+	else if (strcmp(directive, ".set\tnoreorder") == 0)
 	{
-		const node condition = statement_for_get_condition(nd);
-		const rvalue value = emit_expression(enc, &condition);
-		const mips_instruction_t instruction = IC_MIPS_BEQ;
-		emit_conditional_branch(enc, instruction, &value, &label_end);
-		free_rvalue(enc, &value);
+		obj->is_reordered = false;
+		obj->has_noreorder = true;
 	}
-
-	const node body = statement_for_get_body(nd);
-	emit_statement(enc, &body);
-
-	if (statement_for_has_increment(nd))
+	else if (strcmp(directive, ".set\treorder") == 0)
 	{
-		const node increment = statement_for_get_increment(nd);
-		emit_void_expression(enc, &increment);
+		obj->is_reordered = true;
+	}
+	else
+	{
+		obj->has_error = true;
 	}
-
-	emit_unconditional_branch(enc, IC_MIPS_J, &label_begin);
-	emit_label_declaration(enc, &label_end);
-
-	enc->label_continue = old_continue;
-	enc->label_break = old_break;
-
-	enc->scope_displ = scope_displacement;
 }
 
 /**
- *	Emit continue statement
+ *	Encode record into current section
  *
- *	@param	enc					Encoder
+ *	@param	obj					Object file
+ *	@param	code				Record
  */
-static void emit_continue_statement(encoder *const enc)
+static void object_emit_code(object *const obj, const mips_code *const code)
 {
-	emit_unconditional_branch(enc, IC_MIPS_J, &enc->label_continue);
+	switch (code->format)
+	{
+		case FORMAT_LABEL:
+			if (!obj->is_final)
+			{
+				// Глобальна только точка входа, см. pregen и postgen
+				const bool is_main = code->symbol != NULL && strcmp(code->symbol, "main") == 0;
+				object_add_symbol(obj, &(object_symbol){ .lbl = code->lbl, .name = code->symbol
+					, .section = obj->section, .value = object_get_data(obj)->size, .is_global = is_main });
+			}
+			return;
+		case FORMAT_WORD:
+			object_put_word(obj, object_reference(obj, code, R_MIPS_32));
+			return;
+		case FORMAT_DATA:
+			object_put_word(obj, (uint32_t)code->imm);
+			return;
+		case FORMAT_FLOAT:
+			object_put_word(obj, object_float_bits(code->float_imm));
+			return;
+		case FORMAT_SPACE:
+			for (item_t i = 0; i < code->imm && !obj->has_error; i++)
+			{
+				object_put(obj, "", 1);
+			}
+			return;
+		case FORMAT_ASCII:
+			object_put(obj, code->symbol, (size_t)code->imm);
+			object_put(obj, "", 1);
+			return;
+		case FORMAT_DIRECTIVE:
+			object_emit_directive(obj, code->symbol);
+			return;
+
+		case FORMAT_NONE:
+			object_put_word(obj, 0);
+			break;
+		case FORMAT_R:
+			if (code->instruction != IC_MIPS_JR)
+			{
+				obj->has_error = true;
+			}
+			object_put_r(obj, OP_SPECIAL, object_gpr(obj, code->fst_reg), R_ZERO, R_ZERO, 0, FN_JR);
+			break;
+		case FORMAT_2R:
+			object_emit_2R(obj, code);
+			break;
+		case FORMAT_3R:
+			object_emit_3R(obj, code);
+			break;
+		case FORMAT_R_I:
+			if (code->instruction == IC_MIPS_LUI && code->imm >= 0 && code->imm <= 2 * MAX_IMMEDIATE + 1)
+			{
+				object_put_i(obj, OP_LUI, R_ZERO, object_gpr(obj, code->fst_reg), (uint32_t)code->imm);
+			}
+			else if (code->instruction == IC_MIPS_LI)
+			{
+				object_put_li(obj, object_gpr(obj, code->fst_reg), code->imm);
+			}
+			else
+			{
+				obj->has_error = true;
+			}
+			break;
+		case FORMAT_2R_I:
+			object_emit_2R_I(obj, code);
+			break;
+		case FORMAT_R_I_R:
+			object_emit_memory(obj, code);
+			break;
+		case FORMAT_R_F:
+			object_emit_float_immediate(obj, code);
+			break;
+
+		case FORMAT_L:
+		{
+			if (code->instruction != IC_MIPS_J && code->instruction != IC_MIPS_JAL)
+			{
+				obj->has_error = true;
+			}
+			const uint32_t target = object_reference(obj, code, R_MIPS_26);
+			object_put_word(obj, (uint32_t)(code->instruction == IC_MIPS_J ? OP_J : OP_JAL) << 26
+				| ((target >> 2) & 0x3ffffff));
+			break;
+		}
+		case FORMAT_R_L:
+			if (code->instruction == IC_MIPS_LA)
+			{
+				const uint32_t rt = object_gpr(obj, code->fst_reg);
+				object_put_i(obj, OP_LUI, R_ZERO, rt, object_high(object_reference(obj, code, R_MIPS_HI16)));
+				object_put_i(obj, OP_ADDIU, rt, rt, object_reference(obj, code, R_MIPS_LO16));
+			}
+			else
+			{
+				object_emit_branch(obj, code);
+			}
+			break;
+		case FORMAT_2R_L:
+			object_emit_branch(obj, code);
+			break;
+		case FORMAT_R_HI:
+			object_put_i(obj, OP_LUI, R_ZERO, object_gpr(obj, code->fst_reg)
+				, object_high(object_reference(obj, code, R_MIPS_HI16)));
+			break;
+		case FORMAT_2R_LO:
+			object_put_i(obj, OP_ADDIU, object_gpr(obj, code->snd_reg), object_gpr(obj, code->fst_reg)
+				, object_reference(obj, code, R_MIPS_LO16));
+			break;
+	}
+
+	if (obj->is_reordered && code_is_control(code))
+	{
+		// Без noreorder слот задержки заполняет ассемблер
+		object_put_word(obj, 0);
+	}
 }
 
 /**
- *	Emit break statement
+ *	Encode all records of program.
+ *	Sizes of instructions don't depend on labels, so the first pass defines labels, and the second one
+ *	encodes instructions and relocations
  *
- *	@param	enc					Encoder
+ *	@param	obj					Object file
+ *	@param	codes				Records of program
+ *	@param	size				Number of records
  */
-static void emit_break_statement(encoder *const enc)
+static void object_assemble(object *const obj, const mips_code *const codes, const size_t size)
 {
-	emit_unconditional_branch(enc, IC_MIPS_J, &enc->label_break);
+	obj->text.size = 0;
+	obj->rodata.size = 0;
+	obj->data.size = 0;
+	obj->section = SECTION_TEXT;
+	obj->is_reordered = true;
+
+	for (size_t i = 0; i < size && !obj->has_error; i++)
+	{
+		if (codes[i].format == FORMAT_LABEL)
+		{
+			obj->label = &codes[i];
+		}
+
+		object_emit_code(obj, &codes[i]);
+		if (obj->has_error)
+		{
+			obj->failed = &codes[i];
+		}
+	}
 }
 
 /**
- *	Emit return statement
+ *	Pack relocations of section
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	data				Section contents
+ *
+ *	@return	Relocation section, @c NULL on failure
  */
-static void emit_return_statement(encoder *const enc, const node *const nd)
+static uint8_t *object_pack_relocations(const object *const obj, const object_data *const data)
 {
-	if (statement_return_has_expression(nd))
+	const size_t amount = vector_size(&data->relocations) / 3;
+	uint8_t *const buffer = malloc(amount * ELF_RELOCATION_SIZE + 1);
+	if (buffer == NULL)
 	{
-		const node expression = statement_return_get_expression(nd);
-		const rvalue value = emit_expression(enc, &expression);
+		return NULL;
+	}
 
-		const lvalue return_lval = { .kind = LVALUE_KIND_REGISTER, .loc.reg_num = R_V0, .type = value.type };
+	for (size_t i = 0; i < amount; i++)
+	{
+		const size_t offset = (size_t)vector_get(&data->relocations, 3 * i);
+		const size_t symbol = obj->symbols[vector_get(&data->relocations, 3 * i + 1)].index;
+		const size_t type = (size_t)vector_get(&data->relocations, 3 * i + 2);
 
-		emit_store_of_rvalue(enc, &return_lval, &value);
-		free_rvalue(enc, &value);
+		store_little_endian(&buffer[i * ELF_RELOCATION_SIZE], offset, 4);
+		store_little_endian(&buffer[i * ELF_RELOCATION_SIZE + 4], symbol << 8 | type, 4);
 	}
 
-	const label label_end = { .kind = L_FUNCEND, .num = enc->curr_function_ident };
-	emit_unconditional_branch(enc, IC_MIPS_J, &label_end);
+	return buffer;
 }
 
 /**
- *	Emit statement
+ *	Pack symbol table and names of symbols.
+ *	Local symbols go before global ones
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	symtab				Symbol table
+ *	@param	strtab				Names of symbols
+ *	@param	strtab_size			Size of names
+ *
+ *	@return	Number of local symbols, @c 0 on failure
  */
-static void emit_statement(encoder *const enc, const node *const nd)
+static size_t object_pack_symbols(object *const obj, uint8_t **const symtab, char **const strtab
+	, size_t *const strtab_size)
 {
-	switch (statement_get_class(nd))
+	size_t amount = 1;
+	for (size_t i = 0; i < obj->symbols_size; i++)
 	{
-		case STMT_DECL:
-			emit_declaration_statement(enc, nd);
-			break;
-
-		case STMT_CASE:
-			system_error(node_unexpected);
-			break;
-
-		case STMT_DEFAULT:
-			system_error(node_unexpected);
-			break;
-
-		case STMT_COMPOUND:
-			emit_compound_statement(enc, nd);
-			break;
-
-		case STMT_EXPR:
-			emit_void_expression(enc, nd);
-			break;
-
-		case STMT_NULL:
-			break;
-
-		case STMT_IF:
-			emit_if_statement(enc, nd);
-			break;
-
-		case STMT_SWITCH:
-			emit_switch_statement(enc, nd);
-			break;
+		if (!obj->symbols[i].is_global)
+		{
+			obj->symbols[i].index = amount++;
+		}
+	}
 
-		case STMT_WHILE:
-			emit_while_statement(enc, nd);
-			break;
+	const size_t locals = amount;
+	for (size_t i = 0; i < obj->symbols_size; i++)
+	{
+		if (obj->symbols[i].is_global)
+		{
+			obj->symbols[i].index = amount++;
+		}
+	}
 
-		case STMT_DO:
-			emit_do_statement(enc, nd);
-			break;
+	*symtab = calloc(amount, ELF_SYMBOL_SIZE);
+	if (*symtab == NULL)
+	{
+		return 0;
+	}
 
-		case STMT_FOR:
-			emit_for_statement(enc, nd);
-			break;
+	universal_io names = io_create();
+	out_set_buffer(&names, BUFFER_SIZE);
+	uni_printf(&names, "%c", '\0');
 
-		case STMT_CONTINUE:
-			emit_continue_statement(enc);
-			break;
+	for (size_t i = 0; i < obj->symbols_size; i++)
+	{
+		const object_symbol *const symbol = &obj->symbols[i];
+		uint8_t *const entry = &(*symtab)[symbol->index * ELF_SYMBOL_SIZE];
 
-		case STMT_BREAK:
-			emit_break_statement(enc);
-			break;
+		if (!symbol->is_section)
+		{
+			store_little_endian(entry, out_get_position(&names), 4);
+			code_label_to_io(&names, &(mips_code){ .lbl = symbol->lbl, .symbol = symbol->name });
+			uni_printf(&names, "%c", '\0');
+		}
 
-		case STMT_RETURN:
-			emit_return_statement(enc, nd);
-			break;
+		// Точка входа занимает весь остаток .text, как в директиве .size
+		const bool is_function = symbol->is_global && symbol->section != SECTION_UNDEFINED;
+		store_little_endian(&entry[4], symbol->value, 4);
+		store_little_endian(&entry[8], is_function ? obj->text.size - symbol->value : 0, 4);
 
-		default:
-			break;
+		// Связывание в старших битах, тип в младших: NOTYPE 0, FUNC 2, SECTION 3
+		entry[12] = (uint8_t)((symbol->is_global ? 1 << 4 : 0) | (symbol->is_section ? 3 : is_function ? 2 : 0));
+		store_little_endian(&entry[14], symbol->section, 2);
 	}
 
-	uni_printf(enc->sx->io, "\n");
+	*strtab_size = out_get_position(&names);
+	*strtab = out_extract_buffer(&names);
+	return *strtab == NULL ? 0 : locals;
 }
 
 /**
- *	Emit translation unit
+ *	Write ELF32 relocatable object file
  *
- *	@param	enc					Encoder
- *	@param	nd					Node in AST
+ *	@param	obj					Object file
+ *	@param	io					Universal io structure
+ *
+ *	@return	@c 0 on success, @c -1 on failure
  */
-static int emit_translation_unit(encoder *const enc, const node *const nd)
+static int object_write(object *const obj, universal_io *const io)
 {
-	const size_t size = translation_unit_get_size(nd);
-	for (size_t i = 0; i < size; i++)
+	const uint8_t *contents[SECTION_AMOUNT] = { NULL };
+	size_t sizes[SECTION_AMOUNT] = { 0 };
+
+	uint8_t *symtab = NULL;
+	char *strtab = NULL;
+	size_t strtab_size = 0;
+	const size_t locals = object_pack_symbols(obj, &symtab, &strtab, &strtab_size);
+
+	// Номера символов в таблице известны только после её построения
+	uint8_t *const rel_text = object_pack_relocations(obj, &obj->text);
+	uint8_t *const rel_rodata = object_pack_relocations(obj, &obj->rodata);
+	uint8_t *const rel_data = object_pack_relocations(obj, &obj->data);
+
+	// Флаги ABI: ISA mips32r2, 32-битные регистры, fp=xx
+	uint8_t abiflags[ELF_ABIFLAGS_SIZE] = { 0, 0, 32, 2, 1, 1, 0, 5 };
+
+	universal_io names = io_create();
+	out_set_buffer(&names, BUFFER_SIZE);
+	size_t name_offsets[SECTION_AMOUNT];
+	for (size_t i = 0; i < SECTION_AMOUNT; i++)
 	{
-		const node decl = translation_unit_get_declaration(nd, i);
-		emit_declaration(enc, &decl);
+		name_offsets[i] = out_get_position(&names);
+		uni_printf(&names, "%s%c", SECTION_NAMES[i], '\0');
+	}
+	const size_t shstrtab_size = out_get_position(&names);
+	char *const shstrtab = out_extract_buffer(&names);
+
+	contents[SECTION_TEXT] = obj->text.bytes;
+	sizes[SECTION_TEXT] = obj->text.size;
+	contents[SECTION_REL_TEXT] = rel_text;
+	sizes[SECTION_REL_TEXT] = vector_size(&obj->text.relocations) / 3 * ELF_RELOCATION_SIZE;
+	contents[SECTION_RODATA] = obj->rodata.bytes;
+	sizes[SECTION_RODATA] = obj->rodata.size;
+	contents[SECTION_REL_RODATA] = rel_rodata;
+	sizes[SECTION_REL_RODATA] = vector_size(&obj->rodata.relocations) / 3 * ELF_RELOCATION_SIZE;
+	contents[SECTION_DATA] = obj->data.bytes;
+	sizes[SECTION_DATA] = obj->data.size;
+	contents[SECTION_REL_DATA] = rel_data;
+	sizes[SECTION_REL_DATA] = vector_size(&obj->data.relocations) / 3 * ELF_RELOCATION_SIZE;
+	contents[SECTION_ABIFLAGS] = abiflags;
+	sizes[SECTION_ABIFLAGS] = ELF_ABIFLAGS_SIZE;
+	contents[SECTION_SYMTAB] = symtab;
+	sizes[SECTION_SYMTAB] = (obj->symbols_size + 1) * ELF_SYMBOL_SIZE;
+	contents[SECTION_STRTAB] = (const uint8_t *)strtab;
+	sizes[SECTION_STRTAB] = strtab_size;
+	contents[SECTION_SHSTRTAB] = (const uint8_t *)shstrtab;
+	sizes[SECTION_SHSTRTAB] = shstrtab_size;
+
+	// Секции следуют за заголовком, таблица заголовков секций -- в конце файла
+	size_t offsets[SECTION_AMOUNT] = { 0 };
+	size_t offset = ELF_HEADER_SIZE;
+	for (size_t i = 1; i < SECTION_AMOUNT; i++)
+	{
+		offset = (offset + SECTION_ALIGNS[i] - 1) / SECTION_ALIGNS[i] * SECTION_ALIGNS[i];
+		offsets[i] = offset;
+		offset += i != SECTION_BSS ? sizes[i] : 0;
 	}
 
-	return enc->sx->rprt.errors != 0;
-}
-
-// В дальнейшем при необходимости сюда можно передавать флаги вывода директив
-// TODO: подписать, что значит каждая директива и команда
-static void pregen(syntax *const sx)
-{
-	// Подпись "GNU As:" для директив GNU
-	// Подпись "MIPS Assembler:" для директив ассемблера MIPS
+	const size_t headers = (offset + WORD_LENGTH - 1) / WORD_LENGTH * WORD_LENGTH;
+	const size_t size = headers + SECTION_AMOUNT * ELF_SECTION_HEADER_SIZE;
+	uint8_t *const file = calloc(size, sizeof(uint8_t));
 
-	uni_printf(sx->io, "\t.section .mdebug.abi32\n");	// ?
-	uni_printf(sx->io, "\t.previous\n");				// следующая инструкция будет перенесена в секцию, описанную выше
-	uni_printf(sx->io, "\t.nan\tlegacy\n");				// ?
-	uni_printf(sx->io, "\t.module fp=xx\n");			// ?
-	uni_printf(sx->io, "\t.module nooddspreg\n");		// ?
-	uni_printf(sx->io, "\t.abicalls\n");				// ?
-	uni_printf(sx->io, "\t.option pic0\n");				// как если бы при компиляции была включена опция "-fpic" (что означает?)
-	uni_printf(sx->io, "\t.text\n");					// последующий код будет перенесён в текстовый сегмент памяти
-	// выравнивание последующих данных / команд по границе, кратной 2^n байт (в данном случае 2^2 = 4)
-	uni_printf(sx->io, "\t.align 2\n");
+	int ret = -1;
+	if (file != NULL && rel_text != NULL && rel_rodata != NULL && rel_data != NULL && locals != 0
+		&& shstrtab != NULL)
+	{
+		memcpy(file, "\x7f" "ELF", 4);
+		file[4] = 1;										// ELFCLASS32
+		file[5] = 1;										// ELFDATA2LSB
+		file[6] = 1;										// EV_CURRENT
+		store_little_endian(&file[16], 1, 2);				// ET_REL
+		store_little_endian(&file[18], 8, 2);				// EM_MIPS
+		store_little_endian(&file[20], 1, 4);
+		store_little_endian(&file[32], headers, 4);
+		store_little_endian(&file[36], ELF_FLAGS | (obj->has_noreorder ? ELF_FLAG_NOREORDER : 0), 4);
+		store_little_endian(&file[40], ELF_HEADER_SIZE, 2);
+		store_little_endian(&file[46], ELF_SECTION_HEADER_SIZE, 2);
+		store_little_endian(&file[48], SECTION_AMOUNT, 2);
+		store_little_endian(&file[50], SECTION_SHSTRTAB, 2);
+
+		for (size_t i = 1; i < SECTION_AMOUNT; i++)
+		{
+			if (i != SECTION_BSS && sizes[i] != 0)
+			{
+				memcpy(&file[offsets[i]], contents[i], sizes[i]);
+			}
 
-	// делает метку main глобальной -- её можно вызывать извне кода (например, используется при линковке)
-	uni_printf(sx->io, "\n\t.globl\tmain\n");
-	uni_printf(sx->io, "\t.ent\tmain\n");				// начало процедуры main
-	uni_printf(sx->io, "\t.type\tmain, @function\n");	// тип "main" -- функция
-	uni_printf(sx->io, "main:\n");
+			const bool is_relocation = i == SECTION_REL_TEXT || i == SECTION_REL_RODATA || i == SECTION_REL_DATA;
+			const size_t link = is_relocation ? SECTION_SYMTAB : i == SECTION_SYMTAB ? SECTION_STRTAB : 0;
+			const size_t info = is_relocation ? i - 1 : i == SECTION_SYMTAB ? locals : 0;
+
+			uint8_t *const header = &file[headers + i * ELF_SECTION_HEADER_SIZE];
+			store_little_endian(&header[0], name_offsets[i], 4);
+			store_little_endian(&header[4], SECTION_TYPES[i], 4);
+			store_little_endian(&header[8], SECTION_FLAGS[i], 4);
+			store_little_endian(&header[16], offsets[i], 4);
+			store_little_endian(&header[20], sizes[i], 4);
+			store_little_endian(&header[24], link, 4);
+			store_little_endian(&header[28], info, 4);
+			store_little_endian(&header[32], SECTION_ALIGNS[i], 4);
+			store_little_endian(&header[36], SECTION_ENTRY_SIZES[i], 4);
+		}
 
-	// инициализация gp
-	// "__gnu_local_gp" -- локация в памяти, где лежит Global Pointer
-	uni_printf(sx->io, "\tlui $gp, %%hi(__gnu_local_gp)\n");
-	uni_printf(sx->io, "\taddiu $gp, $gp, %%lo(__gnu_local_gp)\n");
+		ret = uni_write(io, file, size) == size ? 0 : -1;
+	}
 
-	// FIXME: сделать для $ra, $sp и $fp отдельные глобальные rvalue
-	to_code_2R(sx->io, IC_MIPS_MOVE, R_FP, R_SP);
-	to_code_2R_I(sx->io, IC_MIPS_ADDI, R_SP, R_SP, -4);
-	to_code_R_I_R(sx->io, IC_MIPS_SW, R_RA, 0, R_SP);
-	to_code_R_I(sx->io, IC_MIPS_LI, R_T0, LOW_DYN_BORDER);
-	to_code_R_I_R(sx->io, IC_MIPS_SW, R_T0, -(item_t)HEAP_DISPL - 60, R_GP);
-	uni_printf(sx->io, "\n");
+	free(file);
+	free(shstrtab);
+	free(strtab);
+	free(symtab);
+	free(rel_data);
+	free(rel_rodata);
+	free(rel_text);
+	return ret;
 }
 
-// создаём метки всех строк в программе
-static void strings_declaration(encoder *const enc)
+/**
+ *	Report record, which can not be encoded, with the last label before it
+ *
+ *	@param	obj					Object file
+ */
+static void object_report_error(const object *const obj)
 {
-	uni_printf(enc->sx->io, "\t.rdata\n");
-	uni_printf(enc->sx->io, "\t.align 2\n");
+	universal_io instruction = io_create();
+	out_set_buffer(&instruction, BUFFER_SIZE);
+	if (obj->failed != NULL)
+	{
+		code_to_io(&instruction, obj->failed);
+	}
 
-	const size_t amount = strings_amount(enc->sx);
-	for (size_t i = 0; i < amount; i++)
+	universal_io label = io_create();
+	out_set_buffer(&label, BUFFER_SIZE);
+	if (obj->label != NULL)
 	{
-		item_t args_for_printf = 0;
-		const label string_label = { .kind = L_STRING, .num = i };
-		emit_label_declaration(enc, &string_label);
-		uni_printf(enc->sx->io, "\t.ascii \"");
+		code_label_to_io(&label, obj->label);
+	}
+	else
+	{
+		uni_printf(&label, "main");
+	}
 
-		const char *string = string_get(enc->sx, i);
-		for (size_t j = 0; string[j] != '\0'; j++)
+	char *const instruction_text = out_extract_buffer(&instruction);
+	char *const label_text = out_extract_buffer(&label);
+	if (instruction_text != NULL && label_text != NULL)
+	{
+		// Запись выводится, как в тексте ассемблера, без отступа и перевода строки
+		const size_t length = strlen(instruction_text);
+		if (length != 0 && instruction_text[length - 1] == '\n')
 		{
-			const char ch = string[j];
-			if (ch == '\n')
-			{
-				uni_printf(enc->sx->io, "\\n");
-			}
-			else if (ch == '%')
-			{
-				args_for_printf++;
-				j++;
-
-				uni_printf(enc->sx->io, "%c", ch);
-				uni_printf(enc->sx->io, "%c", string[j]);
-
-				uni_printf(enc->sx->io, "\\0\"\n");
-				const label another_str_label = { .kind = L_STRING, .num = (size_t)(i + args_for_printf * amount) };
-				emit_label_declaration(enc, &another_str_label);
-				uni_printf(enc->sx->io, "\t.ascii \"");
-			}
-			else
-			{
-				uni_printf(enc->sx->io, "%c", ch);
-			}
+			instruction_text[length - 1] = '\0';
 		}
 
-		uni_printf(enc->sx->io, "\\0\"\n");
+		system_error(instruction_cannot_be_encoded, &instruction_text[strspn(instruction_text, "\t")], label_text);
 	}
-	uni_printf(enc->sx->io, "\t.text\n");
-	uni_printf(enc->sx->io, "\t.align 2\n\n");
-
-	// Прыжок на главную метку
-	uni_printf(enc->sx->io, "\tjal MAIN\n");
 
-	// Выход из программы в конце работы
-	to_code_R_I_R(enc->sx->io, IC_MIPS_LW, R_RA, 0, R_SP);
-	emit_register_branch(enc, IC_MIPS_JR, R_RA);
+	free(instruction_text);
+	free(label_text);
 }
 
-static void postgen(encoder *const enc)
+/**
+ *	Emit object file from records of program instead of assembler text
+ *
+ *	@param	enc					Encoder
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+static int emit_object(encoder *const enc)
 {
-	// FIXME: целиком runtime.s не вставить, т.к. не понятно, что делать с modetab
-	// По этой причине вставляю только defarr
-	uni_printf(enc->sx->io, "\n\n# defarr\n\
-# объявление одномерного массива\n\
-# $a0 -- адрес первого элемента\n\
-# $a1 -- размер измерения\n\
-DEFARR1:\n\
-	sw $a1, 4($a0)			# Сохранение границы\n\
-	li $v0, 4				# Загрузка размера слова\n\
-	mul $v0, $v0, $a1		# Подсчёт размера первого измерения массива в байтах\n\
-	sub $v0, $a0, $v0		# Считаем адрес после конца массива, т.е. $v0 -- на слово ниже последнего элемента\n\
-	addi $v0, $v0, -4\n\
-	jr $ra\n\
-\n\
-# объявление многомерного массива, но сначала обязана вызываться процедура DEFARR1\n\
-# $a0 -- адрес первого элемента\n\
-# $a1 -- размер измерения\n\
-# $a2 -- адрес первого элемента предыдущего измерения\n\
-# $a3 -- размер предыдущего измерения\n\
-DEFARR2:\n\
-	sw $a0, 0($a2)			# Сохраняем адрес в элементе предыдущего измерения\n\
-	move $t0, $ra			# Запоминаем $ra, чтобы он не затёрся\n\
-	jal DEFARR1				# Выделение памяти под массив\n\
-	move $ra, $t0			# Восстанавливаем $ra\n\
-	addi $a2, $a2, -4		# В $a2 следующий элемент в предыдущем измерении\n\
-	addi $a0, $v0, -4		# В $a0 первый элемент массива в текущем измерении, плюс выделяется место под размеры\n\
-	addi $a3, $a3, -1		# Уменьшаем счётчик\n\
-	bne $a3, $0, DEFARR2	# Прыгаем, если ещё не всё выделили\n\
-	jr $ra\n");
-
-	uni_printf(enc->sx->io, "\n\n\t.end\tmain\n");
-	uni_printf(enc->sx->io, "\t.size\tmain, .-main\n");
+	object obj = { .section = SECTION_TEXT, .is_reordered = true };
+	obj.text.relocations = vector_create(HASH_TABLE_SIZE);
+	obj.rodata.relocations = vector_create(HASH_TABLE_SIZE);
+	obj.data.relocations = vector_create(HASH_TABLE_SIZE);
+	obj.labels = hash_create(HASH_TABLE_SIZE);
+
+	// Символы секций идут первыми, см. object_section_symbol
+	object_add_symbol(&obj, &(object_symbol){ .section = SECTION_TEXT, .is_section = true });
+	object_add_symbol(&obj, &(object_symbol){ .section = SECTION_RODATA, .is_section = true });
+
+	object_assemble(&obj, enc->object, enc->object_size);
+	obj.is_final = true;
+	object_assemble(&obj, enc->object, enc->object_size);
+
+	if (obj.has_error)
+	{
+		object_report_error(&obj);
+	}
+
+	const int ret = obj.has_error ? -1 : object_write(&obj, enc->io);
+
+	hash_clear(&obj.labels);
+	vector_clear(&obj.text.relocations);
+	vector_clear(&obj.rodata.relocations);
+	vector_clear(&obj.data.relocations);
+	free(obj.text.bytes);
+	free(obj.rodata.bytes);
+	free(obj.data.bytes);
+	free(obj.symbols);
+	return ret;
 }
 
 
@@ -3943,6 +7644,7 @@ int encode_to_mips(const workspace *const ws, syntax *const sx)
 
 	encoder enc;
 	enc.sx = sx;
+	enc.io = sx->io;
 	enc.next_register = R_T0;
 	enc.next_float_register = R_FT0;
 	enc.label_num = 1;
@@ -3952,19 +7654,49 @@ int encode_to_mips(const workspace *const ws, syntax *const sx)
 	enc.global_displ = 0;
 
 	enc.displacements = hash_create(HASH_TABLE_SIZE);
+	enc.local_registers = hash_create(HASH_TABLE_SIZE);
+
+	enc.code = NULL;
+	enc.code_size = 0;
+	enc.code_capacity = 0;
+	enc.is_buffered = false;
+	enc.is_optimized = !ws_has_flag(ws, "-O0");
+
+	enc.object = NULL;
+	enc.object_size = 0;
+	enc.object_capacity = 0;
+	enc.is_binary = ws_has_flag(ws, "--binary");
+
+	// Для объектного файла текст ассемблера не нужен, он пишется в буфер и выбрасывается
+	universal_io text = io_create();
+	if (enc.is_binary)
+	{
+		out_set_buffer(&text, BUFFER_SIZE);
+		enc.io = &text;
+	}
 
 	for (size_t i = 0; i < TEMP_REG_AMOUNT + TEMP_FP_REG_AMOUNT; i++)
 	{
 		enc.registers[i] = false;
 	}
 
-	pregen(sx);
+	pregen(&enc);
 	strings_declaration(&enc);
 	// TODO: нормальное получение корня
 	const node root = node_get_root(&enc.sx->tree);
-	const int ret = emit_translation_unit(&enc, &root);
+	int ret = emit_translation_unit(&enc, &root, pool_get_threads(ws));
 	postgen(&enc);
 
+	if (enc.is_binary)
+	{
+		free(out_extract_buffer(&text));
+		enc.io = sx->io;
+		ret = ret ? ret : emit_object(&enc);
+	}
+
 	hash_clear(&enc.displacements);
+	hash_clear(&enc.local_registers);
+	free(enc.code);
+	free(enc.object);
 	return ret;
 }
@@ -26,6 +26,8 @@ extern "C" {
 
 /**
  *	Encode to mips codes
+ *	@note	Flag @c --binary selects ELF32 relocatable object file instead of assembler text,
+ *			flag @c -j<number> sets number of threads for function definitions
  *
  *	@param	ws				Compiler workspace
  *	@param	sx				Syntax structure
@@ -0,0 +1,2829 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "optimizer.h"
+#include "AST.h"
+#include "builder.h"
+#include "tree.h"
+#include "uniprinter.h"
+
+
+static const char *const DEFAULT_REPORT = "optimizer.txt";
+
+static const size_t MAX_INLINE_SIZE = 64;
+static const item_t MAX_BOUNDS_STEP = 1024;
+
+
+/** AST optimizer */
+typedef struct optimizer
+{
+	syntax *sx;					/**< Syntax structure */
+	universal_io report;		/**< Optimization report */
+
+	vector constants;			/**< Literal initializers of constant variables by identifier index */
+	vector functions;			/**< Function definitions by identifier index, negative if reachable */
+	vector calls;				/**< Reachable functions to traverse */
+
+	vector renames;				/**< Identifiers of inlined function copy, negative for substituted arguments */
+	size_t inlined;				/**< Number of inlined call sites */
+
+	vector written;				/**< Number of the last loop writing variable by identifier index, @c ITEM_MAX if address is taken */
+	size_t loops;				/**< Number of analysed loops */
+	bool has_call;				/**< Set, if analysed loop contains calls */
+	size_t hoisted;				/**< Number of hoisted loop invariant expressions */
+	size_t reduced;				/**< Number of reduced multiplications by induction variables */
+
+	vector sizes;				/**< Declared sizes of arrays by identifier index, negative if array is reassigned */
+	size_t unchecked;			/**< Number of subscripts without bounds checks */
+} optimizer;
+
+/** Induction variable of for statement */
+typedef struct induction
+{
+	size_t id;					/**< Variable identifier */
+	item_t step;				/**< Increment per iteration */
+	node initial;				/**< Initial value, broken if variable is not assigned in inition */
+	vector factors;				/**< Class, value, number of uses and product variable of reduced factors */
+} induction;
+
+
+/*
+ *	 __  __     ______   __     __         ______
+ *	/\ \/\ \   /\__  _\ /\ \   /\ \       /\  ___\
+ *	\ \ \_\ \  \/_/\ \/ \ \ \  \ \ \____  \ \___  \
+ *	 \ \_____\    \ \_\  \ \_\  \ \_____\  \/\_____\
+ *	  \/_____/     \/_/   \/_/   \/_____/   \/_____/
+ */
+
+
+/**
+ *	Check if child node is used as an object rather than as a value
+ *
+ *	@param	nd			Parent node
+ *	@param	index		Child index
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_object_operand(const node *const nd, const size_t index)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_UNARY:
+			switch (expression_unary_get_operator(nd))
+			{
+				case UN_POSTINC:
+				case UN_POSTDEC:
+				case UN_PREINC:
+				case UN_PREDEC:
+				case UN_ADDRESS:
+				case UN_UPB:
+					return true;
+				default:
+					return false;
+			}
+
+		case OP_SLICE:
+		case OP_SELECT:
+		case OP_ASSIGNMENT:
+			return index == 0;
+
+		case OP_CALL:
+		{
+			if (index == 0)
+			{
+				return true;
+			}
+
+			const node callee = expression_call_get_callee(nd);
+			const size_t func = expression_identifier_get_id(&callee);
+			return func == BI_PRINTID || func == BI_GETID;
+		}
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Get value of constant condition
+ *
+ *	@param	sx			Syntax structure
+ *	@param	nd			Condition expression
+ *	@param	value		Condition value
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool get_condition_value(const syntax *const sx, const node *const nd, bool *const value)
+{
+	if (expression_get_class(nd) != EXPR_LITERAL)
+	{
+		return false;
+	}
+
+	switch (type_get_class(sx, expression_get_type(nd)))
+	{
+		case TYPE_NULL_POINTER:
+			*value = false;
+			return true;
+
+		case TYPE_FLOATING:
+			*value = expression_literal_get_floating(nd) != 0;
+			return true;
+
+		case TYPE_BOOLEAN:
+		case TYPE_CHARACTER:
+		case TYPE_INTEGER:
+		case TYPE_ENUM:
+			*value = expression_literal_get_integer(nd) != 0;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Check if statement contains case or default label of enclosing switch
+ *
+ *	@param	nd			Statement
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool has_label(const node *const nd)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_CASE:
+		case OP_DEFAULT:
+			return true;
+
+		case OP_SWITCH:
+			return false;
+
+		default:
+		{
+			const size_t amount = node_get_amount(nd);
+			for (size_t i = 0; i < amount; i++)
+			{
+				const node child = node_get_child(nd, i);
+				if (has_label(&child))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+}
+
+/**
+ *	Check if statement contains break or continue of enclosing loop
+ *
+ *	@param	nd			Statement
+ *	@param	is_break	Set to search for break, otherwise for continue
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool has_jump(const node *const nd, const bool is_break)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_BREAK:
+			return is_break;
+
+		case OP_CONTINUE:
+			return !is_break;
+
+		case OP_WHILE:
+		case OP_DO:
+		case OP_FOR:
+			return false;
+
+		case OP_SWITCH:
+			if (is_break)
+			{
+				return false;
+			}
+
+		default:
+		{
+			const size_t amount = node_get_amount(nd);
+			for (size_t i = 0; i < amount; i++)
+			{
+				const node child = node_get_child(nd, i);
+				if (has_jump(&child, is_break))
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	}
+}
+
+
+/*
+ *	 ______     ______     __   __     ______     ______   ______     __   __     ______   ______
+ *	/\  ___\   /\  __ \   /\ "-.\ \   /\  ___\   /\__  _\ /\  __ \   /\ "-.\ \   /\__  _\ /\  ___\
+ *	\ \ \____  \ \ \/\ \  \ \ \-.  \  \ \___  \  \/_/\ \/ \ \  __ \  \ \ \-.  \  \/_/\ \/ \ \___  \
+ *	 \ \_____\  \ \_____\  \ \_\\"\_\  \/\_____\    \ \_\  \ \_\ \_\  \ \_\\"\_\    \ \_\  \/\_____\
+ *	  \/_____/   \/_____/   \/_/ \/_/   \/_____/     \/_/   \/_/\/_/   \/_/ \/_/     \/_/   \/_____/
+ */
+
+
+/**
+ *	Remember literal initializer of constant scalar variable
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Variable declaration
+ */
+static void constant_register(optimizer *const opt, const node *const nd)
+{
+	if (!declaration_variable_has_initializer(nd) || declaration_variable_get_bounds_amount(nd) != 0)
+	{
+		return;
+	}
+
+	const size_t id = declaration_variable_get_id(nd);
+	const item_t type = ident_get_type(opt->sx, id);
+	if (!type_is_const(opt->sx, type))
+	{
+		return;
+	}
+
+	const item_t unqualified_type = type_const_get_unqualified_type(opt->sx, type);
+	const node initializer = declaration_variable_get_initializer(nd);
+	if (expression_get_class(&initializer) != EXPR_LITERAL
+		|| !(type_is_arithmetic(opt->sx, unqualified_type) || type_is_boolean(opt->sx, unqualified_type))
+		|| type_is_floating(opt->sx, unqualified_type) != type_is_floating(opt->sx, expression_get_type(&initializer)))
+	{
+		return;
+	}
+
+	vector_set(&opt->constants, id, (item_t)node_save(&initializer));
+}
+
+/**
+ *	Replace constant variable by its value
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Identifier expression
+ *
+ *	@return	Literal expression on success, original expression on failure
+ */
+static node constant_substitute(optimizer *const opt, node *const nd)
+{
+	const size_t id = expression_identifier_get_id(nd);
+	const item_t index = vector_get(&opt->constants, id);
+	if (index == 0 || index == ITEM_MAX)
+	{
+		return *nd;
+	}
+
+	const node initializer = node_load(&opt->sx->tree, (size_t)index);
+	const item_t type = type_const_get_unqualified_type(opt->sx, ident_get_type(opt->sx, id));
+
+	return type_is_floating(opt->sx, type)
+		? expression_to_floating_literal(nd, type, expression_literal_get_floating(&initializer))
+		: expression_to_integer_literal(nd, type, expression_literal_get_integer(&initializer));
+}
+
+/**
+ *	Propagate values of constant variables and fold constant expressions
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ *	@param	is_object	Set, if node is used as an object
+ *
+ *	@return	Optimized node
+ */
+static node constant_propagation(optimizer *const opt, node *const nd, const bool is_object)
+{
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		node child = node_get_child(nd, i);
+		constant_propagation(opt, &child, is_object_operand(nd, i));
+	}
+
+	switch (node_get_type(nd))
+	{
+		case OP_IDENTIFIER:
+			return is_object ? *nd : constant_substitute(opt, nd);
+
+		case OP_DECL_VAR:
+			constant_register(opt, nd);
+			return *nd;
+
+		default:
+			return fold_expression(opt->sx, nd);
+	}
+}
+
+
+/*
+ *	 ______     ______   ______     ______   ______     __    __     ______     __   __     ______   ______
+ *	/\  ___\   /\__  _\ /\  __ \   /\__  _\ /\  ___\   /\ "-./  \   /\  ___\   /\ "-.\ \   /\__  _\ /\  ___\
+ *	\ \___  \  \/_/\ \/ \ \  __ \  \/_/\ \/ \ \  __\   \ \ \-./\ \  \ \  __\   \ \ \-.  \  \/_/\ \/ \ \___  \
+ *	 \/\_____\    \ \_\  \ \_\ \_\    \ \_\  \ \_____\  \ \_\ \ \_\  \ \_____\  \ \_\\"\_\    \ \_\  \/\_____\
+ *	  \/_____/     \/_/   \/_/\/_/     \/_/   \/_____/   \/_/  \/_/   \/_____/   \/_/ \/_/     \/_/   \/_____/
+ */
+
+
+/**
+ *	Check if control never passes from statement to the next one
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Statement
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_terminator(const optimizer *const opt, const node *const nd)
+{
+	switch (statement_get_class(nd))
+	{
+		case STMT_CONTINUE:
+		case STMT_BREAK:
+		case STMT_RETURN:
+			return true;
+
+		case STMT_CASE:
+		{
+			const node substmt = statement_case_get_substmt(nd);
+			return is_terminator(opt, &substmt);
+		}
+
+		case STMT_DEFAULT:
+		{
+			const node substmt = statement_default_get_substmt(nd);
+			return is_terminator(opt, &substmt);
+		}
+
+		case STMT_COMPOUND:
+		{
+			const size_t size = statement_compound_get_size(nd);
+			if (size == 0)
+			{
+				return false;
+			}
+
+			const node substmt = statement_compound_get_substmt(nd, size - 1);
+			return is_terminator(opt, &substmt);
+		}
+
+		case STMT_IF:
+		{
+			if (!statement_if_has_else_substmt(nd))
+			{
+				return false;
+			}
+
+			const node then_substmt = statement_if_get_then_substmt(nd);
+			const node else_substmt = statement_if_get_else_substmt(nd);
+			return is_terminator(opt, &then_substmt) && is_terminator(opt, &else_substmt);
+		}
+
+		case STMT_WHILE:
+		{
+			const node condition = statement_while_get_condition(nd);
+			const node body = statement_while_get_body(nd);
+
+			bool value;
+			return get_condition_value(opt->sx, &condition, &value) && value && !has_jump(&body, true);
+		}
+
+		case STMT_DO:
+		{
+			const node condition = statement_do_get_condition(nd);
+			const node body = statement_do_get_body(nd);
+
+			bool value;
+			return get_condition_value(opt->sx, &condition, &value) && value && !has_jump(&body, true);
+		}
+
+		case STMT_FOR:
+		{
+			const node body = statement_for_get_body(nd);
+			if (!statement_for_has_condition(nd))
+			{
+				return !has_jump(&body, true);
+			}
+
+			const node condition = statement_for_get_condition(nd);
+
+			bool value;
+			return get_condition_value(opt->sx, &condition, &value) && value && !has_jump(&body, true);
+		}
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Check if statement does nothing
+ *
+ *	@param	nd			Statement
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_empty(const node *const nd)
+{
+	switch (statement_get_class(nd))
+	{
+		case STMT_NULL:
+			return true;
+
+		case STMT_COMPOUND:
+			return statement_compound_get_size(nd) == 0;
+
+		case STMT_EXPR:
+			return node_get_type(nd) == OP_LITERAL;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Remove unreachable and empty statements from compound statement
+ *	@note	Unreachable declarations are kept, if some label follows them
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Compound statement
+ */
+static void compound_eliminate(const optimizer *const opt, const node *const nd)
+{
+	size_t labels = 0;
+	for (size_t i = 0; i < statement_compound_get_size(nd); i++)
+	{
+		const node substmt = statement_compound_get_substmt(nd, i);
+		labels += has_label(&substmt) ? 1 : 0;
+	}
+
+	bool is_reachable = true;
+	for (size_t i = 0; i < statement_compound_get_size(nd);)
+	{
+		node substmt = statement_compound_get_substmt(nd, i);
+		if (has_label(&substmt))
+		{
+			is_reachable = true;
+			labels--;
+		}
+
+		if (is_reachable ? is_empty(&substmt) : statement_get_class(&substmt) != STMT_DECL || labels == 0)
+		{
+			node_remove(&substmt);
+			continue;
+		}
+
+		is_reachable = is_reachable && !is_terminator(opt, &substmt);
+		i++;
+	}
+}
+
+/**
+ *	Replace if statement with constant condition by the taken branch
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			If statement
+ *
+ *	@return	Optimized statement
+ */
+static node if_eliminate(const optimizer *const opt, node *const nd)
+{
+	const node condition = statement_if_get_condition(nd);
+	bool value;
+	if (!get_condition_value(opt->sx, &condition, &value))
+	{
+		return *nd;
+	}
+
+	node then_substmt = statement_if_get_then_substmt(nd);
+	if (!statement_if_has_else_substmt(nd))
+	{
+		if (value)
+		{
+			node_swap(nd, &then_substmt);
+			return then_substmt;
+		}
+
+		return has_label(&then_substmt) ? *nd : statement_to_null(nd);
+	}
+
+	node else_substmt = statement_if_get_else_substmt(nd);
+	node *const taken = value ? &then_substmt : &else_substmt;
+	const node *const dropped = value ? &else_substmt : &then_substmt;
+	if (has_label(dropped))
+	{
+		return *nd;
+	}
+
+	node_swap(nd, taken);
+	return *taken;
+}
+
+/**
+ *	Remove loop with false constant condition
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Loop statement
+ *
+ *	@return	Optimized statement
+ */
+static node loop_eliminate(const optimizer *const opt, node *const nd)
+{
+	switch (statement_get_class(nd))
+	{
+		case STMT_WHILE:
+		{
+			const node condition = statement_while_get_condition(nd);
+			const node body = statement_while_get_body(nd);
+
+			bool value;
+			if (!get_condition_value(opt->sx, &condition, &value) || value || has_label(&body))
+			{
+				return *nd;
+			}
+
+			return statement_to_null(nd);
+		}
+
+		case STMT_DO:
+		{
+			// Тело цикла do { ... } while (0) выполняется ровно один раз
+			const node condition = statement_do_get_condition(nd);
+			node body = statement_do_get_body(nd);
+
+			bool value;
+			if (!get_condition_value(opt->sx, &condition, &value) || value
+				|| has_jump(&body, true) || has_jump(&body, false))
+			{
+				return *nd;
+			}
+
+			node_swap(nd, &body);
+			return body;
+		}
+
+		case STMT_FOR:
+		{
+			if (!statement_for_has_condition(nd))
+			{
+				return *nd;
+			}
+
+			const node condition = statement_for_get_condition(nd);
+			node body = statement_for_get_body(nd);
+
+			bool value;
+			if (!get_condition_value(opt->sx, &condition, &value) || value || has_label(&body))
+			{
+				return *nd;
+			}
+
+			if (!statement_for_has_inition(nd))
+			{
+				return statement_to_null(nd);
+			}
+
+			node inition = statement_for_get_inition(nd);
+			if (statement_get_class(&inition) != STMT_DECL)
+			{
+				node_swap(nd, &inition);
+				return inition;
+			}
+
+			// Объявление в заголовке цикла сохраняет свою область действия
+			statement_to_null(&body);
+			return *nd;
+		}
+
+		default:
+			return *nd;
+	}
+}
+
+/**
+ *	Remove dead branches and unreachable statements
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ *
+ *	@return	Optimized node
+ */
+static node dead_code_elimination(const optimizer *const opt, node *const nd)
+{
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		node child = node_get_child(nd, i);
+		dead_code_elimination(opt, &child);
+	}
+
+	switch (node_get_type(nd))
+	{
+		case OP_BLOCK:
+			compound_eliminate(opt, nd);
+			return *nd;
+
+		case OP_IF:
+			return if_eliminate(opt, nd);
+
+		case OP_WHILE:
+		case OP_DO:
+		case OP_FOR:
+			return loop_eliminate(opt, nd);
+
+		default:
+			return *nd;
+	}
+}
+
+
+/*
+ *	 ______   __  __     __   __     ______     ______   __     ______     __   __     ______
+ *	/\  ___\ /\ \/\ \   /\ "-.\ \   /\  ___\   /\__  _\ /\ \   /\  __ \   /\ "-.\ \   /\  ___\
+ *	\ \  __\ \ \ \_\ \  \ \ \-.  \  \ \ \____  \/_/\ \/ \ \ \  \ \ \/\ \  \ \ \-.  \  \ \___  \
+ *	 \ \_\    \ \_____\  \ \_\\"\_\  \ \_____\    \ \_\  \ \_\  \ \_____\  \ \_\\"\_\  \/\_____\
+ *	  \/_/     \/_____/   \/_/ \/_/   \/_____/     \/_/   \/_/   \/_____/   \/_/ \/_/   \/_____/
+ */
+
+
+/**
+ *	Get function predeclaration identifier
+ *
+ *	@param	opt			Optimizer
+ *	@param	id			Function definition identifier
+ *
+ *	@return	Predeclaration identifier, @c 0 if function has no predeclaration
+ */
+static size_t function_get_predeclaration(const optimizer *const opt, const size_t id)
+{
+	const size_t prev = ident_get_prev(opt->sx, id);
+	if (prev == 0 || prev >= vector_size(&opt->sx->identifiers)
+		|| !type_is_function(opt->sx, ident_get_type(opt->sx, prev)))
+	{
+		return 0;
+	}
+
+	return prev;
+}
+
+/**
+ *	Mark function as reachable and add it to the call graph traversal
+ *
+ *	@param	opt			Optimizer
+ *	@param	id			Function identifier
+ */
+static void function_reach(optimizer *const opt, const size_t id)
+{
+	const item_t index = vector_get(&opt->functions, id);
+	if (index <= 0)
+	{
+		return;
+	}
+
+	const node nd = node_load(&opt->sx->tree, (size_t)index);
+	const size_t definition = declaration_function_get_id(&nd);
+	vector_set(&opt->functions, definition, -index);
+
+	const size_t predeclaration = function_get_predeclaration(opt, definition);
+	if (predeclaration != 0)
+	{
+		vector_set(&opt->functions, predeclaration, -index);
+	}
+
+	vector_add(&opt->calls, index);
+}
+
+/**
+ *	Reach functions, which are called or whose address is taken in subtree
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ */
+static void function_reach_references(optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_IDENTIFIER)
+	{
+		function_reach(opt, expression_identifier_get_id(nd));
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		function_reach_references(opt, &child);
+	}
+}
+
+/**
+ *	Fill table of function definitions by identifier index
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Translation unit
+ */
+static void functions_register(optimizer *const opt, const node *const nd)
+{
+	const size_t size = translation_unit_get_size(nd);
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) == DECL_FUNC)
+		{
+			const size_t id = declaration_function_get_id(&decl);
+			const item_t index = (item_t)node_save(&decl);
+			vector_set(&opt->functions, id, index);
+
+			const size_t predeclaration = function_get_predeclaration(opt, id);
+			if (predeclaration != 0)
+			{
+				vector_set(&opt->functions, predeclaration, index);
+			}
+		}
+	}
+}
+
+/**
+ *	Get definition of called function
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Call expression
+ *	@param	func		Function definition
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool function_get_definition(const optimizer *const opt, const node *const nd, node *const func)
+{
+	const node callee = expression_call_get_callee(nd);
+	if (expression_get_class(&callee) != EXPR_IDENTIFIER)
+	{
+		return false;
+	}
+
+	const item_t index = vector_get(&opt->functions, expression_identifier_get_id(&callee));
+	if (index == 0 || index == ITEM_MAX)
+	{
+		return false;
+	}
+
+	*func = node_load(&opt->sx->tree, (size_t)(index > 0 ? index : -index));
+	return true;
+}
+
+/**
+ *	Remove functions, which are not reachable from main in call graph
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Translation unit
+ */
+static void dead_function_elimination(optimizer *const opt, const node *const nd)
+{
+	functions_register(opt, nd);
+
+	// Корни графа вызовов: main и функции, на которые ссылаются глобальные объявления
+	function_reach(opt, opt->sx->ref_main);
+
+	const size_t size = translation_unit_get_size(nd);
+	for (size_t i = 0; i < size; i++)
+	{
+		const node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) != DECL_FUNC)
+		{
+			function_reach_references(opt, &decl);
+		}
+	}
+
+	while (vector_size(&opt->calls) != 0)
+	{
+		const node func = node_load(&opt->sx->tree, (size_t)vector_remove(&opt->calls));
+		function_reach_references(opt, &func);
+	}
+
+	size_t removed = 0;
+	for (size_t i = 0; i < translation_unit_get_size(nd);)
+	{
+		node decl = translation_unit_get_declaration(nd, i);
+		if (declaration_get_class(&decl) != DECL_FUNC)
+		{
+			i++;
+			continue;
+		}
+
+		const size_t id = declaration_function_get_id(&decl);
+		if (vector_get(&opt->functions, id) < 0)
+		{
+			i++;
+			continue;
+		}
+
+		uni_printf(&opt->report, "removed function %s\n", ident_get_spelling(opt->sx, id));
+		node_remove(&decl);
+		removed++;
+	}
+
+	uni_printf(&opt->report, "removed functions: %zu\n", removed);
+}
+
+
+/*
+ *	 __     __   __     __         __     __   __     ______
+ *	/\ \   /\ "-.\ \   /\ \       /\ \   /\ "-.\ \   /\  ___\
+ *	\ \ \  \ \ \-.  \  \ \ \____  \ \ \  \ \ \-.  \  \ \  __\
+ *	 \ \_\  \ \_\\"\_\  \ \_____\  \ \_\  \ \_\\"\_\  \ \_____\
+ *	  \/_/   \/_/ \/_/   \/_____/   \/_/   \/_/ \/_/   \/_____/
+ */
+
+
+/**
+ *	Get size of subtree, but not more than limit
+ *
+ *	@param	nd			Node in AST
+ *	@param	limit		Size limit
+ *
+ *	@return	Number of nodes in subtree
+ */
+static size_t inline_get_size(const node *const nd, const size_t limit)
+{
+	size_t size = 1;
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount && size <= limit; i++)
+	{
+		const node child = node_get_child(nd, i);
+		size += inline_get_size(&child, limit - size);
+	}
+
+	return size;
+}
+
+/**
+ *	Check if subtree contains calls or, optionally, other side effects
+ *
+ *	@param	nd			Node in AST
+ *	@param	is_call		Set to search for calls only
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool inline_has_effect(const node *const nd, const bool is_call)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_CALL:
+			return true;
+
+		case OP_ASSIGNMENT:
+			if (!is_call)
+			{
+				return true;
+			}
+			break;
+
+		case OP_UNARY:
+			switch (expression_unary_get_operator(nd))
+			{
+				case UN_POSTINC:
+				case UN_POSTDEC:
+				case UN_PREINC:
+				case UN_PREDEC:
+					if (!is_call)
+					{
+						return true;
+					}
+					break;
+
+				default:
+					break;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (inline_has_effect(&child, is_call))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Count uses of identifier in subtree
+ *
+ *	@param	nd			Node in AST
+ *	@param	id			Identifier
+ *	@param	is_object	Set, if node is used as an object
+ *
+ *	@return	Number of uses, @c SIZE_MAX if identifier is used as an object
+ */
+static size_t inline_count_uses(const node *const nd, const size_t id, const bool is_object)
+{
+	if (node_get_type(nd) == OP_IDENTIFIER && expression_identifier_get_id(nd) == id)
+	{
+		return is_object ? SIZE_MAX : 1;
+	}
+
+	size_t uses = 0;
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount && uses != SIZE_MAX; i++)
+	{
+		const node child = node_get_child(nd, i);
+		const size_t child_uses = inline_count_uses(&child, id, is_object_operand(nd, i));
+		uses = child_uses == SIZE_MAX ? SIZE_MAX : uses + child_uses;
+	}
+
+	return uses;
+}
+
+/**
+ *	Check if variable of this type can be a copy of parameter or local variable
+ *
+ *	@param	opt			Optimizer
+ *	@param	type		Variable type
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool inline_is_simple_type(const optimizer *const opt, const item_t type)
+{
+	return !type_is_const(opt->sx, type) && (type_is_scalar(opt->sx, type) || type_is_floating(opt->sx, type));
+}
+
+/**
+ *	Check if function parameters match call arguments and can be copied
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Call expression
+ *	@param	func		Function definition
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool inline_check_arguments(const optimizer *const opt, const node *const nd, const node *const func)
+{
+	const size_t amount = declaration_function_get_parameters_amount(func);
+	if (expression_call_get_arguments_amount(nd) != amount)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const size_t parameter = declaration_function_get_parameter(func, i);
+		const item_t type = ident_get_type(opt->sx, parameter);
+		const node argument = expression_call_get_argument(nd, i);
+
+		if (ident_get_displ(opt->sx, parameter) < 0 || !inline_is_simple_type(opt, type)
+			|| expression_get_type(&argument) != type)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *	Check if function body can be inlined as a block
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in function body
+ *	@param	is_last		Set, if node is the last statement of function body
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool inline_check_body(const optimizer *const opt, const node *const nd, const bool is_last)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_RETURN:
+			// Return может быть только последним оператором тела функции
+			if (!is_last)
+			{
+				return false;
+			}
+			break;
+
+		case OP_DECL_VAR:
+			if (declaration_variable_get_bounds_amount(nd) != 0
+				|| !inline_is_simple_type(opt, ident_get_type(opt->sx, declaration_variable_get_id(nd))))
+			{
+				return false;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (!inline_check_body(opt, &child, false))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *	Copy subtree with renaming of callee identifiers
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Source node
+ *	@param	context		Parent of the copy
+ *
+ *	@return	Copied node
+ */
+static node inline_clone(optimizer *const opt, const node *const nd, const node *const context)
+{
+	const item_t type = node_get_type(nd);
+	const size_t id_index = type == OP_IDENTIFIER ? 2 : 0;
+	const item_t rename = type == OP_IDENTIFIER || type == OP_DECL_VAR
+		? vector_get(&opt->renames, (size_t)node_get_arg(nd, id_index))
+		: 0;
+
+	if (rename < 0)
+	{
+		// Параметр подставляется копией аргумента
+		const node argument = node_load(&opt->sx->tree, (size_t)-rename);
+		return inline_clone(opt, &argument, context);
+	}
+
+	const node result = node_add_child(context, type);
+	const size_t argc = node_get_argc(nd);
+	for (size_t i = 0; i < argc; i++)
+	{
+		node_add_arg(&result, node_get_arg(nd, i));
+	}
+
+	if (rename > 0 && rename != ITEM_MAX)
+	{
+		node_set_arg(&result, id_index, rename);
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		inline_clone(opt, &child, &result);
+	}
+
+	return result;
+}
+
+/**
+ *	Add fresh identifier for local variable of inlined function
+ *
+ *	@param	opt			Optimizer
+ *	@param	id			Original identifier
+ *
+ *	@return	New identifier
+ */
+static size_t inline_copy_ident(optimizer *const opt, const size_t id)
+{
+	const size_t result = ident_copy(opt->sx, id);
+	vector_increase(&opt->renames, vector_size(&opt->sx->identifiers) - vector_size(&opt->renames));
+	return result;
+}
+
+/**
+ *	Give fresh identifiers to local variables of inlined function
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in function body
+ */
+static void inline_rename_locals(optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_DECL_VAR)
+	{
+		const size_t id = declaration_variable_get_id(nd);
+		vector_set(&opt->renames, id, (item_t)inline_copy_ident(opt, id));
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		inline_rename_locals(opt, &child);
+	}
+}
+
+/**
+ *	Reset identifier renaming after inlining
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in function body
+ */
+static void inline_reset_renames(optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_DECL_VAR)
+	{
+		vector_set(&opt->renames, declaration_variable_get_id(nd), 0);
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		inline_reset_renames(opt, &child);
+	}
+}
+
+/**
+ *	Replace call of function, whose body is a single return statement, by the returned expression
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Call expression
+ *
+ *	@return	Optimized expression
+ */
+static node inline_expression(optimizer *const opt, node *const nd)
+{
+	node func;
+	if (!function_get_definition(opt, nd, &func) || !inline_check_arguments(opt, nd, &func))
+	{
+		return *nd;
+	}
+
+	const node body = declaration_function_get_body(&func);
+	if (statement_compound_get_size(&body) != 1)
+	{
+		return *nd;
+	}
+
+	const node stmt = statement_compound_get_substmt(&body, 0);
+	if (statement_get_class(&stmt) != STMT_RETURN || !statement_return_has_expression(&stmt))
+	{
+		return *nd;
+	}
+
+	const node expr = statement_return_get_expression(&stmt);
+	if (expression_get_type(&expr) != expression_get_type(nd)
+		|| inline_get_size(&expr, MAX_INLINE_SIZE) > MAX_INLINE_SIZE || inline_has_effect(&expr, false))
+	{
+		return *nd;
+	}
+
+	const size_t amount = declaration_function_get_parameters_amount(&func);
+	for (size_t i = 0; i < amount; i++)
+	{
+		// Сложный аргумент без побочных эффектов можно подставить не более одного раза
+		const size_t parameter = declaration_function_get_parameter(&func, i);
+		const node argument = expression_call_get_argument(nd, i);
+		const size_t uses = inline_count_uses(&expr, parameter, false);
+		const expression_t class = expression_get_class(&argument);
+
+		if (uses == SIZE_MAX || inline_has_effect(&argument, false)
+			|| (uses > 1 && class != EXPR_IDENTIFIER && class != EXPR_LITERAL))
+		{
+			return *nd;
+		}
+	}
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node argument = expression_call_get_argument(nd, i);
+		vector_set(&opt->renames, declaration_function_get_parameter(&func, i), -(item_t)node_save(&argument));
+	}
+
+	node result = inline_clone(opt, &expr, nd);
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		vector_set(&opt->renames, declaration_function_get_parameter(&func, i), 0);
+	}
+
+	uni_printf(&opt->report, "inlined call of %s\n"
+		, ident_get_spelling(opt->sx, declaration_function_get_id(&func)));
+	opt->inlined++;
+
+	node_swap(nd, &result);
+	return constant_propagation(opt, &result, false);
+}
+
+/**
+ *	Replace statement with call of small leaf function by a block with copy of function body
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Expression statement with call, assignment of call result or return of call result
+ *
+ *	@return	Optimized statement
+ */
+static node inline_statement(optimizer *const opt, node *const nd)
+{
+	node call = *nd;
+	if (node_get_type(nd) == OP_RETURN && statement_return_has_expression(nd))
+	{
+		call = statement_return_get_expression(nd);
+	}
+	else if (node_get_type(nd) == OP_ASSIGNMENT && expression_assignment_get_operator(nd) == BIN_ASSIGN)
+	{
+		const node LHS = expression_assignment_get_LHS(nd);
+		if (expression_get_class(&LHS) != EXPR_IDENTIFIER)
+		{
+			return *nd;
+		}
+
+		call = expression_assignment_get_RHS(nd);
+	}
+
+	node func;
+	if (node_get_type(&call) != OP_CALL || !function_get_definition(opt, &call, &func)
+		|| !inline_check_arguments(opt, &call, &func))
+	{
+		return *nd;
+	}
+
+	const node body = declaration_function_get_body(&func);
+	const size_t size = statement_compound_get_size(&body);
+	node last = size != 0 ? statement_compound_get_substmt(&body, size - 1) : body;
+	const bool has_return = size != 0 && statement_get_class(&last) == STMT_RETURN;
+	const bool has_value = has_return && statement_return_has_expression(&last);
+
+	if ((node_get_type(nd) == OP_ASSIGNMENT && !has_value)
+		|| inline_get_size(&body, MAX_INLINE_SIZE) > MAX_INLINE_SIZE || inline_has_effect(&body, true))
+	{
+		return *nd;
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		const node substmt = statement_compound_get_substmt(&body, i);
+		if (!inline_check_body(opt, &substmt, i == size - 1))
+		{
+			return *nd;
+		}
+	}
+
+	const location loc = node_get_location(nd);
+	node result = statement_compound(nd, NULL, loc);
+
+	// Параметры становятся локальными переменными, инициализированными аргументами
+	const size_t amount = declaration_function_get_parameters_amount(&func);
+	if (amount != 0)
+	{
+		node decl_stmt = statement_declaration(&result);
+		statement_declaration_set_location(&decl_stmt, loc);
+
+		for (size_t i = 0; i < amount; i++)
+		{
+			const size_t parameter = declaration_function_get_parameter(&func, i);
+			const size_t id = inline_copy_ident(opt, parameter);
+			const node argument = expression_call_get_argument(&call, i);
+
+			node initializer = inline_clone(opt, &argument, &result);
+			declaration_variable(&decl_stmt, id, NULL, &initializer, loc);
+			vector_set(&opt->renames, parameter, (item_t)id);
+		}
+	}
+
+	inline_rename_locals(opt, &body);
+	for (size_t i = 0; i < (has_return ? size - 1 : size); i++)
+	{
+		const node substmt = statement_compound_get_substmt(&body, i);
+		inline_clone(opt, &substmt, &result);
+	}
+
+	// Оператор return превращается в присваивание значения
+	if (node_get_type(nd) == OP_RETURN)
+	{
+		node value = last;
+		if (has_value)
+		{
+			const node expr = statement_return_get_expression(&last);
+			value = inline_clone(opt, &expr, &result);
+		}
+
+		statement_return(&result, has_value ? &value : NULL, loc);
+	}
+	else if (node_get_type(nd) == OP_ASSIGNMENT)
+	{
+		const node LHS = expression_assignment_get_LHS(nd);
+		node target = inline_clone(opt, &LHS, &result);
+		const node expr = statement_return_get_expression(&last);
+		node value = inline_clone(opt, &expr, &result);
+
+		expression_assignment(expression_get_type(nd), &target, &value, BIN_ASSIGN, loc);
+	}
+	else if (has_value)
+	{
+		const node expr = statement_return_get_expression(&last);
+		if (inline_has_effect(&expr, false))
+		{
+			inline_clone(opt, &expr, &result);
+		}
+	}
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		vector_set(&opt->renames, declaration_function_get_parameter(&func, i), 0);
+	}
+	inline_reset_renames(opt, &body);
+
+	uni_printf(&opt->report, "inlined call of %s\n"
+		, ident_get_spelling(opt->sx, declaration_function_get_id(&func)));
+	opt->inlined++;
+
+	node_swap(nd, &result);
+	return result;
+}
+
+/**
+ *	Check if child node is a statement
+ *
+ *	@param	nd			Parent node
+ *	@param	index		Child index
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_statement_operand(const node *const nd, const size_t index)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_BLOCK:
+			return true;
+
+		case OP_IF:
+		case OP_CASE:
+			return index != 0;
+
+		case OP_WHILE:
+			return index == 1;
+
+		case OP_DO:
+		case OP_FOR:
+		case OP_DEFAULT:
+			return index == 0;
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Inline calls of small leaf functions
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ *
+ *	@return	Optimized node
+ */
+static node inline_calls(optimizer *const opt, node *const nd)
+{
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		node child = node_get_child(nd, i);
+		child = inline_calls(opt, &child);
+
+		if (is_statement_operand(nd, i))
+		{
+			inline_statement(opt, &child);
+		}
+	}
+
+	return node_get_type(nd) == OP_CALL ? inline_expression(opt, nd) : *nd;
+}
+
+
+/*
+ *	 __         ______     ______     ______   ______
+ *	/\ \       /\  __ \   /\  __ \   /\  == \ /\  ___\
+ *	\ \ \____  \ \ \/\ \  \ \ \/\ \  \ \  _-/ \ \___  \
+ *	 \ \_____\  \ \_____\  \ \_____\  \ \_\    \/\_____\
+ *	  \/_____/   \/_____/   \/_____/   \/_/     \/_____/
+ */
+
+
+/**
+ *	Check if child node is an object modified by parent expression
+ *
+ *	@param	nd			Parent node
+ *	@param	index		Child index
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool is_written_operand(const node *const nd, const size_t index)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_UNARY:
+			switch (expression_unary_get_operator(nd))
+			{
+				case UN_POSTINC:
+				case UN_POSTDEC:
+				case UN_PREINC:
+				case UN_PREDEC:
+					return true;
+				default:
+					return false;
+			}
+
+		case OP_ASSIGNMENT:
+			return index == 0;
+
+		case OP_CALL:
+		{
+			const node callee = expression_call_get_callee(nd);
+			return index != 0 && node_get_type(&callee) == OP_IDENTIFIER
+				&& expression_identifier_get_id(&callee) == BI_GETID;
+		}
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Mark variables, whose address is taken, as written in every loop
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ */
+static void loop_register_addresses(optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_UNARY && expression_unary_get_operator(nd) == UN_ADDRESS)
+	{
+		const node operand = expression_unary_get_operand(nd);
+		if (node_get_type(&operand) == OP_IDENTIFIER)
+		{
+			vector_set(&opt->written, expression_identifier_get_id(&operand), ITEM_MAX);
+		}
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		loop_register_addresses(opt, &child);
+	}
+}
+
+/**
+ *	Mark variables written or declared in the current loop
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in loop
+ */
+static void loop_mark_written(optimizer *const opt, const node *const nd)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_DECL_VAR:
+		{
+			const size_t id = declaration_variable_get_id(nd);
+			if (vector_get(&opt->written, id) != ITEM_MAX)
+			{
+				vector_set(&opt->written, id, (item_t)opt->loops);
+			}
+			break;
+		}
+
+		case OP_CALL:
+		{
+			// Функции вывода не изменяют переменные программы
+			const node callee = expression_call_get_callee(nd);
+			const size_t func = node_get_type(&callee) == OP_IDENTIFIER
+				? expression_identifier_get_id(&callee)
+				: SIZE_MAX;
+			opt->has_call = opt->has_call || (func != BI_PRINTF && func != BI_PRINT && func != BI_PRINTID);
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (node_get_type(&child) == OP_IDENTIFIER && is_written_operand(nd, i))
+		{
+			const size_t id = expression_identifier_get_id(&child);
+			if (vector_get(&opt->written, id) != ITEM_MAX)
+			{
+				vector_set(&opt->written, id, (item_t)opt->loops);
+			}
+		}
+
+		loop_mark_written(opt, &child);
+	}
+}
+
+/**
+ *	Check if variable keeps its value during the current loop
+ *	@note	Global variable may be changed by another thread, so only local ones are invariant
+ *
+ *	@param	opt			Optimizer
+ *	@param	id			Variable identifier
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_is_invariant_variable(const optimizer *const opt, const size_t id)
+{
+	const item_t stamp = vector_get(&opt->written, id);
+	return stamp != ITEM_MAX && stamp != (item_t)opt->loops && ident_is_local(opt->sx, id);
+}
+
+/**
+ *	Check if expression has the same value in every iteration of the current loop and can't fail
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Expression
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_is_invariant(const optimizer *const opt, const node *const nd)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_LITERAL:
+			return true;
+
+		case OP_IDENTIFIER:
+		{
+			const item_t type = expression_get_type(nd);
+			return (type_is_scalar(opt->sx, type) || type_is_floating(opt->sx, type))
+				&& loop_is_invariant_variable(opt, expression_identifier_get_id(nd));
+		}
+
+		case OP_UNARY:
+		{
+			const node operand = expression_unary_get_operand(nd);
+			switch (expression_unary_get_operator(nd))
+			{
+				case UN_MINUS:
+				case UN_NOT:
+				case UN_LOGNOT:
+				case UN_ABS:
+					return loop_is_invariant(opt, &operand);
+
+				case UN_UPB:
+					// Граница массива меняется только при присваивании массива
+					return node_get_type(&operand) == OP_IDENTIFIER
+						&& loop_is_invariant_variable(opt, expression_identifier_get_id(&operand));
+
+				default:
+					return false;
+			}
+		}
+
+		case OP_CAST:
+		{
+			const node operand = expression_cast_get_operand(nd);
+			return type_is_integer(opt->sx, expression_cast_get_source_type(nd)) && loop_is_invariant(opt, &operand);
+		}
+
+		case OP_BINARY:
+		{
+			const node LHS = expression_binary_get_LHS(nd);
+			const node RHS = expression_binary_get_RHS(nd);
+			const binary_t op = expression_binary_get_operator(nd);
+
+			// Целочисленное деление выносится из цикла, только если оно не может завершиться аварийно
+			if ((op == BIN_DIV || op == BIN_REM) && type_is_integer(opt->sx, expression_get_type(nd))
+				&& (expression_get_class(&RHS) != EXPR_LITERAL || expression_literal_get_integer(&RHS) == 0
+					|| expression_literal_get_integer(&RHS) == -1))
+			{
+				return false;
+			}
+
+			return loop_is_invariant(opt, &LHS) && loop_is_invariant(opt, &RHS);
+		}
+
+		case OP_TERNARY:
+		{
+			const node cond = expression_ternary_get_condition(nd);
+			const node LHS = expression_ternary_get_LHS(nd);
+			const node RHS = expression_ternary_get_RHS(nd);
+			return loop_is_invariant(opt, &cond) && loop_is_invariant(opt, &LHS) && loop_is_invariant(opt, &RHS);
+		}
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Find local variable used in the loop
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in loop
+ *
+ *	@return	Variable identifier, @c SIZE_MAX on failure
+ */
+static size_t loop_find_local(const optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_IDENTIFIER && ident_is_local(opt->sx, expression_identifier_get_id(nd)))
+	{
+		return expression_identifier_get_id(nd);
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		const size_t id = loop_find_local(opt, &child);
+		if (id != SIZE_MAX)
+		{
+			return id;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/**
+ *	Copy subtree
+ *
+ *	@param	nd			Source node
+ *	@param	context		Parent of the copy
+ *
+ *	@return	Copied node
+ */
+static node loop_clone(const node *const nd, const node *const context)
+{
+	const node result = node_add_child(context, node_get_type(nd));
+	const size_t argc = node_get_argc(nd);
+	for (size_t i = 0; i < argc; i++)
+	{
+		node_add_arg(&result, node_get_arg(nd, i));
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		loop_clone(&child, &result);
+	}
+
+	return result;
+}
+
+/**
+ *	Add temporary variable to be declared before the loop
+ *	@note	The loop is enclosed in a block with declaration statement on the first call
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Loop statement
+ *	@param	decl_stmt	Declaration statement before the loop
+ *	@param	local		Local variable, whose name is given to temporary variable
+ *	@param	type		Temporary variable type
+ *
+ *	@return	Temporary variable identifier
+ */
+static size_t loop_add_temporary(optimizer *const opt, const node *const nd, node *const decl_stmt
+	, const size_t local, const item_t type)
+{
+	if (!node_is_correct(decl_stmt))
+	{
+		node block = statement_compound_enclose(nd);
+		*decl_stmt = statement_declaration(&block);
+		statement_declaration_set_location(decl_stmt, node_get_location(nd));
+		node_swap(decl_stmt, nd);
+	}
+
+	const size_t id = ident_copy(opt->sx, local);
+	ident_set_type(opt->sx, id, type);
+	return id;
+}
+
+/**
+ *	Replace expression by variable, the expression is moved to the end of its parent
+ *
+ *	@param	nd			Expression
+ *	@param	id			Variable identifier
+ */
+static void loop_replace_expression(const node *const nd, const size_t id)
+{
+	node parent = node_get_parent(nd);
+	const node result = expression_identifier(&parent, expression_get_type(nd), id, node_get_location(nd));
+	node_swap(nd, &result);
+}
+
+/**
+ *	Check if expressions are equal, except their locations
+ *
+ *	@param	fst			First expression
+ *	@param	snd			Second expression
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_is_equal(const node *const fst, const node *const snd)
+{
+	const size_t argc = node_get_argc(fst);
+	const size_t amount = node_get_amount(fst);
+	if (node_get_type(fst) != node_get_type(snd) || node_get_argc(snd) != argc || node_get_amount(snd) != amount)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i + 2 < argc; i++)
+	{
+		if (node_get_arg(fst, i) != node_get_arg(snd, i))
+		{
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node fst_child = node_get_child(fst, i);
+		const node snd_child = node_get_child(snd, i);
+		if (!loop_is_equal(&fst_child, &snd_child))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ *	Find temporary variable, which is already initialized by the same expression
+ *
+ *	@param	decl_stmt	Declaration statement before the loop
+ *	@param	nd			Expression
+ *
+ *	@return	Temporary variable identifier, @c SIZE_MAX on failure
+ */
+static size_t loop_find_temporary(const node *const decl_stmt, const node *const nd)
+{
+	const size_t amount = node_is_correct(decl_stmt) ? statement_declaration_get_size(decl_stmt) : 0;
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node decl = statement_declaration_get_declarator(decl_stmt, i);
+		const node initializer = declaration_variable_get_initializer(&decl);
+		if (loop_is_equal(&initializer, nd))
+		{
+			return declaration_variable_get_id(&decl);
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/**
+ *	Move invariant expressions out of the loop to temporary variables
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in loop
+ *	@param	loop		Loop statement
+ *	@param	decl_stmt	Declaration statement before the loop
+ *	@param	local		Local variable, whose name is given to temporary variables
+ */
+static void loop_hoist_invariants(optimizer *const opt, node *const nd, const node *const loop
+	, node *const decl_stmt, const size_t local)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_UNARY:
+		case OP_BINARY:
+		case OP_CAST:
+		case OP_TERNARY:
+		{
+			const item_t type = expression_get_type(nd);
+			if ((type == TYPE_INTEGER || type == TYPE_FLOATING) && loop_is_invariant(opt, nd))
+			{
+				const size_t found = loop_find_temporary(decl_stmt, nd);
+				const size_t id = found != SIZE_MAX ? found : loop_add_temporary(opt, loop, decl_stmt, local, type);
+				loop_replace_expression(nd, id);
+
+				if (found != SIZE_MAX)
+				{
+					node_remove(nd);
+				}
+				else
+				{
+					declaration_variable(decl_stmt, id, NULL, nd, node_get_location(loop));
+				}
+
+				opt->hoisted++;
+				return;
+			}
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		node child = node_get_child(nd, i);
+		loop_hoist_invariants(opt, &child, loop, decl_stmt, local);
+	}
+}
+
+/**
+ *	Get variable and step of increment expression
+ *
+ *	@param	nd			Increment expression
+ *	@param	iv			Induction variable
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_get_step(const node *const nd, induction *const iv)
+{
+	node operand;
+	switch (node_get_type(nd))
+	{
+		case OP_UNARY:
+			switch (expression_unary_get_operator(nd))
+			{
+				case UN_POSTINC:
+				case UN_PREINC:
+					iv->step = 1;
+					break;
+				case UN_POSTDEC:
+				case UN_PREDEC:
+					iv->step = -1;
+					break;
+				default:
+					return false;
+			}
+
+			operand = expression_unary_get_operand(nd);
+			break;
+
+		case OP_ASSIGNMENT:
+		{
+			const binary_t op = expression_assignment_get_operator(nd);
+			const node RHS = expression_assignment_get_RHS(nd);
+			if ((op != BIN_ADD_ASSIGN && op != BIN_SUB_ASSIGN)
+				|| expression_get_class(&RHS) != EXPR_LITERAL || expression_get_type(&RHS) != TYPE_INTEGER)
+			{
+				return false;
+			}
+
+			iv->step = op == BIN_ADD_ASSIGN ? expression_literal_get_integer(&RHS) : -expression_literal_get_integer(&RHS);
+			operand = expression_assignment_get_LHS(nd);
+			break;
+		}
+
+		default:
+			return false;
+	}
+
+	if (node_get_type(&operand) != OP_IDENTIFIER || expression_get_type(&operand) != TYPE_INTEGER)
+	{
+		return false;
+	}
+
+	iv->id = expression_identifier_get_id(&operand);
+	return true;
+}
+
+/**
+ *	Get induction variable of for statement, which is changed only by increment expression
+ *	@note	Loop condition and body must be already marked
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			For statement
+ *	@param	iv			Induction variable
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_get_induction(const optimizer *const opt, const node *const nd, induction *const iv)
+{
+	if (!statement_for_has_increment(nd))
+	{
+		return false;
+	}
+
+	const node increment = statement_for_get_increment(nd);
+	return loop_get_step(&increment, iv) && ident_is_local(opt->sx, iv->id) && loop_is_invariant_variable(opt, iv->id);
+}
+
+/**
+ *	Get initial value of induction variable
+ *	@note	Loop inition must be already marked
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			For statement
+ *	@param	iv			Induction variable
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool loop_get_initial(const optimizer *const opt, const node *const nd, induction *const iv)
+{
+	iv->initial = node_broken();
+	if (!statement_for_has_inition(nd))
+	{
+		return true;
+	}
+
+	const node inition = statement_for_get_inition(nd);
+	if (node_get_type(&inition) == OP_ASSIGNMENT && expression_assignment_get_operator(&inition) == BIN_ASSIGN)
+	{
+		const node LHS = expression_assignment_get_LHS(&inition);
+		if (node_get_type(&LHS) == OP_IDENTIFIER && expression_identifier_get_id(&LHS) == iv->id)
+		{
+			iv->initial = expression_assignment_get_RHS(&inition);
+		}
+	}
+	else if (node_get_type(&inition) == OP_DECLSTMT && statement_declaration_get_size(&inition) == 1)
+	{
+		const node decl = statement_declaration_get_declarator(&inition, 0);
+		if (node_get_type(&decl) == OP_DECL_VAR && declaration_variable_get_id(&decl) == iv->id
+			&& declaration_variable_has_initializer(&decl))
+		{
+			iv->initial = declaration_variable_get_initializer(&decl);
+		}
+	}
+
+	// Начальное значение вычисляется перед циклом ещё раз
+	return node_is_correct(&iv->initial)
+		? expression_get_type(&iv->initial) == TYPE_INTEGER && !inline_has_effect(&iv->initial, false)
+		: loop_is_invariant_variable(opt, iv->id);
+}
+
+/**
+ *	Get index of reduced factor of induction variable
+ *
+ *	@param	iv			Induction variable
+ *	@param	factor		Literal or invariant variable
+ *
+ *	@return	Index of factor record
+ */
+static size_t loop_get_factor(induction *const iv, const node *const factor)
+{
+	const expression_t class = expression_get_class(factor);
+	const item_t value = class == EXPR_LITERAL
+		? expression_literal_get_integer(factor)
+		: (item_t)expression_identifier_get_id(factor);
+
+	const size_t amount = vector_size(&iv->factors);
+	for (size_t i = 0; i < amount; i += 4)
+	{
+		if (vector_get(&iv->factors, i) == (item_t)class && vector_get(&iv->factors, i + 1) == value)
+		{
+			return i;
+		}
+	}
+
+	vector_add(&iv->factors, (item_t)class);
+	vector_add(&iv->factors, value);
+	vector_add(&iv->factors, 0);
+	vector_add(&iv->factors, 0);
+	return amount;
+}
+
+/**
+ *	Add temporary variable equal to product of induction variable and factor
+ *
+ *	@param	opt			Optimizer
+ *	@param	loop		For statement
+ *	@param	decl_stmt	Declaration statement before the loop
+ *	@param	iv			Induction variable
+ *	@param	factor		Literal or invariant variable
+ *
+ *	@return	Temporary variable identifier
+ */
+static size_t loop_add_product(optimizer *const opt, const node *const loop, node *const decl_stmt
+	, const induction *const iv, const node *const factor)
+{
+	const location loc = node_get_location(loop);
+	const size_t id = loop_add_temporary(opt, loop, decl_stmt, iv->id, TYPE_INTEGER);
+	const bool is_literal = expression_get_class(factor) == EXPR_LITERAL;
+
+	// Произведение вычисляется перед циклом
+	node block = node_get_parent(decl_stmt);
+	node product;
+	if (node_is_correct(&iv->initial) && expression_get_class(&iv->initial) == EXPR_LITERAL
+		&& (is_literal || expression_literal_get_integer(&iv->initial) == 0))
+	{
+		const item_t multiplier = is_literal ? expression_literal_get_integer(factor) : 0;
+		product = expression_integer_literal(&block, TYPE_INTEGER
+			, expression_literal_get_integer(&iv->initial) * multiplier, loc);
+	}
+	else
+	{
+		node initial = node_is_correct(&iv->initial)
+			? loop_clone(&iv->initial, &block)
+			: expression_identifier(&block, TYPE_INTEGER, iv->id, loc);
+		node multiplier = loop_clone(factor, &block);
+		product = expression_binary(TYPE_INTEGER, &initial, &multiplier, BIN_MUL, loc);
+	}
+	declaration_variable(decl_stmt, id, NULL, &product, loc);
+
+	// и увеличивается в конце каждой итерации
+	node body = statement_for_get_body(loop);
+	node target = expression_identifier(&body, TYPE_INTEGER, id, loc);
+	node increment;
+	if (is_literal)
+	{
+		increment = expression_integer_literal(&body, TYPE_INTEGER, expression_literal_get_integer(factor) * iv->step, loc);
+	}
+	else
+	{
+		increment = loop_clone(factor, &body);
+		if (iv->step != 1 && iv->step != -1)
+		{
+			node step = expression_integer_literal(&body, TYPE_INTEGER, iv->step, loc);
+			increment = expression_binary(TYPE_INTEGER, &increment, &step, BIN_MUL, loc);
+		}
+	}
+
+	const binary_t op = !is_literal && iv->step == -1 ? BIN_SUB_ASSIGN : BIN_ADD_ASSIGN;
+	expression_assignment(TYPE_INTEGER, &target, &increment, op, loc);
+	return id;
+}
+
+/**
+ *	Replace multiplications of induction variable by temporary variables changed with induction variable
+ *	@note	Product is reduced only if it is used several times, otherwise the update costs as much as the product
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in loop body
+ *	@param	loop		For statement
+ *	@param	decl_stmt	Declaration statement before the loop
+ *	@param	iv			Induction variable
+ *	@param	is_counting	Set to count uses of products without reduction
+ */
+static void loop_reduce_multiplications(optimizer *const opt, node *const nd, const node *const loop
+	, node *const decl_stmt, induction *const iv, const bool is_counting)
+{
+	if (node_get_type(nd) == OP_BINARY && expression_binary_get_operator(nd) == BIN_MUL
+		&& expression_get_type(nd) == TYPE_INTEGER)
+	{
+		const node LHS = expression_binary_get_LHS(nd);
+		const node RHS = expression_binary_get_RHS(nd);
+		const bool is_left = node_get_type(&LHS) == OP_IDENTIFIER && expression_identifier_get_id(&LHS) == iv->id;
+		const bool is_right = node_get_type(&RHS) == OP_IDENTIFIER && expression_identifier_get_id(&RHS) == iv->id;
+		const node factor = is_left ? RHS : LHS;
+
+		if ((is_left || is_right) && expression_get_type(&factor) == TYPE_INTEGER
+			&& (expression_get_class(&factor) == EXPR_LITERAL || (node_get_type(&factor) == OP_IDENTIFIER
+				&& loop_is_invariant_variable(opt, expression_identifier_get_id(&factor)))))
+		{
+			const size_t index = loop_get_factor(iv, &factor);
+			const item_t uses = vector_get(&iv->factors, index + 2);
+			if (is_counting)
+			{
+				vector_set(&iv->factors, index + 2, uses + 1);
+			}
+			else if (uses > 1)
+			{
+				if (vector_get(&iv->factors, index + 3) == 0)
+				{
+					const size_t id = loop_add_product(opt, loop, decl_stmt, iv, &factor);
+					vector_set(&iv->factors, index + 3, (item_t)id);
+				}
+
+				loop_replace_expression(nd, (size_t)vector_get(&iv->factors, index + 3));
+				node_remove(nd);
+				opt->reduced++;
+			}
+			return;
+		}
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		node child = node_get_child(nd, i);
+		loop_reduce_multiplications(opt, &child, loop, decl_stmt, iv, is_counting);
+	}
+}
+
+/**
+ *	Move invariant expressions out of the loop and reduce multiplications by induction variable
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Loop statement
+ */
+static void loop_optimize(optimizer *const opt, const node *const nd)
+{
+	opt->loops++;
+	opt->has_call = false;
+
+	induction iv;
+	bool has_induction = false;
+	if (node_get_type(nd) == OP_FOR)
+	{
+		const node body = statement_for_get_body(nd);
+		if (statement_for_has_condition(nd))
+		{
+			const node cond = statement_for_get_condition(nd);
+			loop_mark_written(opt, &cond);
+		}
+		loop_mark_written(opt, &body);
+
+		has_induction = loop_get_induction(opt, nd, &iv);
+
+		if (statement_for_has_inition(nd))
+		{
+			const node inition = statement_for_get_inition(nd);
+			loop_mark_written(opt, &inition);
+		}
+		if (statement_for_has_increment(nd))
+		{
+			const node increment = statement_for_get_increment(nd);
+			loop_mark_written(opt, &increment);
+		}
+	}
+	else
+	{
+		loop_mark_written(opt, nd);
+	}
+
+	node decl_stmt = node_broken();
+	const size_t local = loop_find_local(opt, nd);
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount && local != SIZE_MAX; i++)
+	{
+		// Инициализация цикла for выполняется один раз
+		node child = node_get_child(nd, i);
+		if (node_get_type(nd) != OP_FOR || !statement_for_has_inition(nd) || i != 1)
+		{
+			loop_hoist_invariants(opt, &child, nd, &decl_stmt, local);
+		}
+	}
+
+	// Обновления произведений добавляются в конец тела, которое не должно пропускаться
+	node body = has_induction ? statement_for_get_body(nd) : node_broken();
+	if (has_induction && node_get_type(&body) == OP_BLOCK && !has_jump(&body, false)
+		&& loop_get_initial(opt, nd, &iv))
+	{
+		iv.factors = vector_create(4);
+		loop_reduce_multiplications(opt, &body, nd, &decl_stmt, &iv, true);
+		loop_reduce_multiplications(opt, &body, nd, &decl_stmt, &iv, false);
+		vector_clear(&iv.factors);
+	}
+}
+
+/**
+ *	Optimize loops
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ */
+static void loops_optimize(optimizer *const opt, const node *const nd)
+{
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		loops_optimize(opt, &child);
+	}
+
+	switch (node_get_type(nd))
+	{
+		case OP_WHILE:
+		case OP_DO:
+		case OP_FOR:
+			loop_optimize(opt, nd);
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/*
+ *	 ______      ______      __  __      __   __      _____      ______
+ *	/\  == \    /\  __ \    /\ \/\ \    /\ "-.\ \    /\  __-.   /\  ___\
+ *	\ \  __<    \ \ \/\ \   \ \ \_\ \   \ \ \-.  \   \ \ \/\ \  \ \___  \
+ *	 \ \_____\   \ \_____\   \ \_____\   \ \_\\"\_\   \ \____-   \/\_____\
+ *	  \/_____/    \/_____/    \/_____/    \/_/ \/_/    \/____/    \/_____/
+ */
+
+
+/**
+ *	Remember declared sizes of arrays, which are never reassigned
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ */
+static void bounds_register_sizes(optimizer *const opt, const node *const nd)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_DECL_VAR:
+		{
+			const size_t id = declaration_variable_get_id(nd);
+			if (declaration_variable_get_bounds_amount(nd) != 0 && !declaration_variable_has_initializer(nd)
+				&& vector_get(&opt->sizes, id) == 0)
+			{
+				const node bound = declaration_variable_get_bound(nd, 0);
+				if (expression_get_class(&bound) == EXPR_LITERAL && expression_get_type(&bound) == TYPE_INTEGER)
+				{
+					vector_set(&opt->sizes, id, expression_literal_get_integer(&bound));
+				}
+			}
+			break;
+		}
+
+		case OP_UNARY:
+			if (expression_unary_get_operator(nd) == UN_ADDRESS)
+			{
+				const node operand = expression_unary_get_operand(nd);
+				if (node_get_type(&operand) == OP_IDENTIFIER)
+				{
+					vector_set(&opt->sizes, expression_identifier_get_id(&operand), -1);
+				}
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (node_get_type(&child) == OP_IDENTIFIER && is_written_operand(nd, i))
+		{
+			vector_set(&opt->sizes, expression_identifier_get_id(&child), -1);
+		}
+
+		bounds_register_sizes(opt, &child);
+	}
+}
+
+/**
+ *	Get value of integer literal
+ *
+ *	@param	nd			Expression
+ *	@param	value		Literal value
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_get_literal(const node *const nd, item_t *const value)
+{
+	if (expression_get_class(nd) != EXPR_LITERAL || expression_get_type(nd) != TYPE_INTEGER)
+	{
+		return false;
+	}
+
+	*value = expression_literal_get_integer(nd);
+	return true;
+}
+
+/**
+ *	Get operand of upb expression
+ *
+ *	@param	nd			Expression
+ *
+ *	@return	Array expression, broken node on failure
+ */
+static node bounds_get_upb_operand(const node *const nd)
+{
+	return node_get_type(nd) == OP_UNARY && expression_unary_get_operator(nd) == UN_UPB
+		? expression_unary_get_operand(nd)
+		: node_broken();
+}
+
+/**
+ *	Get comparison of induction variable, as if the variable is its left operand
+ *
+ *	@param	nd			Expression
+ *	@param	id			Induction variable identifier
+ *	@param	op			Comparison operator
+ *	@param	bound		Compared expression
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_get_comparison(const node *const nd, const size_t id, binary_t *const op, node *const bound)
+{
+	if (node_get_type(nd) != OP_BINARY)
+	{
+		return false;
+	}
+
+	const node LHS = expression_binary_get_LHS(nd);
+	const node RHS = expression_binary_get_RHS(nd);
+	*op = expression_binary_get_operator(nd);
+	if (*op != BIN_LT && *op != BIN_GT && *op != BIN_LE && *op != BIN_GE)
+	{
+		return false;
+	}
+
+	if (node_get_type(&LHS) == OP_IDENTIFIER && expression_identifier_get_id(&LHS) == id)
+	{
+		*bound = RHS;
+		return true;
+	}
+
+	if (node_get_type(&RHS) == OP_IDENTIFIER && expression_identifier_get_id(&RHS) == id)
+	{
+		*op = *op == BIN_LT ? BIN_GT : *op == BIN_GT ? BIN_LT : *op == BIN_LE ? BIN_GE : BIN_LE;
+		*bound = LHS;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ *	Get upper bound of induction variable from loop condition
+ *
+ *	@param	nd			Loop condition
+ *	@param	id			Induction variable identifier
+ *	@param	array		Array, whose upb bounds the variable
+ *	@param	limit		Literal bound, which the variable is less than
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_get_upper(const node *const nd, const size_t id, node *const array, item_t *const limit)
+{
+	if (node_get_type(nd) == OP_BINARY && expression_binary_get_operator(nd) == BIN_LOG_AND)
+	{
+		// Тело выполняется, только если истинны оба операнда
+		const node LHS = expression_binary_get_LHS(nd);
+		const node RHS = expression_binary_get_RHS(nd);
+		return bounds_get_upper(&LHS, id, array, limit) || bounds_get_upper(&RHS, id, array, limit);
+	}
+
+	binary_t op;
+	node bound;
+	item_t value;
+	if (!bounds_get_comparison(nd, id, &op, &bound))
+	{
+		return false;
+	}
+
+	if (op == BIN_LT)
+	{
+		*array = bounds_get_upb_operand(&bound);
+		if (node_is_correct(array))
+		{
+			return true;
+		}
+	}
+
+	if ((op == BIN_LT || op == BIN_LE) && bounds_get_literal(&bound, &value))
+	{
+		*limit = op == BIN_LT ? value : value + 1;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ *	Check if loop condition keeps induction variable non-negative
+ *
+ *	@param	nd			Loop condition
+ *	@param	id			Induction variable identifier
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_has_lower(const node *const nd, const size_t id)
+{
+	if (node_get_type(nd) == OP_BINARY && expression_binary_get_operator(nd) == BIN_LOG_AND)
+	{
+		const node LHS = expression_binary_get_LHS(nd);
+		const node RHS = expression_binary_get_RHS(nd);
+		return bounds_has_lower(&LHS, id) || bounds_has_lower(&RHS, id);
+	}
+
+	binary_t op;
+	node bound;
+	item_t value;
+	return bounds_get_comparison(nd, id, &op, &bound) && bounds_get_literal(&bound, &value)
+		&& ((op == BIN_GE && value >= 0) || (op == BIN_GT && value >= -1));
+}
+
+/**
+ *	Get upper bound of decreasing induction variable from its initial value
+ *
+ *	@param	nd			Initial value
+ *	@param	array		Array, whose upb bounds the variable
+ *	@param	limit		Literal bound, which the variable is less than
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_get_initial_upper(const node *const nd, node *const array, item_t *const limit)
+{
+	item_t value;
+	if (bounds_get_literal(nd, &value))
+	{
+		*limit = value + 1;
+		return true;
+	}
+
+	if (node_get_type(nd) != OP_BINARY || expression_binary_get_operator(nd) != BIN_SUB)
+	{
+		return false;
+	}
+
+	const node LHS = expression_binary_get_LHS(nd);
+	const node RHS = expression_binary_get_RHS(nd);
+	*array = bounds_get_upb_operand(&LHS);
+	return node_is_correct(array) && bounds_get_literal(&RHS, &value) && value >= 1;
+}
+
+/**
+ *	Check if statement contains assignment of array
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Statement
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_has_array_assignment(const optimizer *const opt, const node *const nd)
+{
+	if (node_get_type(nd) == OP_ASSIGNMENT && type_is_array(opt->sx, expression_get_type(nd)))
+	{
+		return true;
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		if (bounds_has_array_assignment(opt, &child))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ *	Check if array expression refers to the same array during the current loop
+ *	@note	Loop must be already marked
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Array expression
+ *	@param	loop		Loop statement
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_is_invariant_array(const optimizer *const opt, const node *const nd, const node *const loop)
+{
+	switch (node_get_type(nd))
+	{
+		case OP_IDENTIFIER:
+			return loop_is_invariant_variable(opt, expression_identifier_get_id(nd));
+
+		case OP_SLICE:
+		{
+			// Строка многомерного массива может быть заменена присваиванием или в вызванной функции
+			const node base = expression_subscript_get_base(nd);
+			const node index = expression_subscript_get_index(nd);
+			return !opt->has_call && loop_is_invariant(opt, &index) && !bounds_has_array_assignment(opt, loop)
+				&& bounds_is_invariant_array(opt, &base, loop);
+		}
+
+		default:
+			return false;
+	}
+}
+
+/**
+ *	Mark subscripts of array by induction variable as unchecked
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in loop body
+ *	@param	id			Induction variable identifier
+ *	@param	array		Array, whose upb bounds the variable, broken for literal bound
+ *	@param	limit		Literal bound, which the variable is less than
+ */
+static void bounds_mark_subscripts(optimizer *const opt, const node *const nd, const size_t id
+	, const node *const array, const item_t limit)
+{
+	if (node_get_type(nd) == OP_SLICE && !expression_subscript_is_unchecked(nd))
+	{
+		const node base = expression_subscript_get_base(nd);
+		const node index = expression_subscript_get_index(nd);
+		const bool is_bounded = node_is_correct(array)
+			? loop_is_equal(&base, array)
+			: node_get_type(&base) == OP_IDENTIFIER
+				&& vector_get(&opt->sizes, expression_identifier_get_id(&base)) >= limit;
+
+		if (is_bounded && node_get_type(&index) == OP_IDENTIFIER && expression_identifier_get_id(&index) == id)
+		{
+			expression_subscript_set_unchecked(nd);
+			opt->unchecked++;
+		}
+	}
+
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		bounds_mark_subscripts(opt, &child, id, array, limit);
+	}
+}
+
+/**
+ *	Eliminate bounds checks of subscripts by induction variable, whose range is limited by loop
+ *	@note	Loop must be already marked
+ *
+ *	@param	opt			Optimizer
+ *	@param	loop		Loop statement
+ *	@param	cond		Loop condition
+ *	@param	body		Loop body
+ *	@param	iv			Induction variable
+ */
+static void bounds_eliminate(optimizer *const opt, const node *const loop, const node *const cond
+	, const node *const body, const induction *const iv)
+{
+	node array = node_broken();
+	item_t limit = 0;
+	item_t initial;
+	if (iv->step > 0)
+	{
+		// Возрастающая переменная ограничена снизу начальным значением, сверху условием
+		if (!bounds_get_literal(&iv->initial, &initial) || initial < 0 || initial > INT32_MAX
+			|| !bounds_get_upper(cond, iv->id, &array, &limit))
+		{
+			return;
+		}
+
+		// После последней итерации переменная не должна переполниться и стать отрицательной,
+		// массивы длиной около INT32_MAX в памяти не помещаются, поэтому для upb достаточно малого шага
+		if (iv->step > MAX_BOUNDS_STEP || (!node_is_correct(&array) && limit - 1 > INT32_MAX - iv->step))
+		{
+			return;
+		}
+	}
+	else if (!bounds_has_lower(cond, iv->id) || !bounds_get_initial_upper(&iv->initial, &array, &limit))
+	{
+		return;
+	}
+
+	if (node_is_correct(&array) ? bounds_is_invariant_array(opt, &array, loop) : limit > 0)
+	{
+		bounds_mark_subscripts(opt, body, iv->id, &array, limit);
+	}
+}
+
+/**
+ *	Eliminate bounds checks in for statement
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			For statement
+ */
+static void bounds_for_eliminate(optimizer *const opt, const node *const nd)
+{
+	const node body = statement_for_get_body(nd);
+	if (!statement_for_has_condition(nd) || has_label(&body))
+	{
+		return;
+	}
+
+	opt->loops++;
+	opt->has_call = false;
+
+	const node cond = statement_for_get_condition(nd);
+	loop_mark_written(opt, &cond);
+	loop_mark_written(opt, &body);
+
+	induction iv;
+	const bool has_induction = loop_get_induction(opt, nd, &iv);
+	loop_mark_written(opt, nd);
+
+	if (has_induction && loop_get_initial(opt, nd, &iv) && node_is_correct(&iv.initial))
+	{
+		bounds_eliminate(opt, nd, &cond, &body, &iv);
+	}
+}
+
+/**
+ *	Get initial value of variable assigned by the statement before while statement
+ *
+ *	@param	nd			While statement
+ *	@param	iv			Induction variable
+ *
+ *	@return	@c true on success, @c false on failure
+ */
+static bool bounds_get_while_initial(const node *const nd, induction *const iv)
+{
+	const node parent = node_get_parent(nd);
+	if (node_get_type(&parent) != OP_BLOCK)
+	{
+		return false;
+	}
+
+	const size_t amount = statement_compound_get_size(&parent);
+	for (size_t i = 1; i < amount; i++)
+	{
+		const node stmt = statement_compound_get_substmt(&parent, i);
+		if (node_save(&stmt) != node_save(nd))
+		{
+			continue;
+		}
+
+		const node prev = statement_compound_get_substmt(&parent, i - 1);
+		if (node_get_type(&prev) == OP_ASSIGNMENT && expression_assignment_get_operator(&prev) == BIN_ASSIGN)
+		{
+			const node LHS = expression_assignment_get_LHS(&prev);
+			iv->initial = expression_assignment_get_RHS(&prev);
+			return node_get_type(&LHS) == OP_IDENTIFIER && expression_identifier_get_id(&LHS) == iv->id;
+		}
+
+		if (node_get_type(&prev) == OP_DECLSTMT)
+		{
+			const node decl = statement_declaration_get_declarator(&prev, statement_declaration_get_size(&prev) - 1);
+			iv->initial = node_get_type(&decl) == OP_DECL_VAR && declaration_variable_has_initializer(&decl)
+				? declaration_variable_get_initializer(&decl)
+				: node_broken();
+			return node_is_correct(&iv->initial) && declaration_variable_get_id(&decl) == iv->id;
+		}
+
+		return false;
+	}
+
+	return false;
+}
+
+/**
+ *	Eliminate bounds checks in while statement, whose body ends with increment of induction variable
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			While statement
+ */
+static void bounds_while_eliminate(optimizer *const opt, const node *const nd)
+{
+	const node body = statement_while_get_body(nd);
+	const size_t amount = node_get_type(&body) == OP_BLOCK ? statement_compound_get_size(&body) : 0;
+	if (amount == 0 || has_label(&body))
+	{
+		return;
+	}
+
+	opt->loops++;
+	opt->has_call = false;
+
+	const node cond = statement_while_get_condition(nd);
+	loop_mark_written(opt, &cond);
+	for (size_t i = 0; i + 1 < amount; i++)
+	{
+		const node stmt = statement_compound_get_substmt(&body, i);
+		loop_mark_written(opt, &stmt);
+	}
+
+	induction iv;
+	const node increment = statement_compound_get_substmt(&body, amount - 1);
+	const bool has_induction = loop_get_step(&increment, &iv) && ident_is_local(opt->sx, iv.id)
+		&& loop_is_invariant_variable(opt, iv.id);
+	loop_mark_written(opt, nd);
+
+	if (has_induction && bounds_get_while_initial(nd, &iv))
+	{
+		bounds_eliminate(opt, nd, &cond, &body, &iv);
+	}
+}
+
+/**
+ *	Eliminate bounds checks of subscripts in loops
+ *
+ *	@param	opt			Optimizer
+ *	@param	nd			Node in AST
+ */
+static void bounds_optimize(optimizer *const opt, const node *const nd)
+{
+	const size_t amount = node_get_amount(nd);
+	for (size_t i = 0; i < amount; i++)
+	{
+		const node child = node_get_child(nd, i);
+		bounds_optimize(opt, &child);
+	}
+
+	switch (node_get_type(nd))
+	{
+		case OP_FOR:
+			bounds_for_eliminate(opt, nd);
+			break;
+
+		case OP_WHILE:
+			bounds_while_eliminate(opt, nd);
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+int optimize(const workspace *const ws, syntax *const sx)
+{
+	if (ws_has_flag(ws, "-O0"))
+	{
+		return 0;
+	}
+
+	optimizer opt;
+	opt.sx = sx;
+	opt.report = io_create();
+	if (ws_has_flag(ws, "--opt-report"))
+	{
+		out_set_file(&opt.report, DEFAULT_REPORT);
+	}
+
+	opt.constants = vector_create(vector_size(&sx->identifiers));
+	vector_increase(&opt.constants, vector_size(&sx->identifiers));
+
+	node root = node_get_root(&sx->tree);
+	constant_propagation(&opt, &root, false);
+	dead_code_elimination(&opt, &root);
+
+	opt.functions = vector_create(vector_size(&sx->identifiers));
+	vector_increase(&opt.functions, vector_size(&sx->identifiers));
+	opt.calls = vector_create(vector_size(&sx->identifiers));
+
+	// Профилирование считает входы в функции, поэтому вызовы сохраняются
+	if (!ws_has_flag(ws, "--no-inline") && !ws_has_flag(ws, "--profile"))
+	{
+		opt.renames = vector_create(vector_size(&sx->identifiers));
+		vector_increase(&opt.renames, vector_size(&sx->identifiers));
+		opt.inlined = 0;
+
+		functions_register(&opt, &root);
+		inline_calls(&opt, &root);
+		uni_printf(&opt.report, "inlined call sites: %zu\n", opt.inlined);
+
+		vector_clear(&opt.renames);
+	}
+
+	// Выполняется до выноса инвариантов, который заменяет upb в условиях циклов
+	if (!ws_has_flag(ws, "--no-bounds-checks-elimination"))
+	{
+		opt.written = vector_create(vector_size(&sx->identifiers));
+		vector_increase(&opt.written, vector_size(&sx->identifiers));
+		opt.sizes = vector_create(vector_size(&sx->identifiers));
+		vector_increase(&opt.sizes, vector_size(&sx->identifiers));
+		opt.loops = 0;
+		opt.unchecked = 0;
+
+		loop_register_addresses(&opt, &root);
+		bounds_register_sizes(&opt, &root);
+		bounds_optimize(&opt, &root);
+		uni_printf(&opt.report, "unchecked subscripts: %zu\n", opt.unchecked);
+
+		vector_clear(&opt.sizes);
+		vector_clear(&opt.written);
+	}
+
+	if (!ws_has_flag(ws, "--no-loops"))
+	{
+		opt.written = vector_create(vector_size(&sx->identifiers));
+		vector_increase(&opt.written, vector_size(&sx->identifiers));
+		opt.loops = 0;
+		opt.hoisted = 0;
+		opt.reduced = 0;
+
+		loop_register_addresses(&opt, &root);
+		loops_optimize(&opt, &root);
+		uni_printf(&opt.report, "hoisted loop invariants: %zu\n", opt.hoisted);
+		uni_printf(&opt.report, "reduced multiplications: %zu\n", opt.reduced);
+
+		vector_clear(&opt.written);
+	}
+
+	// Без main или при раздельной компиляции все функции могут быть вызваны извне
+	if (sx->ref_main != 0 && !ws_has_flag(ws, "-c") && !ws_has_flag(ws, "--no-dead-functions"))
+	{
+		vector_increase(&opt.functions, vector_size(&sx->identifiers) - vector_size(&opt.functions));
+		dead_function_elimination(&opt, &root);
+	}
+
+	vector_clear(&opt.functions);
+	vector_clear(&opt.calls);
+	vector_clear(&opt.constants);
+	io_erase(&opt.report);
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include "syntax.h"
+#include "workspace.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Optimize AST before code generation
+ *	@note	Flag @c -O0 disables all optimizations,
+ *			flag @c --no-inline disables inlining of small leaf functions,
+ *			flag @c --no-loops disables hoisting of loop invariants and strength reduction,
+ *			flag @c --no-bounds-checks-elimination keeps bounds checks of subscripts by loop induction variables,
+ *			flag @c --no-dead-functions keeps functions unreachable from main,
+ *			flag @c --opt-report writes inlined calls, loop statistics, unchecked subscripts and removed functions to @c optimizer.txt
+ *
+ *	@param	ws				Compiler workspace
+ *	@param	sx				Syntax structure
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+int optimize(const workspace *const ws, syntax *const sx);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -2287,3 +2287,34 @@ int parse(syntax *const sx)
 	// Временное решение - парсер не проверяет таблицы
 	return sx->rprt.errors == 0 ? 0 : -1;
 }
+
+int parse_streaming(syntax *const sx, const declaration_handler handler, void *const context)
+{
+	if (sx == NULL || handler == NULL)
+	{
+		return -1;
+	}
+
+	parser prs = parser_create(sx);
+	node root = node_get_root(&sx->tree);
+	node_copy(&prs.bld.context, &root);
+
+	int ret = 0;
+	do
+	{
+		parse_external_definition(&prs, &root);
+
+		// Объявления обрабатываются сразу после разбора, пока нет ошибок
+		const size_t amount = node_get_amount(&root);
+		for (size_t i = 0; i < amount && !ret && sx->rprt.errors == 0; i++)
+		{
+			const node nd = node_get_child(&root, i);
+			ret = handler(context, &nd);
+		}
+
+		node_clear_root(&root);
+	} while (token_is_not(&prs.tk, TK_EOF));
+
+	parser_clear(&prs);
+	return ret == 0 && sx->rprt.errors == 0 ? 0 : -1;
+}
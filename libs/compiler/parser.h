@@ -25,6 +25,10 @@
 extern "C" {
 #endif
 
+/** Handler of parsed external declaration */
+typedef int (*declaration_handler)(void *const context, const node *const nd);
+
+
 /**
  *	Parse source code to generate syntax tree
  *
@@ -34,6 +38,19 @@ extern "C" {
  */
 int parse(syntax *const sx);
 
+/**
+ *	Parse source code declaration by declaration,
+ *	tree storage of each external declaration is reused after its handling
+ *	@note	Handler is not called after the first error
+ *
+ *	@param	sx		Syntax structure
+ *	@param	handler	Handler of external declarations
+ *	@param	context	Handler context
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+int parse_streaming(syntax *const sx, const declaration_handler handler, void *const context);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -128,11 +128,6 @@ static inline bool type_is_equal(const syntax *const sx, const size_t first, con
 	size_t length = 1;
 	const item_t type = vector_get(&sx->types, first);
 
-	if (type == TYPE_CONST)
-	{
-		return type_is_equal(sx, type_const_get_unqualified_type(sx, first), type_const_get_unqualified_type(sx, second));
-	}
-
 	// Определяем, сколько полей надо сравнивать для различных типов записей
 	if (type == TYPE_STRUCTURE || type == TYPE_FUNCTION)
 	{
@@ -463,6 +458,17 @@ size_t ident_add(syntax *const sx, const size_t repr, const item_t kind, const i
 	return last_id;
 }
 
+size_t ident_copy(syntax *const sx, const size_t index)
+{
+	const size_t last_id = vector_size(&sx->identifiers);
+	vector_add(&sx->identifiers, ITEM_MAX - 1);
+	vector_add(&sx->identifiers, ident_get_repr(sx, index));
+	vector_add(&sx->identifiers, ident_get_type(sx, index));
+	vector_add(&sx->identifiers, ident_get_displ(sx, index));
+
+	return last_id;
+}
+
 size_t ident_get_prev(const syntax *const sx, const size_t index)
 {
 	return sx != NULL ? (size_t)vector_get(&sx->identifiers, index) : SIZE_MAX;
@@ -229,6 +229,16 @@ size_t func_reserve(syntax *const sx);
  */
 size_t ident_add(syntax *const sx, const size_t repr, const item_t kind, const item_t type, const int func_def);
 
+/**
+ *	Add a copy of local identifier to identifiers table
+ *
+ *	@param	sx			Syntax structure
+ *	@param	index		Index of record in identifiers table
+ *
+ *	@return	Index of the new record in identifiers table
+ */
+size_t ident_copy(syntax *const sx, const size_t index);
+
 /**
  *	Get index of previous declaration from identifiers table by index
  *
@@ -1485,6 +1485,10 @@ static size_t elem_get_name(const instruction_t elem, const size_t num, char *co
 			argc = 1;
 			sprintf(buffer, "BNE0");
 			break;
+		case IC_SWITCH:
+			argc = 2;
+			sprintf(buffer, "SWITCH");
+			break;
 		case IC_SLICE:
 			argc = 1;
 			was_switch = true;
@@ -1498,6 +1502,19 @@ static size_t elem_get_name(const instruction_t elem, const size_t num, char *co
 					break;
 			}
 			break;
+		case IC_SLICE_UNCHECKED:
+			argc = 1;
+			was_switch = true;
+			switch (num)
+			{
+				case 0:
+					sprintf(buffer, "SLICE_UNCHECKED");
+					break;
+				case 1:
+					sprintf(buffer, "d");
+					break;
+			}
+			break;
 		case IC_SELECT:
 			argc = 1;
 			was_switch = true;
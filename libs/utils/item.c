@@ -20,6 +20,9 @@
 #include "workspace.h"
 
 
+#define ITEM_LANES 16
+
+
 #ifndef abs
 	#define abs(a) ((a) < 0 ? -(a) : (a))
 #endif
@@ -85,6 +88,38 @@ static inline uint64_t item_get_mask(const size_t shift)
 	return mask;
 }
 
+static inline void item_store_little_endian(uint8_t *const buffer, const uint64_t value, const size_t width)
+{
+	// Ширина известна при встраивании, поэтому побайтовые записи сливаются в одну
+	switch (width)
+	{
+		case 8:
+			buffer[7] = (uint8_t)(value >> 56);
+			buffer[6] = (uint8_t)(value >> 48);
+			buffer[5] = (uint8_t)(value >> 40);
+			buffer[4] = (uint8_t)(value >> 32);
+			// fallthrough
+		case 4:
+			buffer[3] = (uint8_t)(value >> 24);
+			buffer[2] = (uint8_t)(value >> 16);
+			// fallthrough
+		case 2:
+			buffer[1] = (uint8_t)(value >> 8);
+			// fallthrough
+		default:
+			buffer[0] = (uint8_t)value;
+	}
+}
+
+static inline void item_pack_block(const item_t *const items, const size_t size, uint8_t *const buffer
+	, const size_t width)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		item_store_little_endian(&buffer[i * width], (uint64_t)items[i], width);
+	}
+}
+
 
 /*
  *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
@@ -323,3 +358,102 @@ bool item_check_var(const item_status status, const item_t var)
 {
 	return var >= item_get_min(status) && var <= item_get_max(status);
 }
+
+bool item_check_array(const item_status status, const item_t *const items, const size_t size)
+{
+	if (items == NULL && size != 0)
+	{
+		return false;
+	}
+
+	// Диапазоны целевых типов имеют длину степени двойки,
+	// поэтому после сдвига на минимум лишними могут быть только старшие биты
+	const uint64_t offset = (uint64_t)item_get_min(status);
+	const uint64_t mask = (uint64_t)item_get_max(status) - offset;
+	if ((mask & (mask + 1)) != 0)
+	{
+		for (size_t i = 0; i < size; i++)
+		{
+			if (!item_check_var(status, items[i]))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Независимые аккумуляторы и блоки постоянной длины позволяют векторизовать цикл
+	uint64_t lanes[ITEM_LANES] = { 0 };
+	const size_t blocks = size - size % ITEM_LANES;
+	for (size_t i = 0; i < blocks; i += ITEM_LANES)
+	{
+		for (size_t j = 0; j < ITEM_LANES; j++)
+		{
+			lanes[j] |= (uint64_t)items[i + j] - offset;
+		}
+	}
+
+	uint64_t bits = 0;
+	for (size_t j = 0; j < ITEM_LANES; j++)
+	{
+		bits |= lanes[j];
+	}
+
+	for (size_t i = blocks; i < size; i++)
+	{
+		bits |= (uint64_t)items[i] - offset;
+	}
+
+	return (bits & ~mask) == 0;
+}
+
+size_t item_get_width(const item_status status)
+{
+	switch (status)
+	{
+		case item_int8:
+		case item_uint8:
+			return 1;
+		case item_int16:
+		case item_uint16:
+			return 2;
+		case item_int32:
+		case item_uint32:
+			return 4;
+		case item_int64:
+		case item_uint64:
+			return 8;
+
+		default:
+			return 0;
+	}
+}
+
+int item_pack_array(const item_status status, const item_t *const items, const size_t size
+	, uint8_t *const buffer)
+{
+	const size_t width = item_get_width(status);
+	if (width == 0 || (buffer == NULL && size != 0) || !item_check_array(status, items, size))
+	{
+		return -1;
+	}
+
+	switch (width)
+	{
+		case 1:
+			item_pack_block(items, size, buffer, 1);
+			break;
+		case 2:
+			item_pack_block(items, size, buffer, 2);
+			break;
+		case 4:
+			item_pack_block(items, size, buffer, 4);
+			break;
+		default:
+			item_pack_block(items, size, buffer, 8);
+			break;
+	}
+
+	return 0;
+}
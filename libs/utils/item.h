@@ -221,6 +221,42 @@ EXPORTED int64_t item_restore_int64_for_target(const item_status status, const i
  */
 EXPORTED bool item_check_var(const item_status status, const item_t var);
 
+/**
+ *	Check that all items of array are not out of range
+ *	@note	Items are reduced without branches in fixed-size blocks,
+ *			which compiler turns into vector instructions
+ *
+ *	@param	status		Item status
+ *	@param	items		Checking items
+ *	@param	size		Number of items
+ *
+ *	@return	@c 1 on true, @c 0 on false
+ */
+EXPORTED bool item_check_array(const item_status status, const item_t *const items, const size_t size);
+
+/**
+ *	Get size of target item in bytes
+ *
+ *	@param	status		Item status
+ *
+ *	@return	Item size, @c 0 on failure
+ */
+EXPORTED size_t item_get_width(const item_status status);
+
+/**
+ *	Pack items into fixed-width little-endian items of target type
+ *	@note	Items are checked once for the whole array, nothing is written on failure
+ *
+ *	@param	status		Item status
+ *	@param	items		Packing items
+ *	@param	size		Number of items
+ *	@param	buffer		Output buffer for @c size items of target width
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+EXPORTED int item_pack_array(const item_status status, const item_t *const items, const size_t size
+	, uint8_t *const buffer);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,136 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "pool.h"
+#include <stdlib.h>
+
+#ifdef POOL_THREADS
+	#include <pthread.h>
+	#include <stdatomic.h>
+	#include <unistd.h>
+#endif
+
+
+#define MAX_THREADS 64
+
+
+#ifdef POOL_THREADS
+
+/** Shared state of pool workers */
+typedef struct pool
+{
+	pool_task task;				/**< Task function */
+	void *context;				/**< Shared context of tasks */
+	size_t amount;				/**< Number of tasks */
+	atomic_size_t next;			/**< Index of the next task to run */
+} pool;
+
+
+/**
+ *	Run tasks until all of them are taken
+ *
+ *	@param	arg			Pool
+ *
+ *	@return	@c NULL
+ */
+static void *pool_worker(void *arg)
+{
+	pool *const pl = arg;
+	for (size_t index = atomic_fetch_add(&pl->next, 1); index < pl->amount; index = atomic_fetch_add(&pl->next, 1))
+	{
+		pl->task(pl->context, index);
+	}
+
+	return NULL;
+}
+
+#endif
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+size_t pool_get_threads(const workspace *const ws)
+{
+	size_t i = 0;
+	const char *flag = ws_get_flag(ws, i);
+	while (flag != NULL)
+	{
+		if (flag[0] == '-' && flag[1] == 'j')
+		{
+			const size_t threads = (size_t)strtoul(&flag[2], NULL, 10);
+			return threads == 0 ? 1 : threads < MAX_THREADS ? threads : MAX_THREADS;
+		}
+
+		flag = ws_get_flag(ws, ++i);
+	}
+
+#ifdef POOL_THREADS
+	const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	return processors < 1 ? 1 : (size_t)processors < MAX_THREADS ? (size_t)processors : MAX_THREADS;
+#else
+	return 1;
+#endif
+}
+
+int pool_run(const size_t threads, const size_t amount, const pool_task task, void *const context)
+{
+	if (task == NULL)
+	{
+		return -1;
+	}
+
+#ifdef POOL_THREADS
+	const size_t workers = threads < amount ? threads : amount;
+	if (workers > 1)
+	{
+		pool pl = { .task = task, .context = context, .amount = amount };
+		atomic_init(&pl.next, 0);
+
+		// Вызывающий поток тоже выполняет задачи, поэтому неудача создания потока не страшна
+		pthread_t handles[MAX_THREADS];
+		size_t created = 0;
+		while (created < workers - 1 && created < MAX_THREADS
+			&& pthread_create(&handles[created], NULL, pool_worker, &pl) == 0)
+		{
+			created++;
+		}
+
+		pool_worker(&pl);
+		for (size_t i = 0; i < created; i++)
+		{
+			pthread_join(handles[i], NULL);
+		}
+
+		return 0;
+	}
+#else
+	(void)threads;
+#endif
+
+	for (size_t i = 0; i < amount; i++)
+	{
+		task(context, i);
+	}
+
+	return 0;
+}
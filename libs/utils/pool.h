@@ -0,0 +1,62 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include "dll.h"
+#include "workspace.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Task of thread pool
+ *
+ *	@param	context		Shared context of tasks
+ *	@param	index		Task index
+ */
+typedef void (*pool_task)(void *const context, const size_t index);
+
+
+/**
+ *	Get number of threads from flag @c -j<number>, number of processors by default
+ *
+ *	@param	ws			Compiler workspace
+ *
+ *	@return	Number of threads
+ */
+EXPORTED size_t pool_get_threads(const workspace *const ws);
+
+/**
+ *	Run tasks on thread pool, every task is run exactly once in some thread
+ *	@note	Tasks are run one by one in order of indexes in the calling thread,
+ *			if there is the only thread or POSIX threads are not supported
+ *
+ *	@param	threads		Number of threads
+ *	@param	amount		Number of tasks
+ *	@param	task		Task function
+ *	@param	context		Shared context of tasks
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+EXPORTED int pool_run(const size_t threads, const size_t amount, const pool_task task, void *const context);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -523,6 +523,19 @@ int node_remove(node *const nd)
 	return 0;
 }
 
+int node_clear_root(node *const nd)
+{
+	if (!node_is_correct(nd) || nd->index != 0)
+	{
+		return -1;
+	}
+
+	// Все узлы дерева являются потомками корня и хранятся после него
+	ref_set_amount(nd, 0);
+	ref_set_children(nd, 0);
+	return vector_resize(nd->tree, ref_get_argc(nd) + node_get_argc(nd) + 1);
+}
+
 bool node_is_correct(const node *const nd)
 {
 	return nd != NULL && vector_is_correct(nd->tree) && nd->index != SIZE_MAX;
@@ -298,6 +298,15 @@ EXPORTED int node_swap(const node *const fst, const node *const snd);
  */
 EXPORTED int node_remove(node *const nd);
 
+/**
+ *	Remove all children of root node and release their storage
+ *
+ *	@param	nd			Root node
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+EXPORTED int node_clear_root(node *const nd);
+
 /**
  *	Check that node is correct
  *
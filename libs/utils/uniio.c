@@ -583,6 +583,11 @@ size_t out_get_path(const universal_io *const io, char *const buffer)
 	return io_get_path(io->out_file, buffer);
 }
 
+size_t out_get_position(const universal_io *const io)
+{
+	return out_is_buffer(io) ? io->out_position : 0;
+}
+
 
 char *out_extract_buffer(universal_io *const io)
 {
@@ -326,6 +326,15 @@ EXPORTED io_func out_get_func(const universal_io *const io);
  */
 EXPORTED size_t out_get_path(const universal_io *const io, char *const buffer);
 
+/**
+ *	Get output buffer position from universal io structure
+ *
+ *	@param	io			Universal io structure
+ *
+ *	@return	Output position
+ */
+EXPORTED size_t out_get_position(const universal_io *const io);
+
 
 /**
  *	Extract output buffer from universal io structure
@@ -47,3 +47,13 @@ int uni_print_char(universal_io *const io, const char32_t wchar)
 
 	return uni_printf(io, "%s", buffer);
 }
+
+size_t uni_write(universal_io *const io, const void *const buffer, const size_t size)
+{
+	if (!out_is_file(io))
+	{
+		return 0;
+	}
+
+	return fwrite(buffer, sizeof(char), size, io->out_file);
+}
@@ -47,6 +47,18 @@ EXPORTED int uni_printf(universal_io *const io, const char *const format, ...)
  */
 EXPORTED int uni_print_char(universal_io *const io, const char32_t wchar);
 
+/**
+ *	Universal function for writing raw bytes
+ *	@note	Supported only for file output
+ *
+ *	@param	io			Universal io structure
+ *	@param	buffer		Bytes to write
+ *	@param	size		Number of bytes
+ *
+ *	@return	Number of written bytes
+ */
+EXPORTED size_t uni_write(universal_io *const io, const void *const buffer, const size_t size);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
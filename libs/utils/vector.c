@@ -210,6 +210,11 @@ size_t vector_size(const vector *const vec)
 	return vector_is_correct(vec) ? vec->size : SIZE_MAX;
 }
 
+const item_t *vector_get_array(const vector *const vec)
+{
+	return vector_is_correct(vec) ? vec->array : NULL;
+}
+
 bool vector_is_correct(const vector *const vec)
 {
 	return vec != NULL && vec->array != NULL;
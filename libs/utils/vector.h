@@ -196,6 +196,15 @@ EXPORTED int vector_resize(vector *const vec, const size_t size);
  */
 EXPORTED size_t vector_size(const vector *const vec);
 
+/**
+ *	Get vector items for bulk reading
+ *
+ *	@param	vec				Vector structure
+ *
+ *	@return	Pointer to the first item, @c NULL on failure
+ */
+EXPORTED const item_t *vector_get_array(const vector *const vec);
+
 /**
  *	Check that vector is correct
  *
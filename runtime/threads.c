@@ -0,0 +1,406 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "threads.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+
+#ifdef TESTING_EXIT_CODE
+	#define RUNTIME_ERROR_CODE TESTING_EXIT_CODE
+#else
+	#define RUNTIME_ERROR_CODE 1
+#endif
+
+
+/**	Number of busy iterations before yielding processor */
+static const size_t SPIN_LIMIT = 64;
+
+/**	Number of yields before sleeping */
+static const size_t YIELD_LIMIT = 1024;
+
+
+/** Message between threads */
+typedef struct message
+{
+	int32_t sender;					/**< Number of sender thread */
+	int32_t data;					/**< Message data */
+} message;
+
+/**
+ *	Slot of mailbox, its sequence for position @c pos is
+ *	@c 2 * lap for empty slot and @c 2 * lap + 1 for filled one,
+ *	where @c lap is @c pos / MAX_MESSAGES, so zeroed mailbox is valid
+ */
+typedef struct slot
+{
+	atomic_size_t sequence;			/**< State of slot */
+	message msg;					/**< Stored message */
+} slot;
+
+/** Lock-free bounded queue with many senders and the only receiver */
+typedef struct mailbox
+{
+	slot slots[MAX_MESSAGES];		/**< Ring buffer */
+	atomic_size_t tail;				/**< Position for the next sent message */
+	size_t head;					/**< Position of the first unread message, owned by receiver */
+} mailbox;
+
+/** Thread of program */
+typedef struct thread
+{
+	void *(*func)(void *);			/**< Thread function */
+	int32_t number;					/**< Thread number, main thread is zero */
+
+	pthread_t handle;				/**< POSIX thread */
+	bool is_joined;					/**< Set, if thread has been joined */
+
+	mailbox mailbox;				/**< Received messages */
+} thread;
+
+/** Counting semaphore */
+typedef struct semaphore
+{
+	atomic_int value;				/**< Counter */
+	atomic_int waiters;				/**< Number of threads waiting on condition */
+} semaphore;
+
+
+static thread threads[MAX_THREADS];
+static atomic_size_t threads_size = 1;
+
+static semaphore semaphores[MAX_SEMAPHORES];
+static atomic_size_t semaphores_size;
+
+/**	Lock for thread creation and joining, also protects waiting on semaphores */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t is_released = PTHREAD_COND_INITIALIZER;
+
+/**	Number of current thread */
+static _Thread_local int32_t current;
+
+
+/**
+ *	Emit runtime error and terminate program
+ *
+ *	@param	format			Message format
+ */
+static void runtime_error(const char *const format, ...)
+{
+	fflush(stdout);
+	fprintf(stderr, "ошибка исполнения: ");
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+
+	fprintf(stderr, "\n");
+	exit(RUNTIME_ERROR_CODE);
+}
+
+/**
+ *	Wait a bit before the next attempt: spin first, then yield processor, then sleep
+ *
+ *	@param	attempts		Number of failed attempts
+ */
+static void backoff(size_t *const attempts)
+{
+	const size_t attempt = (*attempts)++;
+	if (attempt < SPIN_LIMIT)
+	{
+		return;
+	}
+
+	if (attempt < SPIN_LIMIT + YIELD_LIMIT)
+	{
+		sched_yield();
+		return;
+	}
+
+	const struct timespec duration = { .tv_sec = 0, .tv_nsec = 50000L };
+	nanosleep(&duration, NULL);
+}
+
+/**
+ *	Entry point of POSIX thread
+ *
+ *	@param	arg			Thread
+ *
+ *	@return	Result of thread function
+ */
+static void *thread_main(void *arg)
+{
+	thread *const th = arg;
+	current = th->number;
+	return th->func(NULL);
+}
+
+/**
+ *	Get thread by number
+ *
+ *	@param	number		Thread number
+ *
+ *	@return	Thread
+ */
+static thread *thread_get(const int32_t number)
+{
+	if (number < 0 || (size_t)number >= atomic_load_explicit(&threads_size, memory_order_acquire))
+	{
+		runtime_error("поток %" PRId32 " не существует", number);
+	}
+
+	return &threads[number];
+}
+
+/**
+ *	Get semaphore by number
+ *
+ *	@param	number		Semaphore number
+ *
+ *	@return	Semaphore
+ */
+static semaphore *semaphore_get(const int32_t number)
+{
+	if (number < 0 || (size_t)number >= atomic_load_explicit(&semaphores_size, memory_order_acquire))
+	{
+		runtime_error("семафор %" PRId32 " не существует", number);
+	}
+
+	return &semaphores[number];
+}
+
+/**
+ *	Decrement semaphore, if it is positive
+ *
+ *	@param	sem			Semaphore
+ *
+ *	@return	@c true on success
+ */
+static bool semaphore_try_wait(semaphore *const sem)
+{
+	int value = atomic_load(&sem->value);
+	while (value > 0)
+	{
+		if (atomic_compare_exchange_weak(&sem->value, &value, value - 1))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+int32_t t_create(void *(*func)(void *))
+{
+	pthread_mutex_lock(&lock);
+	const size_t number = atomic_load_explicit(&threads_size, memory_order_relaxed);
+	if (number == MAX_THREADS)
+	{
+		pthread_mutex_unlock(&lock);
+		runtime_error("превышено максимальное количество потоков %i", MAX_THREADS);
+	}
+
+	thread *const child = &threads[number];
+	child->func = func;
+	child->number = (int32_t)number;
+
+	// Поток доступен по номеру до запуска, чтобы ему сразу можно было посылать сообщения
+	atomic_store_explicit(&threads_size, number + 1, memory_order_release);
+
+	const int ret = pthread_create(&child->handle, NULL, thread_main, child);
+	pthread_mutex_unlock(&lock);
+
+	if (ret)
+	{
+		runtime_error("не удалось создать поток");
+	}
+
+	return (int32_t)number;
+}
+
+int32_t t_getnum(void)
+{
+	return current;
+}
+
+void t_sleep(const int32_t milliseconds)
+{
+	const struct timespec duration = { .tv_sec = milliseconds / 1000
+		, .tv_nsec = (long)(milliseconds % 1000) * 1000000L };
+	if (milliseconds > 0)
+	{
+		nanosleep(&duration, NULL);
+	}
+}
+
+void t_join(const int32_t number)
+{
+	thread *const child = thread_get(number);
+	if (number == current || number == 0)
+	{
+		runtime_error("поток %" PRId32 " не может ожидать сам себя или главный поток", number);
+	}
+
+	pthread_mutex_lock(&lock);
+	const bool is_joined = child->is_joined;
+	child->is_joined = true;
+	pthread_mutex_unlock(&lock);
+
+	if (!is_joined)
+	{
+		pthread_join(child->handle, NULL);
+	}
+}
+
+void t_exit(void)
+{
+	pthread_exit(NULL);
+}
+
+void t_init(void)
+{
+}
+
+void t_destroy(void)
+{
+}
+
+
+int32_t t_sem_create(const int32_t value)
+{
+	pthread_mutex_lock(&lock);
+	const size_t number = atomic_load_explicit(&semaphores_size, memory_order_relaxed);
+	if (number == MAX_SEMAPHORES)
+	{
+		pthread_mutex_unlock(&lock);
+		runtime_error("превышено максимальное количество семафоров %i", MAX_SEMAPHORES);
+	}
+
+	atomic_store(&semaphores[number].value, value);
+	atomic_store_explicit(&semaphores_size, number + 1, memory_order_release);
+	pthread_mutex_unlock(&lock);
+
+	return (int32_t)number;
+}
+
+void t_sem_wait(const int32_t number)
+{
+	semaphore *const sem = semaphore_get(number);
+	if (semaphore_try_wait(sem))
+	{
+		return;
+	}
+
+	// Счётчик ожидающих увеличивается до повторной проверки,
+	// поэтому t_sem_post либо увидит ожидающего, либо проверка увидит новое значение
+	pthread_mutex_lock(&lock);
+	atomic_fetch_add(&sem->waiters, 1);
+	while (!semaphore_try_wait(sem))
+	{
+		pthread_cond_wait(&is_released, &lock);
+	}
+
+	atomic_fetch_sub(&sem->waiters, 1);
+	pthread_mutex_unlock(&lock);
+}
+
+void t_sem_post(const int32_t number)
+{
+	semaphore *const sem = semaphore_get(number);
+	atomic_fetch_add(&sem->value, 1);
+
+	if (atomic_load(&sem->waiters) > 0)
+	{
+		pthread_mutex_lock(&lock);
+		pthread_cond_broadcast(&is_released);
+		pthread_mutex_unlock(&lock);
+	}
+}
+
+
+void t_msg_send(const int32_t receiver, const int32_t data)
+{
+	mailbox *const box = &thread_get(receiver)->mailbox;
+
+	size_t attempts = 0;
+	size_t pos = atomic_load_explicit(&box->tail, memory_order_relaxed);
+	for (;;)
+	{
+		slot *const cell = &box->slots[pos % MAX_MESSAGES];
+		const size_t expected = 2 * (pos / MAX_MESSAGES);
+		const size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+
+		if (sequence == expected)
+		{
+			// Занимаем позицию, при неудаче pos обновится текущим значением
+			if (atomic_compare_exchange_weak_explicit(&box->tail, &pos, pos + 1
+				, memory_order_relaxed, memory_order_relaxed))
+			{
+				cell->msg = (message){ .sender = current, .data = data };
+				atomic_store_explicit(&cell->sequence, expected + 1, memory_order_release);
+				return;
+			}
+		}
+		else if (sequence < expected)
+		{
+			// Ящик полон: получатель ещё не прочитал сообщение с прошлого круга
+			backoff(&attempts);
+			pos = atomic_load_explicit(&box->tail, memory_order_relaxed);
+		}
+		else
+		{
+			pos = atomic_load_explicit(&box->tail, memory_order_relaxed);
+		}
+	}
+}
+
+uint64_t t_msg_receive(void)
+{
+	mailbox *const box = &threads[current].mailbox;
+	const size_t pos = box->head;
+	slot *const cell = &box->slots[pos % MAX_MESSAGES];
+	const size_t expected = 2 * (pos / MAX_MESSAGES) + 1;
+
+	size_t attempts = 0;
+	while (atomic_load_explicit(&cell->sequence, memory_order_acquire) != expected)
+	{
+		backoff(&attempts);
+	}
+
+	const message msg = cell->msg;
+	atomic_store_explicit(&cell->sequence, expected + 1, memory_order_release);
+	box->head = pos + 1;
+
+	return (uint64_t)(uint32_t)msg.sender | (uint64_t)(uint32_t)msg.data << 32;
+}
@@ -0,0 +1,127 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+
+#define MAX_THREADS 32
+#define MAX_SEMAPHORES 64
+#define MAX_MESSAGES 256
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ *	Runtime of RuC thread builtins for programs compiled with LLVM.
+ *	Names are the same as in RuC, so calls from llvmgen need no mangling.
+ *	Semantics follows in-tree virtual machine: main thread is zero,
+ *	other threads are numbered sequentially in order of creation.
+ */
+
+/**
+ *	Create thread, which starts from function
+ *
+ *	@param	func			Thread function
+ *
+ *	@return	Thread number
+ */
+int32_t t_create(void *(*func)(void *));
+
+/**
+ *	Get number of current thread
+ *
+ *	@return	Thread number
+ */
+int32_t t_getnum(void);
+
+/**
+ *	Suspend current thread
+ *
+ *	@param	milliseconds	Sleep duration
+ */
+void t_sleep(const int32_t milliseconds);
+
+/**
+ *	Wait for thread termination
+ *
+ *	@param	number			Thread number
+ */
+void t_join(const int32_t number);
+
+/**
+ *	Terminate current thread
+ */
+void t_exit(void);
+
+/**
+ *	Initialize threads, does nothing as in virtual machine
+ */
+void t_init(void);
+
+/**
+ *	Finalize threads, does nothing as in virtual machine
+ */
+void t_destroy(void);
+
+
+/**
+ *	Create semaphore
+ *
+ *	@param	value			Initial value
+ *
+ *	@return	Semaphore number
+ */
+int32_t t_sem_create(const int32_t value);
+
+/**
+ *	Decrement semaphore, waiting while it is zero
+ *
+ *	@param	number			Semaphore number
+ */
+void t_sem_wait(const int32_t number);
+
+/**
+ *	Increment semaphore
+ *
+ *	@param	number			Semaphore number
+ */
+void t_sem_post(const int32_t number);
+
+
+/**
+ *	Send message to thread, waiting while its mailbox is full
+ *	@note	Structure @c msg_info is passed by fields to avoid dependence on ABI
+ *
+ *	@param	receiver		Receiver thread number
+ *	@param	data			Message data
+ */
+void t_msg_send(const int32_t receiver, const int32_t data);
+
+/**
+ *	Receive message, waiting for it
+ *	@note	Structure @c msg_info is packed to avoid dependence on ABI
+ *
+ *	@return	Sender thread number in lower half, message data in upper half
+ */
+uint64_t t_msg_receive(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,168 @@
+#!/bin/bash
+
+init()
+{
+	vm_exec=export.txt
+	repeat=1
+	wait_for=10
+
+	dir_install=./install
+	dir_exec=../tests/codegen/executable
+
+	subdir_error=errors
+	subdir_include=include
+
+	while ! [[ -z $1 ]]
+	do
+		case $1 in
+			-h|--help)
+				echo -e "Usage: ./${0##*/} [KEY] ..."
+				echo -e "Description:"
+				echo -e "\tThis script measures execution of all tests from \"$dir_exec\" directory"
+				echo -e "\ton in-tree RuC virtual machine with and without optimizations."
+				echo -e "\tTests from \"*/$subdir_error/*\" and \"*/$subdir_include/*\" subdirectories are skipped."
+				echo -e "Keys:"
+				echo -e "\t-h, --help\tTo output help info."
+				echo -e "\t-s, --silence\tOutput totals only."
+				echo -e "\t-r, --remove\tRemove build folder before measuring."
+				echo -e "\t-n, --repeat\tSet number of runs for each test (default = 1)."
+				echo -e "\t-w, --wait\tSet waiting time for timeout result (default = 10)."
+				exit 0
+				;;
+			-s|--silence)
+				silence=$1
+				;;
+			-r|--remove)
+				remove=$1
+				;;
+			-n|--repeat)
+				repeat=$2
+				shift
+				;;
+			-w|--wait)
+				wait_for=$2
+				shift
+				;;
+		esac
+		shift
+	done
+
+	if [[ $OSTYPE == "darwin"* ]] ; then
+		runner="gtimeout $wait_for"
+	else
+		runner="timeout $wait_for"
+	fi
+
+	log=tmp
+}
+
+build()
+{
+	cd `dirname $0`/..
+	if ! [[ -z $remove ]] ; then
+		rm -rf build
+	fi
+	mkdir -p build && cd build
+
+	cmake .. -DCMAKE_BUILD_TYPE=Release
+	if ! cmake --build . --config Release ; then
+		exit 1
+	fi
+
+	cmake --install . --prefix $dir_install --config Release
+	rm -rf Release
+	mv $dir_install/ruc Release
+	rm -rf $dir_install
+
+	compiler=./Release/ruc
+	interpreter=./Release/ruc-vm
+	if ! [[ -x $interpreter ]] ; then
+		echo "In-tree virtual machine is not built"
+		exit 1
+	fi
+}
+
+# Запуск теста, результат: время в микросекундах и количество исполненных инструкций
+measure()
+{
+	if ! $runner $compiler $path -o $vm_exec -VM --extended-codes $@ &>$log ; then
+		return 1
+	fi
+
+	time=0
+	for (( i = 0; i < $repeat; i++ ))
+	do
+		start=`date +%s%N`
+		if ! echo "" | $runner $interpreter --stats $vm_exec >/dev/null 2>$log ; then
+			return 1
+		fi
+		finish=`date +%s%N`
+
+		let time+=(finish-start)/1000
+	done
+
+	let time/=repeat
+	executed=`grep -o "[0-9]*$" $log`
+	return 0
+}
+
+benchmark()
+{
+	total_plain_time=0
+	total_plain_executed=0
+	total_opt_time=0
+	total_opt_executed=0
+	skipped=0
+
+	if [[ -z $silence ]] ; then
+		printf "%-60s %12s %12s %12s %12s\n" "test" "-O0 us" "-O0 instr" "us" "instr"
+	fi
+
+	# Do not use names with spaces!
+	for path in `find $dir_exec -name *.c | sort`
+	do
+		if [[ $path == */$subdir_error/* || $path == */$subdir_include/* ]] ; then
+			continue
+		fi
+
+		if ! measure -O0 ; then
+			let skipped++
+			continue
+		fi
+		plain_time=$time
+		plain_executed=$executed
+
+		if ! measure ; then
+			let skipped++
+			continue
+		fi
+
+		let total_plain_time+=plain_time
+		let total_plain_executed+=plain_executed
+		let total_opt_time+=time
+		let total_opt_executed+=executed
+
+		if [[ -z $silence ]] ; then
+			printf "%-60s %12d %12d %12d %12d\n" ${path#$dir_exec/} $plain_time $plain_executed $time $executed
+		fi
+	done
+
+	if [[ -z $silence ]] ; then
+		echo
+	fi
+
+	echo -e "-O0: time = $total_plain_time us, instructions = $total_plain_executed"
+	echo -e "default: time = $total_opt_time us, instructions = $total_opt_executed"
+	echo -e "skipped = $skipped"
+	rm -f $log $vm_exec
+}
+
+main()
+{
+	init $@
+
+	build
+	benchmark
+}
+
+main $@
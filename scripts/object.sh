@@ -0,0 +1,171 @@
+#!/bin/bash
+
+init()
+{
+	text_exec=export.s
+	object_exec=export.o
+	object_ref=reference.o
+	assembler="mipsel-linux-gnu-as -mips32r2"
+	objdump=mipsel-linux-gnu-objdump
+	wait_for=10
+
+	dir_install=./install
+	dir_exec=../tests/codegen/executable
+
+	subdir_include=include
+
+	while ! [[ -z $1 ]]
+	do
+		case $1 in
+			-h|--help)
+				echo -e "Usage: ./${0##*/} [KEY] ..."
+				echo -e "Description:"
+				echo -e "\tThis script compares MIPS object files, written by \"ruc -MIPS --binary\","
+				echo -e "\twith assembled \"ruc -MIPS\" output for all tests from \"$dir_exec\" directory."
+				echo -e "\tCode with relocations and read-only data are compared by disassembly."
+				echo -e "\tTests from \"*/$subdir_include/*\" subdirectories are skipped."
+				echo -e "Keys:"
+				echo -e "\t-h, --help\tTo output help info."
+				echo -e "\t-s, --silence\tOutput totals only."
+				echo -e "\t-r, --remove\tRemove build folder before comparing."
+				echo -e "\t-a, --assembler\tSet assembler command (default = $assembler)."
+				echo -e "\t-d, --objdump\tSet objdump command (default = $objdump)."
+				echo -e "\t-w, --wait\tSet waiting time for timeout result (default = 10)."
+				exit 0
+				;;
+			-s|--silence)
+				silence=$1
+				;;
+			-r|--remove)
+				remove=$1
+				;;
+			-a|--assembler)
+				assembler=$2
+				shift
+				;;
+			-d|--objdump)
+				objdump=$2
+				shift
+				;;
+			-w|--wait)
+				wait_for=$2
+				shift
+				;;
+		esac
+		shift
+	done
+
+	if [[ $OSTYPE == "darwin"* ]] ; then
+		runner="gtimeout $wait_for"
+	else
+		runner="timeout $wait_for"
+	fi
+
+	log=tmp
+	dump=dump.txt
+	dump_ref=reference.txt
+}
+
+build()
+{
+	cd `dirname $0`/..
+	if ! [[ -z $remove ]] ; then
+		rm -rf build
+	fi
+	mkdir -p build && cd build
+
+	cmake .. -DCMAKE_BUILD_TYPE=Release
+	if ! cmake --build . --config Release ; then
+		exit 1
+	fi
+
+	cmake --install . --prefix $dir_install --config Release
+	rm -rf Release
+	mv $dir_install/ruc Release
+	rm -rf $dir_install
+
+	compiler=./Release/ruc
+}
+
+# Дизассемблирование кода с перемещениями и содержимое данных только для чтения, без имени файла
+disassemble()
+{
+	$objdump -d -r -j .text $1 | tail -n +3 >$2
+	$objdump -s -j .rodata $1 | tail -n +3 >>$2
+}
+
+message()
+{
+	if [[ -z $silence ]] ; then
+		echo -e "\x1B[1;$1m $2 \x1B[1;39m: $path"
+	fi
+}
+
+compare()
+{
+	success=0
+	failure=0
+	skipped=0
+
+	# Do not use names with spaces!
+	for path in `find $dir_exec -name *.c | sort`
+	do
+		if [[ $path == */$subdir_include/* ]] ; then
+			continue
+		fi
+
+		rm -f $text_exec $object_exec $object_ref
+		if ! $runner $compiler $path -MIPS -o $text_exec &>$log ; then
+			let skipped++
+			continue
+		fi
+
+		$runner $compiler $path -MIPS --binary -o $object_exec &>$log
+		object_ret=$?
+		$runner $assembler $text_exec -o $object_ref &>>$log
+		ref_ret=$?
+
+		# Инструкции, которые отвергает ассемблер, не кодируются и в объектный файл
+		if [[ $object_ret != 0 && $ref_ret != 0 ]] ; then
+			message 33 "rejected"
+			let skipped++
+		elif [[ $object_ret != 0 || $ref_ret != 0 ]] ; then
+			message 31 "failure"
+			let failure++
+		else
+			disassemble $object_exec $dump
+			disassemble $object_ref $dump_ref
+
+			if cmp -s $dump $dump_ref ; then
+				message 32 "success"
+				let success++
+			else
+				message 31 "failure"
+				let failure++
+			fi
+		fi
+	done
+
+	if [[ -z $silence ]] ; then
+		echo
+	fi
+
+	echo -e "\x1B[1;39m success = $success, failure = $failure, skipped = $skipped"
+	rm -f $log $dump $dump_ref $text_exec $object_exec $object_ref
+}
+
+main()
+{
+	init "$@"
+
+	build
+	compare
+
+	if [[ $failure != 0 ]] ; then
+		exit 1
+	fi
+
+	exit 0
+}
+
+main "$@"
@@ -0,0 +1,204 @@
+#!/bin/bash
+
+init()
+{
+	threads="1 2 4 8 16"
+	work=400000000
+	repeat=1
+	wait_for=60
+
+	dir_install=./install
+
+	program=scaling.c
+	llvm_code=scaling.ll
+	native_code=scaling.s
+	native_exec=scaling
+
+	while ! [[ -z $1 ]]
+	do
+		case $1 in
+			-h|--help)
+				echo -e "Usage: ./${0##*/} [KEY] ..."
+				echo -e "Description:"
+				echo -e "\tThis script measures scaling of RuC threads compiled with LLVM"
+				echo -e "\tand linked with runtime of thread builtins for 1 to 16 threads."
+				echo -e "\tThe same amount of work is divided between threads, which are"
+				echo -e "\tsynchronized with semaphore, so ideal speedup equals to number of threads."
+				echo -e "Keys:"
+				echo -e "\t-h, --help\tTo output help info."
+				echo -e "\t-r, --remove\tRemove build folder before measuring."
+				echo -e "\t-n, --repeat\tSet number of runs for each measure (default = 1)."
+				echo -e "\t-t, --threads\tSet list of thread numbers (default = \"$threads\")."
+				echo -e "\t-W, --work\tSet total number of iterations (default = $work)."
+				echo -e "\t-w, --wait\tSet waiting time for timeout result (default = 60)."
+				exit 0
+				;;
+			-r|--remove)
+				remove=$1
+				;;
+			-n|--repeat)
+				repeat=$2
+				shift
+				;;
+			-t|--threads)
+				threads=$2
+				shift
+				;;
+			-W|--work)
+				work=$2
+				shift
+				;;
+			-w|--wait)
+				wait_for=$2
+				shift
+				;;
+		esac
+		shift
+	done
+
+	if [[ $OSTYPE == "darwin"* ]] ; then
+		runner="gtimeout $wait_for"
+	else
+		runner="timeout $wait_for"
+	fi
+
+	llc=${LLC:-llc}
+	cc=${CC:-cc}
+	log=tmp
+}
+
+build()
+{
+	cd `dirname $0`/..
+	if ! [[ -z $remove ]] ; then
+		rm -rf build
+	fi
+	mkdir -p build && cd build
+
+	cmake .. -DCMAKE_BUILD_TYPE=Release
+	if ! cmake --build . --config Release ; then
+		exit 1
+	fi
+
+	cmake --install . --prefix $dir_install --config Release
+	rm -rf Release
+	mv $dir_install/ruc Release
+	rm -rf $dir_install
+
+	compiler=./Release/ruc
+	runtime=./Release/libruc-runtime.a
+	if ! [[ -f $runtime ]] ; then
+		echo "Runtime of thread builtins is not built"
+		exit 1
+	fi
+}
+
+# Программа с заданным количеством потоков, работа делится между ними поровну
+generate()
+{
+	cat > $program <<PROGRAM
+#define THREADS $1
+#define STEPS ($work / THREADS)
+
+int total = 0;
+int lock;
+
+void* worker(void* arg)
+{
+	int num = t_getnum();
+	int sum = 0;
+	for (int i = 0; i < STEPS; i++)
+	{
+		sum = (sum + i % 7 * num) % 1000003;
+	}
+
+	t_sem_wait(lock);
+	total += sum;
+	t_sem_post(lock);
+	return 0;
+}
+
+int main()
+{
+	lock = t_sem_create(1);
+	for (int i = 0; i < THREADS; i++)
+	{
+		t_create(worker);
+	}
+
+	for (int i = 1; i <= THREADS; i++)
+	{
+		t_join(i);
+	}
+
+	printf("%i\n", total);
+	return 0;
+}
+PROGRAM
+}
+
+# Сборка программы в исполняемый файл
+compile()
+{
+	$runner $compiler $program -LLVM -o $llvm_code &>$log \
+		&& $llc -O2 -relocation-model=pic $llvm_code -o $native_code &>$log \
+		&& $cc $native_code $runtime -lpthread -lm -o $native_exec &>$log
+}
+
+# Запуск программы, результат: время в микросекундах
+measure()
+{
+	time=0
+	for (( i = 0; i < $repeat; i++ ))
+	do
+		start=`date +%s%N`
+		if ! $runner ./$native_exec >/dev/null 2>$log ; then
+			return 1
+		fi
+		finish=`date +%s%N`
+
+		let time+=(finish-start)/1000
+	done
+
+	let time/=repeat
+	return 0
+}
+
+benchmark()
+{
+	printf "%8s %12s %8s\n" "threads" "us" "speedup"
+
+	base_time=
+	for number in $threads
+	do
+		generate $number
+		if ! compile ; then
+			echo "Failed to compile program with $number threads:"
+			cat $log
+			exit 1
+		fi
+
+		if ! measure ; then
+			printf "%8d %12s\n" $number "failed"
+			continue
+		fi
+
+		if [[ -z $base_time ]] ; then
+			base_time=$time
+		fi
+
+		printf "%8d %12d %8s\n" $number $time `awk "BEGIN { printf \"%.2f\", $base_time / $time }"`
+	done
+
+	rm -f $log $program $llvm_code $native_code $native_exec
+}
+
+main()
+{
+	init $@
+
+	build
+	benchmark
+}
+
+main $@
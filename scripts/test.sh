@@ -5,7 +5,7 @@ init()
 	exit_code=64
 	vm_exec=export.txt
 
-	vm_release=master
+	vm_release=
 	output_time=0.0
 	wait_for=2
 
@@ -48,7 +48,7 @@ init()
 				echo -e "\t-i, --ignore\tIgnore errors & executing stages."
 				echo -e "\t-r, --remove\tRemove build folder before testing."
 				echo -e "\t-d, --debug\tSwitch on debug tracing."
-				echo -e "\t-v, --virtual\tSet RuC virtual machine release."
+				echo -e "\t-v, --virtual\tSet external RuC virtual machine release instead of in-tree one."
 				echo -e "\t-o, --output\tSet output printing time (default = 0.0)."
 				echo -e "\t-w, --wait\tSet waiting time for timeout result (default = 2)."
 				exit 0
@@ -143,6 +143,23 @@ build_folder()
 
 build_vm()
 {
+	# Виртуальная машина собирается вместе с компилятором и исполняет расширенные коды
+	if [[ -z $vm_release && -x ./Release/ruc-vm ]] ; then
+		vm_flags=--extended-codes
+		interpreter=./Release/ruc-vm
+		if [[ -z $fast ]] ; then
+			interpreter_debug=./Debug/ruc-vm
+		else
+			interpreter_debug=$interpreter
+		fi
+
+		return
+	fi
+
+	if [[ -z $vm_release ]] ; then
+		vm_release=master
+	fi
+
 	if ! [[ -z $remove ]] ; then
 		rm -rf ruc-vm
 	fi
@@ -451,7 +468,7 @@ test()
 	# Do not use names with spaces!
 	for path in `find $dir_test -name *.c | sort`
 	do
-		sources=$path
+		sources="$path $vm_flags"
 
 		if [[ $path != */$subdir_include/* ]] ; then
 			compiling
@@ -469,6 +486,7 @@ test()
 				temp=`dirname $subdir`
 				sources="$sources -I$temp"
 			done
+			sources="$sources $vm_flags"
 
 			compiling
 		done
@@ -0,0 +1,67 @@
+int g[8];
+
+void fill(int a[], int value)
+{
+	for (int i = 0; i < upb(a); i++)
+	{
+		a[i] = value + i;
+	}
+}
+
+void main()
+{
+	int a[10], b[5], m[3][4];
+	int sum = 0;
+	int i;
+
+	fill(a, 1);
+	for (i = upb(a) - 1; i >= 0; i--)
+	{
+		sum += a[i];
+	}
+	assert(sum == 55, "sum must be 55");
+
+	for (i = 0; i < 8; i++)
+	{
+		g[i] = i * i;
+	}
+	for (i = 7; i > -1; i -= 2)
+	{
+		b[i / 2] = g[i];
+	}
+	assert(b[3] == 49 && b[0] == 1, "b must contain odd squares");
+
+	sum = 0;
+	for (i = 1; i < 5; i += 2147483640)
+	{
+		sum += b[i];
+	}
+	assert(sum == 9, "sum must be 9");
+
+	for (int j = 0; j < upb(m); j++)
+	{
+		for (i = 0; i < upb(m[j]) && i <= 3; i++)
+		{
+			m[j][i] = j * 10 + i;
+		}
+	}
+	assert(m[2][3] == 23, "m[2][3] must be 23");
+
+	i = 0;
+	while (i < upb(b))
+	{
+		b[i] = a[i];
+		i++;
+	}
+	assert(b[4] == 5, "b[4] must be 5");
+
+	int k = 0;
+	sum = 0;
+	while (upb(a) > k)
+	{
+		sum += a[k];
+		a = b;
+		k += 2;
+	}
+	assert(sum == 1 + 3 + 5, "sum must be 9");
+}
@@ -0,0 +1,96 @@
+int g = 1;
+int calls = 0;
+
+void bump()
+{
+	g++;
+	calls++;
+}
+
+void main()
+{
+	int n = 6;
+	int m[36];
+
+	// Произведение i * n используется в индексах несколько раз
+	for (int i = 0; i < n; i++)
+	{
+		for (int j = 0; j < n; j++)
+		{
+			m[i * n + j] = i * n + j;
+		}
+	}
+	assert(m[35] == 35, "m[35] must be 35");
+	assert(m[7] == 7, "m[7] must be 7");
+
+	int sum = 0;
+	for (int i = 0; i < n; i += 2)
+	{
+		sum += m[i * n] + m[i * n + 1] + m[n * i + 2];
+	}
+	assert(sum == 3 * (0 + 12 + 24) + 3 * 3, "sum of even rows must be 117");
+
+	sum = 0;
+	for (int i = n - 1; i >= 0; i--)
+	{
+		sum += m[i * 6] - m[6 * i];
+	}
+	assert(sum == 0, "sum of differences must be 0");
+
+	// Выражение n * n + 1 вычисляется один раз
+	int k = 0;
+	int count = 0;
+	while (k < n * n + 1)
+	{
+		count += n * n + 1;
+		k++;
+	}
+	assert(count == 37 * 37, "count must be 37 * 37");
+
+	int len = 0;
+	for (int i = 0; i < upb(m) - 1; i++)
+	{
+		len++;
+	}
+	assert(len == 35, "len must be 35");
+
+	// Переменная, изменяемая в цикле, не выносится
+	int step = 1;
+	sum = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		sum += step * 10;
+		step++;
+	}
+	assert(sum == 100, "sum of steps must be 100");
+
+	// Глобальная переменная может измениться в вызове
+	sum = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		sum += g * 10;
+		bump();
+	}
+	assert(sum == 60, "sum of globals must be 60");
+	assert(calls == 3, "bump must be called 3 times");
+
+	// Переменная, адрес которой взят, может измениться через указатель
+	int x = 1;
+	int *p = &x;
+	sum = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		sum += x + 1;
+		*p = *p + 1;
+	}
+	assert(sum == 9, "sum through pointer must be 9");
+
+	// Деление на ноль не выносится из цикла, который не выполняется
+	int zero = 0;
+	int res = 0;
+	for (int i = 0; i < zero; i++)
+	{
+		res = n / zero;
+	}
+	assert(res == 0, "division must not be executed");
+}
@@ -0,0 +1,24 @@
+const int N = 10;
+const double HALF = 0.5;
+const char LETTER = 'a';
+
+void main()
+{
+    const int twice = N * 2;
+    const int *ptr = &twice;
+    int arr[N];
+    int i;
+
+    for (i = 0; i < N; i++)
+    {
+        arr[i] = i * twice;
+    }
+
+    assert(arr[N - 1] == 180, "Constant propagation error. arr[N - 1] must be 180");
+    assert(*ptr == 20, "Constant address error. *ptr must be 20");
+    assert(HALF * 4 > 1.5, "Floating constant error. HALF * 4 must be 2.0");
+    assert(LETTER + 1 == 'b', "Character constant error. LETTER + 1 must be 'b'");
+    assert((N > 5 ? 1 : 2) == 1, "Ternary folding error. Result must be 1");
+    assert(abs(-N) == N, "abs folding error. Result must be N");
+    assert(-N / 3 == -3 && -N % 3 == -1, "Division folding error. Results must be -3 and -1");
+}
@@ -0,0 +1,8 @@
+void main()
+{
+	int a[5];
+	for (int i = 0; i <= upb(a); i++)
+	{
+		a[i] = i;
+	}
+}
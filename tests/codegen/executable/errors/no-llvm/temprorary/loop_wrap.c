@@ -0,0 +1,9 @@
+void main()
+{
+	int b[10];
+	int s = 0;
+	for (int i = 3; i < 10; i += 2147483646)
+	{
+		s += b[i];
+	}
+}
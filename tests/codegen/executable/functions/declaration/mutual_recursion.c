@@ -0,0 +1,18 @@
+int even(int);
+
+int odd(int n)
+{
+	return n == 0 ? 0 : even(n - 1);
+}
+
+int even(int n)
+{
+	return n == 0 ? 1 : odd(n - 1);
+}
+
+void main()
+{
+	assert(even(10) == 1, "10 must be even");
+	assert(odd(7) == 1, "7 must be odd");
+	assert(odd(4) == 0, "4 must not be odd");
+}
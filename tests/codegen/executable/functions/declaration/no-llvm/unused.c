@@ -0,0 +1,46 @@
+int helper(int);
+
+int twice(int x)
+{
+	return 2 * x;
+}
+
+int unused_second(int);
+
+int unused_first(int x)
+{
+	return unused_second(x) + 1;
+}
+
+int unused_second(int x)
+{
+	return unused_first(x) - 1;
+}
+
+int apply(int (*f)(int), int x)
+{
+	return f(x);
+}
+
+void debug()
+{
+	printf("debug\n");
+}
+
+int main()
+{
+	if (0)
+	{
+		debug();
+	}
+
+	assert(helper(1) == 101, "helper(1) must be 101");
+	assert(apply(twice, 2) == 4, "apply(twice, 2) must be 4");
+
+	return 0;
+}
+
+int helper(int x)
+{
+	return x + 100;
+}
@@ -0,0 +1,86 @@
+int g = 5;
+int arr[10];
+int counter = 0;
+
+int get_g()
+{
+	return g;
+}
+
+void set_g(int v)
+{
+	g = v;
+}
+
+int sq(int x)
+{
+	return x * x;
+}
+
+int at(int i)
+{
+	return arr[i];
+}
+
+double half(double x)
+{
+	return x / 2;
+}
+
+int next()
+{
+	counter++;
+	return counter;
+}
+
+int add3(int a, int b, int c)
+{
+	return a + b + c;
+}
+
+int clamp(int x, int lo, int hi)
+{
+	int r = x;
+	if (r < lo)
+	{
+		r = lo;
+	}
+
+	if (r > hi)
+	{
+		r = hi;
+	}
+
+	return r;
+}
+
+int main()
+{
+	int i;
+	int s = 0;
+
+	for (i = 0; i < 10; i++)
+	{
+		arr[i] = sq(i);
+	}
+
+	for (i = 0; i < 10; i++)
+	{
+		s += at(i) + get_g();
+		s = clamp(s, 0, 200);
+	}
+
+	assert(s == 200, "s must be 200");
+
+	set_g(7);
+	assert(get_g() == 7, "get_g() must be 7");
+	assert(add3(1, next(), sq(3)) == 11, "add3(1, next(), sq(3)) must be 11");
+	assert(next() == 2, "next() must be called once before");
+	assert(half(3.0) > 1.4, "half(3.0) must be 1.5");
+
+	i = clamp(sq(20), 0, 300);
+	assert(i == 300, "i must be 300");
+	assert(sq(i + 1) == 90601, "sq(i + 1) must be 90601");
+
+	return clamp(s, 0, 0);
+}
@@ -0,0 +1,63 @@
+int twice(int x)
+{
+	return x + x;
+}
+
+void set(int *p, int value)
+{
+	*p = value;
+}
+
+int sum(int n)
+{
+	// Переменных больше, чем сохраняемых регистров, и все живы во время вызовов
+	int v1 = n, v2 = n + 1, v3 = n + 2, v4 = n + 3, v5 = n + 4;
+	int v6 = n + 5, v7 = n + 6, v8 = n + 7, v9 = n + 8, v10 = n + 9;
+	int t = twice(v1) + twice(v10);
+
+	return t + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8 + v9 + v10;
+}
+
+void main()
+{
+	assert(sum(1) == 77, "sum(1) must be 77");
+
+	int a = 5;
+	int b = a++;
+	assert(a == 6, "postfix increment must change variable");
+	assert(b == 5, "postfix increment must return previous value");
+
+	int c = ++a + b;
+	assert(c == 12, "prefix increment must return new value");
+
+	int d = a - b - 1;
+	assert(d == 1, "d must be 1");
+	assert(a == 7, "a must not be changed");
+	assert(b == 5, "b must not be changed");
+
+	int e = 0;
+	set(&e, 42);
+	assert(e == 42, "variable with taken address must be changed");
+
+	int arr[4] = { 1, 2, 3, 4 };
+	int *p = &arr[1];
+	int i = 2;
+	*p = arr[i] + arr[i + 1];
+	assert(arr[1] == 7, "element must be changed through pointer");
+	assert(*p == 7, "pointer must stay unchanged");
+
+	{
+		int inner = a * 2;
+		assert(inner == 14, "inner must be 14");
+	}
+	{
+		int other = b * 3;
+		assert(other == 15, "other must be 15");
+	}
+
+	int f = -a;
+	int g = ~a;
+	assert(f == -7, "f must be -7");
+	assert(g == -8, "g must be -8");
+	assert(a == 7, "unary operators must not change operand");
+}
@@ -0,0 +1,53 @@
+int fib(int n)
+{
+	if (n < 2)
+	{
+		return n;
+	}
+
+	return fib(n - 1) + fib(n - 2);
+}
+
+int ackermann(int m, int n)
+{
+	if (m == 0)
+	{
+		return n + 1;
+	}
+
+	if (n == 0)
+	{
+		return ackermann(m - 1, 1);
+	}
+
+	return ackermann(m - 1, ackermann(m, n - 1));
+}
+
+// Листовые функции не вызывают других и не используют стек
+int square(int x)
+{
+	return x * x;
+}
+
+float scale(float x, float k)
+{
+	return x * k + 1;
+}
+
+int sum_squares(int n)
+{
+	int a = square(n), b = square(n + 1), c = square(n + 2);
+	return a + b + c;
+}
+
+void main()
+{
+	assert(fib(15) == 610, "fib(15) must be 610");
+	assert(ackermann(2, 3) == 9, "ackermann(2, 3) must be 9");
+	assert(square(square(3)) == 81, "square(square(3)) must be 81");
+	assert(sum_squares(2) == 29, "sum_squares(2) must be 29");
+
+	float s = scale(2.5, 2);
+	assert(s > 5.9, "scale(2.5, 2) must be 6.0");
+	assert(s < 6.1, "scale(2.5, 2) must be 6.0");
+}
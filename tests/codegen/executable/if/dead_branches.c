@@ -0,0 +1,97 @@
+#define DEBUG 0
+
+int sign(int x)
+{
+	if (x >= 0)
+	{
+		return 1;
+	}
+	else
+	{
+		return -1;
+	}
+
+	return 0;
+}
+
+int choose(int x)
+{
+	switch (x)
+	{
+		case 1:
+			return 10;
+			x++;
+		case 2:
+			x = 20;
+			break;
+			x++;
+		default:
+			x = 30;
+	}
+
+	while (1)
+	{
+		x++;
+		if (x > 40)
+		{
+			return x;
+		}
+	}
+
+	return 0;
+}
+
+int main()
+{
+	int i = 0;
+	int j = 0;
+
+	if (DEBUG)
+	{
+		i = 1;
+	}
+	else
+	{
+		j = 1;
+	}
+
+	assert(i == 0, "if (0) must not take then branch");
+	assert(j == 1, "if (0) must take else branch");
+
+	while (DEBUG)
+	{
+		i++;
+	}
+
+	assert(i == 0, "while (0) must not run");
+
+	do
+	{
+		i += 2;
+	} while (DEBUG);
+
+	assert(i == 2, "do while (0) must run once");
+
+	for (i = 7; DEBUG; i++)
+	{
+		j = 5;
+	}
+
+	assert(i == 7, "for with false condition must run inition");
+	assert(j == 1, "for with false condition must not run body");
+
+	for (int k = 0; DEBUG; k++)
+	{
+		j = 5;
+	}
+
+	assert(j == 1, "for with declaration must not run body");
+
+	assert(sign(3) == 1, "sign(3) must be 1");
+	assert(sign(-3) == -1, "sign(-3) must be -1");
+	assert(choose(1) == 10, "choose(1) must be 10");
+	assert(choose(2) == 41, "choose(2) must be 41");
+	assert(choose(3) == 41, "choose(3) must be 41");
+
+	return 0;
+}
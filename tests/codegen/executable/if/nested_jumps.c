@@ -0,0 +1,79 @@
+int classify(int x)
+{
+	// Каждая ветка заканчивается переходом в конец функции через конец вложенных if
+	if (x < 0)
+	{
+		if (x < -10)
+		{
+			return -2;
+		}
+		else
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		if (x == 0)
+		{
+			return 0;
+		}
+		else if (x < 10)
+		{
+			return 1;
+		}
+	}
+
+	return 2;
+}
+
+int shift(int x)
+{
+	int y = x + 1;
+	y = y + 2;
+	y = y - 3;
+	return y + 100;
+}
+
+void main()
+{
+	assert(classify(-20) == -2, "classify(-20) must be -2");
+	assert(classify(-5) == -1, "classify(-5) must be -1");
+	assert(classify(0) == 0, "classify(0) must be 0");
+	assert(classify(5) == 1, "classify(5) must be 1");
+	assert(classify(50) == 2, "classify(50) must be 2");
+	assert(shift(7) == 107, "shift(7) must be 107");
+
+	int sum = 0;
+	for (int i = 0; i < 10; i++)
+	{
+		if (i == 3)
+		{
+			sum += 10;
+		}
+		else
+		{
+			if (i == 7)
+			{
+				break;
+			}
+		}
+
+		sum += i;
+	}
+	assert(sum == 31, "sum must be 31");
+
+	int count = 0;
+	while (1)
+	{
+		if (count < 5)
+		{
+			count++;
+		}
+		else
+		{
+			break;
+		}
+	}
+	assert(count == 5, "count must be 5");
+}
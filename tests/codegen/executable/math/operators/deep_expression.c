@@ -0,0 +1,36 @@
+int id(int x)
+{
+	return x;
+}
+
+float half(float x)
+{
+	return x / 2;
+}
+
+void main()
+{
+	int a = 1, b = 2, c = 3, d = 4;
+	float x = 1.5, y = 2.5;
+
+	// Каждый уровень вложенности держит левый операнд, пока вычисляется правый
+	int right = a + (b + (c + (d + (a + (b + (c + (d + (a + (b + (c + (d
+		+ (a + (b + (c + (d + (a + (b + (c + (d + (a + (b + (c + (d + 1)))))))))))))))))))))));
+	assert(right == 61, "right nested sum must be 61");
+
+	int mixed = a * (b - (c * (d - (a * (b - (c * (d - (a * (b - (c * (d - (a * (b - (c * (d - 1)))))))))))))));
+	assert(mixed == -319, "right nested mixed expression must be -319");
+
+	int left = (((((((((((((((a + b) * c) - d) + a) * b) - c) + d) * a) - b) + c) * d) - a) + b) * c) - d) + a;
+	assert(left == 168, "left nested expression must be 168");
+
+	int calls = a + (id(b) + (c * (id(d) + (a - (id(b) * (c + (id(d) - (a + id(1)))))))));
+	assert(calls == -12, "nested calls must give -12");
+
+	int constants = a * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2 * 2;
+	assert(constants == 65536, "product of constants must be 65536");
+
+	float floating = x + (y * (x + (y * (x + (y * (x + (y * (x + (y * (x + (y * (x + (y * half(4))))))))))))));
+	assert(floating > 1830, "right nested floating expression must be 1830.0546875");
+	assert(floating < 1831, "right nested floating expression must be 1830.0546875");
+}
@@ -0,0 +1,60 @@
+int counter = 0;
+
+void swap(int *a, int *b)
+{
+	int t = *a;
+	*a = *b;
+	*b = t;
+}
+
+int store_and_load(int *p, int *q)
+{
+	// Запись по одному указателю может изменить значение по другому
+	*p = 1;
+	*q = 2;
+	return *p;
+}
+
+float mix(float x, float y)
+{
+	float a = x * y;
+	float b = x + y;
+	return a - b;
+}
+
+void main()
+{
+	int x = 3, y = 4;
+	swap(&x, &y);
+	assert(x == 4, "x must be 4");
+	assert(y == 3, "y must be 3");
+
+	int arr[3] = { 10, 20, 30 };
+	swap(&arr[0], &arr[2]);
+	assert(arr[0] == 30, "arr[0] must be 30");
+	assert(arr[2] == 10, "arr[2] must be 10");
+
+	int v = 0, w = 0;
+	int *pv = &v, *pw = &w;
+	int same = store_and_load(pv, pv);
+	assert(same == 2, "store through alias must be seen");
+	int other = store_and_load(pv, pw);
+	assert(other == 1, "store through other pointer must not be seen");
+
+	int *p = &arr[1];
+	*p = arr[0] + arr[2];
+	int sum = arr[1] + *p;
+	assert(sum == 80, "sum must be 80");
+
+	// Указатель на глобальную переменную и сама переменная обращаются к одной памяти
+	int *pc = &counter;
+	*pc = 5;
+	counter++;
+	swap(&counter, &x);
+	assert(*pc == 4, "counter must be 4");
+	assert(x == 6, "x must be 6");
+
+	float m = mix(3, 5);
+	assert(m > 6.9, "mix(3, 5) must be 7");
+	assert(m < 7.1, "mix(3, 5) must be 7");
+}
@@ -0,0 +1,63 @@
+int pick(int c)
+{
+	int res = 0;
+
+	// Ветвь по умолчанию в середине, общая с другими метками
+	switch (c)
+	{
+		case 1:
+			res += 1;
+		case 4:
+		default:
+		case 2:
+			res += 10;
+			break;
+		case 3:
+			res += 100;
+	}
+
+	return res;
+}
+
+int count(int c)
+{
+	int res = 0;
+	switch (c)
+	{
+		default:
+			res++;
+		case 5:
+			res++;
+		case 6:
+			res++;
+	}
+
+	return res;
+}
+
+void main()
+{
+	assert(pick(1) == 11, "pick(1) must be 11");
+	assert(pick(2) == 10, "pick(2) must be 10");
+	assert(pick(3) == 100, "pick(3) must be 100");
+	assert(pick(4) == 10, "pick(4) must be 10");
+	assert(pick(5) == 10, "pick(5) must be 10");
+	assert(pick(-5) == 10, "pick(-5) must be 10");
+
+	assert(count(5) == 2, "count(5) must be 2");
+	assert(count(6) == 1, "count(6) must be 1");
+	assert(count(7) == 3, "count(7) must be 3");
+
+	int calls = 0;
+	switch (calls++)
+	{
+	}
+	assert(calls == 1, "switch condition must be evaluated");
+
+	switch (calls)
+	{
+		default:
+			calls = 10;
+	}
+	assert(calls == 10, "default must be executed");
+}
@@ -0,0 +1,58 @@
+int classify(int c)
+{
+	int res = 0;
+
+	// Плотный диапазон значений выбирается по таблице переходов
+	switch (c)
+	{
+		case 0:
+			res = 10;
+			break;
+		case 1:
+			res = 11;
+			break;
+		case 2:
+		case 3:
+			res = 13;
+			break;
+		case 5:
+			res = 15;
+			break;
+		case 6:
+			res = 16;
+		case 7:
+			res += 1;
+			break;
+		default:
+			res = -1;
+	}
+
+	return res;
+}
+
+void main()
+{
+	assert(classify(0) == 10, "classify(0) must be 10");
+	assert(classify(1) == 11, "classify(1) must be 11");
+	assert(classify(2) == 13, "classify(2) must be 13");
+	assert(classify(3) == 13, "classify(3) must be 13");
+	assert(classify(4) == -1, "classify(4) must be -1");
+	assert(classify(5) == 15, "classify(5) must be 15");
+	assert(classify(6) == 17, "classify(6) must be 17");
+	assert(classify(7) == 1, "classify(7) must be 1");
+	assert(classify(8) == -1, "classify(8) must be -1");
+	assert(classify(-1) == -1, "classify(-1) must be -1");
+
+	int sum = 0;
+	for (int i = -2; i < 12; i++)
+	{
+		switch (i % 4)
+		{
+			case 0: sum += 1; break;
+			case 1: sum += 10; break;
+			case 2: sum += 100; break;
+			case 3: sum += 1000; break;
+		}
+	}
+	assert(sum == 3 * 1 + 3 * 10 + 3 * 100 + 3 * 1000, "sum must be 3333");
+}
@@ -0,0 +1,64 @@
+int sign(int c)
+{
+	int res = 0;
+	switch (c)
+	{
+		case -3:
+			res = -30;
+			break;
+		case -2:
+			res = -20;
+			break;
+		case -1:
+			res = -10;
+			break;
+		case 0:
+			res = 0;
+			break;
+		case 1:
+			res = 10;
+			break;
+		default:
+			res = 99;
+	}
+
+	return res;
+}
+
+int far(int c)
+{
+	switch (c)
+	{
+		case -1000000:
+			return 1;
+		case -1000:
+			return 2;
+		case -10:
+			return 3;
+		case 10:
+			return 4;
+		case 1000:
+			return 5;
+	}
+
+	return 0;
+}
+
+void main()
+{
+	assert(sign(-4) == 99, "sign(-4) must be 99");
+	assert(sign(-3) == -30, "sign(-3) must be -30");
+	assert(sign(-2) == -20, "sign(-2) must be -20");
+	assert(sign(-1) == -10, "sign(-1) must be -10");
+	assert(sign(0) == 0, "sign(0) must be 0");
+	assert(sign(1) == 10, "sign(1) must be 10");
+	assert(sign(2) == 99, "sign(2) must be 99");
+
+	assert(far(-1000000) == 1, "far(-1000000) must be 1");
+	assert(far(-1000) == 2, "far(-1000) must be 2");
+	assert(far(-10) == 3, "far(-10) must be 3");
+	assert(far(10) == 4, "far(10) must be 4");
+	assert(far(1000) == 5, "far(1000) must be 5");
+	assert(far(-11) == 0, "far(-11) must be 0");
+	assert(far(0) == 0, "far(0) must be 0");
+}
@@ -0,0 +1,61 @@
+int code(int c)
+{
+	// Разреженные значения выбираются двоичным поиском
+	switch (c)
+	{
+		case 1:
+			return 1;
+		case 10:
+			return 2;
+		case 100:
+			return 3;
+		case 1000:
+			return 4;
+		case 10000:
+			return 5;
+		case 100000:
+			return 6;
+		case 1000000:
+			return 7;
+		case 2147483647:
+			return 8;
+	}
+
+	return 0;
+}
+
+void main()
+{
+	assert(code(1) == 1, "code(1) must be 1");
+	assert(code(10) == 2, "code(10) must be 2");
+	assert(code(100) == 3, "code(100) must be 3");
+	assert(code(1000) == 4, "code(1000) must be 4");
+	assert(code(10000) == 5, "code(10000) must be 5");
+	assert(code(100000) == 6, "code(100000) must be 6");
+	assert(code(1000000) == 7, "code(1000000) must be 7");
+	assert(code(2147483647) == 8, "code(2147483647) must be 8");
+	assert(code(0) == 0, "code(0) must be 0");
+	assert(code(11) == 0, "code(11) must be 0");
+	assert(code(999999) == 0, "code(999999) must be 0");
+
+	// Разреженные кластеры плотных значений
+	int hits = 0;
+	for (int i = 0; i < 300; i++)
+	{
+		switch (i)
+		{
+			case 100: case 101: case 102: case 103: case 104:
+				hits += 1;
+				break;
+			case 200: case 201: case 202: case 203: case 204:
+				hits += 10;
+				break;
+			case 7:
+				hits += 100;
+				break;
+			default:
+				break;
+		}
+	}
+	assert(hits == 5 + 50 + 100, "hits must be 155");
+}
@@ -0,0 +1,26 @@
+int flag = 0;
+
+void* threadf(void* x)
+{
+	t_sleep(10);
+	flag = 1;
+
+	t_exit();
+	return 0;
+}
+
+int main()
+{
+	int waits = 0;
+	t_create(threadf);
+
+	// Глобальная переменная меняется другим потоком, её чтение нельзя выносить из цикла
+	while (flag * 2 == 0)
+	{
+		waits++;
+	}
+
+	t_join(1);
+	assert(flag == 1 && waits >= 0, "flag must be 1");
+	return 0;
+}
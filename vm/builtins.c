@@ -0,0 +1,537 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "builtins.h"
+#include <stdlib.h>
+#include "syntax.h"
+#include "utf8.h"
+
+
+#define MAX_SYMBOL_SIZE 8
+
+
+/**
+ *	Get array contents with bounds checking
+ *
+ *	@param	vm			Virtual machine
+ *	@param	array		Array address
+ *	@param	elem_size	Size of element
+ *	@param	length		Number of elements
+ *
+ *	@return	Array contents
+ */
+static word_t *array_get(const machine *const vm, const word_t array, const word_t elem_size, word_t *const length)
+{
+	if (array < 1 || (size_t)array >= vm->memory_size)
+	{
+		runtime_error("обращение к массиву по некорректному адресу %" PRId32, array);
+	}
+
+	*length = vm->memory[array - 1];
+	if (*length < 0 || (size_t)*length * (size_t)elem_size > vm->memory_size - (size_t)array)
+	{
+		runtime_error("массив по адресу %" PRId32 " повреждён", array);
+	}
+
+	return &vm->memory[array];
+}
+
+/**
+ *	Convert string to NUL-terminated UTF-8 string
+ *
+ *	@param	vm			Virtual machine
+ *	@param	str			String
+ *
+ *	@return	Allocated UTF-8 string
+ */
+static char *string_to_utf8(const machine *const vm, const word_t str)
+{
+	word_t length;
+	const word_t *const symbols = array_get(vm, str, 1, &length);
+
+	char *const buffer = malloc((size_t)length * MAX_SYMBOL_SIZE + 1);
+	if (buffer == NULL)
+	{
+		runtime_error("недостаточно памяти");
+	}
+
+	size_t size = 0;
+	for (word_t i = 0; i < length; i++)
+	{
+		size += utf8_to_string(&buffer[size], (char32_t)symbols[i]);
+	}
+
+	buffer[size] = '\0';
+	return buffer;
+}
+
+/**
+ *	Print symbol in UTF-8
+ *
+ *	@param	file		Output file
+ *	@param	symbol		Symbol code
+ */
+static void print_symbol(FILE *const file, const word_t symbol)
+{
+	char buffer[MAX_SYMBOL_SIZE];
+	const size_t size = utf8_to_string(buffer, (char32_t)symbol);
+	fwrite(buffer, 1, size, file);
+}
+
+/**
+ *	Print string in UTF-8
+ *
+ *	@param	vm			Virtual machine
+ *	@param	file		Output file
+ *	@param	str			String
+ */
+static void print_string(const machine *const vm, FILE *const file, const word_t str)
+{
+	word_t length;
+	const word_t *const symbols = array_get(vm, str, 1, &length);
+	for (word_t i = 0; i < length; i++)
+	{
+		print_symbol(file, symbols[i]);
+	}
+}
+
+/**
+ *	Get class of type
+ *
+ *	@param	vm			Virtual machine
+ *	@param	type		Type
+ *
+ *	@return	Type class
+ */
+static word_t type_get_kind(const machine *const vm, const word_t type)
+{
+	return type > 0 && (size_t)type < vm->prg->types_size ? vm->prg->types[type] : type;
+}
+
+/**
+ *	Get address of identifier record
+ *
+ *	@param	th			Current thread
+ *	@param	ref			Reference to identifiers table
+ *
+ *	@return	Identifier record of name offset, type and displacement
+ */
+static const word_t *identifier_get(const vm_thread *const th, const word_t ref)
+{
+	const program *const prg = th->vm->prg;
+	if (ref < -1 || (size_t)ref + 4 > prg->identifiers_size
+		|| (size_t)prg->identifiers[ref + 1] >= prg->names_size)
+	{
+		runtime_error("идентификатор %" PRId32 " не существует", ref);
+	}
+
+	return &prg->identifiers[ref + 1];
+}
+
+/**
+ *	Read value of type from standard input
+ *
+ *	@param	vm			Virtual machine
+ *	@param	value		Value in memory
+ *	@param	type		Value type
+ */
+static void read_value(const machine *const vm, word_t *const value, const word_t type)
+{
+	const word_t *const types = vm->prg->types;
+	switch (type_get_kind(vm, type))
+	{
+		case TYPE_FLOATING:
+		{
+			double number;
+			if (scanf("%lf", &number) != 1)
+			{
+				runtime_error("ожидалось вещественное число");
+			}
+
+			double_set(value, number);
+			return;
+		}
+		case TYPE_CHARACTER:
+		{
+			char buffer[MAX_SYMBOL_SIZE] = { 0 };
+			const int fst = getchar();
+			if (fst == EOF)
+			{
+				runtime_error("ожидался символ");
+			}
+
+			buffer[0] = (char)fst;
+			for (size_t i = 1; i < utf8_symbol_size(buffer[0]) && i < MAX_SYMBOL_SIZE; i++)
+			{
+				buffer[i] = (char)getchar();
+			}
+
+			*value = (word_t)utf8_convert(buffer);
+			return;
+		}
+		case TYPE_CONST:
+			read_value(vm, value, types[type + 1]);
+			return;
+		case TYPE_ARRAY:
+		{
+			const word_t elem_type = types[type + 1];
+			const word_t elem_size = type_get_size(vm, elem_type);
+
+			word_t length;
+			word_t *const elems = array_get(vm, *value, elem_size, &length);
+			for (word_t i = 0; i < length; i++)
+			{
+				read_value(vm, &elems[i * elem_size], elem_type);
+			}
+			return;
+		}
+		case TYPE_STRUCTURE:
+		{
+			word_t displ = 0;
+			for (word_t i = 0; i < types[type + 2] / 2; i++)
+			{
+				const word_t member_type = types[type + 3 + 2 * i];
+				read_value(vm, &value[displ], member_type);
+				displ += type_get_size(vm, member_type);
+			}
+			return;
+		}
+		default:
+			if (scanf("%" SCNd32, value) != 1)
+			{
+				runtime_error("ожидалось целое число");
+			}
+			return;
+	}
+}
+
+/**
+ *	Get opened file by handle
+ *
+ *	@param	vm			Virtual machine
+ *	@param	file		File handle
+ *
+ *	@return	Opened file
+ */
+static FILE *file_get(machine *const vm, const word_t file)
+{
+	pthread_mutex_lock(&vm->lock);
+	FILE *const opened = file > 0 && file <= MAX_FILES ? vm->files[file - 1] : NULL;
+	pthread_mutex_unlock(&vm->lock);
+
+	if (opened == NULL)
+	{
+		runtime_error("файл %" PRId32 " не открыт", file);
+	}
+
+	return opened;
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+word_t type_get_size(const machine *const vm, const word_t type)
+{
+	switch (type_get_kind(vm, type))
+	{
+		case TYPE_FLOATING:
+			return 2;
+		case TYPE_STRUCTURE:
+			return vm->prg->types[type + 1];
+		case TYPE_CONST:
+			return type_get_size(vm, vm->prg->types[type + 1]);
+		default:
+			return 1;
+	}
+}
+
+
+void print_formatted(vm_thread *const th, const word_t format, const word_t *const args)
+{
+	const machine *const vm = th->vm;
+
+	word_t length;
+	const word_t *const symbols = array_get(vm, format, 1, &length);
+
+	size_t arg = 0;
+	for (word_t i = 0; i < length; i++)
+	{
+		if (symbols[i] != '%' || i + 1 == length)
+		{
+			print_symbol(stdout, symbols[i]);
+			continue;
+		}
+
+		switch (symbols[++i])
+		{
+			case 'i':
+			case U'ц':
+				printf("%" PRId32, args[arg++]);
+				break;
+
+			case 'c':
+			case U'л':
+				print_symbol(stdout, args[arg++]);
+				break;
+
+			case 'f':
+			case U'в':
+				printf("%f", double_get(&args[arg]));
+				arg += 2;
+				break;
+
+			case 's':
+			case U'с':
+				print_string(vm, stdout, args[arg++]);
+				break;
+
+			case '%':
+				printf("%%");
+				break;
+
+			default:
+				printf("%%");
+				print_symbol(stdout, symbols[i]);
+				break;
+		}
+	}
+}
+
+void print_value(vm_thread *const th, const word_t *const value, const word_t type)
+{
+	const machine *const vm = th->vm;
+	const word_t *const types = vm->prg->types;
+	switch (type_get_kind(vm, type))
+	{
+		case TYPE_FLOATING:
+			printf("%f", double_get(value));
+			return;
+		case TYPE_CHARACTER:
+			print_symbol(stdout, *value);
+			return;
+		case TYPE_CONST:
+			print_value(th, value, types[type + 1]);
+			return;
+		case TYPE_ARRAY:
+		{
+			const word_t elem_type = types[type + 1];
+			if (type_get_kind(vm, elem_type) == TYPE_CHARACTER)
+			{
+				print_string(vm, stdout, *value);
+				return;
+			}
+
+			const word_t elem_size = type_get_size(vm, elem_type);
+
+			word_t length;
+			const word_t *const elems = array_get(vm, *value, elem_size, &length);
+
+			printf("{");
+			for (word_t i = 0; i < length; i++)
+			{
+				printf(i == 0 ? "" : ", ");
+				print_value(th, &elems[i * elem_size], elem_type);
+			}
+			printf("}");
+			return;
+		}
+		case TYPE_STRUCTURE:
+		{
+			word_t displ = 0;
+			printf("{");
+			for (word_t i = 0; i < types[type + 2] / 2; i++)
+			{
+				const word_t member_type = types[type + 3 + 2 * i];
+				printf(i == 0 ? "" : ", ");
+				print_value(th, &value[displ], member_type);
+				displ += type_get_size(vm, member_type);
+			}
+			printf("}");
+			return;
+		}
+		default:
+			printf("%" PRId32, *value);
+			return;
+	}
+}
+
+void print_identifier(vm_thread *const th, const word_t ref)
+{
+	const word_t *const record = identifier_get(th, ref);
+	const word_t displ = record[2];
+	const word_t address = displ < 0 ? th->vm->globals - displ : th->l + displ;
+
+	printf("%s ", &th->vm->prg->names[record[0]]);
+	print_value(th, &th->vm->memory[address], record[1]);
+	printf("\n");
+}
+
+void read_identifier(vm_thread *const th, const word_t ref)
+{
+	const word_t *const record = identifier_get(th, ref);
+	const word_t displ = record[2];
+	const word_t address = displ < 0 ? th->vm->globals - displ : th->l + displ;
+
+	fflush(stdout);
+	read_value(th->vm, &th->vm->memory[address], record[1]);
+}
+
+void assert_failed(vm_thread *const th, const word_t msg)
+{
+	char *const buffer = string_to_utf8(th->vm, msg);
+	runtime_error("%s", buffer);
+	free(buffer);
+}
+
+
+word_t string_copy(vm_thread *const th, const word_t str, const word_t amount)
+{
+	return string_concat(th, 0, str, amount);
+}
+
+word_t string_concat(vm_thread *const th, const word_t fst, const word_t snd, const word_t amount)
+{
+	machine *const vm = th->vm;
+
+	word_t fst_length = 0;
+	if (fst != 0)
+	{
+		array_get(vm, fst, 1, &fst_length);
+	}
+
+	word_t snd_length;
+	array_get(vm, snd, 1, &snd_length);
+	if (amount >= 0 && amount < snd_length)
+	{
+		snd_length = amount;
+	}
+
+	// Строка размещается в куче, так как может пережить кадр функции
+	const word_t address = heap_allocate(vm, fst_length + snd_length + 1) + 1;
+	word_t *const memory = vm->memory;
+	memory[address - 1] = fst_length + snd_length;
+	memmove(&memory[address], &memory[fst], (size_t)fst_length * sizeof(word_t));
+	memmove(&memory[address + fst_length], &memory[snd], (size_t)snd_length * sizeof(word_t));
+
+	return address;
+}
+
+word_t string_compare(vm_thread *const th, const word_t fst, const word_t snd, const word_t amount)
+{
+	word_t fst_length;
+	word_t snd_length;
+	const word_t *const fst_symbols = array_get(th->vm, fst, 1, &fst_length);
+	const word_t *const snd_symbols = array_get(th->vm, snd, 1, &snd_length);
+
+	for (word_t i = 0; amount < 0 || i < amount; i++)
+	{
+		if (i == fst_length || i == snd_length)
+		{
+			return fst_length == snd_length ? 0 : i == fst_length ? -1 : 1;
+		}
+
+		if (fst_symbols[i] != snd_symbols[i])
+		{
+			return fst_symbols[i] < snd_symbols[i] ? -1 : 1;
+		}
+	}
+
+	return 0;
+}
+
+word_t string_find(vm_thread *const th, const word_t str, const word_t sub)
+{
+	word_t str_length;
+	word_t sub_length;
+	const word_t *const str_symbols = array_get(th->vm, str, 1, &str_length);
+	const word_t *const sub_symbols = array_get(th->vm, sub, 1, &sub_length);
+
+	for (word_t i = 0; i + sub_length <= str_length; i++)
+	{
+		if (memcmp(&str_symbols[i], sub_symbols, (size_t)sub_length * sizeof(word_t)) == 0)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+word_t string_length(vm_thread *const th, const word_t str)
+{
+	word_t length;
+	array_get(th->vm, str, 1, &length);
+	return length;
+}
+
+
+word_t file_open(vm_thread *const th, const word_t name, const word_t mode)
+{
+	machine *const vm = th->vm;
+	char *const path = string_to_utf8(vm, name);
+	char *const flags = string_to_utf8(vm, mode);
+	FILE *const file = fopen(path, flags);
+	free(path);
+	free(flags);
+
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	pthread_mutex_lock(&vm->lock);
+	for (size_t i = 0; i < MAX_FILES; i++)
+	{
+		if (vm->files[i] == NULL)
+		{
+			vm->files[i] = file;
+			pthread_mutex_unlock(&vm->lock);
+			return (word_t)i + 1;
+		}
+	}
+	pthread_mutex_unlock(&vm->lock);
+
+	fclose(file);
+	runtime_error("превышено максимальное количество открытых файлов %i", MAX_FILES);
+	return 0;
+}
+
+word_t file_get_char(vm_thread *const th, const word_t file)
+{
+	return fgetc(file_get(th->vm, file));
+}
+
+void file_put_char(vm_thread *const th, const word_t symbol, const word_t file)
+{
+	fputc(symbol, file_get(th->vm, file));
+}
+
+void file_close(vm_thread *const th, const word_t file)
+{
+	machine *const vm = th->vm;
+	fclose(file_get(vm, file));
+
+	pthread_mutex_lock(&vm->lock);
+	vm->files[file - 1] = NULL;
+	pthread_mutex_unlock(&vm->lock);
+}
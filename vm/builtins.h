@@ -0,0 +1,177 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include "machine.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Get size of type in items
+ *
+ *	@param	vm				Virtual machine
+ *	@param	type			Type from types table
+ *
+ *	@return	Type size
+ */
+word_t type_get_size(const machine *const vm, const word_t type);
+
+
+/**
+ *	Print formatted values as @c printf function
+ *
+ *	@param	th				Current thread
+ *	@param	format			Format string
+ *	@param	args			Arguments on stack
+ */
+void print_formatted(vm_thread *const th, const word_t format, const word_t *const args);
+
+/**
+ *	Print value of type
+ *
+ *	@param	th				Current thread
+ *	@param	value			Value in memory
+ *	@param	type			Value type
+ */
+void print_value(vm_thread *const th, const word_t *const value, const word_t type);
+
+/**
+ *	Print identifier name and value
+ *
+ *	@param	th				Current thread
+ *	@param	ref				Reference to identifiers table
+ */
+void print_identifier(vm_thread *const th, const word_t ref);
+
+/**
+ *	Read identifier value from standard input
+ *
+ *	@param	th				Current thread
+ *	@param	ref				Reference to identifiers table
+ */
+void read_identifier(vm_thread *const th, const word_t ref);
+
+/**
+ *	Print message of failed assertion and terminate program
+ *
+ *	@param	th				Current thread
+ *	@param	msg				Message string
+ */
+void assert_failed(vm_thread *const th, const word_t msg);
+
+
+/**
+ *	Copy string to heap
+ *
+ *	@param	th				Current thread
+ *	@param	str				Source string
+ *	@param	amount			Maximum number of copied symbols, negative for whole string
+ *
+ *	@return	Copy of string
+ */
+word_t string_copy(vm_thread *const th, const word_t str, const word_t amount);
+
+/**
+ *	Concatenate strings on heap
+ *
+ *	@param	th				Current thread
+ *	@param	fst				The first string
+ *	@param	snd				The second string
+ *	@param	amount			Maximum number of symbols from the second string, negative for whole string
+ *
+ *	@return	Concatenated string
+ */
+word_t string_concat(vm_thread *const th, const word_t fst, const word_t snd, const word_t amount);
+
+/**
+ *	Compare strings lexicographically
+ *
+ *	@param	th				Current thread
+ *	@param	fst				The first string
+ *	@param	snd				The second string
+ *	@param	amount			Maximum number of compared symbols, negative for whole strings
+ *
+ *	@return	Negative, zero or positive value as @c strcmp function
+ */
+word_t string_compare(vm_thread *const th, const word_t fst, const word_t snd, const word_t amount);
+
+/**
+ *	Find substring
+ *
+ *	@param	th				Current thread
+ *	@param	str				String
+ *	@param	sub				Substring
+ *
+ *	@return	Index of the first occurrence, @c -1 if not found
+ */
+word_t string_find(vm_thread *const th, const word_t str, const word_t sub);
+
+/**
+ *	Get string length
+ *
+ *	@param	th				Current thread
+ *	@param	str				String
+ *
+ *	@return	Number of symbols
+ */
+word_t string_length(vm_thread *const th, const word_t str);
+
+
+/**
+ *	Open file
+ *
+ *	@param	th				Current thread
+ *	@param	name			File name
+ *	@param	mode			Opening mode
+ *
+ *	@return	File handle, @c 0 on failure
+ */
+word_t file_open(vm_thread *const th, const word_t name, const word_t mode);
+
+/**
+ *	Read byte from file
+ *
+ *	@param	th				Current thread
+ *	@param	file			File handle
+ *
+ *	@return	Read byte, @c -1 on end of file
+ */
+word_t file_get_char(vm_thread *const th, const word_t file);
+
+/**
+ *	Write byte to file
+ *
+ *	@param	th				Current thread
+ *	@param	symbol			Written byte
+ *	@param	file			File handle
+ */
+void file_put_char(vm_thread *const th, const word_t symbol, const word_t file);
+
+/**
+ *	Close file
+ *
+ *	@param	th				Current thread
+ *	@param	file			File handle
+ */
+void file_close(vm_thread *const th, const word_t file);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
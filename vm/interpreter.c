@@ -0,0 +1,1278 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "interpreter.h"
+#include <math.h>
+#include <stdlib.h>
+#include <time.h>
+#include "builtins.h"
+#include "instructions.h"
+
+
+#if defined(__GNUC__) && !defined(SWITCH_DISPATCH)
+	#define THREADED_DISPATCH
+#endif
+
+
+#define MAX_DIMENSIONS 16
+
+
+/** Operations of integer instructions, which have assignment versions */
+#define INTEGER_OPERATIONS(X) \
+	X(ADD) X(SUB) X(MUL) X(DIV) X(REM) X(SHL) X(SHR) X(AND) X(XOR) X(OR)
+
+/** Integer comparisons */
+#define INTEGER_COMPARISONS(X) \
+	X(EQ) X(NE) X(LT) X(GT) X(LE) X(GE) X(LOG_AND) X(LOG_OR)
+
+/** Integer assignments with instruction prefix and operation */
+#define INTEGER_ASSIGNMENTS(X) \
+	X(IC_ASSIGN, ASSIGN) X(IC_ADD_ASSIGN, ADD) X(IC_SUB_ASSIGN, SUB) X(IC_MUL_ASSIGN, MUL) \
+	X(IC_DIV_ASSIGN, DIV) X(IC_REM_ASSIGN, REM) X(IC_SHL_ASSIGN, SHL) X(IC_SHR_ASSIGN, SHR) \
+	X(IC_AND_ASSIGN, AND) X(IC_XOR_ASSIGN, XOR) X(IC_OR_ASSIGN, OR)
+
+/** Operations of floating instructions, which have assignment versions */
+#define FLOATING_OPERATIONS(X) \
+	X(ADD) X(SUB) X(MUL) X(DIV)
+
+/** Floating comparisons */
+#define FLOATING_COMPARISONS(X) \
+	X(EQ) X(NE) X(LT) X(GT) X(LE) X(GE)
+
+/** Floating assignments with instruction prefix and operation */
+#define FLOATING_ASSIGNMENTS(X) \
+	X(IC_ASSIGN, ASSIGN) X(IC_ADD_ASSIGN, ADD) X(IC_SUB_ASSIGN, SUB) X(IC_MUL_ASSIGN, MUL) X(IC_DIV_ASSIGN, DIV)
+
+/** Increments and decrements with instruction prefix, step and prefix flag */
+#define STEPS(X) \
+	X(IC_POST_INC, 1, 0) X(IC_POST_DEC, -1, 0) X(IC_PRE_INC, 1, 1) X(IC_PRE_DEC, -1, 1)
+
+/** Other instructions */
+#define INSTRUCTIONS(X) \
+	X(IC_NOP) X(IC_LI) X(IC_LID) X(IC_LOAD) X(IC_LOADD) X(IC_LAT) X(IC_LATD) X(IC_LA) X(IC_SELECT) X(IC_SLICE) \
+	X(IC_SLICE_UNCHECKED) X(IC_DUPLICATE) X(IC_WIDEN) X(IC_WIDEN1) X(IC_UNMINUS) X(IC_NOT) X(IC_LOG_NOT) \
+	X(IC_ABSI) X(IC_UNMINUS_R) \
+	X(IC_B) X(IC_BE0) X(IC_BNE0) X(IC_SWITCH) X(IC_STOP) X(IC_FUNC_BEG) X(IC_CALL1) X(IC_CALL2) \
+	X(IC_RETURN_VAL) X(IC_RETURN_VOID) X(IC_DEFARR) X(IC_BEG_INIT) X(IC_ARR_INIT) X(IC_STRUCT_WITH_ARR) \
+	X(IC_COPY00) X(IC_COPY01) X(IC_COPY10) X(IC_COPY11) X(IC_COPY0ST) X(IC_COPY1ST) X(IC_COPY0ST_ASSIGN) \
+	X(IC_COPY1ST_ASSIGN) X(IC_COPYST) X(IC_UPB) X(IC_PRINTF) X(IC_PRINT) X(IC_PRINTID) X(IC_GETID) X(IC_ASSERT) \
+	X(IC_ABS) X(IC_SQRT) X(IC_EXP) X(IC_SIN) X(IC_COS) X(IC_LOG) X(IC_LOG10) X(IC_ASIN) X(IC_RAND) X(IC_ROUND) \
+	X(IC_STRCPY) X(IC_STRNCPY) X(IC_STRCAT) X(IC_STRNCAT) X(IC_STRCMP) X(IC_STRNCMP) X(IC_STRSTR) X(IC_STRLEN) \
+	X(IC_CREATE) X(IC_GETNUM) X(IC_JOIN) X(IC_SLEEP) X(IC_EXIT) X(IC_INIT) X(IC_DESTROY) \
+	X(IC_SEM_CREATE) X(IC_SEM_WAIT) X(IC_SEM_POST) X(IC_MSG_SEND) X(IC_MSG_RECEIVE) \
+	X(IC_FOPEN) X(IC_FGETC) X(IC_FPUTC) X(IC_FCLOSE) \
+	X(IC_SCANF) X(IC_STRING_INIT) X(IC_ROWING) X(IC_ROWING_D) X(IC_ROBOT_SEND_INT) X(IC_ROBOT_SEND_FLOAT) \
+	X(IC_ROBOT_SEND_STRING) X(IC_ROBOT_RECEIVE_INT) X(IC_ROBOT_RECEIVE_FLOAT) X(IC_ROBOT_RECEIVE_STRING)
+
+
+#define INTEGER_ASSIGN(a, b)	(b)
+#define INTEGER_ADD(a, b)		((word_t)((uint32_t)(a) + (uint32_t)(b)))
+#define INTEGER_SUB(a, b)		((word_t)((uint32_t)(a) - (uint32_t)(b)))
+#define INTEGER_MUL(a, b)		((word_t)((uint32_t)(a) * (uint32_t)(b)))
+#define INTEGER_DIV(a, b)		integer_divide(a, b)
+#define INTEGER_REM(a, b)		integer_remainder(a, b)
+#define INTEGER_SHL(a, b)		((word_t)((uint32_t)(a) << ((b) & 31)))
+#define INTEGER_SHR(a, b)		((a) >> ((b) & 31))
+#define INTEGER_AND(a, b)		((a) & (b))
+#define INTEGER_XOR(a, b)		((a) ^ (b))
+#define INTEGER_OR(a, b)		((a) | (b))
+#define INTEGER_EQ(a, b)		((a) == (b))
+#define INTEGER_NE(a, b)		((a) != (b))
+#define INTEGER_LT(a, b)		((a) < (b))
+#define INTEGER_GT(a, b)		((a) > (b))
+#define INTEGER_LE(a, b)		((a) <= (b))
+#define INTEGER_GE(a, b)		((a) >= (b))
+#define INTEGER_LOG_AND(a, b)	((a) && (b))
+#define INTEGER_LOG_OR(a, b)	((a) || (b))
+
+#define FLOATING_ASSIGN(a, b)	(b)
+#define FLOATING_ADD(a, b)		((a) + (b))
+#define FLOATING_SUB(a, b)		((a) - (b))
+#define FLOATING_MUL(a, b)		((a) * (b))
+#define FLOATING_DIV(a, b)		((a) / (b))
+#define FLOATING_EQ(a, b)		((a) == (b))
+#define FLOATING_NE(a, b)		((a) != (b))
+#define FLOATING_LT(a, b)		((a) < (b))
+#define FLOATING_GT(a, b)		((a) > (b))
+#define FLOATING_LE(a, b)		((a) <= (b))
+#define FLOATING_GE(a, b)		((a) >= (b))
+
+
+/**
+ *	Divide integers
+ *
+ *	@param	fst			Dividend
+ *	@param	snd			Divisor
+ *
+ *	@return	Quotient
+ */
+static inline word_t integer_divide(const word_t fst, const word_t snd)
+{
+	if (snd == 0)
+	{
+		runtime_error("деление на ноль");
+	}
+
+	return snd == -1 ? INTEGER_SUB(0, fst) : fst / snd;
+}
+
+/**
+ *	Get remainder of integer division
+ *
+ *	@param	fst			Dividend
+ *	@param	snd			Divisor
+ *
+ *	@return	Remainder
+ */
+static inline word_t integer_remainder(const word_t fst, const word_t snd)
+{
+	if (snd == 0)
+	{
+		runtime_error("деление на ноль");
+	}
+
+	return snd == -1 ? 0 : fst % snd;
+}
+
+/**
+ *	Check argument of mathematical function
+ *
+ *	@param	is_valid	Set, if argument is in function domain
+ *	@param	func		Function name
+ *	@param	arg			Argument
+ */
+static inline void math_check(const bool is_valid, const char *const func, const double arg)
+{
+	if (!is_valid)
+	{
+		runtime_error("аргумент %f функции %s вне области определения", arg, func);
+	}
+}
+
+/**
+ *	Run init procedure of structure
+ *
+ *	@param	th			Thread
+ *	@param	proc		Address of procedure
+ *	@param	base		Address of structure
+ */
+static void procedure_run(vm_thread *const th, const word_t proc, const word_t base)
+{
+	const word_t pc = th->pc;
+	const word_t base_struct = th->base_struct;
+
+	th->pc = proc;
+	th->base_struct = base;
+	interpret(th);
+
+	th->pc = pc;
+	th->base_struct = base_struct;
+}
+
+/**
+ *	Allocate array on stack
+ *
+ *	@param	th			Thread
+ *	@param	length		Number of elements
+ *	@param	elem_size	Size of element
+ *
+ *	@return	Array address
+ */
+static word_t array_allocate(vm_thread *const th, const word_t length, const word_t elem_size)
+{
+	if (length < 0)
+	{
+		runtime_error("отрицательный размер массива %" PRId32, length);
+	}
+
+	const int64_t size = (int64_t)length * elem_size + 1;
+	const word_t array = stack_allocate(th, size > INT32_MAX ? -1 : (word_t)size) + 1;
+	th->vm->memory[array - 1] = length;
+	return array;
+}
+
+/**
+ *	Define array by its bounds
+ *
+ *	@param	th			Thread
+ *	@param	bounds		Bounds of dimensions
+ *	@param	dimensions	Number of dimensions
+ *	@param	elem_size	Size of element
+ *	@param	iniproc		Init procedure of element
+ *
+ *	@return	Array address
+ */
+static word_t array_define(vm_thread *const th, const word_t *const bounds, const word_t dimensions
+	, const word_t elem_size, const word_t iniproc)
+{
+	word_t *const memory = th->vm->memory;
+	if (dimensions > 1)
+	{
+		const word_t array = array_allocate(th, bounds[0], 1);
+		for (word_t i = 0; i < bounds[0]; i++)
+		{
+			memory[array + i] = array_define(th, &bounds[1], dimensions - 1, elem_size, iniproc);
+		}
+
+		return array;
+	}
+
+	const word_t array = array_allocate(th, bounds[0], elem_size);
+	for (word_t i = 0; i < bounds[0] && iniproc != 0; i++)
+	{
+		procedure_run(th, iniproc, array + i * elem_size);
+	}
+
+	return array;
+}
+
+/**
+ *	Pop bounds from stack
+ *
+ *	@param	th			Thread
+ *	@param	top			Top of bounds
+ *	@param	amount		Number of bounds
+ *	@param	bounds		Popped bounds
+ */
+static void bounds_pop(vm_thread *const th, const word_t top, const word_t amount, word_t *const bounds)
+{
+	if (amount < 0 || amount > MAX_DIMENSIONS)
+	{
+		runtime_error("превышено максимальное количество измерений массива %i", MAX_DIMENSIONS);
+	}
+
+	memcpy(bounds, &th->vm->memory[top - amount + 1], (size_t)amount * sizeof(word_t));
+}
+
+/**
+ *	Build array from initializer on stack
+ *	@note	Initializer of each array level starts from the number of elements,
+ *			string initializer is an address of string literal
+ *
+ *	@param	th			Thread
+ *	@param	init		Current position of initializer
+ *	@param	bounds		Bounds of dimensions
+ *	@param	amount		Number of bounds
+ *	@param	level		Current dimension
+ *	@param	dimensions	Number of dimensions
+ *	@param	elem_size	Size of element
+ *	@param	is_string	Set, if the last dimension is initialized by strings
+ *
+ *	@return	Array address
+ */
+static word_t array_initialize(vm_thread *const th, word_t *const init, const word_t *const bounds, const word_t amount
+	, const word_t level, const word_t dimensions, const word_t elem_size, const bool is_string)
+{
+	word_t *const memory = th->vm->memory;
+	const bool is_last = level == dimensions - 1;
+	const word_t str = is_last && is_string ? memory[(*init)++] : 0;
+	const word_t size = is_last && is_string ? string_length(th, str) : memory[(*init)++];
+	const word_t length = level < amount ? bounds[level] : size;
+	if (size > length)
+	{
+		runtime_error("количество элементов инициализатора %" PRId32 " больше размера массива %" PRId32
+			, size, length);
+	}
+
+	if (is_last)
+	{
+		const word_t array = array_allocate(th, length, elem_size);
+		memcpy(&memory[array], &memory[is_string ? str : *init], (size_t)size * (size_t)elem_size * sizeof(word_t));
+		*init += is_string ? 0 : size * elem_size;
+		return array;
+	}
+
+	const word_t array = array_allocate(th, length, 1);
+	for (word_t i = 0; i < size; i++)
+	{
+		const word_t row = array_initialize(th, init, bounds, amount, level + 1, dimensions, elem_size, is_string);
+		memory[array + i] = row;
+	}
+
+	// Строки без инициализатора получают известные размеры или остаются пустыми
+	for (word_t i = size; i < length; i++)
+	{
+		const word_t row = level + 1 < amount
+			? array_define(th, &bounds[level + 1], amount - level - 1, elem_size, 0)
+			: array_allocate(th, 0, elem_size);
+		memory[array + i] = row;
+	}
+
+	return array;
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+void interpret(vm_thread *const th)
+{
+	machine *const vm = th->vm;
+	word_t *const memory = vm->memory;
+	const program *const prg = vm->prg;
+	const word_t globals = vm->globals;
+
+	word_t pc = th->pc;
+	word_t l = th->l;
+	word_t x = th->x;
+	word_t pending = th->pending;
+	unsigned long long executed = 0;
+
+#define OPERAND(i)	memory[pc + (i)]
+#define DISPL(d)	((d) < 0 ? globals - (d) : l + (d))
+#define PUSH(value)	memory[++x] = (value)
+#define SAVE()		(th->pc = pc, th->l = l, th->x = x, th->pending = pending)
+#define RESTORE()	(pc = th->pc, l = th->l, x = th->x, pending = th->pending)
+
+#ifdef THREADED_DISPATCH
+	#define INSTRUCTION(code)	do_##code
+	#define DISPATCH()			do { executed++; goto *handlers[pc]; } while (0)
+	#define LABEL(code)			[code - IC_GETID] = &&do_##code,
+
+	#define LABEL_INTEGER_BINARY(op)				LABEL(IC_##op)
+	#define LABEL_FLOATING_BINARY(op)				LABEL(IC_##op##_R)
+	#define LABEL_INTEGER_ASSIGNMENT(code, op)		LABEL(code) LABEL(code##_AT) LABEL(code##_V) LABEL(code##_AT_V)
+	#define LABEL_FLOATING_ASSIGNMENT(code, op)		LABEL(code##_R) LABEL(code##_AT_R) LABEL(code##_R_V) LABEL(code##_AT_R_V)
+	#define LABEL_STEP(code, step, is_prefix) \
+		LABEL(code) LABEL(code##_AT) LABEL(code##_V) LABEL(code##_AT_V) \
+		LABEL(code##_R) LABEL(code##_AT_R) LABEL(code##_R_V) LABEL(code##_AT_R_V)
+
+	// Обработчики инструкций по их кодам
+	static const void *const labels[MAX_INSTRUCTION_CODE - IC_GETID] =
+	{
+		INTEGER_OPERATIONS(LABEL_INTEGER_BINARY)
+		INTEGER_COMPARISONS(LABEL_INTEGER_BINARY)
+		INTEGER_ASSIGNMENTS(LABEL_INTEGER_ASSIGNMENT)
+		FLOATING_OPERATIONS(LABEL_FLOATING_BINARY)
+		FLOATING_COMPARISONS(LABEL_FLOATING_BINARY)
+		FLOATING_ASSIGNMENTS(LABEL_FLOATING_ASSIGNMENT)
+		STEPS(LABEL_STEP)
+		INSTRUCTIONS(LABEL)
+	};
+
+	// Каждый адрес кодов при первом исполнении получает адрес обработчика
+	const void **const handlers = vm->handlers;
+	if (handlers[0] == NULL)
+	{
+		for (word_t i = 0; i < vm->code_size; i++)
+		{
+			handlers[i] = &&decode;
+		}
+	}
+
+	goto *handlers[pc];
+
+decode:
+	{
+		const word_t code = (word_t)pc < vm->code_size ? memory[pc] : MAX_INSTRUCTION_CODE;
+		const void *const handler = code >= IC_GETID && code < MAX_INSTRUCTION_CODE ? labels[code - IC_GETID] : NULL;
+		if (handler == NULL)
+		{
+			goto unknown;
+		}
+
+		handlers[pc] = handler;
+		goto *handler;
+	}
+#else
+	#define INSTRUCTION(code)	case code
+	#define DISPATCH()			goto dispatch
+
+dispatch:
+	executed++;
+	switch (memory[pc])
+	{
+#endif
+
+#define HANDLE_INTEGER_BINARY(op) \
+	INSTRUCTION(IC_##op): \
+	{ \
+		const word_t value = memory[x--]; \
+		memory[x] = INTEGER_##op(memory[x], value); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_INTEGER_ASSIGNMENT(code, op) \
+	INSTRUCTION(code): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		const word_t value = memory[x]; \
+		*var = INTEGER_##op(*var, value); \
+		memory[x] = *var; \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT): \
+	{ \
+		const word_t value = memory[x--]; \
+		word_t *const var = &memory[memory[x]]; \
+		*var = INTEGER_##op(*var, value); \
+		memory[x] = *var; \
+		pc++; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_V): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		const word_t value = memory[x--]; \
+		*var = INTEGER_##op(*var, value); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_V): \
+	{ \
+		const word_t value = memory[x--]; \
+		word_t *const var = &memory[memory[x--]]; \
+		*var = INTEGER_##op(*var, value); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_FLOATING_BINARY(op) \
+	INSTRUCTION(IC_##op##_R): \
+	{ \
+		x -= 2; \
+		double_set(&memory[x - 1], FLOATING_##op(double_get(&memory[x - 1]), double_get(&memory[x + 1]))); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_FLOATING_COMPARISON(op) \
+	INSTRUCTION(IC_##op##_R): \
+	{ \
+		x -= 3; \
+		memory[x] = FLOATING_##op(double_get(&memory[x]), double_get(&memory[x + 2])); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_FLOATING_ASSIGNMENT(code, op) \
+	INSTRUCTION(code##_R): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		const double value = FLOATING_##op(double_get(var), double_get(&memory[x - 1])); \
+		double_set(var, value); \
+		double_set(&memory[x - 1], value); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_R): \
+	{ \
+		word_t *const var = &memory[memory[x - 2]]; \
+		const double value = FLOATING_##op(double_get(var), double_get(&memory[x - 1])); \
+		double_set(var, value); \
+		x--; \
+		double_set(&memory[x - 1], value); \
+		pc++; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_R_V): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		double_set(var, FLOATING_##op(double_get(var), double_get(&memory[x - 1]))); \
+		x -= 2; \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_R_V): \
+	{ \
+		word_t *const var = &memory[memory[x - 2]]; \
+		double_set(var, FLOATING_##op(double_get(var), double_get(&memory[x - 1]))); \
+		x -= 3; \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_STEP(code, step, is_prefix) \
+	INSTRUCTION(code): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		const word_t old = *var; \
+		*var = INTEGER_ADD(old, step); \
+		PUSH(is_prefix ? *var : old); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT): \
+	{ \
+		word_t *const var = &memory[memory[x]]; \
+		const word_t old = *var; \
+		*var = INTEGER_ADD(old, step); \
+		memory[x] = is_prefix ? *var : old; \
+		pc++; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_V): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		*var = INTEGER_ADD(*var, step); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_V): \
+	{ \
+		word_t *const var = &memory[memory[x--]]; \
+		*var = INTEGER_ADD(*var, step); \
+		pc++; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_R): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		const double old = double_get(var); \
+		double_set(var, old + step); \
+		x += 2; \
+		double_set(&memory[x - 1], is_prefix ? old + step : old); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_R): \
+	{ \
+		word_t *const var = &memory[memory[x]]; \
+		const double old = double_get(var); \
+		double_set(var, old + step); \
+		x++; \
+		double_set(&memory[x - 1], is_prefix ? old + step : old); \
+		pc++; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_R_V): \
+	{ \
+		word_t *const var = &memory[DISPL(OPERAND(1))]; \
+		double_set(var, double_get(var) + step); \
+		pc += 2; \
+		DISPATCH(); \
+	} \
+	INSTRUCTION(code##_AT_R_V): \
+	{ \
+		word_t *const var = &memory[memory[x--]]; \
+		double_set(var, double_get(var) + step); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+#define HANDLE_MATH(code, func, condition) \
+	INSTRUCTION(code): \
+	{ \
+		const double arg = double_get(&memory[x - 1]); \
+		math_check(condition, #func, arg); \
+		double_set(&memory[x - 1], func(arg)); \
+		pc++; \
+		DISPATCH(); \
+	}
+
+	INTEGER_OPERATIONS(HANDLE_INTEGER_BINARY)
+	INTEGER_COMPARISONS(HANDLE_INTEGER_BINARY)
+	INTEGER_ASSIGNMENTS(HANDLE_INTEGER_ASSIGNMENT)
+	FLOATING_OPERATIONS(HANDLE_FLOATING_BINARY)
+	FLOATING_COMPARISONS(HANDLE_FLOATING_COMPARISON)
+	FLOATING_ASSIGNMENTS(HANDLE_FLOATING_ASSIGNMENT)
+	STEPS(HANDLE_STEP)
+
+	HANDLE_MATH(IC_ABS, fabs, true)
+	HANDLE_MATH(IC_SQRT, sqrt, arg >= 0)
+	HANDLE_MATH(IC_EXP, exp, true)
+	HANDLE_MATH(IC_SIN, sin, true)
+	HANDLE_MATH(IC_COS, cos, true)
+	HANDLE_MATH(IC_LOG, log, arg > 0)
+	HANDLE_MATH(IC_LOG10, log10, arg > 0)
+	HANDLE_MATH(IC_ASIN, asin, arg >= -1 && arg <= 1)
+
+	INSTRUCTION(IC_NOP):
+	{
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LI):
+	{
+		PUSH(OPERAND(1));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LID):
+	{
+		PUSH(OPERAND(1));
+		PUSH(OPERAND(2));
+		pc += 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LOAD):
+	{
+		PUSH(memory[DISPL(OPERAND(1))]);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LOADD):
+	{
+		const word_t address = DISPL(OPERAND(1));
+		PUSH(memory[address]);
+		PUSH(memory[address + 1]);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LAT):
+	{
+		memory[x] = memory[memory[x]];
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LATD):
+	{
+		const word_t address = memory[x];
+		memory[x] = memory[address];
+		PUSH(memory[address + 1]);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LA):
+	{
+		PUSH(DISPL(OPERAND(1)));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SELECT):
+	{
+		memory[x] += OPERAND(1);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SLICE):
+	{
+		const word_t index = memory[x--];
+		const word_t array = memory[x];
+		if (array < 1 || (size_t)array >= vm->memory_size)
+		{
+			runtime_error("обращение к массиву по некорректному адресу %" PRId32, array);
+		}
+
+		if (index < 0 || index >= memory[array - 1])
+		{
+			runtime_error("индекс %" PRId32 " выходит за границы массива длины %" PRId32, index, memory[array - 1]);
+		}
+
+		memory[x] = array + index * OPERAND(1);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SLICE_UNCHECKED):
+	{
+		// Индекс доказанно не выходит за границы массива
+		const word_t index = memory[x--];
+		memory[x] += index * OPERAND(1);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_DUPLICATE):
+	{
+		x++;
+		memory[x] = memory[x - 1];
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_WIDEN):
+	{
+		double_set(&memory[x], (double)memory[x]);
+		x++;
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_WIDEN1):
+	{
+		const double value = double_get(&memory[x - 1]);
+		double_set(&memory[x - 2], (double)memory[x - 2]);
+		x++;
+		double_set(&memory[x - 1], value);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_UNMINUS):
+	{
+		memory[x] = INTEGER_SUB(0, memory[x]);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_NOT):
+	{
+		memory[x] = ~memory[x];
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_LOG_NOT):
+	{
+		memory[x] = !memory[x];
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_ABSI):
+	{
+		memory[x] = memory[x] < 0 ? INTEGER_SUB(0, memory[x]) : memory[x];
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_UNMINUS_R):
+	{
+		double_set(&memory[x - 1], -double_get(&memory[x - 1]));
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_B):
+	{
+		pc = OPERAND(1);
+		DISPATCH();
+	}
+	INSTRUCTION(IC_BE0):
+	{
+		pc = memory[x--] == 0 ? OPERAND(1) : pc + 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_BNE0):
+	{
+		pc = memory[x--] != 0 ? OPERAND(1) : pc + 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SWITCH):
+	{
+		// За инструкцией следует таблица переходов, последний переход ведёт на default
+		const int64_t offset = (int64_t)memory[x--] - OPERAND(1);
+		const word_t size = OPERAND(2);
+		pc += 3 + 2 * (offset >= 0 && offset < size ? (word_t)offset : size);
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STOP):
+	{
+		goto finish;
+	}
+	INSTRUCTION(IC_FUNC_BEG):
+	{
+		pc = OPERAND(2);
+		DISPATCH();
+	}
+	INSTRUCTION(IC_CALL1):
+	{
+		// Резервируется место для адреса возврата и кадра вызывающей функции
+		memory[x + 1] = pending;
+		pending = x + 1;
+		x += 3;
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_CALL2):
+	{
+		const word_t func = OPERAND(1) < 0 ? memory[l - OPERAND(1)] : OPERAND(1);
+		if (func < 0 || (size_t)func >= prg->functions_size || prg->functions[func] <= 0)
+		{
+			runtime_error("вызов несуществующей функции %" PRId32, func);
+		}
+
+		const word_t entry = prg->functions[func];
+		const word_t frame = pending;
+		pending = memory[frame];
+
+		memory[frame] = l;
+		memory[frame + 1] = pc + 2;
+		l = frame;
+		x = l + memory[entry + 1] - 1;
+		if (x > th->stack_limit)
+		{
+			runtime_error("переполнение стека");
+		}
+
+		pc = entry + 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_RETURN_VAL):
+	{
+		const word_t size = OPERAND(1);
+		const word_t frame = l;
+		pc = memory[frame + 1];
+		l = memory[frame];
+
+		memmove(&memory[frame], &memory[x - size + 1], (size_t)size * sizeof(word_t));
+		x = frame + size - 1;
+		if (pc == 0)
+		{
+			goto finish;
+		}
+		DISPATCH();
+	}
+	INSTRUCTION(IC_RETURN_VOID):
+	{
+		const word_t frame = l;
+		pc = memory[frame + 1];
+		l = memory[frame];
+
+		x = frame - 1;
+		if (pc == 0)
+		{
+			goto finish;
+		}
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_DEFARR):
+	{
+		const word_t dimensions = OPERAND(1);
+		const word_t elem_size = OPERAND(2);
+		const word_t displ = OPERAND(3);
+		const word_t iniproc = OPERAND(4);
+		const bool has_initializer = OPERAND(6) != 0;
+		const bool is_in_struct = OPERAND(7) != 0;
+		pc += 8;
+
+		if (has_initializer)
+		{
+			// Границы остаются на стеке до инструкции ARR_INIT
+			if (th->inits_size == MAX_INIT_DEPTH)
+			{
+				runtime_error("превышена вложенность инициализаторов массивов %i", MAX_INIT_DEPTH);
+			}
+
+			th->inits[th->inits_size++] = x;
+			DISPATCH();
+		}
+
+		word_t bounds[MAX_DIMENSIONS];
+		bounds_pop(th, x, dimensions, bounds);
+		x -= dimensions;
+
+		const word_t address = is_in_struct ? th->base_struct + displ : DISPL(displ);
+		SAVE();
+		const word_t array = array_define(th, bounds, dimensions, elem_size, iniproc);
+		RESTORE();
+
+		memory[address] = array;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_BEG_INIT):
+	{
+		PUSH(OPERAND(1));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_ARR_INIT):
+	{
+		const word_t dimensions = OPERAND(1);
+		const word_t elem_size = OPERAND(2);
+		const word_t displ = OPERAND(3);
+		const word_t usual = OPERAND(4);
+		pc += 5;
+
+		const word_t top = th->inits[--th->inits_size];
+		const word_t amount = usual & 1 ? dimensions : dimensions - 1;
+
+		word_t bounds[MAX_DIMENSIONS];
+		bounds_pop(th, top, amount, bounds);
+
+		word_t init = top + 1;
+		SAVE();
+		const word_t array = array_initialize(th, &init, bounds, amount, 0, dimensions, elem_size, (usual & 2) != 0);
+		RESTORE();
+
+		memory[DISPL(displ)] = array;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRUCT_WITH_ARR):
+	{
+		const word_t address = DISPL(OPERAND(1));
+		const word_t iniproc = OPERAND(2);
+		pc += 3;
+
+		SAVE();
+		procedure_run(th, iniproc, address);
+		RESTORE();
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_COPY00):
+	{
+		memmove(&memory[DISPL(OPERAND(1))], &memory[DISPL(OPERAND(2))], (size_t)OPERAND(3) * sizeof(word_t));
+		pc += 4;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY01):
+	{
+		const word_t address = memory[x--];
+		memmove(&memory[DISPL(OPERAND(1))], &memory[address], (size_t)OPERAND(2) * sizeof(word_t));
+		pc += 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY10):
+	{
+		const word_t address = memory[x--];
+		memmove(&memory[address], &memory[DISPL(OPERAND(1))], (size_t)OPERAND(2) * sizeof(word_t));
+		pc += 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY11):
+	{
+		const word_t source = memory[x--];
+		const word_t dest = memory[x--];
+		memmove(&memory[dest], &memory[source], (size_t)OPERAND(1) * sizeof(word_t));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY0ST):
+	{
+		const word_t size = OPERAND(2);
+		memmove(&memory[x + 1], &memory[DISPL(OPERAND(1))], (size_t)size * sizeof(word_t));
+		x += size;
+		pc += 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY1ST):
+	{
+		const word_t size = OPERAND(1);
+		const word_t address = memory[x--];
+		memmove(&memory[x + 1], &memory[address], (size_t)size * sizeof(word_t));
+		x += size;
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY0ST_ASSIGN):
+	{
+		// Значение присваивания остаётся на стеке для цепочек присваиваний
+		const word_t size = OPERAND(2);
+		memmove(&memory[DISPL(OPERAND(1))], &memory[x - size + 1], (size_t)size * sizeof(word_t));
+		pc += 3;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPY1ST_ASSIGN):
+	{
+		const word_t size = OPERAND(1);
+		const word_t address = memory[x - size];
+		memmove(&memory[address], &memory[x - size + 1], (size_t)size * sizeof(word_t));
+		memmove(&memory[x - size], &memory[x - size + 1], (size_t)size * sizeof(word_t));
+		x--;
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_COPYST):
+	{
+		// Из структуры на стеке остаётся только выбранное поле
+		const word_t size = OPERAND(2);
+		x -= OPERAND(3);
+		memmove(&memory[x + 1], &memory[x + 1 + OPERAND(1)], (size_t)size * sizeof(word_t));
+		x += size;
+		pc += 4;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_UPB):
+	{
+		const word_t array = memory[x--];
+		SAVE();
+		memory[x] = string_length(th, array);
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_PRINTF):
+	{
+		const word_t format = memory[x--];
+		x -= OPERAND(1);
+		SAVE();
+		print_formatted(th, format, &memory[x + 1]);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_PRINT):
+	{
+		const word_t type = OPERAND(1);
+		x -= type_get_size(vm, type);
+		SAVE();
+		print_value(th, &memory[x + 1], type);
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_PRINTID):
+	{
+		SAVE();
+		print_identifier(th, OPERAND(1));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_GETID):
+	{
+		SAVE();
+		read_identifier(th, OPERAND(1));
+		pc += 2;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_ASSERT):
+	{
+		const word_t msg = memory[x--];
+		if (!memory[x--])
+		{
+			SAVE();
+			assert_failed(th, msg);
+		}
+
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_RAND):
+	{
+		x += 2;
+		double_set(&memory[x - 1], (double)rand() / ((double)RAND_MAX + 1));
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_ROUND):
+	{
+		const double value = round(double_get(&memory[x - 1]));
+		if (!(value >= INT32_MIN && value <= INT32_MAX))
+		{
+			runtime_error("значение %f не помещается в целое", value);
+		}
+
+		memory[--x] = (word_t)value;
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_STRCPY):
+	{
+		const word_t source = memory[x--];
+		const word_t dest = memory[x--];
+		SAVE();
+		memory[dest] = string_copy(th, source, -1);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRNCPY):
+	{
+		const word_t amount = memory[x--];
+		const word_t source = memory[x--];
+		const word_t dest = memory[x--];
+		SAVE();
+		memory[dest] = string_copy(th, source, amount < 0 ? 0 : amount);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRCAT):
+	{
+		const word_t source = memory[x--];
+		const word_t dest = memory[x--];
+		SAVE();
+		memory[dest] = string_concat(th, memory[dest], source, -1);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRNCAT):
+	{
+		const word_t amount = memory[x--];
+		const word_t source = memory[x--];
+		const word_t dest = memory[x--];
+		SAVE();
+		memory[dest] = string_concat(th, memory[dest], source, amount < 0 ? 0 : amount);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRCMP):
+	{
+		const word_t snd = memory[x--];
+		SAVE();
+		memory[x] = string_compare(th, memory[x], snd, -1);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRNCMP):
+	{
+		const word_t amount = memory[x--];
+		const word_t snd = memory[x--];
+		SAVE();
+		memory[x] = string_compare(th, memory[x], snd, amount < 0 ? 0 : amount);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRSTR):
+	{
+		const word_t sub = memory[x--];
+		SAVE();
+		memory[x] = string_find(th, memory[x], sub);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_STRLEN):
+	{
+		SAVE();
+		memory[x] = string_length(th, memory[x]);
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_CREATE):
+	{
+		SAVE();
+		memory[x] = thread_create(th, memory[x]);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_GETNUM):
+	{
+		PUSH(th->number);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_JOIN):
+	{
+		const word_t number = memory[x--];
+		SAVE();
+		thread_join(th, number);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SLEEP):
+	{
+		const word_t milliseconds = memory[x--];
+		const struct timespec duration = { .tv_sec = milliseconds / 1000
+			, .tv_nsec = (long)(milliseconds % 1000) * 1000000L };
+		if (milliseconds > 0)
+		{
+			nanosleep(&duration, NULL);
+		}
+
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_EXIT):
+	{
+		goto finish;
+	}
+	INSTRUCTION(IC_INIT):
+	INSTRUCTION(IC_DESTROY):
+	{
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SEM_CREATE):
+	{
+		SAVE();
+		memory[x] = semaphore_create(th, memory[x]);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SEM_WAIT):
+	{
+		const word_t number = memory[x--];
+		SAVE();
+		semaphore_wait(th, number);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_SEM_POST):
+	{
+		const word_t number = memory[x--];
+		SAVE();
+		semaphore_post(th, number);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_MSG_SEND):
+	{
+		const word_t data = memory[x--];
+		const word_t receiver = memory[x--];
+		SAVE();
+		message_send(th, receiver, data);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_MSG_RECEIVE):
+	{
+		SAVE();
+		const message msg = message_receive(th);
+		PUSH(msg.sender);
+		PUSH(msg.data);
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_FOPEN):
+	{
+		const word_t mode = memory[x--];
+		SAVE();
+		memory[x] = file_open(th, memory[x], mode);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_FGETC):
+	{
+		SAVE();
+		memory[x] = file_get_char(th, memory[x]);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_FPUTC):
+	{
+		const word_t file = memory[x--];
+		const word_t symbol = memory[x--];
+		SAVE();
+		file_put_char(th, symbol, file);
+		pc++;
+		DISPATCH();
+	}
+	INSTRUCTION(IC_FCLOSE):
+	{
+		const word_t file = memory[x--];
+		SAVE();
+		file_close(th, file);
+		pc++;
+		DISPATCH();
+	}
+
+	INSTRUCTION(IC_SCANF):
+	INSTRUCTION(IC_STRING_INIT):
+	INSTRUCTION(IC_ROWING):
+	INSTRUCTION(IC_ROWING_D):
+	INSTRUCTION(IC_ROBOT_SEND_INT):
+	INSTRUCTION(IC_ROBOT_SEND_FLOAT):
+	INSTRUCTION(IC_ROBOT_SEND_STRING):
+	INSTRUCTION(IC_ROBOT_RECEIVE_INT):
+	INSTRUCTION(IC_ROBOT_RECEIVE_FLOAT):
+	INSTRUCTION(IC_ROBOT_RECEIVE_STRING):
+	{
+		runtime_error("инструкция %" PRId32 " по адресу %" PRId32 " не поддерживается", memory[pc], pc);
+		goto finish;
+	}
+
+#ifndef THREADED_DISPATCH
+		default:
+			goto unknown;
+	}
+#endif
+
+unknown:
+	runtime_error("неизвестная инструкция %" PRId32 " по адресу %" PRId32, memory[pc], pc);
+
+finish:
+	SAVE();
+	th->executed += executed;
+
+#undef OPERAND
+#undef DISPL
+#undef PUSH
+#undef SAVE
+#undef RESTORE
+#undef INSTRUCTION
+#undef DISPATCH
+}
@@ -0,0 +1,39 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include "machine.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *	Interpret codes from program counter of thread
+ *	@note	Uses direct threaded dispatch with computed goto, if compiler supports it,
+ *			definition @c SWITCH_DISPATCH selects portable dispatch by switch statement.
+ *			Returns on @c STOP instruction, on return from the outermost function of thread
+ *			and on @c t_exit call.
+ *
+ *	@param	th				Thread
+ */
+void interpret(vm_thread *const th);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
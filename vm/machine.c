@@ -0,0 +1,441 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "machine.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "interpreter.h"
+
+
+#ifdef TESTING_EXIT_CODE
+	#define RUNTIME_ERROR_CODE TESTING_EXIT_CODE
+#else
+	#define RUNTIME_ERROR_CODE 1
+#endif
+
+
+static const word_t MAIN_STACK_SIZE = 1 << 23;
+static const word_t THREAD_STACK_SIZE = 1 << 20;
+static const word_t HEAP_SIZE = 1 << 20;
+
+/**	Reserve at the end of stack for expression values */
+static const word_t STACK_RESERVE = 1 << 12;
+
+/**	Address of the first instruction */
+static const word_t PROGRAM_START = 4;
+
+
+/**
+ *	Get base of thread stack
+ *
+ *	@param	vm			Virtual machine
+ *	@param	number		Thread number
+ *
+ *	@return	Base of stack
+ */
+static inline word_t stack_get_base(const machine *const vm, const word_t number)
+{
+	return vm->heap_end + (number == 0 ? 0 : MAIN_STACK_SIZE + (number - 1) * THREAD_STACK_SIZE);
+}
+
+/**
+ *	Create thread structure
+ *
+ *	@param	vm			Virtual machine
+ *	@param	number		Thread number
+ *
+ *	@return	Thread, @c NULL on failure
+ */
+static vm_thread *thread_alloc(machine *const vm, const word_t number)
+{
+	vm_thread *const th = calloc(1, sizeof(vm_thread));
+	if (th == NULL)
+	{
+		return NULL;
+	}
+
+	th->vm = vm;
+	th->number = number;
+	th->l = stack_get_base(vm, number);
+	th->x = th->l - 1;
+	th->stack_limit = th->l + (number == 0 ? MAIN_STACK_SIZE : THREAD_STACK_SIZE) - STACK_RESERVE;
+
+	pthread_cond_init(&th->has_messages, NULL);
+	pthread_cond_init(&th->has_space, NULL);
+	return th;
+}
+
+/**
+ *	Free thread structure
+ *
+ *	@param	th			Thread
+ */
+static void thread_free(vm_thread *const th)
+{
+	pthread_cond_destroy(&th->has_messages);
+	pthread_cond_destroy(&th->has_space);
+	free(th);
+}
+
+/**
+ *	Entry point of POSIX thread
+ *
+ *	@param	arg			Thread of virtual machine
+ *
+ *	@return	@c NULL
+ */
+static void *thread_main(void *arg)
+{
+	interpret((vm_thread *)arg);
+	return NULL;
+}
+
+/**
+ *	Get thread by number
+ *
+ *	@param	vm			Virtual machine
+ *	@param	number		Thread number
+ *
+ *	@return	Thread
+ */
+static vm_thread *thread_get(machine *const vm, const word_t number)
+{
+	pthread_mutex_lock(&vm->lock);
+	vm_thread *const th = number >= 0 && (size_t)number < vm->threads_size ? vm->threads[number] : NULL;
+	pthread_mutex_unlock(&vm->lock);
+
+	if (th == NULL)
+	{
+		runtime_error("поток %" PRId32 " не существует", number);
+	}
+
+	return th;
+}
+
+/**
+ *	Check semaphore number, must be called under lock
+ *
+ *	@param	vm			Virtual machine
+ *	@param	number		Semaphore number
+ */
+static void semaphore_check(machine *const vm, const word_t number)
+{
+	if (number < 0 || (size_t)number >= vm->semaphores_size)
+	{
+		pthread_mutex_unlock(&vm->lock);
+		runtime_error("семафор %" PRId32 " не существует", number);
+	}
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+machine *machine_create(const program *const prg)
+{
+	if (prg->memory_size < (size_t)PROGRAM_START || prg->max_global_displ < 0
+		|| prg->memory_size + (size_t)prg->max_global_displ + (size_t)HEAP_SIZE + (size_t)MAIN_STACK_SIZE
+			+ (size_t)(MAX_THREADS - 1) * (size_t)THREAD_STACK_SIZE >= INT32_MAX)
+	{
+		fprintf(stderr, "ruc-vm: программа не помещается в память\n");
+		return NULL;
+	}
+
+	machine *const vm = calloc(1, sizeof(machine));
+	if (vm == NULL)
+	{
+		return NULL;
+	}
+
+	// Память: коды, глобальные переменные, куча и стеки потоков
+	vm->prg = prg;
+	vm->code_size = (word_t)prg->memory_size;
+	vm->globals = vm->code_size;
+	vm->heap = vm->globals + prg->max_global_displ + 1;
+	vm->heap_end = vm->heap + HEAP_SIZE;
+	vm->memory_size = (size_t)stack_get_base(vm, MAX_THREADS);
+
+	vm->memory = calloc(vm->memory_size, sizeof(word_t));
+	vm->handlers = calloc(prg->memory_size, sizeof(void *));
+	vm->threads[0] = thread_alloc(vm, 0);
+	if (vm->memory == NULL || vm->handlers == NULL || vm->threads[0] == NULL)
+	{
+		free(vm->memory);
+		free(vm->handlers);
+		free(vm->threads[0]);
+		free(vm);
+		return NULL;
+	}
+
+	memcpy(vm->memory, prg->memory, prg->memory_size * sizeof(word_t));
+	vm->threads_size = 1;
+
+	pthread_mutex_init(&vm->lock, NULL);
+	pthread_cond_init(&vm->is_released, NULL);
+	return vm;
+}
+
+unsigned long long machine_run(machine *const vm)
+{
+	vm_thread *const th = vm->threads[0];
+	th->pc = PROGRAM_START;
+	interpret(th);
+	fflush(stdout);
+
+	unsigned long long executed = 0;
+	pthread_mutex_lock(&vm->lock);
+	for (size_t i = 0; i < vm->threads_size; i++)
+	{
+		executed += vm->threads[i]->executed;
+	}
+	pthread_mutex_unlock(&vm->lock);
+
+	return executed;
+}
+
+void machine_clear(machine *const vm)
+{
+	if (vm == NULL)
+	{
+		return;
+	}
+
+	// Незавершённые потоки продолжают использовать память до выхода из программы
+	for (size_t i = 1; i < vm->threads_size; i++)
+	{
+		if (!vm->threads[i]->is_joined)
+		{
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < MAX_FILES; i++)
+	{
+		if (vm->files[i] != NULL)
+		{
+			fclose(vm->files[i]);
+		}
+	}
+
+	for (size_t i = 0; i < vm->threads_size; i++)
+	{
+		thread_free(vm->threads[i]);
+	}
+
+	pthread_cond_destroy(&vm->is_released);
+	pthread_mutex_destroy(&vm->lock);
+
+	free(vm->memory);
+	free(vm->handlers);
+	free(vm);
+}
+
+
+void runtime_error(const char *const format, ...)
+{
+	fflush(stdout);
+	fprintf(stderr, "ошибка исполнения: ");
+
+	va_list args;
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+
+	fprintf(stderr, "\n");
+	exit(RUNTIME_ERROR_CODE);
+}
+
+word_t heap_allocate(machine *const vm, const word_t size)
+{
+	pthread_mutex_lock(&vm->lock);
+	const word_t address = vm->heap;
+	const bool is_enough = size >= 0 && size <= vm->heap_end - address;
+	if (is_enough)
+	{
+		vm->heap += size;
+	}
+	pthread_mutex_unlock(&vm->lock);
+
+	if (!is_enough)
+	{
+		runtime_error("недостаточно памяти для строки");
+	}
+
+	return address;
+}
+
+word_t stack_allocate(vm_thread *const th, const word_t size)
+{
+	const word_t address = th->x + 1;
+	if (size < 0 || size > th->stack_limit - address)
+	{
+		runtime_error("переполнение стека");
+	}
+
+	memset(&th->vm->memory[address], 0, (size_t)size * sizeof(word_t));
+	th->x += size;
+	return address;
+}
+
+
+word_t thread_create(vm_thread *const th, const word_t func)
+{
+	machine *const vm = th->vm;
+	const program *const prg = vm->prg;
+	if (func < 0 || (size_t)func >= prg->functions_size || prg->functions[func] <= 0)
+	{
+		runtime_error("функция потока %" PRId32 " не существует", func);
+	}
+
+	pthread_mutex_lock(&vm->lock);
+	const word_t number = (word_t)vm->threads_size;
+	vm_thread *const child = number < MAX_THREADS ? thread_alloc(vm, number) : NULL;
+	if (child == NULL)
+	{
+		pthread_mutex_unlock(&vm->lock);
+		runtime_error("превышено максимальное количество потоков %i", MAX_THREADS);
+	}
+
+	// Кадр функции потока: возврат по нулевому адресу завершает поток
+	word_t *const memory = vm->memory;
+	const word_t entry = prg->functions[func];
+	memory[child->l] = 0;
+	memory[child->l + 1] = 0;
+	memory[child->l + 3] = 0;
+	child->x = child->l + memory[entry + 1] - 1;
+	child->pc = entry + 3;
+
+	vm->threads[number] = child;
+	vm->threads_size++;
+
+	const int ret = pthread_create(&child->handle, NULL, thread_main, child);
+	pthread_mutex_unlock(&vm->lock);
+
+	if (ret)
+	{
+		runtime_error("не удалось создать поток");
+	}
+
+	return number;
+}
+
+void thread_join(vm_thread *const th, const word_t number)
+{
+	machine *const vm = th->vm;
+	vm_thread *const child = thread_get(vm, number);
+	if (child == th || number == 0)
+	{
+		runtime_error("поток %" PRId32 " не может ожидать сам себя или главный поток", number);
+	}
+
+	pthread_mutex_lock(&vm->lock);
+	const bool is_joined = child->is_joined;
+	child->is_joined = true;
+	pthread_mutex_unlock(&vm->lock);
+
+	if (!is_joined)
+	{
+		pthread_join(child->handle, NULL);
+	}
+}
+
+word_t semaphore_create(vm_thread *const th, const word_t value)
+{
+	machine *const vm = th->vm;
+	pthread_mutex_lock(&vm->lock);
+	const size_t number = vm->semaphores_size;
+	if (number == MAX_SEMAPHORES)
+	{
+		pthread_mutex_unlock(&vm->lock);
+		runtime_error("превышено максимальное количество семафоров %i", MAX_SEMAPHORES);
+	}
+
+	vm->semaphores[number] = value;
+	vm->semaphores_size++;
+	pthread_mutex_unlock(&vm->lock);
+
+	return (word_t)number;
+}
+
+void semaphore_wait(vm_thread *const th, const word_t number)
+{
+	machine *const vm = th->vm;
+	pthread_mutex_lock(&vm->lock);
+	semaphore_check(vm, number);
+
+	while (vm->semaphores[number] <= 0)
+	{
+		pthread_cond_wait(&vm->is_released, &vm->lock);
+	}
+
+	vm->semaphores[number]--;
+	pthread_mutex_unlock(&vm->lock);
+}
+
+void semaphore_post(vm_thread *const th, const word_t number)
+{
+	machine *const vm = th->vm;
+	pthread_mutex_lock(&vm->lock);
+	semaphore_check(vm, number);
+
+	vm->semaphores[number]++;
+	pthread_cond_broadcast(&vm->is_released);
+	pthread_mutex_unlock(&vm->lock);
+}
+
+void message_send(vm_thread *const th, const word_t receiver, const word_t data)
+{
+	machine *const vm = th->vm;
+	vm_thread *const dest = thread_get(vm, receiver);
+
+	pthread_mutex_lock(&vm->lock);
+	while (dest->mailbox_size == MAX_MESSAGES)
+	{
+		pthread_cond_wait(&dest->has_space, &vm->lock);
+	}
+
+	const size_t index = (dest->mailbox_begin + dest->mailbox_size) % MAX_MESSAGES;
+	dest->mailbox[index] = (message){ .sender = th->number, .data = data };
+	dest->mailbox_size++;
+
+	pthread_cond_signal(&dest->has_messages);
+	pthread_mutex_unlock(&vm->lock);
+}
+
+message message_receive(vm_thread *const th)
+{
+	machine *const vm = th->vm;
+	pthread_mutex_lock(&vm->lock);
+	while (th->mailbox_size == 0)
+	{
+		pthread_cond_wait(&th->has_messages, &vm->lock);
+	}
+
+	const message msg = th->mailbox[th->mailbox_begin];
+	th->mailbox_begin = (th->mailbox_begin + 1) % MAX_MESSAGES;
+	th->mailbox_size--;
+
+	pthread_cond_signal(&th->has_space);
+	pthread_mutex_unlock(&vm->lock);
+	return msg;
+}
@@ -0,0 +1,250 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "program.h"
+
+
+#define MAX_THREADS 32
+#define MAX_SEMAPHORES 64
+#define MAX_MESSAGES 256
+#define MAX_FILES 64
+#define MAX_INIT_DEPTH 64
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct machine machine;
+
+/** Message between threads */
+typedef struct message
+{
+	word_t sender;					/**< Number of sender thread */
+	word_t data;					/**< Message data */
+} message;
+
+/** Thread of virtual machine */
+typedef struct vm_thread
+{
+	machine *vm;					/**< Virtual machine */
+	word_t number;					/**< Thread number, main thread is zero */
+
+	word_t pc;						/**< Program counter */
+	word_t l;						/**< Base of current frame */
+	word_t x;						/**< Top of stack */
+	word_t pending;					/**< Frame reserved by the last call, which has not started yet */
+	word_t base_struct;				/**< Base of structure for init procedure */
+	word_t stack_limit;				/**< Stack boundary */
+
+	word_t inits[MAX_INIT_DEPTH];	/**< Stack tops before array initializers */
+	size_t inits_size;				/**< Number of pending array initializers */
+
+	unsigned long long executed;	/**< Number of executed instructions */
+
+	pthread_t handle;				/**< POSIX thread */
+	bool is_joined;					/**< Set, if thread has been joined */
+
+	message mailbox[MAX_MESSAGES];	/**< Received messages */
+	size_t mailbox_begin;			/**< The first unread message */
+	size_t mailbox_size;			/**< Number of unread messages */
+	pthread_cond_t has_messages;	/**< Signaled on message sending */
+	pthread_cond_t has_space;		/**< Signaled on message receiving */
+} vm_thread;
+
+/** Virtual machine */
+struct machine
+{
+	word_t *memory;					/**< Memory of codes, globals, heap and stacks */
+	size_t memory_size;				/**< Size of memory */
+	word_t code_size;				/**< Size of codes */
+	word_t globals;					/**< Base of global variables */
+	word_t heap;					/**< The first free item of heap */
+	word_t heap_end;				/**< Heap boundary */
+
+	const program *prg;				/**< Loaded program */
+	const void **handlers;			/**< Decoded instructions for threaded dispatch */
+
+	vm_thread *threads[MAX_THREADS];	/**< Threads */
+	size_t threads_size;			/**< Number of created threads */
+
+	word_t semaphores[MAX_SEMAPHORES];	/**< Semaphore counters */
+	size_t semaphores_size;			/**< Number of semaphores */
+	pthread_cond_t is_released;		/**< Signaled on semaphore posting */
+
+	FILE *files[MAX_FILES];			/**< Opened files */
+
+	pthread_mutex_t lock;			/**< Lock for threads, semaphores, messages and heap */
+};
+
+
+/**
+ *	Get floating value, which occupies two items with lower half first
+ *
+ *	@param	value			Value in memory
+ *
+ *	@return	Floating value
+ */
+static inline double double_get(const word_t *const value)
+{
+	const uint64_t bits = (uint64_t)(uint32_t)value[0] | (uint64_t)(uint32_t)value[1] << 32;
+	double number;
+	memcpy(&number, &bits, sizeof(double));
+	return number;
+}
+
+/**
+ *	Set floating value, which occupies two items with lower half first
+ *
+ *	@param	value			Value in memory
+ *	@param	number			Floating value
+ */
+static inline void double_set(word_t *const value, const double number)
+{
+	uint64_t bits;
+	memcpy(&bits, &number, sizeof(double));
+	value[0] = (word_t)(uint32_t)bits;
+	value[1] = (word_t)(uint32_t)(bits >> 32);
+}
+
+
+/**
+ *	Create virtual machine
+ *
+ *	@param	prg				Loaded program
+ *
+ *	@return	Virtual machine, @c NULL on failure
+ */
+machine *machine_create(const program *const prg);
+
+/**
+ *	Run program from the beginning in main thread
+ *
+ *	@param	vm				Virtual machine
+ *
+ *	@return	Number of executed instructions in all threads
+ */
+unsigned long long machine_run(machine *const vm);
+
+/**
+ *	Free allocated memory
+ *	@note	Does nothing, if some threads are still running
+ *
+ *	@param	vm				Virtual machine
+ */
+void machine_clear(machine *const vm);
+
+
+/**
+ *	Emit runtime error and terminate program
+ *
+ *	@param	format			Message format
+ */
+void runtime_error(const char *const format, ...);
+
+/**
+ *	Allocate memory on heap
+ *
+ *	@param	vm				Virtual machine
+ *	@param	size			Number of items
+ *
+ *	@return	Address of allocated memory
+ */
+word_t heap_allocate(machine *const vm, const word_t size);
+
+/**
+ *	Allocate memory on thread stack
+ *
+ *	@param	th				Thread
+ *	@param	size			Number of items
+ *
+ *	@return	Address of allocated memory
+ */
+word_t stack_allocate(vm_thread *const th, const word_t size);
+
+
+/**
+ *	Create thread, which starts from function
+ *
+ *	@param	th				Current thread
+ *	@param	func			Function number
+ *
+ *	@return	Thread number
+ */
+word_t thread_create(vm_thread *const th, const word_t func);
+
+/**
+ *	Wait for thread termination
+ *
+ *	@param	th				Current thread
+ *	@param	number			Thread number
+ */
+void thread_join(vm_thread *const th, const word_t number);
+
+/**
+ *	Create semaphore
+ *
+ *	@param	th				Current thread
+ *	@param	value			Initial value
+ *
+ *	@return	Semaphore number
+ */
+word_t semaphore_create(vm_thread *const th, const word_t value);
+
+/**
+ *	Decrement semaphore, waiting while it is zero
+ *
+ *	@param	th				Current thread
+ *	@param	number			Semaphore number
+ */
+void semaphore_wait(vm_thread *const th, const word_t number);
+
+/**
+ *	Increment semaphore
+ *
+ *	@param	th				Current thread
+ *	@param	number			Semaphore number
+ */
+void semaphore_post(vm_thread *const th, const word_t number);
+
+/**
+ *	Send message to thread
+ *
+ *	@param	th				Current thread
+ *	@param	receiver		Receiver thread number
+ *	@param	data			Message data
+ */
+void message_send(vm_thread *const th, const word_t receiver, const word_t data);
+
+/**
+ *	Receive message, waiting for it
+ *
+ *	@param	th				Current thread
+ *
+ *	@return	Received message
+ */
+message message_receive(vm_thread *const th);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
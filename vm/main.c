@@ -0,0 +1,71 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "machine.h"
+#include "program.h"
+
+
+const char *name = "export.txt";
+
+
+int main(int argc, const char *argv[])
+{
+	bool is_stats = false;
+	const char *path = name;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--stats") == 0)
+		{
+			is_stats = true;
+		}
+		else if (argv[i][0] == '-')
+		{
+			fprintf(stderr, "Использование: ruc-vm [--stats] [файл]\n");
+			return 1;
+		}
+		else
+		{
+			path = argv[i];
+		}
+	}
+
+	program prg;
+	if (program_load(path, &prg))
+	{
+		return 1;
+	}
+
+	machine *const vm = machine_create(&prg);
+	if (vm == NULL)
+	{
+		fprintf(stderr, "ruc-vm: не удалось создать виртуальную машину\n");
+		program_clear(&prg);
+		return 1;
+	}
+
+	const unsigned long long executed = machine_run(vm);
+	if (is_stats)
+	{
+		fprintf(stderr, "ruc-vm: исполнено инструкций %llu\n", executed);
+	}
+
+	machine_clear(vm);
+	program_clear(&prg);
+	return 0;
+}
@@ -0,0 +1,318 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#include "program.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utf8.h"
+
+
+#define BINARY_VERSION 1
+#define BINARY_SHEBANG_SIZE 32
+#define BINARY_SECTIONS 5
+#define BINARY_SECTIONS_TABLE 56
+#define BINARY_HEADER_SIZE (BINARY_SECTIONS_TABLE + 24 * BINARY_SECTIONS)
+
+
+static const size_t TEXT_HEADER_SIZE = 7;
+
+
+/**
+ *	Read table of numbers from text file
+ *
+ *	@param	file		Input file
+ *	@param	size		Size of table
+ *
+ *	@return	Table, @c NULL on failure
+ */
+static word_t *read_table(FILE *const file, const size_t size)
+{
+	word_t *const table = malloc((size + 1) * sizeof(word_t));
+	for (size_t i = 0; i < size && table != NULL; i++)
+	{
+		long long value;
+		if (fscanf(file, "%lld", &value) != 1 || value < INT32_MIN || value > INT32_MAX)
+		{
+			free(table);
+			return NULL;
+		}
+
+		table[i] = (word_t)value;
+	}
+
+	return table;
+}
+
+/**
+ *	Load text tables
+ *
+ *	@param	file		Input file
+ *	@param	prg			Loaded program
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+static int load_text(FILE *const file, program *const prg)
+{
+	// Первая строка может содержать путь к интерпретатору
+	int symbol = fgetc(file);
+	if (symbol == '#')
+	{
+		while (symbol != '\n' && symbol != EOF)
+		{
+			symbol = fgetc(file);
+		}
+	}
+	else
+	{
+		ungetc(symbol, file);
+	}
+
+	long long header[TEXT_HEADER_SIZE];
+	for (size_t i = 0; i < TEXT_HEADER_SIZE; i++)
+	{
+		if (fscanf(file, "%lld", &header[i]) != 1 || header[i] < 0)
+		{
+			return -1;
+		}
+	}
+
+	prg->memory_size = (size_t)header[0];
+	prg->functions_size = (size_t)header[1];
+	prg->identifiers_size = (size_t)header[2];
+	prg->types_size = (size_t)header[4];
+	prg->max_global_displ = (word_t)header[5];
+
+	const size_t representations_size = (size_t)header[3];
+	prg->memory = read_table(file, prg->memory_size);
+	prg->functions = read_table(file, prg->functions_size);
+	prg->identifiers = read_table(file, prg->identifiers_size);
+	word_t *const representations = read_table(file, representations_size);
+	prg->types = read_table(file, prg->types_size);
+
+	// Имена переводятся в UTF-8 так же, как в бинарном контейнере
+	prg->names = malloc(representations_size * 4 + 1);
+	size_t *const offsets = malloc((representations_size + 1) * sizeof(size_t));
+	if (prg->memory == NULL || prg->functions == NULL || prg->identifiers == NULL || representations == NULL
+		|| prg->types == NULL || prg->names == NULL || offsets == NULL)
+	{
+		free(representations);
+		free(offsets);
+		return -1;
+	}
+
+	for (size_t i = 0; i < representations_size; i++)
+	{
+		offsets[i] = prg->names_size;
+		prg->names_size += representations[i] == '\0'
+			? (prg->names[prg->names_size] = '\0', 1)
+			: utf8_to_string(&prg->names[prg->names_size], (char32_t)representations[i]);
+	}
+
+	int ret = 0;
+	for (size_t i = 0; i < prg->identifiers_size; i += 3)
+	{
+		const size_t repr = (size_t)prg->identifiers[i] + 2;
+		if (repr >= representations_size)
+		{
+			ret = -1;
+			break;
+		}
+
+		prg->identifiers[i] = (word_t)offsets[repr];
+	}
+
+	free(representations);
+	free(offsets);
+	return ret;
+}
+
+/**
+ *	Read little-endian number
+ *
+ *	@param	buffer		Input buffer
+ *	@param	width		Number of bytes
+ *
+ *	@return	Number
+ */
+static inline uint64_t load_little_endian(const uint8_t *const buffer, const size_t width)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < width; i++)
+	{
+		value |= (uint64_t)buffer[i] << (8 * i);
+	}
+
+	return value;
+}
+
+/**
+ *	Unpack section of binary container
+ *
+ *	@param	buffer		Contents of file
+ *	@param	size		Size of file
+ *	@param	index		Section index
+ *	@param	length		Size of section in bytes
+ *
+ *	@return	Section contents, @c NULL on failure
+ */
+static uint8_t *unpack_section(const uint8_t *const buffer, const size_t size, const size_t index, size_t *const length)
+{
+	const uint8_t *const record = &buffer[BINARY_SECTIONS_TABLE + 24 * index];
+	const uint64_t offset = load_little_endian(record, 8);
+	*length = (size_t)load_little_endian(&record[8], 8);
+
+	if (offset > size || *length > size - offset)
+	{
+		return NULL;
+	}
+
+	uint8_t *const section = malloc(*length + 1);
+	if (section != NULL)
+	{
+		memcpy(section, &buffer[offset], *length);
+		section[*length] = '\0';
+	}
+
+	return section;
+}
+
+/**
+ *	Unpack table of signed 32-bit items
+ *
+ *	@param	buffer		Contents of file
+ *	@param	size		Size of file
+ *	@param	index		Section index
+ *	@param	amount		Number of items
+ *
+ *	@return	Table, @c NULL on failure
+ */
+static word_t *unpack_table(const uint8_t *const buffer, const size_t size, const size_t index, size_t *const amount)
+{
+	size_t length;
+	uint8_t *const section = unpack_section(buffer, size, index, &length);
+	if (section == NULL)
+	{
+		return NULL;
+	}
+
+	*amount = length / sizeof(word_t);
+	word_t *const table = malloc((*amount + 1) * sizeof(word_t));
+	for (size_t i = 0; i < *amount && table != NULL; i++)
+	{
+		table[i] = (word_t)(uint32_t)load_little_endian(&section[i * sizeof(word_t)], sizeof(word_t));
+	}
+
+	free(section);
+	return table;
+}
+
+/**
+ *	Load binary container
+ *	@note	Only signed 32-bit items are supported, as default target of virtual machine
+ *
+ *	@param	buffer		Contents of file
+ *	@param	size		Size of file
+ *	@param	prg			Loaded program
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+static int load_binary(const uint8_t *const buffer, const size_t size, program *const prg)
+{
+	if (size < BINARY_HEADER_SIZE
+		|| load_little_endian(&buffer[36], 2) != BINARY_VERSION
+		|| load_little_endian(&buffer[38], 1) != sizeof(word_t)
+		|| load_little_endian(&buffer[39], 1) != 1
+		|| load_little_endian(&buffer[44], 4) != BINARY_SECTIONS)
+	{
+		fprintf(stderr, "ruc-vm: неподдерживаемый формат контейнера\n");
+		return -1;
+	}
+
+	prg->max_global_displ = (word_t)load_little_endian(&buffer[48], 8);
+	prg->memory = unpack_table(buffer, size, 0, &prg->memory_size);
+	prg->functions = unpack_table(buffer, size, 1, &prg->functions_size);
+	prg->identifiers = unpack_table(buffer, size, 2, &prg->identifiers_size);
+	prg->names = (char *)unpack_section(buffer, size, 3, &prg->names_size);
+	prg->types = unpack_table(buffer, size, 4, &prg->types_size);
+
+	return prg->memory == NULL || prg->functions == NULL || prg->identifiers == NULL
+		|| prg->names == NULL || prg->types == NULL ? -1 : 0;
+}
+
+
+/*
+ *	 __     __   __     ______   ______     ______     ______   ______     ______     ______
+ *	/\ \   /\ "-.\ \   /\__  _\ /\  ___\   /\  == \   /\  ___\ /\  __ \   /\  ___\   /\  ___\
+ *	\ \ \  \ \ \-.  \  \/_/\ \/ \ \  __\   \ \  __<   \ \  __\ \ \  __ \  \ \ \____  \ \  __\
+ *	 \ \_\  \ \_\\"\_\    \ \_\  \ \_____\  \ \_\ \_\  \ \_\    \ \_\ \_\  \ \_____\  \ \_____\
+ *	  \/_/   \/_/ \/_/     \/_/   \/_____/   \/_/ /_/   \/_/     \/_/\/_/   \/_____/   \/_____/
+ */
+
+
+int program_load(const char *const path, program *const prg)
+{
+	*prg = (program){ .memory = NULL };
+
+	FILE *const file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "ruc-vm: не удалось открыть файл \"%s\"\n", path);
+		return -1;
+	}
+
+	uint8_t magic[BINARY_SHEBANG_SIZE + 4];
+	const size_t read = fread(magic, 1, sizeof(magic), file);
+
+	int ret;
+	if (read == sizeof(magic) && memcmp(&magic[BINARY_SHEBANG_SIZE], "RUCB", 4) == 0)
+	{
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		uint8_t *const buffer = size > 0 ? malloc((size_t)size) : NULL;
+		ret = buffer != NULL && fread(buffer, 1, (size_t)size, file) == (size_t)size
+			? load_binary(buffer, (size_t)size, prg)
+			: -1;
+		free(buffer);
+	}
+	else
+	{
+		fseek(file, 0, SEEK_SET);
+		ret = load_text(file, prg);
+	}
+
+	fclose(file);
+	if (ret)
+	{
+		fprintf(stderr, "ruc-vm: файл \"%s\" повреждён\n", path);
+		program_clear(prg);
+	}
+
+	return ret;
+}
+
+void program_clear(program *const prg)
+{
+	free(prg->memory);
+	free(prg->functions);
+	free(prg->identifiers);
+	free(prg->names);
+	free(prg->types);
+
+	*prg = (program){ .memory = NULL };
+}
@@ -0,0 +1,71 @@
+/*
+ *	Copyright 2023 Andrey Terekhov, Victor Y. Fadeev
+ *
+ *	Licensed under the Apache License, Version 2.0 (the "License");
+ *	you may not use this file except in compliance with the License.
+ *	You may obtain a copy of the License at
+ *
+ *		http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *	Unless required by applicable law or agreed to in writing, software
+ *	distributed under the License is distributed on an "AS IS" BASIS,
+ *	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *	See the License for the specific language governing permissions and
+ *	limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Item of virtual machine memory */
+typedef int32_t word_t;
+
+/** Program of virtual machine */
+typedef struct program
+{
+	word_t *memory;				/**< Codes of virtual machine */
+	size_t memory_size;			/**< Size of codes */
+
+	word_t *functions;			/**< Functions table */
+	size_t functions_size;		/**< Size of functions table */
+
+	word_t *identifiers;		/**< Identifiers table, the first field is an offset of name */
+	size_t identifiers_size;	/**< Size of identifiers table */
+
+	char *names;				/**< NUL-terminated UTF-8 names of identifiers */
+	size_t names_size;			/**< Size of names in bytes */
+
+	word_t *types;				/**< Types table */
+	size_t types_size;			/**< Size of types table */
+
+	word_t max_global_displ;	/**< Maximal displacement of global variables */
+} program;
+
+
+/**
+ *	Load program from file, both text tables and binary container are accepted
+ *
+ *	@param	path			Path to exported file
+ *	@param	prg				Loaded program
+ *
+ *	@return	@c 0 on success, @c -1 on failure
+ */
+int program_load(const char *const path, program *const prg);
+
+/**
+ *	Free allocated memory
+ *
+ *	@param	prg				Program
+ */
+void program_clear(program *const prg);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif